@@ -118,6 +118,12 @@ public class EvercoastPlayback : ModuleRules
 			"AudioExtensions"	// IAudioProxyDataFactory which USoundWave derived from
 		});
 
+		if (Target.Configuration != UnrealTargetConfiguration.Shipping)
+		{
+			// Loopback server for the HTTP automation tests
+			PrivateDependencyModuleNames.Add("HTTPServer");
+		}
+
 		PublicIncludePaths.AddRange(
 			new string[] {
 				// ...
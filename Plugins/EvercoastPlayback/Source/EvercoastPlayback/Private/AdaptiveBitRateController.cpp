@@ -0,0 +1,127 @@
+#include "AdaptiveBitRateController.h"
+#include <algorithm>
+#include <cmath>
+
+void AdaptiveBitRateController::MovingAverage::Sample(double weight, double value)
+{
+	const double alpha = std::pow(0.5, weight / halfLife);
+	estimate = value * (1.0 - alpha) + estimate * alpha;
+	totalWeight += weight;
+}
+
+double AdaptiveBitRateController::MovingAverage::Get() const
+{
+	// Remove the bias towards the initial zero estimate
+	const double zeroFactor = 1.0 - std::pow(0.5, totalWeight / halfLife);
+	return zeroFactor > 0 ? estimate / zeroFactor : 0;
+}
+
+AdaptiveBitRateController::AdaptiveBitRateController(const AdaptiveBitRateConfig& config) :
+	m_config(config),
+	m_currentIndex(0),
+	m_sampledSeconds(0),
+	m_bufferedSeconds(0),
+	m_lastSwitchTime(0),
+	m_hasSwitched(false)
+{
+	m_fastAverage.halfLife = config.fastHalfLifeInSeconds;
+	m_slowAverage.halfLife = config.slowHalfLifeInSeconds;
+}
+
+void AdaptiveBitRateController::SetRepresentations(const std::vector<AbrRepresentation>& representations, uint32_t currentRepresentationId)
+{
+	m_representations = representations;
+	std::stable_sort(m_representations.begin(), m_representations.end(), [](const AbrRepresentation& a, const AbrRepresentation& b) {
+		return a.bitRate < b.bitRate;
+		});
+
+	m_currentIndex = 0;
+	for (size_t i = 0; i < m_representations.size(); ++i)
+	{
+		if (m_representations[i].representationId == currentRepresentationId)
+		{
+			m_currentIndex = i;
+			break;
+		}
+	}
+}
+
+void AdaptiveBitRateController::Reset()
+{
+	m_bufferedSeconds = 0;
+	m_lastSwitchTime = 0;
+	m_hasSwitched = false;
+}
+
+void AdaptiveBitRateController::AddThroughputSample(uint64_t bytes, double durationInSeconds)
+{
+	// Too short to say anything, likely served by a proxy cache or coalesced into a tiny request
+	if (durationInSeconds <= 0.001 || bytes == 0)
+		return;
+
+	const double bitsPerSecond = (double)bytes * 8.0 / durationInSeconds;
+	m_fastAverage.Sample(durationInSeconds, bitsPerSecond);
+	m_slowAverage.Sample(durationInSeconds, bitsPerSecond);
+	m_sampledSeconds += durationInSeconds;
+}
+
+double AdaptiveBitRateController::GetEstimatedThroughput() const
+{
+	if (m_sampledSeconds < m_config.minSampledSeconds)
+		return 0;
+
+	return std::min(m_fastAverage.Get(), m_slowAverage.Get());
+}
+
+uint32_t AdaptiveBitRateController::GetCurrentRepresentationId() const
+{
+	return m_representations.empty() ? 0 : m_representations[m_currentIndex].representationId;
+}
+
+size_t AdaptiveBitRateController::HighestSustainableIndex(double bandwidth) const
+{
+	size_t index = 0;
+	for (size_t i = 0; i < m_representations.size(); ++i)
+	{
+		if ((double)m_representations[i].bitRate <= bandwidth)
+			index = i;
+	}
+	return index;
+}
+
+bool AdaptiveBitRateController::Evaluate(double now, uint32_t& outRepresentationId)
+{
+	const double throughput = GetEstimatedThroughput();
+	if (m_representations.size() < 2 || throughput <= 0)
+		return false;
+
+	size_t targetIndex = m_currentIndex;
+	const double currentBitRate = (double)m_representations[m_currentIndex].bitRate;
+	const bool panic = m_bufferedSeconds < m_config.panicBufferInSeconds;
+
+	if (currentBitRate > throughput || (panic && m_currentIndex > 0 && currentBitRate > throughput * m_config.bandwidthSafetyFactor))
+	{
+		// Can't keep up, go straight to what the safe portion of the bandwidth can carry
+		targetIndex = std::min(m_currentIndex - (m_currentIndex > 0 ? 1 : 0), HighestSustainableIndex(throughput * m_config.bandwidthSafetyFactor));
+	}
+	else if (m_currentIndex + 1 < m_representations.size() && !panic &&
+		m_bufferedSeconds >= m_config.upSwitchMinBufferInSeconds &&
+		(double)m_representations[m_currentIndex + 1].bitRate <= throughput * m_config.bandwidthSafetyFactor)
+	{
+		targetIndex = m_currentIndex + 1;
+	}
+
+	if (targetIndex == m_currentIndex)
+		return false;
+
+	// Down switches aren't throttled when the buffer is draining
+	const bool throttled = m_hasSwitched && now - m_lastSwitchTime < m_config.minSwitchIntervalInSeconds;
+	if (throttled && (targetIndex > m_currentIndex || !panic))
+		return false;
+
+	m_currentIndex = targetIndex;
+	m_lastSwitchTime = now;
+	m_hasSwitched = true;
+	outRepresentationId = m_representations[m_currentIndex].representationId;
+	return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct AbrRepresentation
+{
+	uint32_t representationId;
+	uint32_t bitRate; // bits per second
+};
+
+struct AdaptiveBitRateConfig
+{
+	// Only pick representations whose bit rate fits in this portion of the estimated throughput
+	double bandwidthSafetyFactor = 0.75;
+	// Switching up requires at least this much data buffered ahead of the playhead
+	double upSwitchMinBufferInSeconds = 3.0;
+	// Below this much buffered data, drop to whatever the throughput can sustain right away
+	double panicBufferInSeconds = 1.0;
+	// Minimum time between two switches so the estimate can settle on the new representation
+	double minSwitchIntervalInSeconds = 4.0;
+	// Half lives of the fast and slow moving throughput averages, weighted by transfer time
+	double fastHalfLifeInSeconds = 2.0;
+	double slowHalfLifeInSeconds = 8.0;
+	// Don't trust the estimate till this much transfer time has been sampled
+	double minSampledSeconds = 0.5;
+};
+
+// Picks a representation of the main channel from measured throughput and buffer fill. Throughput is tracked with
+// a fast and a slow exponential average and the lower one is used, so drops are followed quickly and spikes are
+// ignored. Up switches are one step at a time and need enough buffer and a bandwidth margin(safety factor), down
+// switches happen once the current bit rate isn't sustainable. The gap between the two conditions is the hysteresis.
+// Time is supplied by the caller so the decisions are deterministic given the same inputs. Not thread safe.
+class AdaptiveBitRateController
+{
+public:
+	explicit AdaptiveBitRateController(const AdaptiveBitRateConfig& config = AdaptiveBitRateConfig());
+
+	// Candidates of the same sample rate, currentRepresentationId is the one in use
+	void SetRepresentations(const std::vector<AbrRepresentation>& representations, uint32_t currentRepresentationId);
+	// After a seek: forget the buffer level and the switch history. The representations, the one in use and the
+	// throughput estimate are kept, the link didn't change.
+	void Reset();
+
+	// A finished transfer of bytes which took durationInSeconds
+	void AddThroughputSample(uint64_t bytes, double durationInSeconds);
+	void SetBufferLevel(double bufferedSeconds)
+	{
+		m_bufferedSeconds = bufferedSeconds;
+	}
+
+	// Expected to be called at segment boundaries. Return true and the representation to switch to if a switch is due.
+	bool Evaluate(double now, uint32_t& outRepresentationId);
+
+	uint32_t GetCurrentRepresentationId() const;
+	// bits per second, 0 if not enough samples yet
+	double GetEstimatedThroughput() const;
+	double GetBufferLevel() const
+	{
+		return m_bufferedSeconds;
+	}
+private:
+	struct MovingAverage
+	{
+		double halfLife = 1.0;
+		double estimate = 0;
+		double totalWeight = 0;
+
+		void Sample(double weight, double value);
+		double Get() const;
+	};
+
+	// Index of the highest representation fitting in the bandwidth, 0 if none does
+	size_t HighestSustainableIndex(double bandwidth) const;
+
+	AdaptiveBitRateConfig m_config;
+	std::vector<AbrRepresentation> m_representations; // ascending bit rate
+	size_t m_currentIndex;
+	MovingAverage m_fastAverage;
+	MovingAverage m_slowAverage;
+	double m_sampledSeconds;
+	double m_bufferedSeconds;
+	double m_lastSwitchTime;
+	bool m_hasSwitched;
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "CoreMinimal.h"
+
+// Recycles large, cache line aligned memory blocks of varying size, e.g. the upload blocks of decoded frames.
+// Sizes are rounded up to a granularity so frames of similar size share blocks, and a request takes the smallest
+// idle block that fits. Blocks handed out outlive the pool safely: the releaser frees them if the pool is gone.
+class AlignedBlockPool : public std::enable_shared_from_this<AlignedBlockPool>
+{
+public:
+	static constexpr uint32_t ALIGNMENT = 64;
+	static constexpr uint32_t GRANULARITY = 1024 * 1024;
+
+	// Pool is always shared so outstanding blocks can tell whether it's still around
+	static std::shared_ptr<AlignedBlockPool> Create(int32_t maxIdleCount)
+	{
+		return std::shared_ptr<AlignedBlockPool>(new AlignedBlockPool(maxIdleCount));
+	}
+
+	~AlignedBlockPool()
+	{
+		for (auto& block : m_idleBlocks)
+		{
+			FMemory::Free(block.data);
+		}
+	}
+
+	// Returns a block of at least size bytes and the function to give it back with
+	uint8_t* Acquire(uint32_t size, std::function<void(uint8_t*)>& outReleaser)
+	{
+		uint8_t* data = nullptr;
+		uint64_t capacity = 0;
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			int32_t bestIdx = -1;
+			for (int32_t i = 0; i < (int32_t)m_idleBlocks.size(); ++i)
+			{
+				if (m_idleBlocks[i].capacity >= size && (bestIdx < 0 || m_idleBlocks[i].capacity < m_idleBlocks[bestIdx].capacity))
+					bestIdx = i;
+			}
+
+			if (bestIdx >= 0)
+			{
+				data = m_idleBlocks[bestIdx].data;
+				capacity = m_idleBlocks[bestIdx].capacity;
+				m_idleBytes -= capacity;
+				m_idleBlocks[bestIdx] = m_idleBlocks.back();
+				m_idleBlocks.pop_back();
+			}
+		}
+
+		if (!data)
+		{
+			capacity = ((uint64_t)size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+			data = (uint8_t*)FMemory::Malloc(capacity, ALIGNMENT);
+		}
+
+		std::weak_ptr<AlignedBlockPool> weakPool = shared_from_this();
+		outReleaser = [weakPool, capacity](uint8_t* block)
+		{
+			if (auto pool = weakPool.lock())
+			{
+				pool->Release(block, capacity);
+			}
+			else
+			{
+				FMemory::Free(block);
+			}
+		};
+		return data;
+	}
+
+	// Bytes sitting in idle blocks
+	uint64_t GetIdleBytes() const
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		return m_idleBytes;
+	}
+
+private:
+	explicit AlignedBlockPool(int32_t maxIdleCount) :
+		m_maxIdleCount(maxIdleCount), m_idleBytes(0)
+	{
+	}
+
+	AlignedBlockPool(const AlignedBlockPool&) = delete;
+	AlignedBlockPool& operator=(const AlignedBlockPool&) = delete;
+
+	void Release(uint8_t* data, uint64_t capacity)
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			if ((int32_t)m_idleBlocks.size() < m_maxIdleCount)
+			{
+				m_idleBlocks.push_back({ data, capacity });
+				m_idleBytes += capacity;
+				return;
+			}
+		}
+
+		FMemory::Free(data);
+	}
+
+	struct IdleBlock
+	{
+		uint8_t* data;
+		uint64_t capacity;
+	};
+
+	const int32_t m_maxIdleCount;
+	std::vector<IdleBlock> m_idleBlocks;
+	uint64_t m_idleBytes;
+	mutable std::mutex m_lock;
+};
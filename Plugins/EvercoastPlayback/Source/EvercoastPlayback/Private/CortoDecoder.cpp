@@ -1,5 +1,6 @@
 #include "CortoDecoder.h"
 #include "EvercoastVoxelDecoder.h"
+#include "CortoPostProcess.h"
 #include "corto_decoder_c.h"
 
 CortoDecodeResult::CortoDecodeResult(uint32_t initVertexCount, uint32_t initTriangleCount) :
@@ -7,7 +8,11 @@ CortoDecodeResult::CortoDecodeResult(uint32_t initVertexCount, uint32_t initTria
 	VertexCount(0),
 	TriangleCount(0),
 	VertexReserved(initVertexCount),
-	TriangleReserved(initTriangleCount)
+	TriangleReserved(initTriangleCount),
+	NormalsValid(false),
+	BoundsMin(FVector3f::ZeroVector),
+	BoundsMax(FVector3f::ZeroVector),
+	BoundsHasNaN(false)
 {
 	if (VertexReserved > 0 && TriangleReserved > 0)
 	{
@@ -34,7 +39,11 @@ CortoDecodeResult::CortoDecodeResult(const CortoDecodeResult& rhs) :
 	IndexBuffer(rhs.IndexBuffer),
 	PositionBuffer(rhs.PositionBuffer),
 	UVBuffer(rhs.UVBuffer),
-	NormalBuffer(rhs.NormalBuffer)
+	NormalBuffer(rhs.NormalBuffer),
+	NormalsValid(rhs.NormalsValid),
+	BoundsMin(rhs.BoundsMin),
+	BoundsMax(rhs.BoundsMax),
+	BoundsHasNaN(rhs.BoundsHasNaN)
 {
 }
 
@@ -60,7 +69,7 @@ void CortoDecodeResult::EnsureBuffers(uint32_t newVertexCount, uint32_t newTrian
 	}
 }
 
-void CortoDecodeResult::ApplyResult(bool success, double timestamp, int64_t theFrameIndex, uint32_t vnum, uint32_t fnum, uint32_t* ib, FVector3f* pb, FVector2f* uvb, FVector3f* nb)
+void CortoDecodeResult::ApplyResult(bool success, double timestamp, int64_t theFrameIndex, uint32_t vnum, uint32_t fnum, bool hasNormals, bool flipWinding, float positionScale)
 {
 	Lock();
 
@@ -70,30 +79,25 @@ void CortoDecodeResult::ApplyResult(bool success, double timestamp, int64_t theF
 
 	VertexCount = vnum;
 	TriangleCount = fnum;
+	NormalsValid = hasNormals;
 
-	EnsureBuffers(VertexCount, TriangleCount);
+	check(VertexCount <= VertexReserved && TriangleCount <= TriangleReserved);
+
+	BoundsMin = FVector3f::ZeroVector;
+	BoundsMax = FVector3f::ZeroVector;
+	BoundsHasNaN = false;
 
 	if (vnum > 0 && fnum > 0)
 	{
-		memcpy(IndexBuffer.data(), ib, TriangleCount * sizeof(uint32_t) * 3);
-		/*
-		for (uint32_t i = 0; i < TriangleCount * 3; i += 3)
-		{
-			std::swap(IndexBuffer[i + 1], IndexBuffer[i + 2]);
-		}
-		*/
-
-		memcpy(PositionBuffer.data(), pb, VertexCount * sizeof(FVector3f));
-		memcpy(UVBuffer.data(), uvb, VertexCount * sizeof(FVector2f));
-		if (nb)
-		{
-			memcpy(NormalBuffer.data(), nb, VertexCount * sizeof(FVector3f));
-		}
-		else
-		{
-			// we don't have normals
-			NormalBuffer.resize(0);
-		}
+		// Winding, coordinate system, unit and bounds in one go rather than a pass for each
+		uint32_t* indices = IndexBuffer.data();
+		FVector3f* positions = PositionBuffer.data();
+		FVector3f* normals = hasNormals ? NormalBuffer.data() : nullptr;
+		CortoPostProcess::MeshBounds bounds = CortoPostProcess::Process(indices, indices, TriangleCount, flipWinding,
+			positions, positions, normals, normals, VertexCount, positionScale);
+		BoundsMin = bounds.Min;
+		BoundsMax = bounds.Max;
+		BoundsHasNaN = bounds.bHasNaN;
 	}
 
 	Unlock();
@@ -122,7 +126,7 @@ void CortoDecodeResult::Unlock() const
 
 bool CortoDecodeResult::HasNormals() const
 {
-	return NormalBuffer.size() > 0;
+	return NormalsValid;
 }
 
 std::shared_ptr<CortoDecoder> CortoDecoder::Create()
@@ -133,32 +137,8 @@ std::shared_ptr<CortoDecoder> CortoDecoder::Create()
 constexpr int CortoDecoder::DEFAULT_VERTEX_COUNT;
 constexpr int CortoDecoder::DEFAULT_TRIANGLE_COUNT;
 
-CortoDecoder::CortoDecoder() :
-	vertex_count(0),
-	triangle_count(0)
+CortoDecoder::CortoDecoder()
 {
-
-	EnsureBuffers(DEFAULT_VERTEX_COUNT, DEFAULT_TRIANGLE_COUNT);
-	
-}
-
-void CortoDecoder::EnsureBuffers(int vertexCount, int triangleCount)
-{
-	if (vertexCount > vertex_count)
-	{
-		position_buf.resize(vertexCount);
-		uv_buf.resize(vertexCount);
-		normal_buf.resize(vertexCount);
-
-		vertex_count = vertexCount;
-	}
-
-	if (triangleCount > triangle_count)
-	{
-		index_buf.resize(triangleCount * 3);
-
-		triangle_count = triangleCount;
-	}
 }
 
 CortoDecoder::~CortoDecoder()
@@ -180,23 +160,15 @@ bool CortoDecoder::DecodeMemoryStream(const uint8_t* stream, size_t stream_size,
 	uint32_t triangleCount = info.nface;
 	uint32_t vertexCount = info.nvert;
 	bool hasNormal = info.hasNormal > 0 ? true : false;
-	EnsureBuffers((int)vertexCount, (int)triangleCount);
 
 	//UE_LOG(EvercoastVoxelDecoderLog, Log, TEXT("Frame: %d, tri: %d vert: %d"), frameIndex, triangleCount, vertexCount);
-	
-	Corto_DecodeMesh(decoder, (Corto_Vector3*)position_buf.data(), (uint32_t*)index_buf.data(), (Corto_Vector3*)normal_buf.data(), nullptr, (Corto_Vector2*)uv_buf.data());
 
-	CortoDecodeOption* cortoDecodeOption = (CortoDecodeOption*)option;
-	if (cortoDecodeOption->bFlipTriangleWinding)
-	{
-		// flip triangle index (0, 1, 2) to (0, 2, 1)
-		for (uint32_t i = 0; i < index_buf.size(); i += 3)
-		{
-			std::swap(index_buf[i + 1], index_buf[i + 2]);
-		}
-	}
+	// The result is exclusively ours till it's taken, decode right into it and convert in place
+	result->EnsureBuffers(vertexCount, triangleCount);
+	Corto_DecodeMesh(decoder, (Corto_Vector3*)result->PositionBuffer.data(), (uint32_t*)result->IndexBuffer.data(), (Corto_Vector3*)result->NormalBuffer.data(), nullptr, (Corto_Vector2*)result->UVBuffer.data());
 
-	result->ApplyResult(true, timestamp, frameIndex, vertexCount, triangleCount, index_buf.data(), position_buf.data(), uv_buf.data(), hasNormal ? normal_buf.data() : nullptr);
+	CortoDecodeOption* cortoDecodeOption = (CortoDecodeOption*)option;
+	result->ApplyResult(true, timestamp, frameIndex, vertexCount, triangleCount, hasNormal, cortoDecodeOption->bFlipTriangleWinding, POSITION_SCALE);
 	
 	Corto_DestroyDecoder(decoder);
 	return true;
@@ -14,61 +14,16 @@
 #endif
 
 // NOTE:
-// We need to keep this local mesh frame class to do the unit and coordinate system conversion
-// Once figured out how to do it on-the-fly in a vertex shader, we can omit those memcpy and just use
-// CorotoDecodeResult instead.
+// Unit and coordinate system conversion already happened on the decoder thread, see CortoDecodeResult::ApplyResult,
+// so the frame just holds on to the decoded buffers till the render proxy has uploaded them.
 CortoLocalMeshFrame::CortoLocalMeshFrame(const CortoWebpUnifiedDecodeResult* pResult) :
 	m_vertexCount(pResult->meshResult->VertexCount),
-	m_triangleCount(pResult->meshResult->TriangleCount)
+	m_triangleCount(pResult->meshResult->TriangleCount),
+	m_mesh(pResult->meshResult)
 {
-	// triangles
-	m_indexBuffer.SetNumUninitialized(GetIndexCount());
-	FMemory::Memcpy(m_indexBuffer.GetData(), pResult->meshResult->IndexBuffer.data(), sizeof(uint32_t) * GetIndexCount());
-
-	// uv0
-	m_uvBuffer.SetNumUninitialized(GetVertexCount());
-	FMemory::Memcpy(m_uvBuffer.GetData(), pResult->meshResult->UVBuffer.data(), sizeof(FVector2f) * GetVertexCount());
-
-	// position needs to be scaled (x100) and swap y<->z so there's no memcpy
-	m_positionBuffer.SetNumUninitialized(GetVertexCount());
-	//FMemory::Memcpy(m_positionBuffer.GetData(), pResult->meshResult->PositionBuffer, sizeof(FVector) * GetVertexCount());
-	FVector3f* pDst = m_positionBuffer.GetData();
-	const FVector3f* pSrc = pResult->meshResult->PositionBuffer.data();;
-	
-	ParallelFor(m_vertexCount, [&](int32 k)
-		{
-			const FVector3f& SrcVertexPos = *(pSrc + k);
-			FVector3f& DstVertexPos = *(pDst + k);
-
-			DstVertexPos.X = SrcVertexPos.X * 100.0f;
-			DstVertexPos.Y = SrcVertexPos.Z * 100.0f;
-			DstVertexPos.Z = SrcVertexPos.Y * 100.0f;
-		});
-
-	if (pResult->meshResult->HasNormals())
-	{
-		m_normalBuffer.SetNumUninitialized(GetVertexCount());
-
-		FVector3f* pNormalDst = m_normalBuffer.GetData();
-		const FVector3f* pNormalSrc = pResult->meshResult->NormalBuffer.data();;
-
-		ParallelFor(m_vertexCount, [&](int32 k)
-			{
-				const FVector3f& SrcVertexNormal = *(pNormalSrc + k);
-				FVector3f& DstVertexNormal = *(pNormalDst + k);
-
-				DstVertexNormal.X = SrcVertexNormal.X;
-				DstVertexNormal.Y = SrcVertexNormal.Z;
-				DstVertexNormal.Z = SrcVertexNormal.Y;
-			});
-	}
-	else
-	{
-		m_normalBuffer.Empty();
-	}
-
-	m_bounds = FBoxSphereBounds3f(m_positionBuffer.GetData(), GetVertexCount());
-	if (m_bounds.BoxExtent.ContainsNaN() || m_bounds.Origin.ContainsNaN())
+	// Sphere derived from the box rather than the farthest vertex, slightly looser but saves another pass
+	m_bounds = FBoxSphereBounds3f(FBox3f(m_mesh->BoundsMin, m_mesh->BoundsMax));
+	if (m_mesh->BoundsHasNaN || m_bounds.BoxExtent.ContainsNaN() || m_bounds.Origin.ContainsNaN())
 	{
 		UE_LOG(EvercoastVoxelDecoderLog, Error, TEXT("Bounds NaN found! Probably due to vertex data corruption with threading."));
 
@@ -92,6 +47,15 @@ CortoLocalTextureFrame::CortoLocalTextureFrame(const CortoWebpUnifiedDecodeResul
 
 void CortoLocalTextureFrame::UpdateTexture(const CortoWebpUnifiedDecodeResult* pResult)
 {
+	TRACE_CPUPROFILER_EVENT_SCOPE(CortoLocalTextureFrame_UpdateTexture);
+
+	// Used to be a blocking wait, count the times the game thread would have stalled on it
+	if (!m_copyFence.IsFenceComplete())
+	{
+		m_pendingCopyCount++;
+		UE_LOG(EvercoastVoxelDecoderLog, VeryVerbose, TEXT("Previous video texture copy still in flight(%d so far), not waiting for it"), m_pendingCopyCount);
+	}
+
 	if (pResult->imgResult->IsValid())
 	{
 		// use webp image
@@ -120,7 +84,20 @@ void CortoLocalTextureFrame::UpdateTexture(const CortoWebpUnifiedDecodeResult* p
 		void* TextureData = Mip0.BulkData.Lock(LOCK_READ_WRITE);
 
 		const int32 PixelStride = (int32)(BitPerPixel / 8);
-		FMemory::Memcpy(TextureData, pResult->imgResult->RawTexelBuffer, SIZE_T(Width * Height * PixelStride));
+		const SIZE_T RowBytes = SIZE_T(Width * PixelStride);
+		const SIZE_T Pitch = SIZE_T(pResult->imgResult->Pitch);
+		if (Pitch == RowBytes)
+		{
+			FMemory::Memcpy(TextureData, pResult->imgResult->RawTexelBuffer, RowBytes * Height);
+		}
+		else
+		{
+			// Padded rows, mip data is tightly packed
+			for (int32 Row = 0; Row < Height; ++Row)
+			{
+				FMemory::Memcpy((uint8*)TextureData + RowBytes * Row, pResult->imgResult->RawTexelBuffer + Pitch * Row, RowBytes);
+			}
+		}
 
 		Mip0.BulkData.Unlock();
 
@@ -133,8 +110,6 @@ void CortoLocalTextureFrame::UpdateTexture(const CortoWebpUnifiedDecodeResult* p
 	{
 		// use video texture
 		auto pTexture = pResult->videoTextureResult;
-		auto copyPromise = MakeShared<TPromise<void>, ESPMode::ThreadSafe>();
-		auto future = copyPromise->GetFuture();
 
 		// getting ready to make a copy
 		int32 width = pTexture->GetSurfaceWidth();
@@ -152,7 +127,7 @@ void CortoLocalTextureFrame::UpdateTexture(const CortoWebpUnifiedDecodeResult* p
 		}
 
 		ENQUEUE_RENDER_COMMAND(CortoLocalTextureFrame_CopyTexture)(
-			[srcTex = pTexture, mainTex = m_localTexture, self = this, promise = copyPromise](FRHICommandListImmediate& RHICmdList)
+			[srcTex = pTexture, mainTex = m_localTexture](FRHICommandListImmediate& RHICmdList)
 			{
 				auto targetRHIRes = mainTex->GetResource();
 				auto srcRHIRes = srcTex->GetResource();
@@ -166,11 +141,11 @@ void CortoLocalTextureFrame::UpdateTexture(const CortoWebpUnifiedDecodeResult* p
 				RHICmdList.CopyTexture(srcTex->GetResource()->TextureRHI, mainTex->GetResource()->TextureRHI, FRHICopyTextureInfo());
 				RHICmdList.Transition(FRHITransitionInfo(targetRHI, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
 				RHICmdList.Transition(FRHITransitionInfo(srcRHI, ERHIAccess::CopySrc, ERHIAccess::SRVMask));
-
-				promise->SetValue();
 			});
 
-		future.Get();
+		// No need to wait: the video ring slot is only rewritten by render commands enqueued after this one,
+		// and anything drawing m_localTexture is enqueued after it too
+		m_copyFence.BeginFence();
 #if PLATFORM_ANDROID
 
 	if (IsAndroidOpenGLESPlatform(GMaxRHIShaderPlatform))
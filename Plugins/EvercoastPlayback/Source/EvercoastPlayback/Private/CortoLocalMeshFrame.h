@@ -1,11 +1,15 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include "CoreMinimal.h"
 #include "CortoDecoder.h"
 #include "UObject/GCObject.h"
 #include "Engine/Texture.h"
+#include "RenderingThread.h"
 
 struct CortoWebpUnifiedDecodeResult;
+// Read only view of a decoded mesh, shares the decoder's buffers instead of copying them. The decode result stays
+// alive and untouched for as long as a frame refers to it, see CortoWebpUnifiedDecodeResult::DetachSharedMesh()
 struct CortoLocalMeshFrame
 {
 	CortoLocalMeshFrame(const CortoWebpUnifiedDecodeResult* pResult);
@@ -21,13 +25,31 @@ struct CortoLocalMeshFrame
 		return m_vertexCount;
 	}
 
+	const uint32_t* GetIndexData() const
+	{
+		return m_mesh->IndexBuffer.data();
+	}
+
+	const FVector3f* GetPositionData() const
+	{
+		return m_mesh->PositionBuffer.data();
+	}
+
+	const FVector2f* GetUVData() const
+	{
+		return m_mesh->UVBuffer.data();
+	}
+
+	// optional
+	const FVector3f* GetNormalData() const
+	{
+		return m_mesh->HasNormals() ? m_mesh->NormalBuffer.data() : nullptr;
+	}
+
 	uint32_t m_vertexCount;
 	uint32_t m_triangleCount;
 
-	TArray<int32_t> m_indexBuffer; // should be uint32_t but UProceduralMeshComponent accepts only TArray<int32>
-	TArray<FVector3f> m_positionBuffer;
-	TArray<FVector2f> m_uvBuffer;
-	TArray<FVector3f> m_normalBuffer; // optional
+	std::shared_ptr<const CortoDecodeResult> m_mesh;
 
 	FBoxSphereBounds3f m_bounds;
 
@@ -43,6 +65,9 @@ class CortoLocalTextureFrame : public FGCObject
 	UTexture* m_localTexture;
 #endif
 	bool m_needsSwizzle;
+	// Signalled once the last video texture copy has run on the render thread
+	FRenderCommandFence m_copyFence;
+	int32 m_pendingCopyCount = 0;
 public:
 	CortoLocalTextureFrame(const CortoWebpUnifiedDecodeResult* pResult);
 	virtual ~CortoLocalTextureFrame();
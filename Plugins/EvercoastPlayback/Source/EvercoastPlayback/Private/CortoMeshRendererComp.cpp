@@ -30,6 +30,7 @@
 #include "RayTracingDefinitions.h"
 #include "RayTracingInstance.h"
 #endif
+#include <atomic>
 
 DEFINE_LOG_CATEGORY(EvercoastRendererLog);
 
@@ -236,8 +237,30 @@ public:
 		
 	}
 
+	// Only queues the update, the game thread never waits on the render thread here. Everything below runs in order
+	// with the other render commands touching this proxy, so there's nothing to fence against.
 	void SetMeshData(std::shared_ptr<CortoLocalMeshFrame> localMeshFrame)
 	{
+		MeshUpdatesInFlight.fetch_add(1, std::memory_order_relaxed);
+
+		ENQUEUE_RENDER_COMMAND(FEvercoastMeshDataUpdate)(
+			[this, meshFrame=std::move(localMeshFrame)](FRHICommandListImmediate& RHICmdList)
+			{
+				SetMeshData_RenderThread(meshFrame, RHICmdList);
+				MeshUpdatesInFlight.fetch_sub(1, std::memory_order_release);
+			});
+	}
+
+	// Updates queued by SetMeshData() the render thread hasn't applied yet
+	int32 GetMeshUpdatesInFlight() const
+	{
+		return MeshUpdatesInFlight.load(std::memory_order_acquire);
+	}
+
+	void SetMeshData_RenderThread(const std::shared_ptr<CortoLocalMeshFrame>& localMeshFrame, FRHICommandListImmediate& RHICmdList)
+	{
+		check(IsInRenderingThread());
+
 		const auto& meshFrame = *localMeshFrame;
 		int32_t newNumVerts = meshFrame.GetVertexCount();
 		int32_t newNumIndices = meshFrame.GetIndexCount();
@@ -249,37 +272,12 @@ public:
 		{
 			UE_LOG(EvercoastRendererLog, Warning, TEXT("Current mesh data exceeds soft limit, increase vertex and index buffer by 100%%. Requested vertices: %d Requested indices: %d"), newNumVerts, newNumIndices);
 
-            auto promise = MakeShared<TPromise<void>, ESPMode::ThreadSafe>();
-            auto future = promise->GetFuture();
-
-            ENQUEUE_RENDER_COMMAND(FEvercoastMeshDataReinit)(
-                [this, newNumVerts, newNumIndices, promise](FRHICommandListImmediate& RHICmdList)
-                {
-                    ReinitialiseBuffers_RenderThread(newNumVerts, newNumIndices);
-                    promise->SetValue();
-                });
-			
-            future.Get();
+			ReinitialiseBuffers_RenderThread(newNumVerts, newNumIndices);
 		}
 
-
-
-		bool hasNormal = meshFrame.m_normalBuffer.Num() == newNumVerts;
-
-		if (newNumIndices > 0)
-		{
-			int IndexTypeSize = IndexBuffer.Indices.GetTypeSize();
-			FMemory::Memcpy(IndexBuffer.Indices.GetData(), meshFrame.m_indexBuffer.GetData(), newNumIndices * IndexTypeSize);
-		}
-
-		if (newNumVerts > 0)
-		{
-			int PositionTypeSize = VertexBuffers.PositionVertexBuffer.GetStride();
-			FMemory::Memcpy(VertexBuffers.PositionVertexBuffer.GetVertexData(), meshFrame.m_positionBuffer.GetData(), newNumVerts * PositionTypeSize);
-
-			int TexcoordTypeSize = VertexBuffers.StaticMeshVertexBuffer.GetTexCoordSize() / VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords() / VertexBuffers.StaticMeshVertexBuffer.GetNumVertices();
-			FMemory::Memcpy(VertexBuffers.StaticMeshVertexBuffer.GetTexCoordData(), meshFrame.m_uvBuffer.GetData(), newNumVerts * TexcoordTypeSize);
-		}
+		// Indices, positions and uvs go from the frame straight into the locked RHI buffers in UploadMeshData_RenderThread()
+		const FVector3f* normals = meshFrame.GetNormalData();
+		bool hasNormal = normals != nullptr;
 
 		// Iterate through vertex data, copying in new tangents if vertex data contains normal
 		// Note this is different from bNormalRender
@@ -288,7 +286,7 @@ public:
 			for (int32 i = 0; i < newNumVerts; i++)
 			{
 				const auto TangentX = FPackedNormal(FVector3f(1.f, 0.f, 0.f));
-				FPackedNormal TangentZ = FPackedNormal(meshFrame.m_normalBuffer[i]);
+				FPackedNormal TangentZ = FPackedNormal(normals[i]);
 				TangentZ.Vector.W = 127;
 
 				const auto TangentY = FVector3f(GenerateYAxis(TangentX, TangentZ));	//LWC_TODO: Precision loss
@@ -307,38 +305,24 @@ public:
 			// Copy verts and indices
 			if (newNumVerts > 0)
 			{
-				const FVector3f* src = meshFrame.m_positionBuffer.GetData();
+				const FVector3f* src = meshFrame.GetPositionData();
 				NormalRender_PositionVertexBuffer->CopyVertices((FPositionOnlyVertex*)src, newNumVerts);
 			}
 
 			if (newNumIndices > 0)
 			{
-				check(NormalRender_IndexBuffer->Indices.GetTypeSize() == meshFrame.m_indexBuffer.GetTypeSize());
-				FMemory::Memcpy(NormalRender_IndexBuffer->Indices.GetData(), meshFrame.m_indexBuffer.GetData(), newNumIndices * NormalRender_IndexBuffer->Indices.GetTypeSize());
+				check(NormalRender_IndexBuffer->Indices.GetTypeSize() == sizeof(uint32_t));
+				FMemory::Memcpy(NormalRender_IndexBuffer->Indices.GetData(), meshFrame.GetIndexData(), newNumIndices * NormalRender_IndexBuffer->Indices.GetTypeSize());
 			}
 		}
 
-		
-
-		auto promise = MakeShared<TPromise<void>, ESPMode::ThreadSafe>();
-		auto future = promise->GetFuture();
+		UploadMeshData_RenderThread(localMeshFrame, newNumVerts, newNumIndices, RHICmdList);
+		RHICmdList.ImmediateFlush(EImmediateFlushType::DispatchToRHIThread);
 
-		ENQUEUE_RENDER_COMMAND(FEvercoastMeshDataUpdate)(
-			[this, meshFrame=localMeshFrame, newNumVerts, newNumIndices, promise](FRHICommandListImmediate& RHICmdList)
-			{
-				UploadMeshData_RenderThread(meshFrame, newNumVerts, newNumIndices, RHICmdList);
-				RHICmdList.ImmediateFlush(EImmediateFlushType::DispatchToRHIThread);
-
-				promise->SetValue();
-			});
-
-		future.Get();
-
-		// Update those numbers at last, as it will be used in parallel in GetDynamicMeshElements()
+		// Update those numbers at last, GetDynamicMeshElements() runs on this thread too and sees them with the buffers
 		NumVerts = newNumVerts;
 		NumIndices = newNumIndices;
 		NumTriangles = newNumTriangles;
-
 	}
 
 	/** Called on render thread to assign new dynamic data */
@@ -346,25 +330,26 @@ public:
 	{
 		check(IsInRenderingThread());
 
-		// linearize guaranteed by promise/future pair in SetMeshData()
+		// linearize guaranteed by render command order, see SetMeshData()
 
 		const auto& meshFrame = *localMeshFrame;
 
 		int IndexTypeSize = IndexBuffer.Indices.GetTypeSize();
 		int PositionTypeSize = VertexBuffers.PositionVertexBuffer.GetStride();
 		int TexcoordTypeSize = VertexBuffers.StaticMeshVertexBuffer.GetTexCoordSize() / VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords() / VertexBuffers.StaticMeshVertexBuffer.GetNumVertices();
+		// Frame data is copied as is, full precision uvs and float positions
+		check(IndexTypeSize == sizeof(uint32_t) && PositionTypeSize == sizeof(FVector3f) && TexcoordTypeSize == sizeof(FVector2f));
 
 #if ENGINE_MAJOR_VERSION == 5
 		if (newNumIndices > 0)
 		{
-			auto& srcIndexBuffer = IndexBuffer.Indices;
 #if ENGINE_MINOR_VERSION >= 3
 			void* dstIndexBuffer = RHICmdList.LockBuffer(IndexBuffer.IndexBufferRHI, 0, newNumIndices * IndexTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(dstIndexBuffer, srcIndexBuffer.GetData(), newNumIndices * IndexTypeSize);
+			FMemory::Memcpy(dstIndexBuffer, meshFrame.GetIndexData(), newNumIndices * IndexTypeSize);
 			RHICmdList.UnlockBuffer(IndexBuffer.IndexBufferRHI);
 #else
 			void* dstIndexBuffer = RHILockBuffer(IndexBuffer.IndexBufferRHI, 0, newNumIndices * IndexTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(dstIndexBuffer, srcIndexBuffer.GetData(), newNumIndices * IndexTypeSize);
+			FMemory::Memcpy(dstIndexBuffer, meshFrame.GetIndexData(), newNumIndices * IndexTypeSize);
 			RHIUnlockBuffer(IndexBuffer.IndexBufferRHI);
 #endif
 		}
@@ -374,11 +359,11 @@ public:
 			auto& VertexBuffer = VertexBuffers.PositionVertexBuffer;
 #if ENGINE_MINOR_VERSION >= 3
 			void* VertexBufferData = RHICmdList.LockBuffer(VertexBuffer.VertexBufferRHI, 0, newNumVerts * PositionTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetVertexData(), newNumVerts * PositionTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetPositionData(), newNumVerts * PositionTypeSize);
 			RHICmdList.UnlockBuffer(VertexBuffer.VertexBufferRHI);
 #else
 			void* VertexBufferData = RHILockBuffer(VertexBuffer.VertexBufferRHI, 0, newNumVerts * PositionTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetVertexData(), newNumVerts * PositionTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetPositionData(), newNumVerts * PositionTypeSize);
 			RHIUnlockBuffer(VertexBuffer.VertexBufferRHI);
 #endif
 		}
@@ -404,27 +389,26 @@ public:
 			auto& VertexBuffer = VertexBuffers.StaticMeshVertexBuffer;
 #if ENGINE_MINOR_VERSION >= 3
 			void* VertexBufferData = RHICmdList.LockBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI, 0, newNumVerts * TexcoordTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetTexCoordData(), newNumVerts * TexcoordTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetUVData(), newNumVerts * TexcoordTypeSize);
 			RHICmdList.UnlockBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI);
 #else
 			void* VertexBufferData = RHILockBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI, 0, newNumVerts * TexcoordTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetTexCoordData(), newNumVerts * TexcoordTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetUVData(), newNumVerts * TexcoordTypeSize);
 			RHIUnlockBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI);
 #endif
 		}
 #else
 		if (newNumIndices > 0)
 		{
-			auto& srcIndexBuffer = IndexBuffer.Indices;
 			void* dstIndexBuffer = RHILockIndexBuffer(IndexBuffer.IndexBufferRHI, 0, newNumIndices * IndexTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(dstIndexBuffer, srcIndexBuffer.GetData(), newNumIndices * IndexTypeSize);
+			FMemory::Memcpy(dstIndexBuffer, meshFrame.GetIndexData(), newNumIndices * IndexTypeSize);
 			RHIUnlockIndexBuffer(IndexBuffer.IndexBufferRHI);
 		}
 		if (newNumVerts > 0)
 		{
 			auto& VertexBuffer = VertexBuffers.PositionVertexBuffer;
 			void* VertexBufferData = RHILockVertexBuffer(VertexBuffer.VertexBufferRHI, 0, newNumVerts * PositionTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetVertexData(), newNumVerts * PositionTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetPositionData(), newNumVerts * PositionTypeSize);
 			RHIUnlockVertexBuffer(VertexBuffer.VertexBufferRHI);
 		}
 
@@ -448,7 +432,7 @@ public:
 		{
 			auto& VertexBuffer = VertexBuffers.StaticMeshVertexBuffer;
 			void* VertexBufferData = RHILockVertexBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI, 0, newNumVerts * TexcoordTypeSize, RLM_WriteOnly);
-			FMemory::Memcpy(VertexBufferData, VertexBuffer.GetTexCoordData(), newNumVerts * TexcoordTypeSize);
+			FMemory::Memcpy(VertexBufferData, meshFrame.GetUVData(), newNumVerts * TexcoordTypeSize);
 			RHIUnlockVertexBuffer(VertexBuffer.TexCoordVertexBuffer.VertexBufferRHI);
 		}
 #endif
@@ -873,6 +857,7 @@ private:
 	int32 NumVerts;
 	int32 NumIndices;
 	int32 NumTriangles;
+	std::atomic<int32> MeshUpdatesInFlight{ 0 };
 	/** Material applied to this section */
 	UMaterialInstanceDynamic* Material;
 	/** Vertex buffer for this section */
@@ -946,6 +931,12 @@ void UCortoMeshRendererComp::SetMeshData(std::shared_ptr<CortoLocalMeshFrame> lo
 	sceneProxy->SetMeshData(meshFrame);
 }
 
+int32 UCortoMeshRendererComp::GetMeshUpdatesInFlight() const
+{
+	const FCortoMeshSceneProxy* sceneProxy = (const FCortoMeshSceneProxy*)(this->SceneProxy);
+	return sceneProxy ? sceneProxy->GetMeshUpdatesInFlight() : 0;
+}
+
 void UCortoMeshRendererComp::SetCortoMeshMaterial(UMaterialInterface* pMaterial)
 {
 	if (CortoMeshMaterial != pMaterial)
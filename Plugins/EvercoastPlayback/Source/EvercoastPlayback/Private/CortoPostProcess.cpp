@@ -0,0 +1,331 @@
+#include "CortoPostProcess.h"
+#include <cmath>
+#include <limits>
+
+#if defined(PLATFORM_ENABLE_VECTORINTRINSICS_NEON) && PLATFORM_ENABLE_VECTORINTRINSICS_NEON && defined(__aarch64__)
+#define CORTO_POST_PROCESS_NEON 1
+#include <arm_neon.h>
+#elif defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1
+#define CORTO_POST_PROCESS_SSE 1
+#include <smmintrin.h>
+#endif
+
+#ifndef CORTO_POST_PROCESS_NEON
+#define CORTO_POST_PROCESS_NEON 0
+#endif
+#ifndef CORTO_POST_PROCESS_SSE
+#define CORTO_POST_PROCESS_SSE 0
+#endif
+
+namespace
+{
+	using CortoPostProcess::MeshBounds;
+
+	MeshBounds EmptyBounds()
+	{
+		const float inf = std::numeric_limits<float>::infinity();
+		return MeshBounds{ FVector3f(inf, inf, inf), FVector3f(-inf, -inf, -inf), false };
+	}
+
+	// Same operand order as _mm_min_ps/_mm_max_ps so the SIMD variants end up with identical bounds
+	inline float MinOf(float v, float m)
+	{
+		return v < m ? v : m;
+	}
+
+	inline float MaxOf(float v, float m)
+	{
+		return v > m ? v : m;
+	}
+
+	void CopyIndicesScalar(const uint32_t* in, uint32_t* out, uint32_t triangleCount, bool flipWinding)
+	{
+		if (!flipWinding)
+		{
+			if (out != in)
+				FMemory::Memcpy(out, in, sizeof(uint32_t) * 3 * triangleCount);
+			return;
+		}
+
+		// flip triangle index (0, 1, 2) to (0, 2, 1)
+		for (uint32_t i = 0; i < triangleCount; ++i)
+		{
+			const uint32_t i1 = in[i * 3 + 1];
+			const uint32_t i2 = in[i * 3 + 2];
+			out[i * 3 + 0] = in[i * 3 + 0];
+			out[i * 3 + 1] = i2;
+			out[i * 3 + 2] = i1;
+		}
+	}
+
+	void CopyPositionsScalar(const FVector3f* in, FVector3f* out, uint32_t count, float scale, MeshBounds& bounds)
+	{
+		// swap y<->z and scale
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const FVector3f src = in[i];
+			FVector3f& dst = out[i];
+			dst.X = src.X * scale;
+			dst.Y = src.Z * scale;
+			dst.Z = src.Y * scale;
+
+			bounds.bHasNaN |= std::isnan(dst.X) || std::isnan(dst.Y) || std::isnan(dst.Z);
+			bounds.Min.X = MinOf(dst.X, bounds.Min.X);
+			bounds.Min.Y = MinOf(dst.Y, bounds.Min.Y);
+			bounds.Min.Z = MinOf(dst.Z, bounds.Min.Z);
+			bounds.Max.X = MaxOf(dst.X, bounds.Max.X);
+			bounds.Max.Y = MaxOf(dst.Y, bounds.Max.Y);
+			bounds.Max.Z = MaxOf(dst.Z, bounds.Max.Z);
+		}
+	}
+
+	void CopyNormalsScalar(const FVector3f* in, FVector3f* out, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const FVector3f src = in[i];
+			out[i].X = src.X;
+			out[i].Y = src.Z;
+			out[i].Z = src.Y;
+		}
+	}
+
+	MeshBounds FinishBounds(MeshBounds bounds, uint32_t vertexCount)
+	{
+		if (vertexCount == 0)
+		{
+			bounds.Min = FVector3f::ZeroVector;
+			bounds.Max = FVector3f::ZeroVector;
+		}
+		// Which of +0/-0 survives a min/max depends on operand order, which differs between the kernels; fold to +0
+		bounds.Min = FVector3f(bounds.Min.X + 0.0f, bounds.Min.Y + 0.0f, bounds.Min.Z + 0.0f);
+		bounds.Max = FVector3f(bounds.Max.X + 0.0f, bounds.Max.Y + 0.0f, bounds.Max.Z + 0.0f);
+		return bounds;
+	}
+
+#if CORTO_POST_PROCESS_SSE
+	// 4 triples loaded as 3 registers: [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3]
+	// come out as [x0 z0 y0 x1] [z1 y1 x2 z2] [y2 x3 z3 y3]
+	inline void SwapYZ(__m128 a, __m128 b, __m128 c, __m128& o0, __m128& o1, __m128& o2)
+	{
+		o0 = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 2, 0));
+		o1 = _mm_blend_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 2, 0, 1)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0)), 0x8);
+		o2 = _mm_blend_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 3, 1, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3)), 0x1);
+	}
+
+	uint32_t CopyIndicesSIMD(const uint32_t* in, uint32_t* out, uint32_t triangleCount)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= triangleCount; i += 4)
+		{
+			const float* src = (const float*)(in + i * 3);
+			float* dst = (float*)(out + i * 3);
+			__m128 o0, o1, o2;
+			SwapYZ(_mm_loadu_ps(src), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8), o0, o1, o2);
+			_mm_storeu_ps(dst, o0);
+			_mm_storeu_ps(dst + 4, o1);
+			_mm_storeu_ps(dst + 8, o2);
+		}
+		return i;
+	}
+
+	uint32_t CopyPositionsSIMD(const FVector3f* in, FVector3f* out, uint32_t count, float scale, MeshBounds& bounds)
+	{
+		const __m128 scaleV = _mm_set1_ps(scale);
+		const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+		// Lanes hold X Y Z X, Y Z X Y and Z X Y Z respectively
+		__m128 min0 = inf, min1 = inf, min2 = inf;
+		__m128 max0 = _mm_sub_ps(_mm_setzero_ps(), inf), max1 = max0, max2 = max0;
+		__m128 nan = _mm_setzero_ps();
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* src = (const float*)(in + i);
+			float* dst = (float*)(out + i);
+			__m128 o0, o1, o2;
+			SwapYZ(_mm_loadu_ps(src), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8), o0, o1, o2);
+			o0 = _mm_mul_ps(o0, scaleV);
+			o1 = _mm_mul_ps(o1, scaleV);
+			o2 = _mm_mul_ps(o2, scaleV);
+			_mm_storeu_ps(dst, o0);
+			_mm_storeu_ps(dst + 4, o1);
+			_mm_storeu_ps(dst + 8, o2);
+
+			min0 = _mm_min_ps(o0, min0);
+			min1 = _mm_min_ps(o1, min1);
+			min2 = _mm_min_ps(o2, min2);
+			max0 = _mm_max_ps(o0, max0);
+			max1 = _mm_max_ps(o1, max1);
+			max2 = _mm_max_ps(o2, max2);
+			nan = _mm_or_ps(nan, _mm_or_ps(_mm_cmpunord_ps(o0, o0), _mm_or_ps(_mm_cmpunord_ps(o1, o1), _mm_cmpunord_ps(o2, o2))));
+		}
+
+		if (i > 0)
+		{
+			// First and last lane of each hold the same component, fold them together
+			min0 = _mm_min_ps(min0, _mm_shuffle_ps(min0, min0, _MM_SHUFFLE(3, 2, 1, 3)));
+			min1 = _mm_min_ps(min1, _mm_shuffle_ps(min1, min1, _MM_SHUFFLE(3, 2, 1, 3)));
+			min2 = _mm_min_ps(min2, _mm_shuffle_ps(min2, min2, _MM_SHUFFLE(3, 2, 1, 3)));
+			max0 = _mm_max_ps(max0, _mm_shuffle_ps(max0, max0, _MM_SHUFFLE(3, 2, 1, 3)));
+			max1 = _mm_max_ps(max1, _mm_shuffle_ps(max1, max1, _MM_SHUFFLE(3, 2, 1, 3)));
+			max2 = _mm_max_ps(max2, _mm_shuffle_ps(max2, max2, _MM_SHUFFLE(3, 2, 1, 3)));
+
+			// Then line all three up as X Y Z X
+			const __m128 minV = _mm_min_ps(min0, _mm_min_ps(_mm_shuffle_ps(min1, min1, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(min2, min2, _MM_SHUFFLE(1, 0, 2, 1))));
+			const __m128 maxV = _mm_max_ps(max0, _mm_max_ps(_mm_shuffle_ps(max1, max1, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(max2, max2, _MM_SHUFFLE(1, 0, 2, 1))));
+			alignas(16) float minLanes[4];
+			alignas(16) float maxLanes[4];
+			_mm_store_ps(minLanes, minV);
+			_mm_store_ps(maxLanes, maxV);
+
+			bounds.Min = FVector3f(minLanes[0], minLanes[1], minLanes[2]);
+			bounds.Max = FVector3f(maxLanes[0], maxLanes[1], maxLanes[2]);
+			bounds.bHasNaN = _mm_movemask_ps(nan) != 0;
+		}
+		return i;
+	}
+
+	uint32_t CopyNormalsSIMD(const FVector3f* in, FVector3f* out, uint32_t count)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* src = (const float*)(in + i);
+			float* dst = (float*)(out + i);
+			__m128 o0, o1, o2;
+			SwapYZ(_mm_loadu_ps(src), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8), o0, o1, o2);
+			_mm_storeu_ps(dst, o0);
+			_mm_storeu_ps(dst + 4, o1);
+			_mm_storeu_ps(dst + 8, o2);
+		}
+		return i;
+	}
+#elif CORTO_POST_PROCESS_NEON
+	uint32_t CopyIndicesSIMD(const uint32_t* in, uint32_t* out, uint32_t triangleCount)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= triangleCount; i += 4)
+		{
+			uint32x4x3_t v = vld3q_u32(in + i * 3);
+			const uint32x4_t t = v.val[1];
+			v.val[1] = v.val[2];
+			v.val[2] = t;
+			vst3q_u32(out + i * 3, v);
+		}
+		return i;
+	}
+
+	uint32_t CopyPositionsSIMD(const FVector3f* in, FVector3f* out, uint32_t count, float scale, MeshBounds& bounds)
+	{
+		const float inf = std::numeric_limits<float>::infinity();
+		float32x4_t minX = vdupq_n_f32(inf), minY = minX, minZ = minX;
+		float32x4_t maxX = vdupq_n_f32(-inf), maxY = maxX, maxZ = maxX;
+		uint32x4_t notNaN = vdupq_n_u32(0xffffffff);
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float32x4x3_t v = vld3q_f32((const float*)(in + i));
+			float32x4x3_t o;
+			o.val[0] = vmulq_n_f32(v.val[0], scale);
+			o.val[1] = vmulq_n_f32(v.val[2], scale);
+			o.val[2] = vmulq_n_f32(v.val[1], scale);
+			vst3q_f32((float*)(out + i), o);
+
+			// Compare and select rather than vminq/vmaxq to keep the scalar operand order
+			minX = vbslq_f32(vcltq_f32(o.val[0], minX), o.val[0], minX);
+			minY = vbslq_f32(vcltq_f32(o.val[1], minY), o.val[1], minY);
+			minZ = vbslq_f32(vcltq_f32(o.val[2], minZ), o.val[2], minZ);
+			maxX = vbslq_f32(vcgtq_f32(o.val[0], maxX), o.val[0], maxX);
+			maxY = vbslq_f32(vcgtq_f32(o.val[1], maxY), o.val[1], maxY);
+			maxZ = vbslq_f32(vcgtq_f32(o.val[2], maxZ), o.val[2], maxZ);
+			notNaN = vandq_u32(notNaN, vandq_u32(vceqq_f32(o.val[0], o.val[0]), vandq_u32(vceqq_f32(o.val[1], o.val[1]), vceqq_f32(o.val[2], o.val[2]))));
+		}
+
+		if (i > 0)
+		{
+			bounds.Min = FVector3f(vminvq_f32(minX), vminvq_f32(minY), vminvq_f32(minZ));
+			bounds.Max = FVector3f(vmaxvq_f32(maxX), vmaxvq_f32(maxY), vmaxvq_f32(maxZ));
+			bounds.bHasNaN = vminvq_u32(notNaN) == 0;
+		}
+		return i;
+	}
+
+	uint32_t CopyNormalsSIMD(const FVector3f* in, FVector3f* out, uint32_t count)
+	{
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			float32x4x3_t v = vld3q_f32((const float*)(in + i));
+			const float32x4_t t = v.val[1];
+			v.val[1] = v.val[2];
+			v.val[2] = t;
+			vst3q_f32((float*)(out + i), v);
+		}
+		return i;
+	}
+#endif
+}
+
+namespace CortoPostProcess
+{
+
+const TCHAR* GetKernelName()
+{
+#if CORTO_POST_PROCESS_SSE
+	return TEXT("SSE4.1");
+#elif CORTO_POST_PROCESS_NEON
+	return TEXT("NEON");
+#else
+	return TEXT("Scalar");
+#endif
+}
+
+MeshBounds Process(const uint32_t* inIndices, uint32_t* outIndices, uint32_t triangleCount, bool flipWinding,
+	const FVector3f* inPositions, FVector3f* outPositions, const FVector3f* inNormals, FVector3f* outNormals, uint32_t vertexCount, float positionScale)
+{
+#if CORTO_POST_PROCESS_SSE || CORTO_POST_PROCESS_NEON
+	MeshBounds bounds = EmptyBounds();
+
+	if (flipWinding)
+	{
+		const uint32_t done = CopyIndicesSIMD(inIndices, outIndices, triangleCount);
+		CopyIndicesScalar(inIndices + done * 3, outIndices + done * 3, triangleCount - done, true);
+	}
+	else
+	{
+		CopyIndicesScalar(inIndices, outIndices, triangleCount, false);
+	}
+
+	const uint32_t positionsDone = CopyPositionsSIMD(inPositions, outPositions, vertexCount, positionScale, bounds);
+	CopyPositionsScalar(inPositions + positionsDone, outPositions + positionsDone, vertexCount - positionsDone, positionScale, bounds);
+
+	if (inNormals)
+	{
+		const uint32_t normalsDone = CopyNormalsSIMD(inNormals, outNormals, vertexCount);
+		CopyNormalsScalar(inNormals + normalsDone, outNormals + normalsDone, vertexCount - normalsDone);
+	}
+
+	return FinishBounds(bounds, vertexCount);
+#else
+	return ProcessScalar(inIndices, outIndices, triangleCount, flipWinding, inPositions, outPositions, inNormals, outNormals, vertexCount, positionScale);
+#endif
+}
+
+MeshBounds ProcessScalar(const uint32_t* inIndices, uint32_t* outIndices, uint32_t triangleCount, bool flipWinding,
+	const FVector3f* inPositions, FVector3f* outPositions, const FVector3f* inNormals, FVector3f* outNormals, uint32_t vertexCount, float positionScale)
+{
+	MeshBounds bounds = EmptyBounds();
+
+	CopyIndicesScalar(inIndices, outIndices, triangleCount, flipWinding);
+	CopyPositionsScalar(inPositions, outPositions, vertexCount, positionScale, bounds);
+	if (inNormals)
+	{
+		CopyNormalsScalar(inNormals, outNormals, vertexCount);
+	}
+
+	return FinishBounds(bounds, vertexCount);
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include "CoreMinimal.h"
+#include "UnrealEngineCompatibility.h"
+
+// Brings a decoded Corto mesh to engine space in a single pass per stream: triangle winding flip, y<->z swap and unit
+// scale of positions, y<->z swap of normals, and the bounds of the output positions. Input and output may be the same
+// buffers. SSE4.1 or NEON variant picked at compile time, the scalar one is the reference they match bit for bit.
+namespace CortoPostProcess
+{
+	struct MeshBounds
+	{
+		FVector3f Min;
+		FVector3f Max;
+		bool bHasNaN;
+	};
+
+	// Name of the kernel set compiled in, for logging
+	const TCHAR* GetKernelName();
+
+	// Indices flipped from (0, 1, 2) to (0, 2, 1) when flipWinding, normals are optional
+	MeshBounds Process(const uint32_t* inIndices, uint32_t* outIndices, uint32_t triangleCount, bool flipWinding,
+		const FVector3f* inPositions, FVector3f* outPositions, const FVector3f* inNormals, FVector3f* outNormals, uint32_t vertexCount, float positionScale);
+
+	MeshBounds ProcessScalar(const uint32_t* inIndices, uint32_t* outIndices, uint32_t triangleCount, bool flipWinding,
+		const FVector3f* inPositions, FVector3f* outPositions, const FVector3f* inNormals, FVector3f* outNormals, uint32_t vertexCount, float positionScale);
+}
@@ -45,13 +45,36 @@ struct CortoWebpUnifiedDecodeResult : public GenericDecodeResult
 
 	}
 
+	// Renderers keep the mesh of the frame they show without copying it. If that's still the case when this result
+	// gets reused, leave that mesh to them and decode into a new one, so meshes handed out stay immutable
+	void DetachSharedMesh()
+	{
+		if (meshResult.use_count() > 1)
+		{
+			meshResult = std::make_shared<CortoDecodeResult>(meshResult->VertexReserved, meshResult->TriangleReserved);
+		}
+	}
+
 	void InvalidateResult()
 	{
+		GenericDecodeResult::InvalidateResult();
 		meshResult->InvalidateResult();
 		imgResult->InvalidateResult();
 		videoTextureResult = nullptr;
 	}
 
+	// Memory held by the mesh and image buffers, for pool accounting
+	size_t GetAllocatedBytes() const
+	{
+		size_t bytes = meshResult->IndexBuffer.capacity() * sizeof(uint32_t) +
+			meshResult->PositionBuffer.capacity() * sizeof(FVector3f) +
+			meshResult->UVBuffer.capacity() * sizeof(FVector2f) +
+			meshResult->NormalBuffer.capacity() * sizeof(FVector3f);
+
+		bytes += imgResult->TexelCapacity;
+		return bytes;
+	}
+
 	virtual DecodeResultType GetType() const
 	{
 		return DecodeResultType::DRT_CortoMesh_WebpImage_Unified;
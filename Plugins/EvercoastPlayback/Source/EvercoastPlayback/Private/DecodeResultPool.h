@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "CoreMinimal.h"
+#include "Containers/LockFreeList.h"
+
+// Recycles heavy decode results(e.g. CortoWebpUnifiedDecodeResult) instead of allocating one per frame.
+// Acquire() hands out a shared_ptr whose deleter pushes the object back to the free list once the last reference,
+// in the result cache, the presorter or a renderer, is released. Objects keep their buffers so they stay sized to
+// the high-water mark of the content. Push/pop go through the engine's lock-free list, so decode threads and the
+// game thread releasing results never contend on a lock. Results outliving the pool are simply deleted.
+// T is expected to provide InvalidateResult() and GetAllocatedBytes().
+template<typename T>
+class DecodeResultPool : public std::enable_shared_from_this<DecodeResultPool<T>>
+{
+public:
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t bytesHeld;	// by the idle objects in the free list
+		int32_t idleCount;
+	};
+
+	// Pool is always shared so outstanding results can tell whether it's still around
+	static std::shared_ptr<DecodeResultPool<T>> Create(int32_t maxIdleCount, std::function<T*()> factory)
+	{
+		return std::shared_ptr<DecodeResultPool<T>>(new DecodeResultPool<T>(maxIdleCount, std::move(factory)));
+	}
+
+	~DecodeResultPool()
+	{
+		while (T* object = m_freeList.Pop())
+		{
+			delete object;
+		}
+	}
+
+	std::shared_ptr<T> Acquire()
+	{
+		T* object = m_freeList.Pop();
+		if (object)
+		{
+			m_idleCount.fetch_sub(1, std::memory_order_relaxed);
+			m_bytesHeld.fetch_sub(object->GetAllocatedBytes(), std::memory_order_relaxed);
+			m_hits.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			object = m_factory();
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::weak_ptr<DecodeResultPool<T>> weakPool = this->shared_from_this();
+		return std::shared_ptr<T>(object, [weakPool](T* released)
+			{
+				if (auto pool = weakPool.lock())
+				{
+					pool->Recycle(released);
+				}
+				else
+				{
+					delete released;
+				}
+			});
+	}
+
+	Stats GetStats() const
+	{
+		Stats stats;
+		stats.hits = m_hits.load(std::memory_order_relaxed);
+		stats.misses = m_misses.load(std::memory_order_relaxed);
+		stats.bytesHeld = m_bytesHeld.load(std::memory_order_relaxed);
+		stats.idleCount = m_idleCount.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+private:
+	DecodeResultPool(int32_t maxIdleCount, std::function<T*()> factory) :
+		m_factory(std::move(factory)), m_maxIdleCount(maxIdleCount),
+		m_idleCount(0), m_hits(0), m_misses(0), m_bytesHeld(0)
+	{
+	}
+
+	DecodeResultPool(const DecodeResultPool&) = delete;
+	DecodeResultPool& operator=(const DecodeResultPool&) = delete;
+
+	void Recycle(T* object)
+	{
+		// Over the limit, e.g. a burst after a resize, let the heap have it back
+		if (m_idleCount.fetch_add(1, std::memory_order_relaxed) >= m_maxIdleCount)
+		{
+			m_idleCount.fetch_sub(1, std::memory_order_relaxed);
+			delete object;
+			return;
+		}
+
+		object->InvalidateResult();
+		m_bytesHeld.fetch_add(object->GetAllocatedBytes(), std::memory_order_relaxed);
+		m_freeList.Push(object);
+	}
+
+	TLockFreePointerListUnordered<T, PLATFORM_CACHE_LINE_SIZE> m_freeList;
+	std::function<T*()> m_factory;
+	const int32_t m_maxIdleCount;
+
+	std::atomic<int32_t> m_idleCount;
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_bytesHeld;
+};
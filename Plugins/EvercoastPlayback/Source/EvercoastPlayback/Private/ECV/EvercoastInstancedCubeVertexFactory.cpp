@@ -6,6 +6,7 @@
 #include "EvercoastVoxelSceneProxy.h"
 #include "EvercoastVoxelDecoder.h"
 #include "EvercoastLocalVoxelFrame.h"
+#include "VoxelCompactPacking.h"
 #include "MaterialShared.h"
 #if ENGINE_MAJOR_VERSION == 5
 #if ENGINE_MINOR_VERSION >= 2
@@ -258,6 +259,19 @@ void FEvercoastInstancedCubeVertexFactory::SetInstancingData(std::shared_ptr<Eve
 	{
 		uint32_t voxelCount = std::min(VOXEL_COUNT_LIMIT, m_voxelFrame->m_voxelCount);
 		uint32_t stride = 0;
+		if (m_voxelFrame->m_compact)
+		{
+			// The cube shaders read the decoder layout, expand straight into both textures in the pass that would copy them
+			void* LockedPositions = RHILockTexture2D(m_positionsTex, 0, EResourceLockMode::RLM_WriteOnly, stride, false);
+			check(stride == 2048 * DECODER_POSITION_ELEMENT_SIZE);
+			void* LockedColours = RHILockTexture2D(m_coloursTex, 0, EResourceLockMode::RLM_WriteOnly, stride, false);
+			check(stride == 2048 * DECODER_COLOUR_ELEMENT_SIZE);
+			VoxelCompactPacking::Unpack(m_voxelFrame->m_positionData, (uint16_t*)LockedPositions, (uint8_t*)LockedColours, voxelCount);
+			RHIUnlockTexture2D(m_coloursTex, 0, false);
+			RHIUnlockTexture2D(m_positionsTex, 0, false);
+			return;
+		}
+
 		void* LockedTexData = RHILockTexture2D(m_positionsTex, 0, EResourceLockMode::RLM_WriteOnly, stride, false);
 		check(stride == 2048 * DECODER_POSITION_ELEMENT_SIZE);
 		FMemory::Memcpy(LockedTexData, 
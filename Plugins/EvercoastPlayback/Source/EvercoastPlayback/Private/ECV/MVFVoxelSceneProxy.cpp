@@ -153,11 +153,15 @@ void FMVFVoxelSceneProxy::SetVoxelData_RenderThread(FRHICommandListBase& RHICmdL
 
 	if (VoxelFrame->m_voxelCount > 0) {
 		const auto voxelCount = std::min(VoxelFrame->m_voxelCount, MAX_VOXELS);
+		// Compact elements have the same stride as the coordinates and carry the colour, nothing else to upload
 		VoxelPositionVertexBuffer.Update(RHICmdList, VoxelFrame->m_positionData, voxelCount);
-		VoxelColorVertexBuffer.Update(RHICmdList, VoxelFrame->m_colourData, voxelCount);
+		if (!VoxelFrame->m_compact)
+		{
+			VoxelColorVertexBuffer.Update(RHICmdList, VoxelFrame->m_colourData, voxelCount);
+		}
 		VoxelIndexBuffer.SetNumPoints(voxelCount);
 		const auto Rescale = (1.0f / ((1 << VoxelFrame->m_bitsPerVoxel) - 1)) * VoxelFrame->m_boundsDim;
-		VoxelVertexFactory.SetParameters(VoxelFrame->m_boundsMin * 100.0f, Rescale * 100.0f);
+		VoxelVertexFactory.SetParameters(VoxelFrame->m_boundsMin * 100.0f, Rescale * 100.0f, VoxelFrame->m_compact);
 	}
 }
 
@@ -28,6 +28,7 @@ public:
 	{
 		BoundsMin.Bind(ParameterMap, TEXT("BoundsMin"));
 		BoundsDim.Bind(ParameterMap, TEXT("BoundsDim"));
+		CompactVoxels.Bind(ParameterMap, TEXT("CompactVoxels"));
 	}
 
 	void GetElementShaderBindings(
@@ -47,11 +48,13 @@ public:
 
 		ShaderBindings.Add(BoundsMin, VertexFactory->GetBoundsMin());
 		ShaderBindings.Add(BoundsDim, VertexFactory->GetBoundsDim());
+		ShaderBindings.Add(CompactVoxels, VertexFactory->GetCompactVoxels());
 	}
 
 private:
 	LAYOUT_FIELD(FShaderParameter, BoundsMin);
 	LAYOUT_FIELD(FShaderParameter, BoundsDim);
+	LAYOUT_FIELD(FShaderParameter, CompactVoxels);
 };
 
 /**
@@ -175,10 +178,11 @@ void FMVFVoxelVertexFactory::SetParameters(const FMVFVoxelVertexFactoryParameter
 	UniformBuffer = FMVFVoxelVertexFactoryBufferRef::CreateUniformBufferImmediate(InUniformParameters, UniformBuffer_MultiFrame);
 }
 
-void FMVFVoxelVertexFactory::SetParameters(const FVector3f& InBoundsMin, const float InBoundsDim)
+void FMVFVoxelVertexFactory::SetParameters(const FVector3f& InBoundsMin, const float InBoundsDim, bool bInCompactVoxels)
 {
 	BoundsMin = InBoundsMin;
 	BoundsDim = InBoundsDim;
+	CompactVoxels = bInCompactVoxels ? 1 : 0;
 }
 
 IMPLEMENT_TYPE_LAYOUT(FMVFVoxelVertexFactoryShaderParameters);
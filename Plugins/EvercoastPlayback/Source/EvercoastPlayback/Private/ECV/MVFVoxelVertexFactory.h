@@ -59,7 +59,7 @@ public:
 	 * Set parameters for this vertex factory instance.
 	 */
 	void SetParameters(const FMVFVoxelVertexFactoryParameters& InUniformParameters);
-	void SetParameters(const FVector3f& InBoundsMin, const float InBoundsDim);
+	void SetParameters(const FVector3f& InBoundsMin, const float InBoundsDim, bool bInCompactVoxels);
 
 	inline const FUniformBufferRHIRef GetVoxelVertexFactoryUniformBuffer() const
 	{
@@ -76,10 +76,17 @@ public:
 		return BoundsDim;
 	}
 
+	inline const uint32& GetCompactVoxels() const
+	{
+		return CompactVoxels;
+	}
+
 private:
 	/** Buffers to read from */
 	FUniformBufferRHIRef UniformBuffer;
 
 	FVector3f BoundsMin;
 	float BoundsDim;
+	// Non zero when the position buffer holds VoxelCompactPacking elements
+	uint32 CompactVoxels = 0;
 };
@@ -6,6 +6,7 @@
 #include "CortoDecoder.h"
 #include "WebpDecoder.h"
 #include "CortoWebpUnifiedDecodeResult.h"
+#include "DecodeResultPool.h"
 #include "Gaussian/EvercoastGaussianSplatDecoder.h"
 #include "Gaussian/EvercoastGaussianSplatPassthroughResult.h"
 #include "HAL/Runnable.h"
@@ -15,11 +16,15 @@
 #include <chrono>
 #include <queue>
 #include <list>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
 
 EvercoastAsyncStreamingDataDecoder::ResultCache::ResultCache(int initialBufferCount) :
 	m_resultStartIdx(0),
 	m_resultEndIdx(0),
-	m_bufferCount(initialBufferCount)
+	m_bufferCount(initialBufferCount),
+	m_frameInterval(0)
 {
 	m_resultArray = new std::shared_ptr<GenericDecodeResult>[initialBufferCount];
 }
@@ -28,6 +33,8 @@ void EvercoastAsyncStreamingDataDecoder::ResultCache::Dispose()
 {
 	std::lock_guard<std::recursive_mutex> guard(m_mutex);
 
+	ClearIndex();
+
 	if (m_resultArray)
 	{
 		for (int i = 0; i < m_bufferCount; ++i)
@@ -52,7 +59,7 @@ void EvercoastAsyncStreamingDataDecoder::ResultCache::DisposeAndReinit()
 	m_resultArray = new std::shared_ptr<GenericDecodeResult>[m_bufferCount];
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultCache::Resize(uint32_t bufferCount)
+void EvercoastAsyncStreamingDataDecoder::ResultCache::Resize(uint32_t bufferCount, double frameInterval)
 {
 	Dispose();
 
@@ -63,6 +70,14 @@ void EvercoastAsyncStreamingDataDecoder::ResultCache::Resize(uint32_t bufferCoun
 
 	m_resultStartIdx = 0;
 	m_resultEndIdx = 0;
+
+	std::unique_lock<std::shared_mutex> indexGuard(m_indexLock);
+	m_frameInterval = frameInterval;
+	size_t directIndexSize = 1;
+	while (directIndexSize < (size_t)bufferCount * 2)
+		directIndexSize <<= 1;
+	m_directIndex.assign(frameInterval > 0 ? directIndexSize : 0, IndexSlot());
+	m_sortedIndex.reserve(bufferCount);
 }
 
 void EvercoastAsyncStreamingDataDecoder::ResultCache::Add(std::shared_ptr<GenericDecodeResult> result)
@@ -76,63 +91,92 @@ void EvercoastAsyncStreamingDataDecoder::ResultCache::Add(std::shared_ptr<Generi
 
 	m_resultArray[m_resultEndIdx] = result;
 	m_resultEndIdx = (m_resultEndIdx + 1) % m_bufferCount;
-}
-
-std::shared_ptr<GenericDecodeResult> EvercoastAsyncStreamingDataDecoder::ResultCache::Prealloc()
-{
-	// no lock, requires a full Lock() beforehand
 
-	auto result = m_resultArray[m_resultEndIdx];
-	if (result)
+	if (m_resultEndIdx == m_resultStartIdx)
 	{
-		result->InvalidateResult(); // free memory if used before
+		// Overflown, the ring reads as empty now
+		ClearIndex();
 	}
+	else
+	{
+		IndexAdd(result);
+	}
+}
 
-	m_resultEndIdx = (m_resultEndIdx + 1) % m_bufferCount;
-
-	return result;
+int64_t EvercoastAsyncStreamingDataDecoder::ResultCache::FrameKey(double timestamp) const
+{
+	return (int64_t)std::floor(timestamp / m_frameInterval + 0.5);
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultCache::FillLastPrealloc(std::shared_ptr<GenericDecodeResult> newCacheObj)
+void EvercoastAsyncStreamingDataDecoder::ResultCache::IndexAdd(const std::shared_ptr<GenericDecodeResult>& result)
 {
-	// no lock, requires a full Lock() beforehand
+	if (!result)
+		return;
 
-	int lastEndIdx = m_resultEndIdx - 1;
-	if (lastEndIdx < 0)
-	{
-		lastEndIdx += m_bufferCount;
-	}
+	IndexSlot slot;
+	slot.timestamp = result->frameTimestamp;
+	slot.result = result;
 
-	if (m_resultArray[lastEndIdx])
+	std::unique_lock<std::shared_mutex> indexGuard(m_indexLock);
+	if (!m_directIndex.empty())
 	{
-		m_resultArray[lastEndIdx]->InvalidateResult();
+		slot.key = FrameKey(slot.timestamp);
+		m_directIndex[(size_t)slot.key & (m_directIndex.size() - 1)] = slot;
 	}
 
-	m_resultArray[lastEndIdx] = newCacheObj;
+	// Results mostly arrive in ascending order, so this is usually an append
+	auto it = std::upper_bound(m_sortedIndex.begin(), m_sortedIndex.end(), slot.timestamp, [](double timestamp, const IndexSlot& other) {
+		return timestamp < other.timestamp;
+		});
+	m_sortedIndex.insert(it, std::move(slot));
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultCache::Lock()
+void EvercoastAsyncStreamingDataDecoder::ResultCache::ClearIndex()
 {
-	m_mutex.lock();
+	std::unique_lock<std::shared_mutex> indexGuard(m_indexLock);
+	for (auto& slot : m_directIndex)
+	{
+		slot = IndexSlot();
+	}
+	m_sortedIndex.clear();
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultCache::Unlock()
+void EvercoastAsyncStreamingDataDecoder::ResultCache::RebuildIndex()
 {
-	m_mutex.unlock();
+	ClearIndex();
+
+	if (!m_resultArray)
+		return;
+
+	for (int i = m_resultStartIdx; i != m_resultEndIdx; i = (i + 1) % m_bufferCount)
+	{
+		IndexAdd(m_resultArray[i]);
+	}
 }
 
 std::shared_ptr<GenericDecodeResult> EvercoastAsyncStreamingDataDecoder::ResultCache::Query(double timestamp, double halfFrameInterval)
 {
-	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+	std::shared_lock<std::shared_mutex> indexGuard(m_indexLock);
 
-	for (int i = m_resultStartIdx; i != m_resultEndIdx; i = (i + 1) % m_bufferCount)
+	if (!m_directIndex.empty())
 	{
-		if (abs(m_resultArray[i]->frameTimestamp - timestamp) <= halfFrameInterval)
+		const int64_t key = FrameKey(timestamp);
+		const IndexSlot& slot = m_directIndex[(size_t)key & (m_directIndex.size() - 1)];
+		if (slot.key == key && abs(slot.timestamp - timestamp) <= halfFrameInterval)
 		{
-			return m_resultArray[i];
+			return slot.result;
 		}
 	}
 
+	// First result within reach of the timestamp
+	auto it = std::lower_bound(m_sortedIndex.begin(), m_sortedIndex.end(), timestamp - halfFrameInterval, [](const IndexSlot& slot, double timestamp) {
+		return slot.timestamp < timestamp;
+		});
+	if (it != m_sortedIndex.end() && it->timestamp <= timestamp + halfFrameInterval)
+	{
+		return it->result;
+	}
+
 	return nullptr;
 }
 
@@ -189,11 +233,21 @@ bool EvercoastAsyncStreamingDataDecoder::ResultCache::IsGoingToBeFull(int future
 }
 
 
+void EvercoastAsyncStreamingDataDecoder::ResultCache::Release(int fromIdx, int toIdx)
+{
+	for (int i = fromIdx; i != toIdx; i = (i + 1) % m_bufferCount)
+	{
+		m_resultArray[i].reset();
+	}
+}
+
 bool EvercoastAsyncStreamingDataDecoder::ResultCache::Trim(double medianTimestamp, double halfFrameInterval, int halfCacheWidth)
 {
 	bool trimmed = false;
 	// halfFrameInterval == 0.5 / content_sample_rate
 	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+	const int oldStartIdx = m_resultStartIdx;
+	const int oldEndIdx = m_resultEndIdx;
 
 	// find median
 	int medianIdx = -1;
@@ -294,6 +348,11 @@ bool EvercoastAsyncStreamingDataDecoder::ResultCache::Trim(double medianTimestam
 		UE_LOG(EvercoastVoxelDecoderLog, VeryVerbose, TEXT("Geom Trimmed: median: %.2f head(%d): %.2f -> tail(%d): %.2f"), medianTimestamp, 
 			m_resultStartIdx, m_resultArray[m_resultStartIdx]->frameTimestamp, 
 			m_resultEndIdx, m_resultEndIdx == 0 ? m_resultArray[m_bufferCount-1]->frameTimestamp : m_resultArray[m_resultEndIdx-1]->frameTimestamp);
+
+		// Let go of the trimmed results so pooled ones can be recycled right away
+		Release(oldStartIdx, m_resultStartIdx);
+		Release(m_resultEndIdx, oldEndIdx);
+		RebuildIndex();
 	}
 
 	return trimmed;
@@ -321,98 +380,78 @@ bool EvercoastAsyncStreamingDataDecoder::ResultCache::IsBeyond(double timestamp,
 
 }
 
-EvercoastAsyncStreamingDataDecoder::ResultPresorter::ResultPresorter(ResultCache& resultCache, double frameInterval) :
-	m_frameInterval(frameInterval), m_lastDeliveredTimestamp(-1.0), m_resultCache(resultCache)
+EvercoastAsyncStreamingDataDecoder::ResultPresorter::ResultPresorter(ResultCache& resultCache) :
+	m_epoch(0), m_nextSequenceToIssue(0), m_nextSequenceToDeliver(0), m_resultCache(resultCache)
 {
 
 }
 
-/*
-static void DebugPrintPresortResults(std::vector< std::shared_ptr<GenericDecodeResult>>& presortedResults)
+EvercoastDecodeTicket EvercoastAsyncStreamingDataDecoder::ResultPresorter::Issue()
 {
-	UE_LOG(EvercoastVoxelDecoderLog, Log, TEXT(">>>>"));
-	for (int i = 0; i < presortedResults.size(); ++i)
-	{
-		UE_LOG(EvercoastVoxelDecoderLog, Log, TEXT("Presort[%d] = %.2f"), i, presortedResults[i]->frameTimestamp);
-	}
-	UE_LOG(EvercoastVoxelDecoderLog, Log, TEXT("<<<<"));
+	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
+	EvercoastDecodeTicket ticket;
+	ticket.epoch = m_epoch;
+	ticket.sequence = m_nextSequenceToIssue++;
+	return ticket;
 }
-*/
 
-void EvercoastAsyncStreamingDataDecoder::ResultPresorter::Add(std::shared_ptr<GenericDecodeResult> result)
+void EvercoastAsyncStreamingDataDecoder::ResultPresorter::Add(const EvercoastDecodeTicket& ticket, std::shared_ptr<GenericDecodeResult> result)
 {
 	std::lock_guard<std::recursive_mutex> guard(m_mutex);
 
-	// first delivery
-	if (m_lastDeliveredTimestamp < 0 && result->frameTimestamp == 0.0)
+	if (ticket.epoch != m_epoch || ticket.sequence < m_nextSequenceToDeliver)
 	{
-		// Can force deliver the first frame
-		ForceDeliver(result);
-		m_lastDeliveredTimestamp = result->frameTimestamp;
+		// Decoded before a flush, nobody wants it any more
+		UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("Presorter drops stale result %.2f epoch: %d sequence: %llu"), result->frameTimestamp, ticket.epoch, (unsigned long long)ticket.sequence);
+		result->InvalidateResult();
+		return;
 	}
-	else
-	{
-		// Need to insert to the presort cache before sending off
-		auto it = std::find_if(m_presortedResults.begin(), m_presortedResults.end(), [result](std::shared_ptr<GenericDecodeResult> existingResult) {
-				return existingResult->frameTimestamp > result->frameTimestamp;
-			});
-
-		if (it != m_presortedResults.end())
-		{
-			// Insert *after*
-			m_presortedResults.insert(it, result);
-		}
-		else
-		{
-			m_presortedResults.push_back(result);
-		}
-
-		//DebugPrintPresortResults(m_presortedResults);
 
-			
-		CheckContinuityAndFeed();
-	}
+	m_presortedResults[ticket.sequence] = result;
+	FeedInOrder();
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultPresorter::ForceDeliver(std::shared_ptr<GenericDecodeResult> result)
+void EvercoastAsyncStreamingDataDecoder::ResultPresorter::Skip(const EvercoastDecodeTicket& ticket)
 {
 	std::lock_guard<std::recursive_mutex> guard(m_mutex);
 
-	m_resultCache.Add(result);
+	if (ticket.epoch != m_epoch || ticket.sequence < m_nextSequenceToDeliver)
+		return;
+
+	m_presortedResults[ticket.sequence] = nullptr;
+	FeedInOrder();
 }
 
-void EvercoastAsyncStreamingDataDecoder::ResultPresorter::CheckContinuityAndFeed()
+int EvercoastAsyncStreamingDataDecoder::ResultPresorter::GetPendingCount() const
 {
-	if (m_lastDeliveredTimestamp < 0)
-		return;
+	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+	return (int)m_presortedResults.size();
+}
 
-	// Check if the first element in the list is in-order
-	// If so, deliver it
-	while (m_presortedResults.size() > 0)
+void EvercoastAsyncStreamingDataDecoder::ResultPresorter::FeedInOrder()
+{
+	// Deliver the run of consecutive results starting from the next expected sequence
+	auto it = m_presortedResults.begin();
+	while (it != m_presortedResults.end() && it->first == m_nextSequenceToDeliver)
 	{
-		auto firstCandidateIt = m_presortedResults.begin();
-		auto& firstCandidate = *firstCandidateIt;
-
-		if (abs((firstCandidate->frameTimestamp - m_lastDeliveredTimestamp) - m_frameInterval) < 0.001)
+		if (it->second)
 		{
-			ForceDeliver(firstCandidate);
-
-			m_lastDeliveredTimestamp = firstCandidate->frameTimestamp;
-			m_presortedResults.erase(firstCandidateIt);
-		}
-		else
-		{
-			// No longer having continuity, wait
-			break;
+			m_resultCache.Add(it->second);
 		}
+
+		++m_nextSequenceToDeliver;
+		it = m_presortedResults.erase(it);
 	}
 }
 
 void EvercoastAsyncStreamingDataDecoder::ResultPresorter::CleanupPresortedResults()
 {
+	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
 	for(auto it = m_presortedResults.begin(); it != m_presortedResults.end(); ++it)
 	{
-		auto pResult = *it;
+		auto pResult = it->second;
 		if (pResult)
 		{
 			pResult->InvalidateResult();
@@ -420,11 +459,17 @@ void EvercoastAsyncStreamingDataDecoder::ResultPresorter::CleanupPresortedResult
 	}
 
 	m_presortedResults.clear();
-	m_lastDeliveredTimestamp = -1.0;
+
+	// Tickets issued so far are void
+	++m_epoch;
+	m_nextSequenceToIssue = 0;
+	m_nextSequenceToDeliver = 0;
 }
 
 void EvercoastAsyncStreamingDataDecoder::ResultPresorter::Dispose()
 {
+	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
 	m_resultCache.Dispose();
 
 	CleanupPresortedResults();
@@ -432,16 +477,62 @@ void EvercoastAsyncStreamingDataDecoder::ResultPresorter::Dispose()
 
 void EvercoastAsyncStreamingDataDecoder::ResultPresorter::DisposeAndReinit()
 {
+	std::lock_guard<std::recursive_mutex> guard(m_mutex);
+
 	m_resultCache.DisposeAndReinit();
 
 	CleanupPresortedResults();
 }
 
+// Decoding is CPU bound, so every decoder in the process shares one budget of frames being decoded at a time instead
+// of each reader bringing its own core count worth of busy workers. Workers hold a slot for the duration of a frame.
+class DecodeWorkerBudget
+{
+public:
+	static DecodeWorkerBudget& Get()
+	{
+		// Leave a couple of cores for game and render thread
+		static DecodeWorkerBudget s_budget(FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 2, 1, EvercoastAsyncStreamingDataDecoder::MAX_DECODE_THREAD_COUNT));
+		return s_budget;
+	}
+
+	int GetSlotCount() const
+	{
+		return m_slotCount;
+	}
+
+	class Slot
+	{
+	public:
+		Slot()
+		{
+			DecodeWorkerBudget::Get().m_slots.acquire();
+		}
+
+		~Slot()
+		{
+			DecodeWorkerBudget::Get().m_slots.release();
+		}
+
+		Slot(const Slot&) = delete;
+		Slot& operator=(const Slot&) = delete;
+	};
+
+private:
+	explicit DecodeWorkerBudget(int slotCount) :
+		m_slotCount(slotCount), m_slots(slotCount)
+	{
+	}
+
+	const int m_slotCount;
+	CountingSemaphore m_slots;
+};
+
 class EvercoastSpzDecodeThread final : public FEvercoastGenericDecodeThread
 {
 public:
 	EvercoastSpzDecodeThread(std::shared_ptr<IGenericDecoder> decoder, EvercoastAsyncStreamingDataDecoder::ResultPresorter& resultPresorter) :
-		m_baseDecoder(decoder), m_running(false),
+		m_baseDecoder(decoder), m_running(false), m_decoding(false),
 		m_resultPresorter(resultPresorter)
 	{
 	}
@@ -478,6 +569,7 @@ public:
 					
 					dataFrame = m_localDataFrameList.front();
 					m_localDataFrameList.pop();
+					m_decoding = true;
 
 					UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("SpzDecodeThread::Run HasNewEntry time: %.2f, Input Ring size: %d"), dataFrame->m_timestamp, m_localDataFrameList.size());
 				}
@@ -485,6 +577,7 @@ public:
 
 			if (dataFrame)
 			{
+				DecodeWorkerBudget::Slot decodeSlot;
 #if 0
 				EvercoastGaussianSplatDecodeOption decodeOption(true);
 				if (m_baseDecoder->DecodeMemoryStream(dataFrame->m_data, dataFrame->m_dataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &decodeOption))
@@ -492,7 +585,7 @@ public:
 					auto result = m_baseDecoder->TakeResult();
 					auto pResult = std::static_pointer_cast<EvercoastGaussianSplatDecodeResult>(result);
 
-					m_resultPresorter.Add(pResult);
+					m_resultPresorter.Add(dataFrame->m_ticket, pResult);
 				}
 #else
 				EvercoastGaussianSplatDecodeOption decodeOption(false);
@@ -501,13 +594,17 @@ public:
 					auto result = m_baseDecoder->TakeResult();
 					auto pResult = std::static_pointer_cast<EvercoastGaussianSplatPassthroughResult>(result);
 
-					m_resultPresorter.Add(pResult);
+					m_resultPresorter.Add(dataFrame->m_ticket, pResult);
 				}
 #endif
 				else
 				{
 					UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode Gaussian failed"));
+					m_resultPresorter.Skip(dataFrame->m_ticket);
 				}
+
+				std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+				m_decoding = false;
 			}
 
 
@@ -525,11 +622,6 @@ public:
 		m_newEntrySemaphore.release();
 	}
 
-	void Exit() override
-	{
-		m_resultPresorter.Dispose();
-	}
-
 	bool HasNewEntry() const
 	{
 		// Removed the lock as it will be called along with explicit lock
@@ -542,39 +634,32 @@ public:
 		return m_localDataFrameList.size();
 	}
 
-	void AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata)
+	bool AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata, const EvercoastDecodeTicket& ticket)
 	{
 		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
 
 		UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("SpzDecodeThread::AddEntry %.2f"), timestamp);
-		m_localDataFrameList.emplace(std::make_shared<EvercoastEncodedDataFrame>(timestamp, frameIndex, data, dataSize));
+		auto dataFrame = std::make_shared<EvercoastEncodedDataFrame>(timestamp, frameIndex, data, dataSize);
+		dataFrame->m_ticket = ticket;
+		m_localDataFrameList.emplace(dataFrame);
 
 		m_newEntrySemaphore.release();
-
+		return true;
 	}
 
 	int GetPotentialResultCount() const
 	{
-		int potentialCount = 2;
-		{
-			std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
-			potentialCount += m_localDataFrameList.size();
-		}
-
-		return potentialCount;
+		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+		return (int)m_localDataFrameList.size() + (m_decoding ? 1 : 0);
 	}
 
 	void FlushAndDisposeResults()
 	{
 		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
 
-		// deplete input buffer
+		// deplete input buffer, output is drained by the presorter's owner
 		while (!m_localDataFrameList.empty())
 			m_localDataFrameList.pop();
-
-		// drain output cache
-		m_resultPresorter.DisposeAndReinit();
-
 	}
 
 private:
@@ -582,6 +667,7 @@ private:
 
 	std::queue<std::shared_ptr<EvercoastEncodedDataFrame>> m_localDataFrameList;
 	bool m_running;
+	bool m_decoding; // a frame has been popped and not yet handed to presorter
 
 	mutable std::recursive_mutex m_controllerMutex;
 	mutable std::recursive_mutex m_inputMutex;
@@ -595,7 +681,7 @@ class VoxelDecodeThread final : public FEvercoastGenericDecodeThread
 {
 public:
 	VoxelDecodeThread(std::shared_ptr<IGenericDecoder> decoder, EvercoastAsyncStreamingDataDecoder::ResultPresorter& resultPresorter) :
-		m_baseDecoder(decoder), m_running(false),
+		m_baseDecoder(decoder), m_running(false), m_decoding(false),
 		m_resultPresorter(resultPresorter)
 	{
 		auto voxelDecoder = std::static_pointer_cast<EvercoastVoxelDecoder>(m_baseDecoder);
@@ -606,6 +692,8 @@ public:
 		m_baseDefinition.gfx_api_compatibility_mode = true;
 		m_baseDefinition.half_float_coordinates = false;
 
+		m_requiredLOD = m_baseDefinition.required_lod;
+		m_compactVoxels = false;
 	}
 
 	~VoxelDecodeThread()
@@ -618,6 +706,18 @@ public:
 		return m_baseDecoder != nullptr;
 	}
 
+	// Takes effect from the next frame decoded, frames already decoded stay at the LOD they have
+	void SetRequiredLOD(uint32_t lod)
+	{
+		m_requiredLOD = lod;
+	}
+
+	// Same, frames already decoded keep their layout
+	void SetCompactVoxels(bool compact)
+	{
+		m_compactVoxels = compact;
+	}
+
 	uint32 Run() override
 	{
 		while (true)
@@ -640,25 +740,32 @@ public:
 					UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("Decode: Input Ring size: %d"), m_localDataFrameList.size());
 					dataFrame = m_localDataFrameList.front();
 					m_localDataFrameList.pop();
+					m_decoding = true;
 				}
 			}
 
 			if (dataFrame)
 			{
-				EvercoastVoxelDecodeOption option(m_baseDefinition);
+				DecodeWorkerBudget::Slot decodeSlot;
+				EvercoastVoxelDecodeOption option(m_baseDefinition, m_compactVoxels);
+				option.definition.required_lod = (uint8_t)std::min<uint32_t>(m_requiredLOD, UINT8_MAX);
 				if (m_baseDecoder->DecodeMemoryStream(dataFrame->m_data, dataFrame->m_dataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option))
 				{
 					auto result = m_baseDecoder->TakeResult();
 					auto pResult = std::static_pointer_cast<EvercoastVoxelDecodeResult>(result);
 					check(pResult->resultFrame);
 
-					m_resultPresorter.Add(pResult);
+					m_resultPresorter.Add(dataFrame->m_ticket, pResult);
 				}
 				else
 				{
 					UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode voxel failed"));
+					m_resultPresorter.Skip(dataFrame->m_ticket);
 				}
 
+				std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+				m_decoding = false;
+
 			}
 
 
@@ -675,11 +782,6 @@ public:
 		m_newEntrySemaphore.release();
 	}
 
-	void Exit() override
-	{
-		m_resultPresorter.Dispose();
-	}
-
 	bool HasNewEntry() const
 	{
 		// Removed the lock as it will be called along with explicit lock
@@ -694,49 +796,46 @@ public:
 
 	// Always able to AddEntry() but will be limiting request next block based on whether output buffer is full
 	// So the pending
-	void AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata)
+	bool AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata, const EvercoastDecodeTicket& ticket)
 	{
 		UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("AddEntry: %.2f Input Ring length: %d"), timestamp, m_localDataFrameList.size());
 
 		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
-		m_localDataFrameList.emplace(std::make_shared<EvercoastEncodedDataFrame>(timestamp, frameIndex, data, dataSize));
+		auto dataFrame = std::make_shared<EvercoastEncodedDataFrame>(timestamp, frameIndex, data, dataSize);
+		dataFrame->m_ticket = ticket;
+		m_localDataFrameList.emplace(dataFrame);
 
 		m_newEntrySemaphore.release();
+		return true;
 	}
 
 
 	int GetPotentialResultCount() const
 	{
-		// 1: there could be one result popped from input list, decoding in the middle, and not yet pushed to result cache
-		// 2: there could be another one in the middle of the network streaming, but due to the one after one nature of GT's reading API, it cannot be more than one in transfer
-		int potentialCount = 2; 
-		{
-			std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
-			potentialCount += m_localDataFrameList.size();
-		}
-
-		return potentialCount;
+		// there could be one result popped from input list, decoding in the middle, and not yet pushed to presorter
+		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+		return (int)m_localDataFrameList.size() + (m_decoding ? 1 : 0);
 	}
 
 	void FlushAndDisposeResults()
 	{
 		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
 
-		// deplete input buffer
+		// deplete input buffer, output is drained by the presorter's owner
 		while(!m_localDataFrameList.empty())
 			m_localDataFrameList.pop();
-
-		// drain output cache
-		m_resultPresorter.DisposeAndReinit();
 	}
 
 private:
 
 	std::shared_ptr<IGenericDecoder> m_baseDecoder;
 	Definition m_baseDefinition;
+	std::atomic<uint32_t> m_requiredLOD;
+	std::atomic<bool> m_compactVoxels;
 
 	std::queue<std::shared_ptr<EvercoastEncodedDataFrame>> m_localDataFrameList;
 	bool m_running;
+	bool m_decoding; // a frame has been popped and not yet handed to presorter
 
 	mutable std::recursive_mutex m_controllerMutex;
 	mutable std::recursive_mutex m_inputMutex;
@@ -751,11 +850,12 @@ class CortoDecodeThread final : public FEvercoastGenericDecodeThread
 {
 	
 public:
-	CortoDecodeThread(std::shared_ptr<IGenericDecoder> mesh_decoder, std::shared_ptr<IGenericDecoder> image_decoder, EvercoastAsyncStreamingDataDecoder::ResultPresorter& resultPresorter) :
+	CortoDecodeThread(std::shared_ptr<IGenericDecoder> mesh_decoder, std::shared_ptr<IGenericDecoder> image_decoder, EvercoastAsyncStreamingDataDecoder::ResultPresorter& resultPresorter,
+		std::shared_ptr<DecodeResultPool<CortoWebpUnifiedDecodeResult>> resultPool) :
 		m_cortoDecoder(std::static_pointer_cast<CortoDecoder>(mesh_decoder)), 
 		m_webpDecoder(std::static_pointer_cast<WebpDecoder>(image_decoder)), 
-		m_running(false), m_requiresExternalData(false),
-		m_resultPresorter(resultPresorter)
+		m_running(false), m_requiresExternalData(false), m_decoding(false),
+		m_resultPresorter(resultPresorter), m_resultPool(resultPool)
 	{
 	}
 
@@ -811,6 +911,7 @@ public:
 					if (dataFrame->IsReady())
 					{
 						m_localDataFrameList.pop_front();
+						m_decoding = true;
 					}
 					else
 					{
@@ -824,16 +925,18 @@ public:
 			CortoDecodeOption option;
 			if (dataFrame)
 			{
-				// FIXME: preallocate and reuse buffers!
-				std::shared_ptr<CortoWebpUnifiedDecodeResult> unifiedResult = std::make_shared<CortoWebpUnifiedDecodeResult>(
-					CortoDecoder::DEFAULT_VERTEX_COUNT, CortoDecoder::DEFAULT_TRIANGLE_COUNT, 1024, 1024, 32);
+				DecodeWorkerBudget::Slot decodeSlot;
+				// Goes back to the pool when the result cache and renderers are done with it
+				std::shared_ptr<CortoWebpUnifiedDecodeResult> unifiedResult = m_resultPool->Acquire();
+				unifiedResult->DetachSharedMesh();
 
-				m_cortoDecoder->SetReceivingResult(std::move(unifiedResult->meshResult));
+				// Decoders only borrow the buffers, unified result keeps its references even if decoding fails
+				m_cortoDecoder->SetReceivingResult(unifiedResult->meshResult);
 				bool requireImageDecoding = !m_requiresExternalData;
 				if (requireImageDecoding)
 				{
 					if (m_webpDecoder)
-						m_webpDecoder->SetReceivingResult(std::move(unifiedResult->imgResult));
+						m_webpDecoder->SetReceivingResult(unifiedResult->imgResult);
 
 					if (m_cortoDecoder->DecodeMemoryStream(dataFrame->m_data, dataFrame->m_dataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option) &&
 						m_webpDecoder->DecodeMemoryStream(dataFrame->m_imageData, dataFrame->m_imageDataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option))
@@ -842,7 +945,7 @@ public:
 						unifiedResult->imgResult = std::static_pointer_cast<WebpDecodeResult>(m_webpDecoder->TakeResult());
 						unifiedResult->SyncWithMeshResult();
 
-						m_resultPresorter.Add(unifiedResult);
+						m_resultPresorter.Add(dataFrame->m_ticket, unifiedResult);
 					}
 					else
 					{
@@ -851,6 +954,7 @@ public:
 						if (m_webpDecoder)
 							m_webpDecoder->UnsetReceivingResult();
 
+						m_resultPresorter.Skip(dataFrame->m_ticket);
 					}
 				}
 				else
@@ -860,13 +964,14 @@ public:
 						unifiedResult->meshResult = std::static_pointer_cast<CortoDecodeResult>(m_cortoDecoder->TakeResult());
 						unifiedResult->SyncWithMeshResult();
 						
-						m_resultPresorter.Add(unifiedResult);
+						m_resultPresorter.Add(dataFrame->m_ticket, unifiedResult);
 					}
 					else
 					{
 						UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode mesh failed"));
 
 						m_cortoDecoder->UnsetReceivingResult();
+						m_resultPresorter.Skip(dataFrame->m_ticket);
 					}
 				}
 
@@ -874,65 +979,10 @@ public:
 
 				dataFrame->Invalidate();
 
-
-				/*
-				// The cache needs to be frozen, no more cursor moving or content changing
-				m_resultCache.Lock();
-				std::shared_ptr<CortoWebpUnifiedDecodeResult> unifiedResult = std::static_pointer_cast<CortoWebpUnifiedDecodeResult>(m_resultCache.Prealloc());
-				if (!unifiedResult)
 				{
-					unifiedResult = std::make_shared<CortoWebpUnifiedDecodeResult>(
-						CortoDecoder::DEFAULT_VERTEX_COUNT, CortoDecoder::DEFAULT_TRIANGLE_COUNT, 1024, 1024, 32);
-
-					m_resultCache.FillLastPrealloc(unifiedResult);
+					std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+					m_decoding = false;
 				}
-
-				m_cortoDecoder->SetReceivingResult(std::move(unifiedResult->meshResult));
-
-				bool requireImageDecoding = !m_requiresExternalData;
-				if (requireImageDecoding)
-				{
-					if (m_webpDecoder)
-						m_webpDecoder->SetReceivingResult(std::move(unifiedResult->imgResult));
-
-					if (m_cortoDecoder->DecodeMemoryStream(dataFrame->m_data, dataFrame->m_dataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option) &&
-						m_webpDecoder->DecodeMemoryStream(dataFrame->m_imageData, dataFrame->m_imageDataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option))
-					{
-						unifiedResult->meshResult = std::static_pointer_cast<CortoDecodeResult>(m_cortoDecoder->TakeResult());
-						unifiedResult->imgResult = std::static_pointer_cast<WebpDecodeResult>(m_webpDecoder->TakeResult());
-						unifiedResult->SyncWithMeshResult();
-							
-						// No need to add to result cache, unifiedResult was preallocated
-					}
-					else
-					{
-						UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode mesh+image failed"));
-						m_cortoDecoder->UnsetReceivingResult();
-						if (m_webpDecoder)
-							m_webpDecoder->UnsetReceivingResult();
-
-					}
-				}
-				else
-				{
-					if (m_cortoDecoder->DecodeMemoryStream(dataFrame->m_data, dataFrame->m_dataSize, dataFrame->m_timestamp, dataFrame->m_frameIndex, &option))
-					{
-						unifiedResult->meshResult = std::static_pointer_cast<CortoDecodeResult>(m_cortoDecoder->TakeResult());
-						unifiedResult->SyncWithMeshResult();
-						// No need to add to result cache, unifiedResult was preallocated
-					}
-					else
-					{
-						UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode mesh failed"));
-
-						m_cortoDecoder->UnsetReceivingResult();
-					}
-				}
-
-				m_resultCache.Unlock();
-
-				dataFrame->Invalidate();
-				*/
 			}
 		}
 
@@ -958,7 +1008,6 @@ public:
 		FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
 #endif
 		m_localDataFrameList.clear();
-		m_resultPresorter.Dispose();
 
 		m_cortoDecoder.reset();
 		m_webpDecoder.reset();
@@ -1004,7 +1053,20 @@ public:
 		return nullptr;
 	}
 
-	virtual void AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata) override
+	virtual bool HasIncompleteFrame(int64_t frameIndex) const override
+	{
+		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+		for (const auto& dataFrame : m_localDataFrameList)
+		{
+			if (dataFrame && dataFrame->m_frameIndex == frameIndex && !dataFrame->IsReady())
+				return true;
+		}
+
+		return false;
+	}
+
+	// Only mesh data takes a ticket, the image data can come before or after it
+	virtual bool AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata, const EvercoastDecodeTicket& ticket) override
 	{
 #if ENGINE_MAJOR_VERSION == 5
 		FTaskTagScope Scope(ETaskTag::EParallelRenderingThread);
@@ -1019,35 +1081,43 @@ public:
 			existingFrame->UpdateData(data, dataSize, isImage);
 			UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("AddEntry(update) input_buffer = %lld %s"), frameIndex, isImage ? TEXT("image_data") : TEXT("mesh_data"));
 
+			bool ticketTaken = false;
+			if (!isImage && !existingFrame->m_ticket.IsAssigned())
+			{
+				existingFrame->m_ticket = ticket;
+				ticketTaken = true;
+			}
+
 			m_newEntrySemaphore.release();
-			return;
+			return ticketTaken;
 		}
 
 
-		m_localDataFrameList.emplace_back(std::make_shared<ECMEncodedDataFrame>(timestamp, frameIndex, data, dataSize, !m_requiresExternalData, isImage));
+		auto dataFrame = std::make_shared<ECMEncodedDataFrame>(timestamp, frameIndex, data, dataSize, !m_requiresExternalData, isImage);
+		if (!isImage)
+		{
+			dataFrame->m_ticket = ticket;
+		}
+		m_localDataFrameList.emplace_back(dataFrame);
 
 		UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("AddEntry(new) input_buffer = %.2f %s"), timestamp, isImage ? TEXT("image_data") : TEXT("mesh_data"));
 
 		m_newEntrySemaphore.release();
+		return !isImage;
 	}
 
 	int GetPotentialResultCount() const
 	{
-		int potentialCount = 2;
-		{
-			std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
-			potentialCount += m_localDataFrameList.size();
-		}
-		return potentialCount;
+		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
+		return (int)m_localDataFrameList.size() + (m_decoding ? 1 : 0);
 	}
 
 	void FlushAndDisposeResults()
 	{
 		std::lock_guard<std::recursive_mutex> guardInput(m_inputMutex);
 
+		// output is drained by the presorter's owner
 		m_localDataFrameList.clear();
-
-		m_resultPresorter.DisposeAndReinit();
 	}
 
 private:
@@ -1059,17 +1129,19 @@ private:
 	std::list<std::shared_ptr<ECMEncodedDataFrame>> m_localDataFrameList;
 	bool m_running;
 	bool m_requiresExternalData;
+	bool m_decoding; // a frame has been popped and not yet handed to presorter
 
 	mutable std::recursive_mutex m_controllerMutex;
 	mutable std::recursive_mutex m_inputMutex;
 	CountingSemaphore m_newEntrySemaphore;
 
 	EvercoastAsyncStreamingDataDecoder::ResultPresorter& m_resultPresorter;
+	std::shared_ptr<DecodeResultPool<CortoWebpUnifiedDecodeResult>> m_resultPool;
 };
 
 
 EvercoastAsyncStreamingDataDecoder::EvercoastAsyncStreamingDataDecoder(DecoderType decoderType) :
-	m_resultCache(DEFAULT_BUFFER_COUNT), m_decoderType(decoderType)
+	m_resultCache(DEFAULT_BUFFER_COUNT), m_resultPresorter(nullptr), m_requiresExternalData(false), m_requiredVoxelLOD(-1), m_compactVoxels(false), m_decoderType(decoderType)
 {
 	// Init has been delayed to when we can know frame interval
 }
@@ -1080,9 +1152,9 @@ EvercoastAsyncStreamingDataDecoder::~EvercoastAsyncStreamingDataDecoder()
 }
 
 
-void EvercoastAsyncStreamingDataDecoder::Init(double frameInterval, int maxThreadCount)
+void EvercoastAsyncStreamingDataDecoder::Init(int maxThreadCount)
 {
-	m_resultPresorter = new ResultPresorter(m_resultCache, frameInterval);
+	m_resultPresorter = new ResultPresorter(m_resultCache);
 
 	if (m_decoderType == DT_EvercoastVoxel)
 	{
@@ -1095,6 +1167,12 @@ void EvercoastAsyncStreamingDataDecoder::Init(double frameInterval, int maxThrea
 			FString name = FString::Format(TEXT("Voxel Decode Thread {0}"), { i + 1 });
 			m_decodeWorkerControllers.push_back(FRunnableThread::Create(decodeWorker, *name));
 		}
+
+		if (m_requiredVoxelLOD >= 0)
+		{
+			SetRequiredVoxelLOD((uint32_t)m_requiredVoxelLOD);
+		}
+		SetCompactVoxels(m_compactVoxels);
 	}
 	else if (m_decoderType == DT_EvercoastSpz)
 	{
@@ -1110,17 +1188,25 @@ void EvercoastAsyncStreamingDataDecoder::Init(double frameInterval, int maxThrea
 	}
 	else if (m_decoderType == DT_CortoMesh)
 	{
+		// Enough to fill the result cache and keep every worker busy without going to the heap
+		m_cortoResultPool = DecodeResultPool<CortoWebpUnifiedDecodeResult>::Create((int32_t)m_halfCacheWidth * 2 + maxThreadCount + 2, []()
+			{
+				return new CortoWebpUnifiedDecodeResult(CortoDecoder::DEFAULT_VERTEX_COUNT, CortoDecoder::DEFAULT_TRIANGLE_COUNT, 1024, 1024, 32);
+			});
+
 		for (int i = 0; i < maxThreadCount; ++i)
 		{
 			auto cortoDecoder = CortoDecoder::Create();
 			auto webpDecoder = WebpDecoder::Create();
 
-			auto decodeWorker = new CortoDecodeThread(cortoDecoder, webpDecoder, *m_resultPresorter);
+			auto decodeWorker = new CortoDecodeThread(cortoDecoder, webpDecoder, *m_resultPresorter, m_cortoResultPool);
 			m_decodeWorkers.push_back(decodeWorker);
 
 			FString name = FString::Format(TEXT("Corto Decode Thread {0}"), { i + 1 });
 			m_decodeWorkerControllers.push_back(FRunnableThread::Create(decodeWorker, *name));
 		}
+
+		SetRequiresExternalData(m_requiresExternalData);
 	}
 }
 
@@ -1150,8 +1236,19 @@ void EvercoastAsyncStreamingDataDecoder::Deinit()
 	m_decodeWorkers.clear();
 	m_decodeWorkerControllers.clear();
 
+	// Once, after every worker has joined, so none can still be adding to it
+	m_resultPresorter->Dispose();
 	delete m_resultPresorter;
 	m_resultPresorter = nullptr;
+
+	if (m_cortoResultPool)
+	{
+		auto stats = m_cortoResultPool->GetStats();
+		UE_LOG(EvercoastVoxelDecoderLog, Log, TEXT("Corto result pool hits: %llu misses: %llu idle: %d bytes held: %llu"),
+			(unsigned long long)stats.hits, (unsigned long long)stats.misses, stats.idleCount, (unsigned long long)stats.bytesHeld);
+		// Results still held by renderers will be deleted instead of recycled
+		m_cortoResultPool.reset();
+	}
 }
 
 FEvercoastGenericDecodeThread* EvercoastAsyncStreamingDataDecoder::FindLeastJobWorker()
@@ -1175,12 +1272,44 @@ FEvercoastGenericDecodeThread* EvercoastAsyncStreamingDataDecoder::FindLeastJobW
 	return m_decodeWorkers[foundIndex];
 }
 
+FEvercoastGenericDecodeThread* EvercoastAsyncStreamingDataDecoder::FindWorkerWithIncompleteFrame(int64_t frameIndex)
+{
+	for (auto it = m_decodeWorkers.begin(); it != m_decodeWorkers.end(); ++it)
+	{
+		if ((*it)->HasIncompleteFrame(frameIndex))
+			return *it;
+	}
+
+	return nullptr;
+}
+
 void EvercoastAsyncStreamingDataDecoder::Receive(double timestamp, int64_t frameIndex, const uint8_t* data, size_t data_size, uint32_t metadata)
 {
 	UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("AsyncStreamingDataDecoder::Receive %.2f"), timestamp);
 
-	FEvercoastGenericDecodeThread* decodeWorker = FindLeastJobWorker();
-	decodeWorker->AddEntry(timestamp, frameIndex, data, data_size, metadata);
+	if (m_decodeWorkers.empty())
+	{
+		UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("AsyncStreamingDataDecoder received data before initialisation, dropped %.2f"), timestamp);
+		return;
+	}
+
+	// Image data only complements the mesh data of the same frame, which holds the ticket
+	EvercoastDecodeTicket ticket;
+	if (metadata != UGhostTreeFormatReader::DECODE_META_IMAGE_WEBP)
+	{
+		ticket = m_resultPresorter->Issue();
+	}
+
+	FEvercoastGenericDecodeThread* decodeWorker = FindWorkerWithIncompleteFrame(frameIndex);
+	if (!decodeWorker)
+	{
+		decodeWorker = FindLeastJobWorker();
+	}
+
+	if (!decodeWorker->AddEntry(timestamp, frameIndex, data, data_size, metadata, ticket) && ticket.IsAssigned())
+	{
+		m_resultPresorter->Skip(ticket);
+	}
 }
 
 std::shared_ptr<GenericDecodeResult> EvercoastAsyncStreamingDataDecoder::QueryResult(double timestamp)
@@ -1214,10 +1343,17 @@ void EvercoastAsyncStreamingDataDecoder::FlushAndDisposeResults()
 	{
 		(*it)->FlushAndDisposeResults();
 	}
+
+	// Results still being decoded belong to the old epoch and will be dropped on arrival
+	if (m_resultPresorter)
+	{
+		m_resultPresorter->DisposeAndReinit();
+	}
 }
 
 void EvercoastAsyncStreamingDataDecoder::SetRequiresExternalData(bool required)
 {
+	m_requiresExternalData = required;
 	if (m_decoderType == DT_CortoMesh)
 	{
 		for (auto it = m_decodeWorkers.begin(); it != m_decodeWorkers.end(); ++it)
@@ -1228,16 +1364,47 @@ void EvercoastAsyncStreamingDataDecoder::SetRequiresExternalData(bool required)
 	}
 }
 
+void EvercoastAsyncStreamingDataDecoder::SetRequiredVoxelLOD(uint32_t lod)
+{
+	m_requiredVoxelLOD = (int32_t)lod;
+	if (m_decoderType == DT_EvercoastVoxel)
+	{
+		for (auto it = m_decodeWorkers.begin(); it != m_decodeWorkers.end(); ++it)
+		{
+			VoxelDecodeThread* decodeWorker = static_cast<VoxelDecodeThread*>(*it);
+			decodeWorker->SetRequiredLOD(lod);
+		}
+	}
+}
+
+void EvercoastAsyncStreamingDataDecoder::SetCompactVoxels(bool compact)
+{
+	m_compactVoxels = compact;
+	if (m_decoderType == DT_EvercoastVoxel)
+	{
+		for (auto it = m_decodeWorkers.begin(); it != m_decodeWorkers.end(); ++it)
+		{
+			VoxelDecodeThread* decodeWorker = static_cast<VoxelDecodeThread*>(*it);
+			decodeWorker->SetCompactVoxels(compact);
+		}
+	}
+}
 
 void EvercoastAsyncStreamingDataDecoder::ResizeBuffer(uint32_t bufferCount, double halfFrameInterval)
 {
-	m_resultCache.Resize(bufferCount);
+	// Workers dispose the result cache on exit, so they have to go before resizing
+	if (!m_decodeWorkers.empty())
+	{
+		Deinit();
+	}
+
+	m_resultCache.Resize(bufferCount, halfFrameInterval * 2.0);
 
 	m_halfCacheWidth = bufferCount / 2;
 	m_halfFrameInterval = halfFrameInterval;
 
-	// FIXME: supply maximum threads but Presorter seems to have problem when sending first a few frames when loops back to the beginning
-	Init(halfFrameInterval * 2.0, 1);// FGenericPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	// Enough workers for one reader to use the whole budget, with more readers they take turns
+	Init(DecodeWorkerBudget::Get().GetSlotCount());
 }
 
 
@@ -1249,5 +1416,11 @@ bool EvercoastAsyncStreamingDataDecoder::IsGoingToBeFull() const
 		potentialResultCountFromWorkers += (*it)->GetPotentialResultCount();
 	}
 
-	return m_resultCache.IsGoingToBeFull(potentialResultCountFromWorkers);
+	if (m_resultPresorter)
+	{
+		potentialResultCountFromWorkers += m_resultPresorter->GetPendingCount();
+	}
+
+	// Plus one in the middle of network streaming, GT's reading API only has one in transfer
+	return m_resultCache.IsGoingToBeFull(potentialResultCountFromWorkers + 1);
 }
\ No newline at end of file
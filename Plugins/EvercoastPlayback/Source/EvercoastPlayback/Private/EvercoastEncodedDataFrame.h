@@ -1,6 +1,21 @@
 #pragma once
 #include <cstdint>
 
+// Where a frame sits in the decoder's delivery order. The epoch changes whenever results get flushed(e.g. seeking), so
+// frames decoded for a stale epoch can be told apart and dropped.
+struct EvercoastDecodeTicket
+{
+	static constexpr uint64_t UNASSIGNED_SEQUENCE = (uint64_t)-1;
+
+	uint32_t epoch = 0;
+	uint64_t sequence = UNASSIGNED_SEQUENCE;
+
+	bool IsAssigned() const
+	{
+		return sequence != UNASSIGNED_SEQUENCE;
+	}
+};
+
 struct EvercoastEncodedDataFrame
 {
 	EvercoastEncodedDataFrame(double timestamp, int64_t frameIndex, const uint8_t* data, size_t data_size);
@@ -12,6 +27,7 @@ struct EvercoastEncodedDataFrame
 	int64_t m_frameIndex;
 	uint8_t* m_data;
 	size_t m_dataSize;
+	EvercoastDecodeTicket m_ticket;
 };
 
 
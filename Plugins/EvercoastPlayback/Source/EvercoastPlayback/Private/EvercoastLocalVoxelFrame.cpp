@@ -9,39 +9,38 @@
 */
 #include "EvercoastLocalVoxelFrame.h"
 #include "EvercoastVoxelDecoder.h"
+#include "VoxelCompactPacking.h"
 
-EvercoastLocalVoxelFrame::EvercoastLocalVoxelFrame(const GTHandle voxelFrame, bool makeCopy) :
+EvercoastLocalVoxelFrame::EvercoastLocalVoxelFrame(std::shared_ptr<const EvercoastVoxelFrameOwner> voxelFrame) :
 	m_voxelCount(0),
 	m_boundsMin(FVector3f()),
 	m_boundsDim(0),
 	m_bitsPerVoxel(0),
+	m_compact(voxelFrame && voxelFrame->compact),
 	m_positionData(nullptr),
 	m_colourData(nullptr),
 	m_voxelDataSize(0),
-	m_madeCopy(makeCopy),
-	m_voxelFrameHandle(voxelFrame)
+	m_voxelFrameHandle(voxelFrame ? voxelFrame->frame : InvalidHandle),
+	m_voxelFrame(std::move(voxelFrame))
 {
 	VoxelFrameDefinition frameDef;
-	if (voxel_frame_get_definition(voxelFrame, &frameDef))
+	if (m_voxelFrameHandle != InvalidHandle && voxel_frame_get_definition(m_voxelFrameHandle, &frameDef))
 	{
 		m_voxelCount = frameDef.voxel_count;
 		m_boundsMin = FVector3f(frameDef.bounds_min_x, frameDef.bounds_min_y, frameDef.bounds_min_z);
 		m_boundsDim = frameDef.bounds_dim;
 		m_bitsPerVoxel = frameDef.bits_per_voxel;
-		m_voxelDataSize = m_voxelCount * (DECODER_POSITION_ELEMENT_SIZE + DECODER_COLOUR_ELEMENT_SIZE);
 
-		if (makeCopy)
+		// No copy, the frame stays alive as long as this does
+		m_positionData = reinterpret_cast<const uint16_t*>(voxel_frame_get_coordinates(m_voxelFrameHandle));
+		if (m_compact)
 		{
-			m_positionData = new uint16_t[m_voxelCount * DECODER_POSITION_ELEMENT_SIZE];
-			m_colourData = new uint8_t[m_voxelCount * DECODER_COLOUR_ELEMENT_SIZE];
-
-			FMemory::Memcpy(m_positionData, reinterpret_cast<uint16_t*>(voxel_frame_get_coordinates(voxelFrame)), m_voxelCount * DECODER_POSITION_ELEMENT_SIZE);
-			FMemory::Memcpy(m_colourData, reinterpret_cast<uint8_t*>(voxel_frame_get_colours(voxelFrame)), m_voxelCount * DECODER_COLOUR_ELEMENT_SIZE);
+			m_voxelDataSize = m_voxelCount * VoxelCompactPacking::ELEMENT_SIZE;
 		}
 		else
 		{
-			m_positionData = reinterpret_cast<uint16_t*>(voxel_frame_get_coordinates(voxelFrame));
-			m_colourData = reinterpret_cast<uint8_t*>(voxel_frame_get_colours(voxelFrame));
+			m_colourData = reinterpret_cast<const uint8_t*>(voxel_frame_get_colours(m_voxelFrameHandle));
+			m_voxelDataSize = m_voxelCount * (DECODER_POSITION_ELEMENT_SIZE + DECODER_COLOUR_ELEMENT_SIZE);
 		}
 	}
 	else
@@ -52,14 +51,8 @@ EvercoastLocalVoxelFrame::EvercoastLocalVoxelFrame(const GTHandle voxelFrame, bo
 
 EvercoastLocalVoxelFrame::~EvercoastLocalVoxelFrame()
 {
-	if (m_madeCopy)
-	{
-		delete[] m_positionData;
-		delete[] m_colourData;
-	}
 }
 
-
 FBoxSphereBounds EvercoastLocalVoxelFrame::CalcBounds() const
 {
 	const float EVERCOAST_TO_UNREAL = 100.0f;
@@ -15,9 +15,12 @@
 #include "ec_decoder_compatibility.h"
 
 
+struct EvercoastVoxelFrameOwner;
+
+// Voxels of a decoded frame, read in place from the decoder's output
 struct EvercoastLocalVoxelFrame
 {
-	EvercoastLocalVoxelFrame(const GTHandle voxelFrame, bool makeCopy);
+	EvercoastLocalVoxelFrame(std::shared_ptr<const EvercoastVoxelFrameOwner> voxelFrame);
 	virtual ~EvercoastLocalVoxelFrame();
 
 	uint32_t m_voxelCount;
@@ -25,11 +28,12 @@ struct EvercoastLocalVoxelFrame
 	float m_boundsDim;
 	uint32_t m_bitsPerVoxel;
 
-	uint16_t* m_positionData;
-	uint8_t* m_colourData;
+	// In compact mode m_positionData holds VoxelCompactPacking elements and there's no separate colour data
+	bool m_compact;
+	const uint16_t* m_positionData;
+	const uint8_t* m_colourData;
 	uint32_t m_voxelDataSize;
 
-	bool m_madeCopy;
 	GTHandle m_voxelFrameHandle;
 
 	FBoxSphereBounds CalcBounds() const;
@@ -39,4 +43,8 @@ struct EvercoastLocalVoxelFrame
 public:
 	bool operator==(EvercoastLocalVoxelFrame& rhs) const;
 	bool operator!=(EvercoastLocalVoxelFrame& rhs) const;
+
+private:
+	// Keeps the data pointed to alive
+	std::shared_ptr<const EvercoastVoxelFrameOwner> m_voxelFrame;
 };
@@ -1,10 +1,28 @@
 #include "EvercoastPerfCounter.h"
-#include <thread>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 
-#define MEASUREMENTS_MAX_COUNT (16384)
+// Spreads the threads adding to a counter over its shards, each thread keeps the one it got first
+static std::atomic<uint32_t> s_nextShard{ 0 };
+
+static uint32_t ThreadShard()
+{
+	thread_local const uint32_t shard = s_nextShard.fetch_add(1, std::memory_order_relaxed) % EvercoastPerfCounter::SHARD_COUNT;
+	return shard;
+}
+
+static uint32_t BucketTag(int64_t sliceIndex)
+{
+	return (uint32_t)sliceIndex << EvercoastPerfCounter::BUCKET_COUNT_BITS;
+}
 
 EvercoastPerfCounter::EvercoastPerfCounter(const std::string& name, double timeSpan) :
-	_name(name), _duration(timeSpan)
+	_name(name), _shards(new Shard[SHARD_COUNT]), _histograms(new Histogram[SLICE_COUNT]()), _duration(timeSpan), _sliceDuration(timeSpan / SLICE_COUNT), _startTime(FPlatformTime::Seconds())
+{
+}
+
+EvercoastPerfCounter::~EvercoastPerfCounter()
 {
 }
 
@@ -15,166 +33,314 @@ const std::string& EvercoastPerfCounter::Name() const
 
 void EvercoastPerfCounter::AddSample()
 {
-	std::lock_guard<std::mutex> guard(_mutex);
+	Record(1, 1.0);
+}
+
+void EvercoastPerfCounter::AddSampleAsInt64(int64_t measuredData)
+{
+	Record(measuredData, (double)measuredData);
+}
+
+void EvercoastPerfCounter::AddSampleAsDouble(double measuredData)
+{
+	// Out of range or NaN would be undefined for llround, the int64 sum only saturates. Largest double below 2^63
+	const double int64Limit = 9223372036854774784.0;
+	const double rounded = measuredData == measuredData ? std::min(std::max(measuredData, -int64Limit), int64Limit) : 0.0;
+	Record((int64_t)std::llround(rounded), measuredData);
+}
 
-	DataType dataType;
-	dataType.timestamp = FPlatformTime::Seconds();
-	dataType.data.measuredInt64 = 1;
-	_measurements.push_back(dataType);
+void EvercoastPerfCounter::Record(int64_t valueInt64, double valueDouble)
+{
+	const int64_t index = (int64_t)(FPlatformTime::Seconds() / _sliceDuration.load(std::memory_order_relaxed));
+	Slice& slice = AcquireSlice(index);
 
-	// do NOT exceed the hard limit
-	while (_measurements.size() > MEASUREMENTS_MAX_COUNT)
+	slice.count.fetch_add(1, std::memory_order_relaxed);
+	slice.sumInt64.fetch_add(valueInt64, std::memory_order_relaxed);
+	double sum = slice.sumDouble.load(std::memory_order_relaxed);
+	while (!slice.sumDouble.compare_exchange_weak(sum, sum + valueDouble, std::memory_order_relaxed))
 	{
-		_measurements.pop_front();
 	}
+	AddToBucket(_histograms[index % SLICE_COUNT].buckets[BucketOf(valueDouble)], BucketTag(index));
 }
 
-void EvercoastPerfCounter::AddSampleAsInt64(int64_t measuredData)
+void EvercoastPerfCounter::AddToBucket(std::atomic<uint32_t>& bucket, uint32_t tag)
 {
-	std::lock_guard<std::mutex> guard(_mutex);
-
-	DataType dataType;
-	dataType.timestamp = FPlatformTime::Seconds();
-	dataType.data.measuredInt64 = measuredData;
+	uint32_t current = bucket.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		uint32_t next;
+		if ((current & ~BUCKET_COUNT_MASK) != tag)
+			next = tag | 1;
+		else if ((current & BUCKET_COUNT_MASK) != BUCKET_COUNT_MASK)
+			next = current + 1;
+		else
+			return;
+
+		if (bucket.compare_exchange_weak(current, next, std::memory_order_relaxed))
+			return;
+	}
+}
 
-	_measurements.push_back(dataType);
+EvercoastPerfCounter::Slice& EvercoastPerfCounter::AcquireSlice(int64_t index)
+{
+	Slice& slice = _shards[ThreadShard()].slices[index % SLICE_COUNT];
 
-	// do NOT exceed the hard limit
-	while (_measurements.size() > MEASUREMENTS_MAX_COUNT)
+	// First one in since this slot was last used takes it over and zeroes it. A sample added by another thread
+	// of the same shard right at the turn over may get cleared along, which is fine for stats.
+	int64_t current = slice.index.load(std::memory_order_acquire);
+	while (current < index)
 	{
-		_measurements.pop_front();
+		if (slice.index.compare_exchange_weak(current, index, std::memory_order_acq_rel))
+		{
+			slice.count.store(0, std::memory_order_relaxed);
+			slice.sumInt64.store(0, std::memory_order_relaxed);
+			slice.sumDouble.store(0, std::memory_order_relaxed);
+			break;
+		}
 	}
+
+	return slice;
 }
-void EvercoastPerfCounter::AddSampleAsDouble(double measuredData)
+
+void EvercoastPerfCounter::Merge(MergedWindow& merged, bool withBuckets)
 {
-	std::lock_guard<std::mutex> guard(_mutex);
+	const double now = FPlatformTime::Seconds();
+	const double sliceDuration = _sliceDuration.load(std::memory_order_relaxed);
+	const int64_t currentIndex = (int64_t)(now / sliceDuration);
+	const int64_t oldestIndex = currentIndex - SLICE_COUNT + 1;
+
+	merged.count = 0;
+	merged.sumInt64 = 0;
+	merged.sumDouble = 0;
+	if (withBuckets)
+	{
+		std::fill(std::begin(merged.buckets), std::end(merged.buckets), 0);
+	}
 
-	DataType dataType;
-	dataType.timestamp = FPlatformTime::Seconds();
-	dataType.data.measuredDouble = measuredData;
-	_measurements.push_back(dataType);
+	for (int s = 0; s < SHARD_COUNT; ++s)
+	{
+		for (const Slice& slice : _shards[s].slices)
+		{
+			const int64_t index = slice.index.load(std::memory_order_acquire);
+			if (index < oldestIndex || index > currentIndex)
+				continue;
+
+			merged.count += slice.count.load(std::memory_order_relaxed);
+			merged.sumInt64 += slice.sumInt64.load(std::memory_order_relaxed);
+			merged.sumDouble += slice.sumDouble.load(std::memory_order_relaxed);
+		}
+	}
 
-	// do NOT exceed the hard limit
-	while (_measurements.size() > MEASUREMENTS_MAX_COUNT)
+	if (withBuckets)
 	{
-		_measurements.pop_front();
+		// Each histogram holds the one slice of the window that maps onto it. Buckets tagged with an older one
+		// are cleared on the way, so they can't alias a slice 2^12 indices later, but not those a writer has
+		// already started the next slice in.
+		for (int64_t index = oldestIndex; index <= currentIndex; ++index)
+		{
+			const uint32_t tag = BucketTag(index);
+			const uint32_t nextTag = BucketTag(index + SLICE_COUNT);
+			std::atomic<uint32_t>* buckets = _histograms[index % SLICE_COUNT].buckets;
+			for (int b = 0; b < BUCKET_COUNT; ++b)
+			{
+				uint32_t bucket = buckets[b].load(std::memory_order_relaxed);
+				if ((bucket & ~BUCKET_COUNT_MASK) == tag)
+				{
+					merged.buckets[b] += bucket & BUCKET_COUNT_MASK;
+				}
+				else if (bucket != 0 && (bucket & ~BUCKET_COUNT_MASK) != nextTag)
+				{
+					// Fails if a writer got there first, which is just as good
+					buckets[b].compare_exchange_strong(bucket, 0, std::memory_order_relaxed);
+				}
+			}
+		}
 	}
+
+	// The current slice is only partly through, and there may not be a whole time span since the start
+	const double covered = (SLICE_COUNT - 1) * sliceDuration + (now - currentIndex * sliceDuration);
+	merged.coveredTime = std::max(std::min(covered, now - _startTime.load(std::memory_order_relaxed)), sliceDuration);
 }
 
-void EvercoastPerfCounter::TrimToTimespan()
+int EvercoastPerfCounter::BucketOf(double value)
 {
-	// Trim to the timespan
-	double currTime = FPlatformTime::Seconds();
-	while (!_measurements.empty() && currTime - _measurements[0].timestamp > _duration)
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const int biasedExponent = (int)((bits >> 52) & 0x7ff);
+	// Zero, denormals and NaN
+	if (biasedExponent == 0 || value != value)
+		return MAGNITUDE_BUCKET_COUNT;
+
+	int exponent = biasedExponent - 1023 - EXPONENT_MIN;
+	int subBucket = (int)((bits >> (52 - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+	if (exponent < 0)
 	{
-		_measurements.pop_front();
+		exponent = 0;
+		subBucket = 0;
 	}
+	else if (exponent >= EXPONENT_COUNT)
+	{
+		exponent = EXPONENT_COUNT - 1;
+		subBucket = SUB_BUCKET_COUNT - 1;
+	}
+
+	const int magnitude = exponent * SUB_BUCKET_COUNT + subBucket;
+	// Ordered by value, most negative first
+	return (bits >> 63) ? MAGNITUDE_BUCKET_COUNT - 1 - magnitude : MAGNITUDE_BUCKET_COUNT + 1 + magnitude;
 }
 
-size_t EvercoastPerfCounter::GetSampleCount()
+double EvercoastPerfCounter::BucketValue(int bucket)
 {
-	std::lock_guard<std::mutex> guard(_mutex);
-	
-	TrimToTimespan();
-	return _measurements.size();
+	if (bucket == MAGNITUDE_BUCKET_COUNT)
+		return 0.0;
+
+	const bool negative = bucket < MAGNITUDE_BUCKET_COUNT;
+	const int magnitude = negative ? MAGNITUDE_BUCKET_COUNT - 1 - bucket : bucket - MAGNITUDE_BUCKET_COUNT - 1;
+	const int exponent = magnitude / SUB_BUCKET_COUNT + EXPONENT_MIN;
+	const int subBucket = magnitude % SUB_BUCKET_COUNT;
+
+	// Middle of the bucket
+	const double value = std::ldexp(1.0 + (subBucket + 0.5) / SUB_BUCKET_COUNT, exponent);
+	return negative ? -value : value;
 }
 
-double EvercoastPerfCounter::GetSampleAccumulatedDouble()
+double EvercoastPerfCounter::Percentile(const MergedWindow& merged, double percentile)
 {
-	std::lock_guard<std::mutex> guard(_mutex);
-	TrimToTimespan();
+	uint64_t total = 0;
+	for (uint64_t count : merged.buckets)
+	{
+		total += count;
+	}
 
-	double accumulated = 0.0;
-	for (auto it = _measurements.begin(); it != _measurements.end(); ++it)
+	if (total == 0)
+		return -1.0;
+
+	const uint64_t target = std::min(std::max((uint64_t)std::ceil(std::min(std::max(percentile, 0.0), 1.0) * total), (uint64_t)1), total);
+	uint64_t accumulated = 0;
+	for (int b = 0; b < BUCKET_COUNT; ++b)
 	{
-		accumulated += (*it).data.measuredDouble;
+		accumulated += merged.buckets[b];
+		if (accumulated >= target)
+			return BucketValue(b);
 	}
 
-	return accumulated;
+	return BucketValue(BUCKET_COUNT - 1);
 }
 
+size_t EvercoastPerfCounter::GetSampleCount()
+{
+	MergedWindow merged;
+	Merge(merged, false);
+	return (size_t)merged.count;
+}
 
-int64_t EvercoastPerfCounter::GetSampleAccumulatedInt64()
+double EvercoastPerfCounter::GetSampleAccumulatedDouble()
 {
-	std::lock_guard<std::mutex> guard(_mutex);
-	TrimToTimespan();
+	MergedWindow merged;
+	Merge(merged, false);
+	return merged.sumDouble;
+}
 
-	int64_t accumulated = 0;
-	for (auto it = _measurements.begin(); it != _measurements.end(); ++it)
-	{
-		accumulated += (*it).data.measuredInt64;
-	}
 
-	return accumulated;
+int64_t EvercoastPerfCounter::GetSampleAccumulatedInt64()
+{
+	MergedWindow merged;
+	Merge(merged, false);
+	return merged.sumInt64;
 }
 
 
 // NOTE: this assume the measured data is in unit(1)
 double EvercoastPerfCounter::GetSampleAverageInt64OnCount()
 {
-	size_t count = GetSampleCount();
-	int64_t accum = GetSampleAccumulatedInt64();
-	{
-		if (count == 0)
-			return -1.0;
+	MergedWindow merged;
+	Merge(merged, false);
+	if (merged.count == 0)
+		return -1.0;
 
-
-		return (double)accum / count;
-	}
-	
+	return (double)merged.sumInt64 / merged.count;
 }
 
 double EvercoastPerfCounter::GetSampleAverageDoubleOnCount()
 {
-	size_t count = GetSampleCount();
-	double accum = GetSampleAccumulatedDouble();
-	{
-		if (count == 0)
-			return -1.0;
-
-
-		return accum / count;
-	}
+	MergedWindow merged;
+	Merge(merged, false);
+	if (merged.count == 0)
+		return -1.0;
 
+	return merged.sumDouble / merged.count;
 }
 
 
 double EvercoastPerfCounter::GetSampleAverageInt64OnDuration()
 {
-	size_t count = GetSampleCount();
-	int64_t accum = GetSampleAccumulatedInt64();
-	{
-		if (count == 0)
-			return -1.0;
+	MergedWindow merged;
+	Merge(merged, false);
+	if (merged.count == 0)
+		return -1.0;
 
-
-		std::lock_guard<std::mutex> guard(_mutex);
-		return (double)accum / _duration;
-	}
+	return (double)merged.sumInt64 / merged.coveredTime;
 }
 
 
 double EvercoastPerfCounter::GetSampleAverageDoubleOnDuration()
 {
-	size_t count = GetSampleCount();
-	double accum = GetSampleAccumulatedDouble();
-	{
-		if (count == 0)
-			return -1.0;
+	MergedWindow merged;
+	Merge(merged, false);
+	if (merged.count == 0)
+		return -1.0;
 
+	return merged.sumDouble / merged.coveredTime;
+}
 
-		return accum / _duration;
-	}
+double EvercoastPerfCounter::GetSamplePercentile(double percentile)
+{
+	MergedWindow merged;
+	Merge(merged, true);
+	return Percentile(merged, percentile);
+}
+
+EvercoastPerfCounter::Summary EvercoastPerfCounter::GetSummary()
+{
+	MergedWindow merged;
+	Merge(merged, true);
+
+	Summary summary;
+	summary.count = (size_t)merged.count;
+	summary.accumulated = merged.sumDouble;
+	summary.rate = merged.sumDouble / merged.coveredTime;
+	summary.p50 = Percentile(merged, 0.5);
+	summary.p95 = Percentile(merged, 0.95);
+	summary.p99 = Percentile(merged, 0.99);
+	return summary;
 }
 
 
 void EvercoastPerfCounter::SetTimespan(double newTimespan)
 {
-	std::lock_guard<std::mutex> guard(_mutex);
 	_duration = newTimespan;
+	_sliceDuration = newTimespan / SLICE_COUNT;
+	Reset();
 }
 
 void EvercoastPerfCounter::Reset()
 {
-	_measurements.clear();
-}
\ No newline at end of file
+	for (int s = 0; s < SHARD_COUNT; ++s)
+	{
+		for (Slice& slice : _shards[s].slices)
+		{
+			// Zeroed by whoever takes the slot next
+			slice.index.store(-1, std::memory_order_release);
+		}
+	}
+	// A new time span brings new slice indices, which may carry the same tags
+	for (int h = 0; h < SLICE_COUNT; ++h)
+	{
+		for (auto& bucket : _histograms[h].buckets)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+	_startTime = FPlatformTime::Seconds();
+}
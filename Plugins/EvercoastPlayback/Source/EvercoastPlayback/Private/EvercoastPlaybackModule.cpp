@@ -13,6 +13,7 @@
 #include "Modules/ModuleManager.h"
 #include "Interfaces/IPluginManager.h"
 #include "GhostTreeFormatReader.h"
+#include "ReaderPersistentCache.h"
 #include "InstructionSet.h"
 #include "EvercoastVoxelDecoder.h"
 #include "picoquic.h"
@@ -91,6 +92,7 @@ void FEvercoastPlaybackModule::ShutdownModule()
 	}
 
 	RemoveAllDiskCacheFiles();
+	ReaderPersistentCache::ShutdownIfLoaded();
 }
 
 bool FEvercoastPlaybackModule::SupportsDynamicReloading()
@@ -308,6 +308,15 @@ std::vector<std::shared_ptr<IEvercoastStreamingDataUploader>> UEvercoastRenderer
 	return uploaders;
 }
 
+bool UEvercoastRendererSelectorComp::GetRenderedBounds(FBoxSphereBounds& outBounds) const
+{
+	if (!m_currRenderer)
+		return false;
+
+	outBounds = m_currRenderer->Bounds;
+	return true;
+}
+
 #if WITH_EDITOR
 void UEvercoastRendererSelectorComp::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
@@ -12,9 +12,11 @@
 #include "Components/AudioComponent.h"
 #include <memory>
 #include <map>
+#include <algorithm>
 #include "ec/reading/API_events.h"
 #include "TimestampedMediaTexture.h"
 #include "Kismet/GameplayStatics.h"
+#include "Camera/PlayerCameraManager.h"
 
 #include "FFmpegVideoTextureHog.h"
 
@@ -23,9 +25,17 @@
 #include "CortoWebpUnifiedDecodeResult.h"
 #include "RuntimeAudio.h"
 #include "EvercoastVolcapActor.h"
+#include "ReaderPersistentCache.h"
+#include "VoxelLODPolicy.h"
+#include "Engine/GameViewportClient.h"
 
 static std::map<GTHandle, UEvercoastStreamingReaderComp*> s_readerCompRegistry;
 
+// Readers with screen size voxel LOD on, evaluated together once per engine frame on the game thread
+static std::vector<UEvercoastStreamingReaderComp*> s_voxelLODReaders;
+static uint64 s_voxelLODEvaluatedFrame = (uint64)-1;
+static VoxelLODPolicy s_voxelLODPolicy;
+
 extern UGhostTreeFormatReader* find_reader(GTHandle reader_inst);
 static UEvercoastStreamingReaderComp* find_reader_comp(GTHandle reader_inst)
 {
@@ -139,9 +149,9 @@ public:
 		return find_reader(reader_inst)->OnReaderReadFromConnection(conn_handle, request);
 	}
 
-	static bool cancel_connection_request(GTHandle handle, uint32_t conn_handle, uint32_t requestId)
+	static bool cancel_connection_request(GTHandle reader_inst, uint32_t conn_handle, uint32_t requestId)
 	{
-		return true;
+		return find_reader(reader_inst)->OnCancelConnectionRequest(conn_handle, requestId);
 	}
 
 	static bool read_from_cache(GTHandle handle, ReadRequest request)
@@ -183,7 +193,10 @@ UEvercoastStreamingReaderComp::UEvercoastStreamingReaderComp(const FObjectInitia
 	m_readerHasFatalError(false),
 	m_currentMatchingFrameNumber(0),
 	m_currentMatchingTimestamp(0.0f),
-	m_lastDueTimestamp(0)
+	m_lastDueTimestamp(0),
+	m_voxelLODScreenRadius(0),
+	m_voxelLOD(0),
+	m_voxelLODRegistered(false)
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
@@ -194,6 +207,7 @@ UEvercoastStreamingReaderComp::UEvercoastStreamingReaderComp(const FObjectInitia
 
 UEvercoastStreamingReaderComp::~UEvercoastStreamingReaderComp()
 {
+	StopVoxelLOD();
 	ResetReader();
 }
 
@@ -234,6 +248,13 @@ void UEvercoastStreamingReaderComp::CreateReader()
 
 	m_reader->SetUsingMemoryCache(bForceMemoryCache);
 	m_reader->SetPreferExternalVideoData(bPreferVideoCodec);
+	m_reader->SetHttpRequestLimits((uint32_t)FMath::Max(MaxConcurrentHttpRequests, 1), (uint32_t)FMath::Max(HttpMaxRetries, 0), HttpRequestTimeoutInSeconds);
+	m_reader->SetUsingPersistentCache(bUsePersistentCache);
+	m_reader->SetAdaptiveBitRate(bAdaptiveBitRate);
+	if (bUsePersistentCache)
+	{
+		ReaderPersistentCache::Get().SetCapacity(1024ull * 1024ull * FMath::Max(PersistentCacheSizeInMB, 64));
+	}
 	
 	if (!ECVAsset)
 	{
@@ -278,6 +299,14 @@ void UEvercoastStreamingReaderComp::CreateReader()
 	}
 
 	m_dataDecoder = std::make_shared<EvercoastAsyncStreamingDataDecoder>(m_baseDecoderType);
+	if (m_baseDecoderType == DT_EvercoastVoxel && m_voxelLOD > 0)
+	{
+		m_dataDecoder->SetRequiredVoxelLOD(m_voxelLOD);
+	}
+	if (m_baseDecoderType == DT_EvercoastVoxel && bCompactVoxelData)
+	{
+		m_dataDecoder->SetCompactVoxels(true);
+	}
 
 	m_fileOpenPromise = std::promise<void>();
 	m_fileOpenFuture = m_fileOpenPromise.get_future();
@@ -313,6 +342,7 @@ void UEvercoastStreamingReaderComp::ResetReader()
 	m_currentMatchingTimestamp = 0.0f;
 	m_audioComponent = nullptr;
 	m_lastDueTimestamp = 0;
+	m_voxelLODCounts.clear();
 
 }
 
@@ -334,6 +364,8 @@ void UEvercoastStreamingReaderComp::OnUnregister()
 {
 	Super::OnUnregister();
 
+	StopVoxelLOD();
+
 	if (!GIsCookerLoadingPackage)
 	{
 		ResetReader();
@@ -700,6 +732,11 @@ void UEvercoastStreamingReaderComp::NotifyReceivedChannelsInfo()
 				UE_LOG(EvercoastReaderLog, Log, TEXT("%s using ffmpeg decoder."), *UGameplayStatics::GetPlatformName());
 			}
 
+			if (UFFmpegVideoTextureHog* ffmpegHog = Cast<UFFmpegVideoTextureHog>(m_videoTextureHog))
+			{
+				ffmpegHog->SetHardwareDecodePreferred(bHardwareVideoDecode);
+			}
+
 			//m_cortoTexSeekStage = CTS_DEFAULT;
 			m_gtSeekStage = GTS_DEFAULT;
 			m_vdSeekStage = VDS_DEFAULT;
@@ -1325,6 +1362,12 @@ void UEvercoastStreamingReaderComp::TickNormalPlayback(float clipDuration)
 						}
 						m_currentMatchingFrameNumber = result->frameIndex;
 						m_currentMatchingTimestamp = result->frameTimestamp;
+
+						if (result->GetType() == DecodeResultType::DRT_EvercoastVoxel)
+						{
+							auto voxelResult = std::static_pointer_cast<EvercoastVoxelDecodeResult>(result);
+							m_voxelLODCounts.assign(voxelResult->lodVoxelCounts, voxelResult->lodVoxelCounts + voxelResult->lodCount);
+						}
 					}
 					else
 					{
@@ -1602,6 +1645,17 @@ void UEvercoastStreamingReaderComp::TickComponent(float DeltaTime, ELevelTick Ti
 	
 
 
+	/////////////////////////////////////////
+	// Voxel level of detail
+	if (bScreenSizeVoxelLOD && m_baseDecoderType == DT_EvercoastVoxel && m_dataDecoder)
+	{
+		UpdateVoxelLOD();
+	}
+	else
+	{
+		StopVoxelLOD();
+	}
+
 	/////////////////////////////////////////
 	// Misc components tick
 	if (m_reader)
@@ -1612,6 +1666,103 @@ void UEvercoastStreamingReaderComp::TickComponent(float DeltaTime, ELevelTick Ti
 	/////////////////////////////////////////
 }
 
+void UEvercoastStreamingReaderComp::UpdateVoxelLOD()
+{
+	// Needs a player camera, otherwise LOD stays where it is
+	UWorld* world = GetWorld();
+	APlayerCameraManager* cameraManager = world ? UGameplayStatics::GetPlayerCameraManager(world, 0) : nullptr;
+	UGameViewportClient* viewportClient = world ? world->GetGameViewport() : nullptr;
+	FBoxSphereBounds bounds;
+	if (!cameraManager || !viewportClient || !Renderer || !Renderer->GetRenderedBounds(bounds))
+		return;
+
+	if (!m_voxelLODRegistered)
+	{
+		s_voxelLODReaders.push_back(this);
+		m_voxelLODRegistered = true;
+	}
+
+	FVector2D viewportSize;
+	viewportClient->GetViewportSize(viewportSize);
+
+	const FVector cameraLocation = cameraManager->GetCameraLocation();
+	const FVector toBounds = bounds.Origin - cameraLocation;
+	if (!Renderer->IsVisible() || FVector::DotProduct(toBounds, cameraManager->GetCameraRotation().Vector()) < -bounds.SphereRadius)
+	{
+		// Hidden or behind the camera
+		m_voxelLODScreenRadius = 0;
+	}
+	else
+	{
+		// Camera FOV is horizontal
+		m_voxelLODScreenRadius = VoxelLODPolicy::ProjectedRadiusInPixels(bounds.SphereRadius, toBounds.Size(),
+			FMath::DegreesToRadians(cameraManager->GetFOVAngle()), viewportSize.X);
+	}
+
+	// Whoever ticks first in a frame decides for everyone, using the others' latest state
+	if (s_voxelLODEvaluatedFrame != GFrameCounter)
+	{
+		s_voxelLODEvaluatedFrame = GFrameCounter;
+		EvaluateVoxelLOD();
+	}
+}
+
+void UEvercoastStreamingReaderComp::StopVoxelLOD()
+{
+	if (m_voxelLODRegistered)
+	{
+		s_voxelLODReaders.erase(std::remove(s_voxelLODReaders.begin(), s_voxelLODReaders.end(), this), s_voxelLODReaders.end());
+		m_voxelLODRegistered = false;
+	}
+
+	// Back to full detail
+	if (m_voxelLOD != 0 && m_dataDecoder && m_baseDecoderType == DT_EvercoastVoxel)
+	{
+		SetVoxelLOD(0);
+	}
+}
+
+void UEvercoastStreamingReaderComp::SetVoxelLOD(uint32_t lod)
+{
+	if (lod == m_voxelLOD)
+		return;
+
+	UE_LOG(EvercoastReaderLog, Verbose, TEXT("%s voxel LOD %u -> %u"), *GetName(), m_voxelLOD, lod);
+	m_voxelLOD = lod;
+	if (m_dataDecoder)
+	{
+		m_dataDecoder->SetRequiredVoxelLOD(lod);
+	}
+}
+
+void UEvercoastStreamingReaderComp::EvaluateVoxelLOD()
+{
+	if (s_voxelLODReaders.empty())
+		return;
+
+	VoxelLODConfig config = s_voxelLODPolicy.GetConfig();
+	int32 budgetInThousands = INT32_MAX;
+	std::vector<VoxelLODRequest> requests(s_voxelLODReaders.size());
+	for (size_t i = 0; i < s_voxelLODReaders.size(); ++i)
+	{
+		const UEvercoastStreamingReaderComp* reader = s_voxelLODReaders[i];
+		requests[i].projectedRadiusInPixels = reader->m_voxelLODScreenRadius;
+		requests[i].targetPixelsPerVoxel = FMath::Max(reader->TargetPixelsPerVoxel, 0.1f);
+		requests[i].lodVoxelCounts = reader->m_voxelLODCounts;
+		requests[i].currentLOD = reader->m_voxelLOD;
+		budgetInThousands = FMath::Min(budgetInThousands, reader->VoxelLODBudgetInThousands);
+	}
+	config.globalVoxelBudget = 1000ull * (uint64_t)FMath::Max(budgetInThousands, 1);
+	s_voxelLODPolicy.SetConfig(config);
+
+	std::vector<uint32_t> lods;
+	s_voxelLODPolicy.Evaluate(requests, lods);
+	for (size_t i = 0; i < s_voxelLODReaders.size(); ++i)
+	{
+		s_voxelLODReaders[i]->SetVoxelLOD(lods[i]);
+	}
+}
+
 UTexture* UEvercoastStreamingReaderComp::FindVideoTexture(int64_t frameIndex) const
 {
 	check(m_videoTextureHog);
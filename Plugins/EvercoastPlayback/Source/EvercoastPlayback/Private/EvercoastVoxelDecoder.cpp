@@ -1,4 +1,7 @@
 #include "EvercoastVoxelDecoder.h"
+#include "VoxelCompactPacking.h"
+#include <algorithm>
+#include <cstring>
 
 DEFINE_LOG_CATEGORY(EvercoastVoxelDecoderLog);
 
@@ -54,8 +57,17 @@ bool EvercoastVoxelDecoder::DecodeMemoryStream(const uint8_t* stream, size_t str
 	}
 
 	EvercoastVoxelDecodeOption* evercoastOption = static_cast<EvercoastVoxelDecodeOption*>(option);
+	Definition definition = evercoastOption->definition;
 
-	if (!decoder_decode(m_interface, evercoastOption->definition))
+	// The LOD requested may not exist in every frame, take the coarsest available then
+	uint32_t lodVoxelCounts[DECODER_MAX_LOD_COUNT];
+	const uint32_t lodCount = ReadLODVoxelCounts(lodVoxelCounts);
+	if (lodCount > 0 && definition.required_lod >= lodCount)
+	{
+		definition.required_lod = (uint8_t)(lodCount - 1);
+	}
+
+	if (!decoder_decode(m_interface, definition))
 	{
 		UE_LOG(EvercoastVoxelDecoderLog, Warning, TEXT("Decode failed. Cannot decode"));
 		return false;
@@ -83,10 +95,48 @@ bool EvercoastVoxelDecoder::DecodeMemoryStream(const uint8_t* stream, size_t str
 
 	UE_LOG(EvercoastVoxelDecoderLog, Verbose, TEXT("Decode successful: frame %d, voxel count: %d"), frameDef.frame_number, frameDef.voxel_count);
 
-	m_result = std::make_shared<EvercoastVoxelDecodeResult>(true, timestamp, frameIndex, voxelFrame);
+	// Still on the decode thread and nobody else has seen the frame, so its coordinates can be rewritten
+	if (evercoastOption->compactVoxels)
+	{
+		VoxelCompactPacking::PackInPlace(reinterpret_cast<uint16_t*>(voxel_frame_get_coordinates(voxelFrame)),
+			reinterpret_cast<const uint8_t*>(voxel_frame_get_colours(voxelFrame)), frameDef.voxel_count);
+	}
+
+	m_result = std::make_shared<EvercoastVoxelDecodeResult>(true, timestamp, frameIndex, voxelFrame, evercoastOption->compactVoxels);
+	m_result->lod = definition.required_lod;
+	m_result->lodCount = lodCount;
+	memcpy(m_result->lodVoxelCounts, lodVoxelCounts, lodCount * sizeof(uint32_t));
 	return true;
 }
 
+uint32_t EvercoastVoxelDecoder::ReadLODVoxelCounts(uint32_t* outCounts) const
+{
+	GTHandle headerInfo = decoder_get_frame_header_info(m_interface);
+	if (headerInfo == InvalidHandle)
+		return 0;
+
+	// Counts are indexed by tree level, the deepest valid level being LOD0
+	uint32_t lodCount = 0;
+	FrameHeaderInfo info;
+	if (frame_header_info_get_info(headerInfo, &info) && info.max_valid_level >= info.min_valid_level)
+	{
+		uint32_t levelVoxelCounts[32];
+		const uint32_t levelCount = std::min(frame_header_info_level_voxel_counts(headerInfo, levelVoxelCounts, 32), 32u);
+		const uint32_t maxLevel = std::min(info.max_valid_level, levelCount - 1);
+		if (levelCount > 0 && maxLevel >= info.min_valid_level)
+		{
+			lodCount = std::min(maxLevel - info.min_valid_level + 1, DECODER_MAX_LOD_COUNT);
+			for (uint32_t lod = 0; lod < lodCount; ++lod)
+			{
+				outCounts[lod] = levelVoxelCounts[maxLevel - lod];
+			}
+		}
+	}
+
+	release_frame_header_info_instance(headerInfo);
+	return lodCount;
+}
+
 std::shared_ptr<GenericDecodeResult> EvercoastVoxelDecoder::TakeResult()
 {
 	return std::move(m_result);
@@ -0,0 +1,1148 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/FileManager.h"
+#include "GhostTreeFormatReader.h"
+#include "YUVConversion.h"
+#include <inttypes.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// FFmpeg headers are only C compatible
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+#include "libavutil/hwcontext.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+}
+
+// Demuxes and decodes the sidecar video on its own thread, driven by commands. Decoded frames only leave through the
+// callbacks given to CommandOpenFile(), so it runs without UFFmpegVideoTextureHog or a renderer as well.
+class FFFmpegDecodingThread final : public FRunnable
+{
+	AVFormatContext*		m_videoFormatCtx;
+	AVIOContext*			m_videoIOCtx;
+	const AVCodec*			m_videoCodec;
+	AVCodecParameters*		m_videoCodecParam;
+	AVCodecContext*			m_videoCodecCtx;
+	AVFrame*				m_currVideoFrame;
+	AVPacket*				m_currVideoPacket;
+	AVRational				m_videoTimebase;
+	int32_t					m_videoFrameRate = -1;
+	int32_t					m_videoStreamIndex = -1;
+	// pts units of one frame, for streams not telling each frame's duration
+	int64_t					m_framePtsDuration = 1;
+
+	// Frame threading keeps up to thread_count frames inside the decoder, more than that doesn't pay off
+	static constexpr int	MAX_DECODE_THREAD_COUNT = 16;
+	// Set once end of stream is sent to the decoder, the frames it still holds are then received one per decode step
+	bool					m_decoderDraining = false;
+
+	// Hardware decoding, only when asked for and a device can be created. Otherwise all is software.
+	bool					m_preferHardwareDecode = false;
+	AVBufferRef*			m_hwDeviceCtx;
+	AVPixelFormat			m_hwPixelFormat;
+	// Hardware frames get downloaded here
+	AVFrame*				m_transferFrame;
+	// Pixel formats other than 8 bit YUV420P(NV12, P010, 10 bit planar etc.) get converted into buffers of this pool.
+	// Each converted frame holds its buffer until the render thread is done with it.
+	SwsContext*				m_swsCtx;
+	AVBufferPool*			m_convertedPlanePool;
+	int						m_convertedPoolWidth = 0;
+	int						m_convertedPoolHeight = 0;
+	int						m_convertedLinesizes[4];
+	AVPixelFormat			m_lastConvertedFormat;
+
+	// Keyframe timestamps of the video stream in ascending order, taken from the demuxer's index once per file.
+	// Empty when the container has no index, seeking then relies on av_seek_frame() alone.
+	std::vector<int64_t>	m_keyframeTimestamps;
+	// Pts of the last frame out of the decoder, handed over or not
+	int64_t					m_lastDecodedPts;
+	// After a seek, frames ending before this pts are decoded but not converted
+	int64_t					m_discardBeforePts;
+	int32_t					m_seekDiscardedFrames = 0;
+	std::chrono::steady_clock::time_point m_seekStartTime;
+
+	enum Command
+	{
+		CMD_NOP = 0,
+		CMD_OPEN,
+		CMD_DECODE,
+		CMD_SEEK,
+		CMD_CLOSE,
+		CMD_CLOSE_THEN_STOP
+	};
+
+	struct CommandPayload
+	{
+		Command cmd;
+		std::function<void(void)> payload;
+
+		CommandPayload(Command cmd, const std::function<void(void)>& payload) :
+			cmd(cmd), payload(payload)
+		{
+		}
+
+		void RunPayload()
+		{
+			if (payload)
+				payload();
+		}
+	};
+
+	char					m_openFilename[2048];
+	double					m_seekTargetTimestamp = 0;
+	int64_t					m_lastHoggedFramePts = 0;
+	int64_t					m_lastHoggedFrameIndex = -1;
+	std::function<void(int64_t, int32_t, int, int)>	
+							m_openingCompletedCallback;
+	std::function<void(int64_t)>
+							m_reachedStreamEndCallback;
+	std::function<void(double, int64_t, int64_t, int, int, uint32_t, uint32_t, uint32_t, uint8_t*, uint8_t*, uint8_t*, YUVConversion::Matrix, bool, std::shared_ptr<void>)>	
+							m_convertTextureCallback;
+	std::function<void()>	m_seekCompletedCallback;
+	std::function<bool()>	m_checkBufferFullCallback;
+	std::function<void(bool)> m_bufferFullCallback;
+
+	Command					m_currCmd{ Command::CMD_NOP };
+	std::deque<CommandPayload>	m_cmdQueue;
+	mutable std::mutex		m_cmdQueueAccessMutex;
+
+	std::atomic<bool>		m_running{ false };
+	
+	mutable std::mutex		m_cmdCondMutex;
+	std::condition_variable	m_cmdCond;
+	mutable std::mutex		m_semaphoreCountMutex;
+	int						m_semaphoreCount { 0 };
+
+
+	std::promise<void>		m_openingPromise;
+	std::future<void>		m_openingFuture;
+
+	TSharedPtr<FArchive, ESPMode::NotThreadSafe> m_fileStream;
+	
+	void*					m_ioBuffer = nullptr;
+
+public:
+	virtual bool Init() override
+	{
+		m_seekTargetTimestamp = 0;
+		m_videoFormatCtx = nullptr;
+		m_videoIOCtx = nullptr;
+		m_videoCodec = nullptr;
+		m_videoCodecParam = nullptr;
+		m_videoCodecCtx = nullptr;
+		m_currVideoFrame = nullptr;
+		m_currVideoPacket = nullptr;
+		m_videoTimebase = av_make_q(0, 1);
+		m_videoFrameRate = -1;
+		m_videoStreamIndex = -1;
+		m_framePtsDuration = 1;
+		m_decoderDraining = false;
+		m_hwDeviceCtx = nullptr;
+		m_hwPixelFormat = AV_PIX_FMT_NONE;
+		m_transferFrame = nullptr;
+		m_swsCtx = nullptr;
+		m_convertedPlanePool = nullptr;
+		m_convertedPoolWidth = 0;
+		m_convertedPoolHeight = 0;
+		m_lastConvertedFormat = AV_PIX_FMT_NONE;
+		m_lastDecodedPts = AV_NOPTS_VALUE;
+		m_discardBeforePts = AV_NOPTS_VALUE;
+		m_ioBuffer = nullptr;
+
+		m_openFilename[0] = 0;
+		m_currCmd = Command::CMD_NOP;
+		m_running = true;
+
+		return true;
+	}
+
+	void CommandOpenFile(const char* filename, std::function<void(int64_t, int32_t, int, int)> onOpenedCallback, std::function<void(int64_t)> onReachedVideoEndCallback,
+		std::function<void(double, int64_t, int64_t, int, int, uint32_t, uint32_t, uint32_t, uint8_t*, uint8_t*, uint8_t*, YUVConversion::Matrix, bool, std::shared_ptr<void>)> convertTextureCallback,
+		std::function<bool(void)> checkBufferFullCallback, std::function<void(bool)> bufferFullCallback, bool preferHardwareDecode)
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+
+		// Copy the string outside the lambda for sake of simplicity...
+#if PLATFORM_WINDOWS
+		strncpy_s(m_openFilename, 2048, filename, strlen(filename));
+#else
+		strncpy(m_openFilename, filename, 2048);
+#endif
+
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_OPEN, [this, onOpenedCallback, onReachedVideoEndCallback, convertTextureCallback, checkBufferFullCallback, bufferFullCallback, preferHardwareDecode]() {
+			m_seekTargetTimestamp = 0;
+			m_preferHardwareDecode = preferHardwareDecode;
+			m_openingCompletedCallback = onOpenedCallback;
+			m_reachedStreamEndCallback = onReachedVideoEndCallback;
+			m_convertTextureCallback = convertTextureCallback;
+			m_checkBufferFullCallback = checkBufferFullCallback;
+			m_bufferFullCallback = bufferFullCallback;
+
+			m_openingPromise = std::promise<void>();
+			m_openingFuture = m_openingPromise.get_future();
+		}));
+
+		Notify();
+	}
+
+	
+
+	void CommandResumeDecoding()
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_DECODE, nullptr));
+		Notify();
+	}
+
+	void CommandPauseDecoding()
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_NOP, nullptr));
+
+		Notify();
+	}
+
+	void CommandSeekTo(double timestamp, std::function<void()> onSeekCompletedCallback )
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_SEEK, [this, timestamp, onSeekCompletedCallback]() {
+				m_seekTargetTimestamp = timestamp;
+				m_seekCompletedCallback = onSeekCompletedCallback;
+			}));
+		
+		Notify();
+	}
+
+	void CommandSeekRelative(double timestampOffset, std::function<void()> onSeekCompletedCallback)
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_SEEK, [this, timestampOffset, onSeekCompletedCallback]() {
+				double timestamp = Framenumber2Timestamp(m_lastHoggedFramePts) + timestampOffset;
+				if (timestamp < 0)
+					timestamp = 0;
+
+				m_seekTargetTimestamp = timestamp;
+				m_seekCompletedCallback = onSeekCompletedCallback;
+			}));
+
+		
+		Notify();
+	}
+
+
+	void CommandClose()
+	{
+		SyncOpenFile();
+
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_CLOSE, nullptr));
+		Notify();
+	}
+
+	void CommandCloseThenStop()
+	{
+		SyncOpenFile();
+
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+		m_cmdQueue.push_back(CommandPayload(Command::CMD_CLOSE_THEN_STOP, nullptr));
+		Notify();
+	}
+
+	bool IsDecoding() const
+	{
+		std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+		return m_currCmd == Command::CMD_DECODE;
+	}
+	
+	void WaitForNotify()
+	{
+		int newCount;
+		{
+			std::lock_guard<std::mutex> lock(m_semaphoreCountMutex);
+			m_semaphoreCount--;
+
+			newCount = m_semaphoreCount;
+		}
+
+		if (newCount < 0)
+		{
+			std::unique_lock<std::mutex> newCmdLock(m_cmdCondMutex);
+			m_cmdCond.wait(newCmdLock);
+		}
+		
+	}
+
+	void Notify()
+	{
+		int oldCount;
+		{
+			std::lock_guard<std::mutex> lock(m_semaphoreCountMutex);
+			oldCount = m_semaphoreCount;
+			m_semaphoreCount++;
+		}
+
+		if (oldCount < 0)
+		{
+			m_cmdCond.notify_one();
+		}
+	}
+
+	virtual uint32 Run() override
+	{
+		while (m_running)
+		{
+			// Get the next command
+			{
+				std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+				if (!m_cmdQueue.empty())
+				{
+					CommandPayload& commandPayload = m_cmdQueue.front();
+					m_currCmd = commandPayload.cmd;
+					commandPayload.RunPayload();
+
+					m_cmdQueue.pop_front();
+				}
+			}
+
+			// Wait special command NOP
+			if (m_currCmd == Command::CMD_NOP)
+			{
+				WaitForNotify();
+			}
+
+			switch (m_currCmd)
+			{
+			case Command::CMD_OPEN:
+			{
+				if (ProcessOpenFile())
+				{
+					m_openingCompletedCallback(m_videoFormatCtx->duration, m_videoFrameRate, m_videoCodecParam->width, m_videoCodecParam->height);
+					m_openingPromise.set_value();
+					// Switch to NOP, need explicitly call command decode to commence
+					std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+					m_cmdQueue.push_back(CommandPayload(Command::CMD_NOP, nullptr));
+				}
+				else
+				{
+					m_openingPromise.set_value(); // keep promise
+					m_running = false;
+				}
+
+				break;
+			}
+
+			case Command::CMD_DECODE:
+			{
+				bool isFull = m_checkBufferFullCallback();
+				m_bufferFullCallback(isFull);
+
+				if (!isFull)
+				{
+					int decodeResult = ProcessDecoding();
+					if (decodeResult == 0)
+					{
+						m_running = false;
+					}
+					else if (decodeResult == 2) // EOF
+					{
+						// EOF, switch to idle
+						std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+						m_cmdQueue.push_back(CommandPayload(Command::CMD_NOP, nullptr));
+					}
+				}
+				else
+				{
+					// Buffer full, switch to idle
+					std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+					m_cmdQueue.push_back(CommandPayload(Command::CMD_NOP, nullptr));
+				}
+
+				break;
+			}
+
+			case Command::CMD_SEEK:
+			{
+				if (ProcessSeek())
+				{
+					// switch to continuous decode
+					std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+					m_cmdQueue.push_back(CommandPayload(Command::CMD_DECODE, nullptr));
+				}
+				else
+					m_running = false;
+				break;
+			}
+			case Command::CMD_CLOSE:
+			{
+				ProcessCloseFile();
+				std::lock_guard<std::mutex> guard(m_cmdQueueAccessMutex);
+				m_cmdQueue.push_back(CommandPayload(Command::CMD_NOP, nullptr));
+				break;
+			}
+			case Command::CMD_CLOSE_THEN_STOP:
+			{
+				ProcessCloseFile();
+				m_running = false;
+				break;
+			}
+
+			}
+
+			
+		}
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		CommandCloseThenStop();
+	}
+
+	virtual void Exit() override
+	{
+		// nothing to do
+
+	}
+
+private:
+
+
+	int64_t Timestamp2Framenumber(double timestamp) const
+	{
+		return (int64_t)(timestamp * m_videoTimebase.den / m_videoTimebase.num);
+	}
+
+	double Framenumber2Timestamp(int64_t index) const
+	{
+		return (double)(index * m_videoTimebase.num) / m_videoTimebase.den;
+	}
+
+	void SyncOpenFile()
+	{
+		if (m_openingFuture.valid())
+			m_openingFuture.wait();
+	}
+
+	static int OnAVIOReadPacket(void* opaque, uint8_t* buf, int buf_size)
+	{
+		FFFmpegDecodingThread* thread = (FFFmpegDecodingThread*)opaque;
+		auto fileStream = thread->m_fileStream;
+		int64_t before_pos = fileStream->Tell();
+		int64_t total_size = fileStream->TotalSize();
+		if (before_pos + buf_size > total_size)
+		{
+			buf_size = total_size - before_pos;
+		}
+		
+		if (buf_size > 0)
+		{
+			fileStream->Serialize(buf, buf_size);
+			// This check should be redundant now but keep it safe here
+			if (fileStream->GetError())
+			{
+				// Might read across EOF, try again
+				fileStream->ClearError();
+
+				fileStream->Serialize(buf, total_size - before_pos);
+				if (!fileStream->GetError())
+				{
+					return (int)(total_size - before_pos);
+				}
+				else
+				{
+					fileStream->ClearError();
+					return 0;
+				}
+			}
+			int64_t after_pos = fileStream->Tell();
+			return (int)(after_pos - before_pos);
+		}
+		else
+		{
+			return 0;
+		}
+	}
+
+	static int64_t OnAVIOSeek(void* opaque, int64_t offset, int origin)
+	{
+		FFFmpegDecodingThread* thread = (FFFmpegDecodingThread*)opaque;
+		auto fileStream = thread->m_fileStream;
+		int64_t size = fileStream->TotalSize();
+
+		if (origin == 0) // SEEK_SET
+		{
+			fileStream->Seek(std::max((int64_t)0, std::min(offset, size)));
+			return fileStream->Tell();
+		}
+		else if (origin == 1) // SEEK_CUR
+		{
+			int64_t curr = fileStream->Tell();
+			fileStream->Seek(std::max((int64_t)0, std::min(curr + offset, size)));
+			return fileStream->Tell();
+		}
+		else if (origin == 2) // SEEK_END
+		{
+			fileStream->Seek(std::max((int64_t)0, std::min(size + offset, size)));
+			return fileStream->Tell();
+		}
+		else if (origin == 0x10000)
+		{
+			return size;
+		}
+		return 0;
+	}
+
+	static AVPixelFormat OnGetFormat(AVCodecContext* pCodecContext, const AVPixelFormat* pFormats)
+	{
+		FFFmpegDecodingThread* thread = (FFFmpegDecodingThread*)pCodecContext->opaque;
+		for (const AVPixelFormat* p = pFormats; *p != AV_PIX_FMT_NONE; ++p)
+		{
+			if (*p == thread->m_hwPixelFormat)
+				return *p;
+		}
+
+		// e.g. the profile isn't supported by the hardware, the default picks a software format
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("Hardware decoder cannot take the video stream, decoding in software"));
+		return avcodec_default_get_format(pCodecContext, pFormats);
+	}
+
+	bool SetupHardwareDecode()
+	{
+		for (int i = 0; ; ++i)
+		{
+			const AVCodecHWConfig* config = avcodec_get_hw_config(m_videoCodec, i);
+			if (!config)
+				break;
+
+			if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) == 0)
+				continue;
+
+			if (av_hwdevice_ctx_create(&m_hwDeviceCtx, config->device_type, NULL, NULL, 0) < 0)
+			{
+				UE_LOG(EvercoastReaderLog, Verbose, TEXT("Hardware device %s unavailable"), ANSI_TO_TCHAR(av_hwdevice_get_type_name(config->device_type)));
+				continue;
+			}
+
+			m_hwPixelFormat = config->pix_fmt;
+			m_videoCodecCtx->hw_device_ctx = av_buffer_ref(m_hwDeviceCtx);
+			m_videoCodecCtx->opaque = this;
+			m_videoCodecCtx->get_format = OnGetFormat;
+
+			UE_LOG(EvercoastReaderLog, Log, TEXT("Video decoding on hardware device: %s"), ANSI_TO_TCHAR(av_hwdevice_get_type_name(config->device_type)));
+			return true;
+		}
+
+		UE_LOG(EvercoastReaderLog, Log, TEXT("No hardware decoder available for %s, decoding in software"), ANSI_TO_TCHAR(m_videoCodec->name));
+		return false;
+	}
+
+	void ReleaseCodecContext()
+	{
+		if (m_videoCodecCtx)
+		{
+			avcodec_free_context(&m_videoCodecCtx);
+			m_videoCodecCtx = nullptr;
+		}
+		if (m_hwDeviceCtx)
+		{
+			av_buffer_unref(&m_hwDeviceCtx);
+			m_hwDeviceCtx = nullptr;
+		}
+		m_hwPixelFormat = AV_PIX_FMT_NONE;
+	}
+
+	bool OpenCodecContext(bool tryHardware)
+	{
+		// Make codec context
+		m_videoCodecCtx = avcodec_alloc_context3(m_videoCodec);
+		if (!m_videoCodecCtx)
+		{
+			return false;
+		}
+
+		// Fill the codec context based on the values from the supplied codec parameters
+		if (avcodec_parameters_to_context(m_videoCodecCtx, m_videoCodecParam) < 0)
+		{
+			return false;
+		}
+
+		if (tryHardware && SetupHardwareDecode())
+		{
+			// Hardware decodes a frame at a time, extra threads only add latency
+			m_videoCodecCtx->thread_count = 1;
+		}
+		else
+		{
+			// Frame threading holds back up to thread_count frames, those get drained at end of stream and
+			// dropped by avcodec_flush_buffers() on seek
+			m_videoCodecCtx->thread_count = FMath::Clamp(FGenericPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, MAX_DECODE_THREAD_COUNT);
+			m_videoCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+		}
+
+		// Initialize the AVCodecContext to use the given AVCodec.
+		// https://ffmpeg.org/doxygen/trunk/group__lavc__core.html#ga11f785a188d7d9df71621001465b0f1d
+		return avcodec_open2(m_videoCodecCtx, m_videoCodec, NULL) >= 0;
+	}
+
+	void BuildKeyframeIndex()
+	{
+		m_keyframeTimestamps.clear();
+
+		// mp4 has the whole sample table read at opening, so this costs no extra IO
+		AVStream* pStream = m_videoFormatCtx->streams[m_videoStreamIndex];
+		const int entryCount = avformat_index_get_entries_count(pStream);
+		m_keyframeTimestamps.reserve(entryCount);
+		for (int i = 0; i < entryCount; ++i)
+		{
+			const AVIndexEntry* pEntry = avformat_index_get_entry(pStream, i);
+			if (pEntry && (pEntry->flags & AVINDEX_KEYFRAME) && !(pEntry->flags & AVINDEX_DISCARD_FRAME))
+			{
+				m_keyframeTimestamps.push_back(pEntry->timestamp);
+			}
+		}
+		std::sort(m_keyframeTimestamps.begin(), m_keyframeTimestamps.end());
+
+		UE_LOG(EvercoastReaderLog, Log, TEXT("Video keyframe index: %d keyframes in %d frames"), (int)m_keyframeTimestamps.size(), entryCount);
+	}
+
+	bool ProcessOpenFile()
+	{
+		m_videoFormatCtx = avformat_alloc_context();
+
+		// Check if local or network url
+		if (strncmp(m_openFilename, "http", 4) == 0)
+		{
+			if (avformat_open_input(&m_videoFormatCtx, m_openFilename, NULL, NULL) != 0) {
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot open the file: %s"), ANSI_TO_TCHAR(m_openFilename));
+				return false;
+			}
+
+		}
+		else
+		{
+			// Custom IO using Unreal's FArchive interface
+			FArchive* ar = IFileManager::Get().CreateFileReader(ANSI_TO_TCHAR(m_openFilename));
+			if (ar)
+			{
+				m_fileStream = MakeShareable(ar);
+				if (!m_fileStream->GetError() && m_fileStream->IsLoading())
+				{
+					UE_LOG(EvercoastReaderLog, Verbose, TEXT("Open file successful: %s"), ANSI_TO_TCHAR(m_openFilename));
+				}
+				else
+				{
+
+					UE_LOG(EvercoastReaderLog, Error, TEXT("Open file with error: %s"), ANSI_TO_TCHAR(m_openFilename));
+					m_fileStream->ClearError();
+					return false;
+				}
+			}
+			else
+			{
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Open failed: %s"), ANSI_TO_TCHAR(m_openFilename));
+				return false;
+			}
+
+			int io_buffer_size = 1024 * 1024;
+			m_ioBuffer = av_malloc(io_buffer_size);
+
+
+			m_videoIOCtx = avio_alloc_context((unsigned char*)m_ioBuffer, io_buffer_size, 0, this, OnAVIOReadPacket, nullptr, OnAVIOSeek);
+
+			// Assign custom io context to format context
+			m_videoFormatCtx->pb = m_videoIOCtx;
+
+			if (avformat_open_input(&m_videoFormatCtx, "UnrealFArchive", NULL, NULL) != 0) {
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot open the file: %s"), ANSI_TO_TCHAR(m_openFilename));
+				return false;
+			}
+		}
+
+
+		UE_LOG(EvercoastReaderLog, Log, TEXT("Format: %s"), *FString(m_videoFormatCtx->iformat->name));
+
+		if (avformat_find_stream_info(m_videoFormatCtx, NULL) < 0) {
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Could not get the stream info"));
+			return false;
+		}
+
+		const AVCodec* pCodec = NULL;
+		// this component describes the properties of a codec used by the stream i
+		AVCodecParameters* pCodecParam = NULL;
+
+		// loop though all the streams and print its main information
+		for (unsigned int i = 0; i < m_videoFormatCtx->nb_streams; i++)
+		{
+			const AVStream& avStream = *m_videoFormatCtx->streams[i];
+
+			AVCodecParameters* pLocalCodecParameters = NULL;
+			pLocalCodecParameters = avStream.codecpar;
+
+
+			UE_LOG(EvercoastReaderLog, Log, TEXT("AVStream->time_base before open coded %d/%d"), avStream.time_base.num, avStream.time_base.den);
+			UE_LOG(EvercoastReaderLog, Log, TEXT("AVStream->r_frame_rate before open coded %d/%d"), avStream.r_frame_rate.num, avStream.r_frame_rate.den);
+			UE_LOG(EvercoastReaderLog, Log, TEXT("AVStream->start_time %" PRId64), avStream.start_time);
+			UE_LOG(EvercoastReaderLog, Log, TEXT("AVStream->duration %" PRId64 " in seconds: %.3f"), avStream.duration, (double)avStream.duration * avStream.time_base.num / avStream.time_base.den);
+
+			UE_LOG(EvercoastReaderLog, Log, TEXT("Finding the proper decoder (CODEC)"));
+
+			// finds the registered decoder for a codec ID
+			const AVCodec* pLocalCodec = avcodec_find_decoder(pLocalCodecParameters->codec_id);
+
+			if (pLocalCodec == NULL) {
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Unsupported codec!"));
+				// In this example if the codec is not found we just skip it
+				continue;
+			}
+
+			// when the stream is a video we store its index, codec parameters and codec
+			if (pLocalCodecParameters->codec_type == AVMEDIA_TYPE_VIDEO) {
+				// select whatever the first video stream
+				if (m_videoStreamIndex == -1) {
+					m_videoStreamIndex = i;
+					m_videoCodec = pLocalCodec;
+					m_videoCodecParam = pLocalCodecParameters;
+
+					// Hopefully we get a proper frame rate
+					m_videoFrameRate = (int32_t)((float)avStream.r_frame_rate.num / (float)avStream.r_frame_rate.den + 0.5f);
+					m_videoTimebase = avStream.time_base;
+					if (avStream.r_frame_rate.num > 0 && avStream.r_frame_rate.den > 0)
+					{
+						m_framePtsDuration = std::max((int64_t)1, av_rescale_q(1, av_inv_q(avStream.r_frame_rate), avStream.time_base));
+					}
+				}
+
+				UE_LOG(EvercoastReaderLog, Log, TEXT("Video Codec: resolution %d x %d"), pLocalCodecParameters->width, pLocalCodecParameters->height);
+			}
+			else if (pLocalCodecParameters->codec_type == AVMEDIA_TYPE_AUDIO) {
+				UE_LOG(EvercoastReaderLog, Log, TEXT("Audio Codec: %d channels, sample rate %d"), pLocalCodecParameters->ch_layout.nb_channels, pLocalCodecParameters->sample_rate);
+			}
+
+			// print its name, id and bitrate
+			UE_LOG(EvercoastReaderLog, Log, TEXT("Codec %s ID %d bit_rate %lld"), *FString(pLocalCodec->name), pLocalCodec->id, pLocalCodecParameters->bit_rate);
+
+		}
+
+		if (!m_videoCodec || !m_videoCodecParam)
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("No codec or code param can be retrieved! Cannot decode video."));
+			return false;
+		}
+
+		if (m_videoStreamIndex == -1)
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("No video stream found! Cannot decode video."));
+			return false;
+		}
+
+		BuildKeyframeIndex();
+
+		if (!OpenCodecContext(m_preferHardwareDecode))
+		{
+			if (!m_hwDeviceCtx)
+			{
+				return false;
+			}
+
+			UE_LOG(EvercoastReaderLog, Warning, TEXT("Cannot open hardware video decoder, falling back to software"));
+			ReleaseCodecContext();
+			if (!OpenCodecContext(false))
+			{
+				return false;
+			}
+		}
+
+		// https://ffmpeg.org/doxygen/trunk/structAVFrame.html
+		m_currVideoFrame = av_frame_alloc();
+		if (!m_currVideoFrame)
+		{
+			return false;
+		}
+		// https://ffmpeg.org/doxygen/trunk/structAVPacket.html
+		m_currVideoPacket = av_packet_alloc();
+		if (!m_currVideoPacket)
+		{
+			return false;
+		}
+
+		m_transferFrame = av_frame_alloc();
+		if (!m_transferFrame)
+		{
+			return false;
+		}
+
+		m_decoderDraining = false;
+		return true;
+	}
+
+	int ProcessDecoding()
+	{
+		int response = -1;
+		if (m_decoderDraining)
+		{
+			response = ReceiveFrame(m_videoFormatCtx->streams[m_videoStreamIndex], m_videoCodecCtx, m_currVideoFrame);
+			if (response == AVERROR(EAGAIN))
+				response = AVERROR_EOF;
+		}
+		else while ((response = av_read_frame(m_videoFormatCtx, m_currVideoPacket)) >= 0)
+		{
+			// if it's the video stream
+			if (m_currVideoPacket->stream_index == m_videoStreamIndex) {
+				//UE_LOG(EvercoastReaderLog, Log, TEXT("AVPacket->pts %" PRId64), m_currVideoPacket->pts);
+
+				const AVStream& avStream = *m_videoFormatCtx->streams[m_videoStreamIndex];
+				//UE_LOG(EvercoastReaderLog, Log, TEXT("DecodePacket on stream %d"), m_videoStreamIndex);
+				response = DecodePacket(&avStream, m_currVideoPacket, m_videoCodecCtx, m_currVideoFrame);
+			}
+			av_packet_unref(m_currVideoPacket);
+			break;
+		}
+
+		if (response == AVERROR_EOF && !m_decoderDraining)
+		{
+			// The decoder still holds the last few frames, especially with frame threading. Enter draining mode and
+			// take them out one per call like the rest, so the buffer full check still applies.
+			m_decoderDraining = true;
+			response = avcodec_send_packet(m_videoCodecCtx, NULL);
+			if (response >= 0)
+			{
+				response = ReceiveFrame(m_videoFormatCtx->streams[m_videoStreamIndex], m_videoCodecCtx, m_currVideoFrame);
+				if (response == AVERROR(EAGAIN))
+					response = AVERROR_EOF;
+			}
+		}
+
+		if (response == AVERROR_EOF)
+		{
+			UE_LOG(EvercoastReaderLog, VeryVerbose, TEXT("EOF reached!"));
+			m_reachedStreamEndCallback(m_lastHoggedFrameIndex);
+
+			using namespace std::chrono_literals;
+			std::this_thread::sleep_for(1ms);
+			// EOF is not an error
+			return 2;
+		}
+		else if (response != 0) // other issue
+		{
+			char buf[AV_ERROR_MAX_STRING_SIZE];
+			av_make_error_string(buf, AV_ERROR_MAX_STRING_SIZE, response);
+			UE_LOG(EvercoastReaderLog, Error, TEXT("ProcessDecoding result in error: %s(%d)"), ANSI_TO_TCHAR(buf), response);
+		}
+		return (int)(response == 0);
+	}
+
+	int DecodePacket(const AVStream* pStream, AVPacket* pPacket, AVCodecContext* pCodecContext, AVFrame* pFrame)
+	{
+		// Supply raw packet data as input to a decoder
+		// https://ffmpeg.org/doxygen/trunk/group__lavc__decoding.html#ga58bc4bf1e0ac59e27362597e467efff3
+		int response = avcodec_send_packet(pCodecContext, pPacket);
+
+		if (response < 0) {
+			char error_msg[AV_ERROR_MAX_STRING_SIZE];
+			av_make_error_string(error_msg, AV_ERROR_MAX_STRING_SIZE, response);
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Error while sending a packet to the decoder: %s(%d)"), ANSI_TO_TCHAR(error_msg), response);
+			return response;
+		}
+
+		while ((response = ReceiveFrame(pStream, pCodecContext, pFrame)) == 0)
+		{
+		}
+
+		if (response == AVERROR(EAGAIN) || response == AVERROR_EOF)
+			return 0;
+
+		return response;
+	}
+
+	// Receives one frame and hands it over to texture conversion. Returns 0 for a frame handed over, AVERROR(EAGAIN)
+	// when the decoder needs more input and AVERROR_EOF when it is fully drained.
+	int ReceiveFrame(const AVStream* pStream, AVCodecContext* pCodecContext, AVFrame* pFrame)
+	{
+		char error_msg[AV_ERROR_MAX_STRING_SIZE];
+
+		// Return decoded output data (into a frame) from a decoder
+		// https://ffmpeg.org/doxygen/trunk/group__lavc__decoding.html#ga11e6542c4e66d3028668788a1a74217c
+		int response = avcodec_receive_frame(pCodecContext, pFrame);
+		if (response == AVERROR(EAGAIN) || response == AVERROR_EOF) {
+			av_make_error_string(error_msg, AV_ERROR_MAX_STRING_SIZE, response);
+			UE_LOG(EvercoastReaderLog, VeryVerbose, TEXT("%s(%d)"), ANSI_TO_TCHAR(error_msg), response);
+			return response;
+		}
+		else if (response < 0) {
+			av_make_error_string(error_msg, AV_ERROR_MAX_STRING_SIZE, response);
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Error while receiving a frame from the decoder: %s(%d)"), ANSI_TO_TCHAR(error_msg), response);
+			return response;
+		}
+
+		// Frame threading outputs a frame some packets after its own, so the duration comes from the frame rather than the packet just sent
+		const int64_t framePts = pFrame->pts != AV_NOPTS_VALUE ? pFrame->pts : pFrame->best_effort_timestamp;
+		const int64_t frameDuration = pFrame->pkt_duration > 0 ? pFrame->pkt_duration : m_framePtsDuration;
+		m_lastDecodedPts = framePts;
+
+		if (m_discardBeforePts != AV_NOPTS_VALUE)
+		{
+			// Frames from the keyframe up to the seek target are only needed as references
+			if (framePts + frameDuration <= m_discardBeforePts)
+			{
+				m_seekDiscardedFrames++;
+				return 0;
+			}
+
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("Seek reached frame pts %" PRId64 " in %.2f ms, %d frames skipped"), framePts,
+				std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_seekStartTime).count(), m_seekDiscardedFrames);
+			m_discardBeforePts = AV_NOPTS_VALUE;
+		}
+
+		const AVFrame* pSrcFrame = pFrame;
+		if (m_hwPixelFormat != AV_PIX_FMT_NONE && pFrame->format == m_hwPixelFormat)
+		{
+			// Download to system memory, comes out as NV12 or P010 mostly
+			av_frame_unref(m_transferFrame);
+			response = av_hwframe_transfer_data(m_transferFrame, pFrame, 0);
+			if (response < 0)
+			{
+				av_make_error_string(error_msg, AV_ERROR_MAX_STRING_SIZE, response);
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Error while downloading a hardware frame: %s(%d)"), ANSI_TO_TCHAR(error_msg), response);
+				return response;
+			}
+			pSrcFrame = m_transferFrame;
+		}
+
+		AVFrame* pYUVFrame = RefYUV420Frame(pSrcFrame);
+		if (!pYUVFrame)
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot convert video frame of format %s"), ANSI_TO_TCHAR(av_get_pix_fmt_name((AVPixelFormat)pSrcFrame->format)));
+			return AVERROR(EINVAL);
+		}
+
+		// All ownerships to be transfered to texture update lambda, the planes are read straight from the frame's
+		// ref counted buffers which get back to their pool once the render thread drops the last reference
+		std::shared_ptr<void> frameRef(pYUVFrame, [](void* pFrameToFree)
+			{
+				AVFrame* pRefFrame = (AVFrame*)pFrameToFree;
+				av_frame_free(&pRefFrame);
+			});
+		uint32_t YPitch = sizeof(uint8_t) * pYUVFrame->linesize[0];
+		uint32_t UPitch = sizeof(uint8_t) * pYUVFrame->linesize[1];
+		uint32_t VPitch = sizeof(uint8_t) * pYUVFrame->linesize[2];
+
+		double frameTimestamp = (double)(framePts * pStream->time_base.num) / pStream->time_base.den;
+		int64_t frameIndex = framePts / frameDuration;
+
+		// Only CPU conversion tells these apart, the shader is fixed to limited range BT.601
+		const YUVConversion::Matrix matrix = pSrcFrame->colorspace == AVCOL_SPC_BT709 ? YUVConversion::Matrix::BT709 : YUVConversion::Matrix::BT601;
+		const bool fullRange = pSrcFrame->color_range == AVCOL_RANGE_JPEG || pSrcFrame->format == AV_PIX_FMT_YUVJ420P;
+
+		UE_LOG(EvercoastReaderLog, VeryVerbose, TEXT("Decoded frame=%" PRId64 ", time=%.2f"), frameIndex, frameTimestamp);
+		m_convertTextureCallback(frameTimestamp, frameIndex, framePts, pYUVFrame->width, pYUVFrame->height, YPitch, UPitch, VPitch,
+			pYUVFrame->data[0], pYUVFrame->data[1], pYUVFrame->data[2], matrix, fullRange, std::move(frameRef));
+
+		m_lastHoggedFramePts = framePts;
+		m_lastHoggedFrameIndex = frameIndex;
+		return 0;
+	}
+
+	// A new reference to the frame as planar 8 bit YUV 4:2:0, what the texture conversion takes. Frames already in it
+	// are referenced without a copy, other formats(NV12, P010, 10 bit planar and so on) are converted into a pooled buffer.
+	AVFrame* RefYUV420Frame(const AVFrame* pFrame)
+	{
+		if (pFrame->format == AV_PIX_FMT_YUV420P || pFrame->format == AV_PIX_FMT_YUVJ420P)
+		{
+			return av_frame_clone(pFrame);
+		}
+
+		if (pFrame->format != m_lastConvertedFormat)
+		{
+			UE_LOG(EvercoastReaderLog, Log, TEXT("Converting video frames from %s to yuv420p"), ANSI_TO_TCHAR(av_get_pix_fmt_name((AVPixelFormat)pFrame->format)));
+			m_lastConvertedFormat = (AVPixelFormat)pFrame->format;
+		}
+
+		// Same size and the same chroma subsampling, point sampling is all it needs
+		m_swsCtx = sws_getCachedContext(m_swsCtx, pFrame->width, pFrame->height, (AVPixelFormat)pFrame->format,
+			pFrame->width, pFrame->height, AV_PIX_FMT_YUV420P, SWS_POINT, NULL, NULL, NULL);
+		if (!m_swsCtx)
+			return nullptr;
+
+		if (!m_convertedPlanePool || m_convertedPoolWidth != pFrame->width || m_convertedPoolHeight != pFrame->height)
+		{
+			// Buffers still referenced by the render thread free themselves after uninit
+			av_buffer_pool_uninit(&m_convertedPlanePool);
+
+			// Rows 64 byte aligned for swscale
+			if (av_image_fill_linesizes(m_convertedLinesizes, AV_PIX_FMT_YUV420P, FFALIGN(pFrame->width, 64)) < 0)
+				return nullptr;
+
+			size_t planeSizes[4];
+			const ptrdiff_t linesizes[4] = { m_convertedLinesizes[0], m_convertedLinesizes[1], m_convertedLinesizes[2], m_convertedLinesizes[3] };
+			if (av_image_fill_plane_sizes(planeSizes, AV_PIX_FMT_YUV420P, pFrame->height, linesizes) < 0)
+				return nullptr;
+
+			m_convertedPlanePool = av_buffer_pool_init(planeSizes[0] + planeSizes[1] + planeSizes[2] + planeSizes[3], NULL);
+			if (!m_convertedPlanePool)
+				return nullptr;
+
+			m_convertedPoolWidth = pFrame->width;
+			m_convertedPoolHeight = pFrame->height;
+		}
+
+		AVFrame* pConvertedFrame = av_frame_alloc();
+		if (!pConvertedFrame)
+			return nullptr;
+
+		pConvertedFrame->buf[0] = av_buffer_pool_get(m_convertedPlanePool);
+		if (!pConvertedFrame->buf[0])
+		{
+			av_frame_free(&pConvertedFrame);
+			return nullptr;
+		}
+
+		pConvertedFrame->format = AV_PIX_FMT_YUV420P;
+		pConvertedFrame->width = pFrame->width;
+		pConvertedFrame->height = pFrame->height;
+		FMemory::Memcpy(pConvertedFrame->linesize, m_convertedLinesizes, sizeof(m_convertedLinesizes));
+		av_image_fill_pointers(pConvertedFrame->data, AV_PIX_FMT_YUV420P, pFrame->height, pConvertedFrame->buf[0]->data, pConvertedFrame->linesize);
+		av_frame_copy_props(pConvertedFrame, pFrame);
+
+		sws_scale(m_swsCtx, pFrame->data, pFrame->linesize, 0, pFrame->height, pConvertedFrame->data, pConvertedFrame->linesize);
+		return pConvertedFrame;
+	}
+
+	// Whether the target is ahead in the GOP being decoded, where seeking would only restart from the same keyframe
+	bool CanDecodeForwardTo(int64_t targetPts) const
+	{
+		if (m_keyframeTimestamps.empty() || m_decoderDraining || m_lastDecodedPts == AV_NOPTS_VALUE || targetPts <= m_lastDecodedPts)
+			return false;
+
+		auto nextKeyframe = std::upper_bound(m_keyframeTimestamps.begin(), m_keyframeTimestamps.end(), m_lastDecodedPts);
+		return nextKeyframe == m_keyframeTimestamps.end() || *nextKeyframe > targetPts;
+	}
+
+	bool ProcessSeek()
+	{
+		const int64_t targetPts = Timestamp2Framenumber(m_seekTargetTimestamp);
+		m_seekStartTime = std::chrono::steady_clock::now();
+		m_seekDiscardedFrames = 0;
+
+		if (CanDecodeForwardTo(targetPts))
+		{
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("Video seeking to timestamp: %.2f by decoding forward"), m_seekTargetTimestamp);
+		}
+		else
+		{
+			// Jump straight to the keyframe starting the target's GOP when the index knows it
+			int64_t seekPts = targetPts;
+			auto keyframe = std::upper_bound(m_keyframeTimestamps.begin(), m_keyframeTimestamps.end(), targetPts);
+			if (keyframe != m_keyframeTimestamps.begin())
+			{
+				seekPts = *(keyframe - 1);
+			}
+
+			if (av_seek_frame(m_videoFormatCtx, m_videoStreamIndex, seekPts, AVSEEK_FLAG_BACKWARD) < 0)
+			{
+				UE_LOG(EvercoastReaderLog, Error, TEXT("Error seeking to timestamp: %.2f, frame: %" PRId64), m_seekTargetTimestamp, targetPts);
+				return false;
+			}
+
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("Video seeked to timestamp: %.2f, keyframe: %" PRId64), m_seekTargetTimestamp, seekPts);
+
+			// Drops the frames frame threads still hold, and leaves draining mode if the end was reached
+			avcodec_flush_buffers(m_videoCodecCtx);
+			m_decoderDraining = false;
+			m_lastDecodedPts = AV_NOPTS_VALUE;
+
+			av_packet_unref(m_currVideoPacket);
+			av_frame_unref(m_currVideoFrame);
+		}
+
+		m_discardBeforePts = targetPts;
+		m_seekCompletedCallback();
+		return true;
+	}
+
+	void ProcessCloseFile()
+	{
+		if (m_currVideoPacket)
+		{
+			av_packet_free(&m_currVideoPacket);
+			m_currVideoPacket = nullptr;
+		}
+		if (m_currVideoFrame)
+		{
+			av_frame_free(&m_currVideoFrame);
+			m_currVideoFrame = nullptr;
+		}
+		if (m_transferFrame)
+		{
+			av_frame_free(&m_transferFrame);
+			m_transferFrame = nullptr;
+		}
+		av_buffer_pool_uninit(&m_convertedPlanePool);
+		m_convertedPoolWidth = 0;
+		m_convertedPoolHeight = 0;
+		if (m_swsCtx)
+		{
+			sws_freeContext(m_swsCtx);
+			m_swsCtx = nullptr;
+		}
+		m_lastConvertedFormat = AV_PIX_FMT_NONE;
+
+		ReleaseCodecContext();
+
+
+		if (m_videoIOCtx)
+		{
+			// http://ffmpeg.org/doxygen/2.5/avio_8h.html
+			// Memory block for input/output operations via AVIOContext. 
+			// The buffer must be allocated with av_malloc() and friends. 
+			// It may be freed and replaced with a new buffer by libavformat. 
+			// AVIOContext.buffer holds the buffer currently in use, which must be later freed with av_free().
+			if (m_ioBuffer)
+			{
+				// Note just releasing m_ioBuffer will likely cause access violation, see comments above.
+				av_free(m_videoIOCtx->buffer);
+				m_ioBuffer = nullptr;
+			}
+
+			avio_context_free(&m_videoIOCtx);
+			m_videoIOCtx = nullptr;
+		}
+
+		if (m_videoFormatCtx)
+		{
+			avformat_close_input(&m_videoFormatCtx);
+			m_videoFormatCtx = nullptr;
+		}
+
+
+		m_videoCodec = nullptr;
+		m_videoCodecParam = nullptr;
+		m_videoFrameRate = -1;
+		m_videoStreamIndex = -1;
+		m_framePtsDuration = 1;
+		m_decoderDraining = false;
+		m_keyframeTimestamps.clear();
+		m_lastDecodedPts = AV_NOPTS_VALUE;
+		m_discardBeforePts = AV_NOPTS_VALUE;
+		m_seekTargetTimestamp = 0;
+		m_lastHoggedFramePts = 0;
+		m_lastHoggedFrameIndex = -1;
+	}
+
+};
@@ -5,8 +5,10 @@
 #include <functional> 
 #include <mutex>
 #include <condition_variable>
+#include <memory>
 
 #include "VideoTextureHog.h"
+#include "YUVConversion.h"
 #include "FFmpegVideoTextureHog.generated.h"
 
 #define FORCE_NV12_CPU_CONVERSION (0)
@@ -57,10 +59,13 @@ public:
 	virtual void TrimCache(double medianTimestamp, double halfFrameInterval) override;
 
 	virtual bool IsTextureBeyondRange(double timestamp, double halfFrameInterval) const;
+
+	// Try hardware decoding on the next opened video, falls back to software if no device can be created
+	void SetHardwareDecodePreferred(bool preferred);
 private:
 	void OnVideoOpened(int64_t avformat_duration, int32_t frame_rate, int frame_width, int frame_height);
 	void OnVideoEndReached(int64_t last_frame_index);
-	void OnConvertNV12Texture(double timestamp, int64_t frame_index, int64_t frame_pts, int width, int height, uint32_t y_pitch, uint32_t u_pitch, uint32_t v_pitch, uint8_t* y_data, uint8_t* u_data, uint8_t* v_data);
+	void OnConvertNV12Texture(double timestamp, int64_t frame_index, int64_t frame_pts, int width, int height, uint32_t y_pitch, uint32_t u_pitch, uint32_t v_pitch, uint8_t* y_data, uint8_t* u_data, uint8_t* v_data, YUVConversion::Matrix matrix, bool full_range, std::shared_ptr<void> frame_ref);
 	void OnFull(bool isFull);
 
 	void RestartHoggingIfPausedDueToFull();
@@ -79,6 +84,7 @@ private:
 	bool				m_videoEndReached;
 	int64_t				m_videoEndFrameIndex;
 	bool				m_hoggingStoppedDueToFullBuffer;
+	bool				m_hardwareDecodePreferred = false;
 
     UPROPERTY(Transient)
 	TArray<UTextureRecord*> m_textureBuffer;
@@ -95,17 +101,28 @@ private:
 	
 	double				m_videoDuration = 0;
 
-#if FORCE_NV12_CPU_CONVERSION
-	uint8_t*			m_scratchPadRGBA;
-#else
+	// Frames are converted to BGRA on CPU instead of NV12TextureConversion.usf
+	bool				m_cpuConversion = false;
 	FTexture2DRHIRef	m_nv12YPlaneRHI;
 	FTexture2DRHIRef	m_nv12UPlaneRHI;
 	FTexture2DRHIRef	m_nv12VPlaneRHI;
-#endif
-	// conversion
-	uint8* m_scratchPadY;
-	uint8* m_scratchPadU;
-	uint8* m_scratchPadV;
+
+	// conversion, the render commands read the decoded frame's planes directly and signal their slot when done.
+	// The decoder thread only waits when all slots are still in flight.
+	static constexpr int MAX_CONVERSIONS_IN_FLIGHT = 3;
+	struct ConversionSlot
+	{
+		// Set by the render command, which owns the promise so it can outlive the slot being reset
+		std::future<void>	future;
+		uint8_t*			scratchPadRGBA = nullptr;
+		uint32_t			scratchPadRGBASize = 0;
+	};
+	ConversionSlot		m_conversionSlots[MAX_CONVERSIONS_IN_FLIGHT];
+	int					m_nextConversionSlot = 0;
+	int64_t				m_conversionCount = 0;
+	int64_t				m_conversionStallCount = 0;
+	double				m_conversionStallSeconds = 0;
+	void ReleaseConversionSlots();
 
 	// threading
 	FFFmpegDecodingThread*					m_runnable;
@@ -8,13 +8,15 @@ EvercoastGaussianSplatPassthroughResult::EvercoastGaussianSplatPassthroughResult
 	uint8_t* inColourAlphas, uint32_t inColourAlphasSize,
 	uint8_t* inScales, uint32_t inScalesSize,
 	uint8_t* inRotations, uint32_t inRotationsSize,
-	uint8_t* inSHCoeffs, uint32_t inSHCoeffsSize) :
+	uint8_t* inSHCoeffs, uint32_t inSHCoeffsSize,
+	std::function<void(uint8_t*)> wholeMemoryBlockReleaser) :
 	GenericDecodeResult(success, timestamp, index),
 	pointCount(inPointCount),
 	shDegree(inShDegree),
 	positionScalar(inPositionScalar),
 	memBlock(wholeMemoryBlock),
 	memBlockSize(wholeMemoryBlockSize),
+	memBlockReleaser(std::move(wholeMemoryBlockReleaser)),
 	packedPositions(inPositions), packedPositionsSize(inPositionsSize),
 	packedColourAlphas(inColourAlphas), packedColourAlphasSize(inColourAlphasSize),
 	packedScales(inScales), packedScalesSize(inScalesSize),
@@ -32,8 +34,16 @@ void EvercoastGaussianSplatPassthroughResult::InvalidateResult()
 {
 	GenericDecodeResult::InvalidateResult();
 
-	delete[] memBlock;
+	if (memBlock && memBlockReleaser)
+	{
+		memBlockReleaser(memBlock);
+	}
+	else
+	{
+		delete[] memBlock;
+	}
 	memBlock = nullptr;
+	memBlockReleaser = nullptr;
 }
 
 EvercoastGaussianSplatPassthroughResult::EvercoastGaussianSplatPassthroughResult(const EvercoastGaussianSplatPassthroughResult& rhs) :
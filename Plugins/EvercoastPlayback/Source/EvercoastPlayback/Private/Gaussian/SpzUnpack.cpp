@@ -0,0 +1,423 @@
+#include "Gaussian/SpzUnpack.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(PLATFORM_ENABLE_VECTORINTRINSICS_NEON) && PLATFORM_ENABLE_VECTORINTRINSICS_NEON && defined(__aarch64__)
+#define SPZ_UNPACK_NEON 1
+#include <arm_neon.h>
+#elif defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1
+#define SPZ_UNPACK_SSE 1
+#include <smmintrin.h>
+#if defined(PLATFORM_ALWAYS_HAS_AVX_2) && PLATFORM_ALWAYS_HAS_AVX_2
+#define SPZ_UNPACK_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#ifndef SPZ_UNPACK_NEON
+#define SPZ_UNPACK_NEON 0
+#endif
+#ifndef SPZ_UNPACK_SSE
+#define SPZ_UNPACK_SSE 0
+#endif
+#ifndef SPZ_UNPACK_AVX2
+#define SPZ_UNPACK_AVX2 0
+#endif
+
+namespace
+{
+	// Lookup tables for everything derived from a single byte, computed with the exact expressions the decoder
+	// always used so the results don't change
+	struct SpzLookupTables
+	{
+		float scale[256];
+		float rotation[256];
+
+		SpzLookupTables()
+		{
+			for (int i = 0; i < 256; ++i)
+			{
+				// Turns out scale has to be calculated as exp( float(value) / 16.0f - 10.0f)
+				// The spz format has a * 2.0f term at the end though. There must be either eigenvalue extraction or covariance Sigma construction error
+				// lead to "too flat" gaussian falloffs
+				scale[i] = expf(float(i) / 16.0f - 10.0f);
+				// Rotation x, y, z should be converted with float(xu8) / 127.5 - 1.0, replacing 127.0 with 127.5
+				rotation[i] = (float)(float(i) / 127.5 - 1.0);
+			}
+		}
+	};
+
+	const SpzLookupTables& GetLookupTables()
+	{
+		static const SpzLookupTables tables;
+		return tables;
+	}
+
+	void PadTripletsScalar(const uint8_t* in, uint8_t* out, uint32_t tripletCount)
+	{
+		for (uint32_t i = 0; i < tripletCount; ++i)
+		{
+			*out++ = *in++;
+			*out++ = *in++;
+			*out++ = *in++;
+			*out++ = 0;
+		}
+	}
+
+	void InterleaveColourAlphaScalar(const uint8_t* colours, const uint8_t* alphas, uint8_t* out, uint32_t pointCount)
+	{
+		for (uint32_t i = 0; i < pointCount; ++i)
+		{
+			*out++ = *colours++;
+			*out++ = *colours++;
+			*out++ = *colours++;
+			*out++ = *alphas++;
+		}
+	}
+
+	void SplitSHCoefficientsScalar(const uint8_t* in, uint32_t shDim, uint32_t stride, uint8_t* outR, uint8_t* outG, uint8_t* outB, uint32_t pointCount)
+	{
+		for (uint32_t i = 0; i < pointCount; ++i)
+		{
+			uint32_t d = 0;
+			for (; d < shDim; ++d)
+			{
+				*outR++ = *in++;
+				*outG++ = *in++;
+				*outB++ = *in++;
+			}
+
+			for (; d < stride; ++d)
+			{
+				*outR++ = 0;
+				*outG++ = 0;
+				*outB++ = 0;
+			}
+		}
+	}
+
+	void DecodePositionsScalar(const uint8_t* in, float positionScalar, float* out, uint32_t pointCount)
+	{
+		for (uint32_t i = 0; i < pointCount; ++i)
+		{
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				int32_t v = *in++;
+				v |= *in++ << 8;
+				v |= *in++ << 16;
+				v |= v & 0x800000 ? static_cast<int32_t>(0xff000000) : 0;
+				*out++ = static_cast<float>(v) * positionScalar;
+			}
+
+			*out++ = 0.0f;
+		}
+	}
+
+	void DecodeColourAlphasScalar(const uint8_t* rgba, float* out, uint32_t pointCount)
+	{
+		for (uint32_t i = 0; i < pointCount * 4; ++i)
+		{
+			*out++ = (float)rgba[i] / 255.0f;
+		}
+	}
+
+	void DecodeRotationsScalar(const uint8_t* in, float* out, uint32_t pointCount)
+	{
+		const float* lut = GetLookupTables().rotation;
+		for (uint32_t i = 0; i < pointCount; ++i)
+		{
+			const float x = lut[*in++];
+			const float y = lut[*in++];
+			const float z = lut[*in++];
+			*out++ = x;
+			*out++ = y;
+			*out++ = z;
+			*out++ = std::sqrt(std::max(0.0f, 1.0f - (x * x + y * y + z * z)));
+		}
+	}
+
+#if SPZ_UNPACK_SSE
+	// 4 triplets in the low 12 bytes to 4 zero padded 32 bit slots
+	inline __m128i PadTripletsMask()
+	{
+		return _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	}
+
+	// Split 48 bytes of interleaved r,g,b into 16 bytes of each
+	inline void Deinterleave3(const uint8_t* in, __m128i& r, __m128i& g, __m128i& b)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*)in);
+		const __m128i m = _mm_loadu_si128((const __m128i*)(in + 16));
+		const __m128i c = _mm_loadu_si128((const __m128i*)(in + 32));
+
+		r = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+		g = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+		b = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+	}
+#endif
+}
+
+namespace SpzUnpack
+{
+
+const TCHAR* GetKernelName()
+{
+#if SPZ_UNPACK_AVX2
+	return TEXT("AVX2");
+#elif SPZ_UNPACK_SSE
+	return TEXT("SSE4.1");
+#elif SPZ_UNPACK_NEON
+	return TEXT("NEON");
+#else
+	return TEXT("Scalar");
+#endif
+}
+
+void PadTriplets(const uint8_t* in, uint8_t* out, uint32_t tripletCount)
+{
+	uint32_t i = 0;
+#if SPZ_UNPACK_AVX2
+	// 16 byte loads 12 bytes apart, stay 4 bytes clear of the end
+	const __m256i mask256 = _mm256_broadcastsi128_si256(PadTripletsMask());
+	for (; i + 10 <= tripletCount; i += 8)
+	{
+		const __m128i lo = _mm_loadu_si128((const __m128i*)(in + i * 3));
+		const __m128i hi = _mm_loadu_si128((const __m128i*)(in + i * 3 + 12));
+		const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		_mm256_storeu_si256((__m256i*)(out + i * 4), _mm256_shuffle_epi8(v, mask256));
+	}
+#endif
+#if SPZ_UNPACK_SSE
+	const __m128i mask = PadTripletsMask();
+	for (; i + 6 <= tripletCount; i += 4)
+	{
+		const __m128i v = _mm_loadu_si128((const __m128i*)(in + i * 3));
+		_mm_storeu_si128((__m128i*)(out + i * 4), _mm_shuffle_epi8(v, mask));
+	}
+#elif SPZ_UNPACK_NEON
+	const uint8x16_t zero = vdupq_n_u8(0);
+	for (; i + 16 <= tripletCount; i += 16)
+	{
+		const uint8x16x3_t v = vld3q_u8(in + i * 3);
+		uint8x16x4_t padded;
+		padded.val[0] = v.val[0];
+		padded.val[1] = v.val[1];
+		padded.val[2] = v.val[2];
+		padded.val[3] = zero;
+		vst4q_u8(out + i * 4, padded);
+	}
+#endif
+	PadTripletsScalar(in + i * 3, out + i * 4, tripletCount - i);
+}
+
+void InterleaveColourAlpha(const uint8_t* colours, const uint8_t* alphas, uint8_t* out, uint32_t pointCount)
+{
+	uint32_t i = 0;
+#if SPZ_UNPACK_SSE
+	const __m128i colourMask = PadTripletsMask();
+	const __m128i alphaMask = _mm_setr_epi8(-1, -1, -1, 0, -1, -1, -1, 1, -1, -1, -1, 2, -1, -1, -1, 3);
+	for (; i + 6 <= pointCount; i += 4)
+	{
+		int32_t packedAlphas;
+		memcpy(&packedAlphas, alphas + i, sizeof(packedAlphas));
+
+		const __m128i rgb = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(colours + i * 3)), colourMask);
+		const __m128i a = _mm_shuffle_epi8(_mm_cvtsi32_si128(packedAlphas), alphaMask);
+		_mm_storeu_si128((__m128i*)(out + i * 4), _mm_or_si128(rgb, a));
+	}
+#elif SPZ_UNPACK_NEON
+	for (; i + 16 <= pointCount; i += 16)
+	{
+		const uint8x16x3_t rgb = vld3q_u8(colours + i * 3);
+		uint8x16x4_t rgba;
+		rgba.val[0] = rgb.val[0];
+		rgba.val[1] = rgb.val[1];
+		rgba.val[2] = rgb.val[2];
+		rgba.val[3] = vld1q_u8(alphas + i);
+		vst4q_u8(out + i * 4, rgba);
+	}
+#endif
+	InterleaveColourAlphaScalar(colours + i * 3, alphas + i, out + i * 4, pointCount - i);
+}
+
+void SplitSHCoefficients(const uint8_t* in, uint32_t shDim, uint32_t stride, uint8_t* outR, uint8_t* outG, uint8_t* outB, uint32_t pointCount)
+{
+	uint32_t i = 0;
+#if SPZ_UNPACK_SSE
+	if (shDim == 15 && stride == 16)
+	{
+		// A point is 45 bytes, the 48 byte load takes 3 of the next point's which end up in lane 15 and get cleared
+		const __m128i keepMask = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0);
+		for (; i + 1 < pointCount; ++i)
+		{
+			__m128i r, g, b;
+			Deinterleave3(in + i * 45, r, g, b);
+			_mm_storeu_si128((__m128i*)(outR + i * 16), _mm_and_si128(r, keepMask));
+			_mm_storeu_si128((__m128i*)(outG + i * 16), _mm_and_si128(g, keepMask));
+			_mm_storeu_si128((__m128i*)(outB + i * 16), _mm_and_si128(b, keepMask));
+		}
+	}
+	else if (shDim == 8 && stride == 8)
+	{
+		// 2 points are exactly 48 bytes and 8 coefficients of each fill a plane's 16 bytes
+		for (; i + 2 <= pointCount; i += 2)
+		{
+			__m128i r, g, b;
+			Deinterleave3(in + i * 24, r, g, b);
+			_mm_storeu_si128((__m128i*)(outR + i * 8), r);
+			_mm_storeu_si128((__m128i*)(outG + i * 8), g);
+			_mm_storeu_si128((__m128i*)(outB + i * 8), b);
+		}
+	}
+#elif SPZ_UNPACK_NEON
+	if (shDim == 15 && stride == 16)
+	{
+		for (; i + 1 < pointCount; ++i)
+		{
+			const uint8x16x3_t v = vld3q_u8(in + i * 45);
+			vst1q_u8(outR + i * 16, vsetq_lane_u8(0, v.val[0], 15));
+			vst1q_u8(outG + i * 16, vsetq_lane_u8(0, v.val[1], 15));
+			vst1q_u8(outB + i * 16, vsetq_lane_u8(0, v.val[2], 15));
+		}
+	}
+	else if (shDim == 8 && stride == 8)
+	{
+		for (; i + 2 <= pointCount; i += 2)
+		{
+			const uint8x16x3_t v = vld3q_u8(in + i * 24);
+			vst1q_u8(outR + i * 8, v.val[0]);
+			vst1q_u8(outG + i * 8, v.val[1]);
+			vst1q_u8(outB + i * 8, v.val[2]);
+		}
+	}
+#endif
+	SplitSHCoefficientsScalar(in + i * shDim * 3, shDim, stride, outR + i * stride, outG + i * stride, outB + i * stride, pointCount - i);
+}
+
+void DecodePositions(const uint8_t* in, float positionScalar, float* out, uint32_t pointCount)
+{
+	// Put each 24 bit value in the top of a 32 bit lane, arithmetic shift brings it down sign extended.
+	// Points are 9 bytes apart and loads are 16 bytes, so stop 2 points before the end.
+	uint32_t i = 0;
+#if SPZ_UNPACK_AVX2
+	{
+		const __m256i mask256 = _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, -1, -1, -1));
+		const __m256 scalar256 = _mm256_set1_ps(positionScalar);
+		for (; i + 3 <= pointCount; i += 2)
+		{
+			const __m128i lo = _mm_loadu_si128((const __m128i*)(in + i * 9));
+			const __m128i hi = _mm_loadu_si128((const __m128i*)(in + i * 9 + 9));
+			const __m256i v = _mm256_srai_epi32(_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), mask256), 8);
+			_mm256_storeu_ps(out + i * 4, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scalar256));
+		}
+	}
+#endif
+#if SPZ_UNPACK_SSE
+	const __m128i mask = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, -1, -1, -1);
+	const __m128 scalar = _mm_set1_ps(positionScalar);
+	for (; i + 2 <= pointCount; ++i)
+	{
+		const __m128i v = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + i * 9)), mask), 8);
+		_mm_storeu_ps(out + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(v), scalar));
+	}
+#elif SPZ_UNPACK_NEON
+	static const uint8_t maskBytes[16] = { 0xff, 0, 1, 2, 0xff, 3, 4, 5, 0xff, 6, 7, 8, 0xff, 0xff, 0xff, 0xff };
+	const uint8x16_t mask = vld1q_u8(maskBytes);
+	for (; i + 2 <= pointCount; ++i)
+	{
+		const int32x4_t v = vshrq_n_s32(vreinterpretq_s32_u8(vqtbl1q_u8(vld1q_u8(in + i * 9), mask)), 8);
+		vst1q_f32(out + i * 4, vmulq_n_f32(vcvtq_f32_s32(v), positionScalar));
+	}
+#endif
+	DecodePositionsScalar(in + i * 9, positionScalar, out + i * 4, pointCount - i);
+}
+
+void DecodeColourAlphas(const uint8_t* rgba, float* out, uint32_t pointCount)
+{
+	uint32_t i = 0;
+#if SPZ_UNPACK_SSE
+	const __m128 divisor = _mm_set1_ps(255.0f);
+	for (; i < pointCount; ++i)
+	{
+		int32_t packed;
+		memcpy(&packed, rgba + i * 4, sizeof(packed));
+		const __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+		_mm_storeu_ps(out + i * 4, _mm_div_ps(_mm_cvtepi32_ps(v), divisor));
+	}
+#elif SPZ_UNPACK_NEON
+	const float32x4_t divisor = vdupq_n_f32(255.0f);
+	for (; i + 4 <= pointCount; i += 4)
+	{
+		const uint8x16_t v = vld1q_u8(rgba + i * 4);
+		const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+		const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+		vst1q_f32(out + i * 4, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), divisor));
+		vst1q_f32(out + i * 4 + 4, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), divisor));
+		vst1q_f32(out + i * 4 + 8, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), divisor));
+		vst1q_f32(out + i * 4 + 12, vdivq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), divisor));
+	}
+#endif
+	DecodeColourAlphasScalar(rgba + i * 4, out + i * 4, pointCount - i);
+}
+
+void DecodeScales(const uint8_t* in, float* out, uint32_t pointCount)
+{
+	// exp() of 256 possible values is a table lookup, which leaves nothing worth vectorising
+	const float* lut = GetLookupTables().scale;
+	for (uint32_t i = 0; i < pointCount; ++i)
+	{
+		*out++ = lut[*in++];
+		*out++ = lut[*in++];
+		*out++ = lut[*in++];
+		*out++ = 0.0f;
+	}
+}
+
+void DecodeRotations(const uint8_t* in, float* out, uint32_t pointCount)
+{
+	uint32_t i = 0;
+#if SPZ_UNPACK_SSE || SPZ_UNPACK_NEON
+	// 4 points at a time in x,y,z,w planes, same operation order as the scalar version
+	const float* lut = GetLookupTables().rotation;
+	for (; i + 4 <= pointCount; i += 4)
+	{
+		const uint8_t* p = in + i * 3;
+#if SPZ_UNPACK_SSE
+		__m128 x = _mm_setr_ps(lut[p[0]], lut[p[3]], lut[p[6]], lut[p[9]]);
+		__m128 y = _mm_setr_ps(lut[p[1]], lut[p[4]], lut[p[7]], lut[p[10]]);
+		__m128 z = _mm_setr_ps(lut[p[2]], lut[p[5]], lut[p[8]], lut[p[11]]);
+		const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 w = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_set1_ps(1.0f), lengthSquared)));
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(out + i * 4, x);
+		_mm_storeu_ps(out + i * 4 + 4, y);
+		_mm_storeu_ps(out + i * 4 + 8, z);
+		_mm_storeu_ps(out + i * 4 + 12, w);
+#else
+		const float xs[4] = { lut[p[0]], lut[p[3]], lut[p[6]], lut[p[9]] };
+		const float ys[4] = { lut[p[1]], lut[p[4]], lut[p[7]], lut[p[10]] };
+		const float zs[4] = { lut[p[2]], lut[p[5]], lut[p[8]], lut[p[11]] };
+		float32x4x4_t quats;
+		quats.val[0] = vld1q_f32(xs);
+		quats.val[1] = vld1q_f32(ys);
+		quats.val[2] = vld1q_f32(zs);
+		const float32x4_t lengthSquared = vaddq_f32(vaddq_f32(vmulq_f32(quats.val[0], quats.val[0]), vmulq_f32(quats.val[1], quats.val[1])), vmulq_f32(quats.val[2], quats.val[2]));
+		quats.val[3] = vsqrtq_f32(vmaxq_f32(vdupq_n_f32(0.0f), vsubq_f32(vdupq_n_f32(1.0f), lengthSquared)));
+		vst4q_f32(out + i * 4, quats);
+#endif
+	}
+#endif
+	DecodeRotationsScalar(in + i * 3, out + i * 4, pointCount - i);
+}
+
+}
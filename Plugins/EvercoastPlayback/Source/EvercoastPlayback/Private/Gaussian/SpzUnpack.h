@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include "CoreMinimal.h"
+
+// Unpacking kernels for ECSPZ frames. Each one has SSE4.1(optionally AVX2) and NEON variants picked at compile time
+// from the engine's platform macros, and a scalar fallback which the SIMD variants match bit for bit.
+namespace SpzUnpack
+{
+	// SH coefficient count per colour channel: 0, 3, 8, 15 for degree 0 to 3
+	inline uint32_t SHDimForDegree(uint32_t shDegree)
+	{
+		return (shDegree + 1) * (shDegree + 1) - 1;
+	}
+
+	// Bytes per point per colour channel once padded for GPU upload: 0, 4, 8, 16 for degree 0 to 3
+	inline uint32_t PaddedSHStride(uint32_t shDim)
+	{
+		return shDim == 0 ? 0 : (shDim + 3) & ~3u;
+	}
+
+	// Name of the kernel set compiled in, for logging
+	const TCHAR* GetKernelName();
+
+	// Every 3 bytes followed by a zero byte: 24 bit positions to 32 bit slots, scale and rotation to 4 bytes
+	void PadTriplets(const uint8_t* in, uint8_t* out, uint32_t tripletCount);
+
+	// Planar r,g,b + a to interleaved rgba
+	void InterleaveColourAlpha(const uint8_t* colours, const uint8_t* alphas, uint8_t* out, uint32_t pointCount);
+
+	// Per point shDim coefficients of interleaved r,g,b into three planes, each point padded to stride bytes with zeros
+	void SplitSHCoefficients(const uint8_t* in, uint32_t shDim, uint32_t stride, uint8_t* outR, uint8_t* outG, uint8_t* outB, uint32_t pointCount);
+
+	// 24 bit fixed point x,y,z to float x,y,z,0
+	void DecodePositions(const uint8_t* in, float positionScalar, float* out, uint32_t pointCount);
+
+	// Interleaved rgba bytes to normalised floats
+	void DecodeColourAlphas(const uint8_t* rgba, float* out, uint32_t pointCount);
+
+	// Log encoded sx,sy,sz to float sx,sy,sz,0
+	void DecodeScales(const uint8_t* in, float* out, uint32_t pointCount);
+
+	// rx,ry,rz to float quaternion x,y,z,w with w reconstructed from unit length
+	void DecodeRotations(const uint8_t* in, float* out, uint32_t pointCount);
+}
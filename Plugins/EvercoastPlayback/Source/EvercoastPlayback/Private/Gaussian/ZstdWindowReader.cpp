@@ -0,0 +1,97 @@
+#include "Gaussian/ZstdWindowReader.h"
+#include <cstring>
+#include "zstd.h"
+
+ZstdWindowReader::ZstdWindowReader(size_t windowSize) :
+	m_dctx(ZSTD_createDCtx()),
+	m_input(nullptr), m_inputSize(0), m_inputPos(0),
+	m_window(windowSize),
+	m_readPos(0), m_writePos(0),
+	m_frameEnded(true)
+{
+}
+
+ZstdWindowReader::~ZstdWindowReader()
+{
+	ZSTD_freeDCtx(m_dctx);
+}
+
+bool ZstdWindowReader::Begin(const uint8_t* stream, size_t streamSize)
+{
+	if (!m_dctx)
+		return false;
+
+	// Keeps the allocated workspace, only drops the state of the last frame
+	ZSTD_DCtx_reset(m_dctx, ZSTD_reset_session_only);
+
+	m_input = stream;
+	m_inputSize = streamSize;
+	m_inputPos = 0;
+	m_readPos = 0;
+	m_writePos = 0;
+	m_frameEnded = false;
+	return true;
+}
+
+bool ZstdWindowReader::Fill(size_t minBytes)
+{
+	if (m_writePos - m_readPos >= minBytes)
+		return true;
+
+	if (minBytes > m_window.size())
+		return false;
+
+	// Move the partial element left over to the front and fill up the rest
+	const size_t leftover = m_writePos - m_readPos;
+	if (leftover > 0 && m_readPos > 0)
+	{
+		memmove(m_window.data(), m_window.data() + m_readPos, leftover);
+	}
+	m_readPos = 0;
+	m_writePos = leftover;
+
+	while (m_writePos < minBytes)
+	{
+		if (m_frameEnded)
+			return false;
+
+		ZSTD_inBuffer input{ m_input, m_inputSize, m_inputPos };
+		ZSTD_outBuffer output{ m_window.data(), m_window.size(), m_writePos };
+		const size_t ret = ZSTD_decompressStream(m_dctx, &output, &input);
+		if (ZSTD_isError(ret))
+			return false;
+
+		const bool progressed = output.pos != m_writePos || input.pos != m_inputPos;
+		m_inputPos = input.pos;
+		m_writePos = output.pos;
+
+		if (ret == 0)
+		{
+			m_frameEnded = true;
+		}
+		else if (!progressed)
+		{
+			// Truncated frame
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ZstdWindowReader::Read(void* destination, size_t size)
+{
+	uint8_t* writer = (uint8_t*)destination;
+	while (size > 0)
+	{
+		if (!Fill(1))
+			return false;
+
+		const size_t count = std::min(size, m_writePos - m_readPos);
+		memcpy(writer, m_window.data() + m_readPos, count);
+		m_readPos += count;
+		writer += count;
+		size -= count;
+	}
+	return true;
+}
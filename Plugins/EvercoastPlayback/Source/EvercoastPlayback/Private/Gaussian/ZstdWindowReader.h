@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct ZSTD_DCtx_s;
+
+// Decompresses a zstd frame a window at a time, small enough to stay in cache, so the decompressed bytes get
+// converted while they are hot instead of materialising the whole frame first. The decompression context and the
+// window are kept across frames. Not thread safe, one per decoder thread.
+class ZstdWindowReader
+{
+public:
+	static constexpr size_t DEFAULT_WINDOW_SIZE = 256 * 1024;
+
+	explicit ZstdWindowReader(size_t windowSize = DEFAULT_WINDOW_SIZE);
+	~ZstdWindowReader();
+
+	// Start reading a new frame, stream has to stay valid till the frame is consumed
+	bool Begin(const uint8_t* stream, size_t streamSize);
+
+	// Read exactly size bytes
+	bool Read(void* destination, size_t size);
+
+	// Hand elementCount elements of elementSize bytes to consumer(const uint8_t* data, uint32_t firstElement, uint32_t count)
+	// in runs of whole elements. Returns false if the frame is corrupted or ends early.
+	template<typename Consumer>
+	bool ForEachRun(uint32_t elementSize, uint32_t elementCount, Consumer&& consumer)
+	{
+		uint32_t done = 0;
+		while (done < elementCount)
+		{
+			if (!Fill(elementSize))
+				return false;
+
+			const uint32_t count = (uint32_t)std::min<size_t>(elementCount - done, (m_writePos - m_readPos) / elementSize);
+			consumer(m_window.data() + m_readPos, done, count);
+			m_readPos += (size_t)count * elementSize;
+			done += count;
+		}
+		return true;
+	}
+
+private:
+	ZstdWindowReader(const ZstdWindowReader&) = delete;
+	ZstdWindowReader& operator=(const ZstdWindowReader&) = delete;
+
+	// Make at least minBytes available in the window
+	bool Fill(size_t minBytes);
+
+	ZSTD_DCtx_s* m_dctx;
+	const uint8_t* m_input;
+	size_t m_inputSize;
+	size_t m_inputPos;
+
+	std::vector<uint8_t> m_window;
+	size_t m_readPos;
+	size_t m_writePos;
+	bool m_frameEnded;
+};
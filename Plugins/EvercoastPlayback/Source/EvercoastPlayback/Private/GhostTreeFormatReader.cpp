@@ -15,7 +15,10 @@
 #include "GenericPlatform/GenericPlatformProcess.h"
 // For UFS serialisation
 #include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/AsyncFileHandle.h"
 #include "Misc/FileHelper.h"
+#include "Misc/ScopeExit.h"
 #include "Serialization/Archive.h"
 #include "Serialization/ArrayReader.h"
 
@@ -26,6 +29,10 @@
 #include "EvercoastPlaybackUtils.h"
 #include "RuntimeAudioFactory.h"
 #include "RuntimeAudio.h"
+#include "ReaderCache.h"
+#include "HttpRangeScheduler.h"
+#include "ReaderPersistentCache.h"
+#include "AdaptiveBitRateController.h"
 
 #include "zstd.h"
 #include "Gaussian/EvercoastGaussianSplatDecoder.h"
@@ -138,9 +145,9 @@ public:
 		return find_reader(reader_inst)->OnReaderReadFromConnection(conn_handle, request);
 	}
 
-	static bool cancel_connection_request(GTHandle handle, uint32_t conn_handle, uint32_t requestId)
+	static bool cancel_connection_request(GTHandle reader_inst, uint32_t conn_handle, uint32_t requestId)
 	{
-		return true;
+		return find_reader(reader_inst)->OnCancelConnectionRequest(conn_handle, requestId);
 	}
 
 	static bool read_from_cache(GTHandle handle, ReadRequest request)
@@ -155,316 +162,12 @@ public:
 };
 
 
-class SavedHttpRequest
-{
-public:
-	SavedHttpRequest(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> httpRequestRef) : m_requestRef(httpRequestRef), m_finished(false)
-	{
-	}
-
-	virtual ~SavedHttpRequest()
-	{
-		// Unbind all lambdas before shutting down the request
-		m_requestRef->OnProcessRequestComplete().Unbind();
-#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
-		m_requestRef->OnRequestProgress64().Unbind();
-#else
-		m_requestRef->OnRequestProgress().Unbind();
-#endif
-		m_requestRef->OnRequestWillRetry().Unbind();
-		m_requestRef->OnHeaderReceived().Unbind();
-		m_requestRef->CancelRequest();
-	}
-
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Get() const
-	{
-		return m_requestRef;
-	}
-
-	operator TSharedRef<IHttpRequest, ESPMode::ThreadSafe>() const {
-		return m_requestRef;
-	}
-
-	void MarkAsFinished()
-	{
-		m_finished = true;
-	}
-
-	bool IsFinished() const
-	{
-		return m_finished;
-	}
-private:
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> m_requestRef;
-	bool m_finished;
-};
-
-
 //////////////////////////////////////////////////////////////////////////////////////////
 // ReaderDiskCache
 //
 const TCHAR* GHOSTTREE_DISKCACHE_PREFIX = TEXT("EC_Cache_");
 const TCHAR* GHOSTTREE_DISKCACHE_EXTENSION = TEXT(".bin");
 
-UGhostTreeFormatReader::ReaderDiskCache::ReaderDiskCache() :
-	m_currentCacheId(-1)
-{
-	m_cacheFileFullpath = FPaths::CreateTempFilename(FGenericPlatformMisc::GamePersistentDownloadDir(), GHOSTTREE_DISKCACHE_PREFIX, GHOSTTREE_DISKCACHE_EXTENSION);
-}
-
-
-UGhostTreeFormatReader::ReaderDiskCache::~ReaderDiskCache()
-{
-	Reset();
-}
-
-void UGhostTreeFormatReader::ReaderDiskCache::Reset()
-{
-	IFileManager::Get().Delete(*m_cacheFileFullpath);
-
-	m_entries.clear();
-	m_currentCache.clear();
-	m_currentCacheId = -1;
-}
-
-FArchive* UGhostTreeFormatReader::ReaderDiskCache::GetCacheFileWriter()
-{
-	IFileManager& fileManager = IFileManager::Get();
-	FArchive* Archive = fileManager.CreateFileWriter(*m_cacheFileFullpath, FILEWRITE_Append);
-	if (!Archive)
-	{
-		UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot write cache file '%s'."), *m_cacheFileFullpath);
-		return nullptr;
-	}
-
-	return Archive;
-}
-
-
-FArchive* UGhostTreeFormatReader::ReaderDiskCache::GetCacheFileReader()
-{
-	IFileManager& fileManager = IFileManager::Get();
-	if (fileManager.FileExists(*m_cacheFileFullpath))
-	{
-		FArchive* Archive = fileManager.CreateFileReader(*m_cacheFileFullpath, FILEREAD_NoFail | FILEREAD_Silent);
-		if (!Archive)
-		{
-			UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot read cache file '%s'."), *m_cacheFileFullpath);
-			return nullptr;
-		}
-
-		return Archive;
-	}
-
-	UE_LOG(EvercoastReaderLog, Error, TEXT("Cache file '%s' does not exist."), *m_cacheFileFullpath);
-	return nullptr;
-
-	
-}
-
-bool UGhostTreeFormatReader::ReaderDiskCache::CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	if (m_entries.find(cache_id) == m_entries.end())
-	{
-		FArchive* Writer = GetCacheFileWriter();
-		size_t offset = Writer->TotalSize();
-		Writer->Serialize((void*)data, size);
-		Writer->Close();
-
-		m_entries.insert(std::pair<uint32_t, DiskCacheRecord>(cache_id, { offset, size }));
-		return true;
-	}
-	else
-	{
-		// existing entry, update the cache
-		FArchive* Writer = GetCacheFileWriter();
-		size_t offset = Writer->TotalSize();
-		Writer->Serialize((void*)data, size);
-		Writer->Close();
-
-		m_entries[cache_id] = { offset, size };
-
-		return false;
-	}
-}
-
-bool UGhostTreeFormatReader::ReaderDiskCache::Remove(uint32_t cache_id)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = m_entries.find(cache_id);
-	if (it != m_entries.end())
-	{
-		// We don't do anything to the disk cache file as it's grow-only
-		m_entries.erase(it);
-
-		// if happens to be the current cache
-		if (cache_id == m_currentCacheId)
-		{
-			m_currentCacheId = -1;
-			m_currentCache.clear();
-		}
-		return true;
-	}
-
-	return false;
-}
-
-const uint8_t* UGhostTreeFormatReader::ReaderDiskCache::Get(uint32_t cache_id)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-
-	if (cache_id != m_currentCacheId)
-	{
-		auto it = m_entries.find(cache_id);
-		if (it != m_entries.end())
-		{
-			FArchive* Reader = GetCacheFileReader();
-			if (Reader)
-			{
-				Reader->Seek(it->second.offset);
-
-				m_currentCacheId = cache_id;
-				m_currentCache.resize(it->second.size);
-
-				Reader->Serialize(m_currentCache.data(), it->second.size);
-				Reader->Close();
-				return m_currentCache.data();
-			}
-		}
-
-		return nullptr;
-	}
-	else
-	{
-		if (m_currentCache.size() > 0)
-			return m_currentCache.data();
-		else
-			return nullptr;
-	}
-}
-
-const uint8_t* UGhostTreeFormatReader::ReaderDiskCache::GetRange(uint32_t cache_id, uint32_t offset, uint32_t size)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	if (cache_id != m_currentCacheId)
-	{
-		auto it = m_entries.find(cache_id);
-		if (it != m_entries.end())
-		{
-			FArchive* Reader = GetCacheFileReader();
-			if (Reader)
-			{
-				Reader->Seek(it->second.offset);
-
-				m_currentCacheId = cache_id;
-				m_currentCache.resize(it->second.size);
-
-				Reader->Serialize(m_currentCache.data(), it->second.size);
-				Reader->Close();
-				return m_currentCache.data() + offset;
-			}
-		}
-
-		return nullptr;
-	}
-	else
-	{
-		if (m_currentCache.size() > 0)
-			return m_currentCache.data() + offset;
-		else
-			return nullptr;
-	}
-}
-
-//////////////////////////////////////////////////////////////////////////////////////////
-// UGhostTreeFormatReader::ReaderMemoryCache
-UGhostTreeFormatReader::ReaderMemoryCache::ReaderMemoryCache()
-{
-}
-
-
-UGhostTreeFormatReader::ReaderMemoryCache::~ReaderMemoryCache()
-{
-	Reset();
-}
-
-void UGhostTreeFormatReader::ReaderMemoryCache::Reset()
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
-	{
-		delete[] it->second;
-	}
-
-	m_entries.clear();
-}
-
-bool UGhostTreeFormatReader::ReaderMemoryCache::CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto find_it = m_entries.find(cache_id);
-	if (find_it == m_entries.end())
-	{
-		uint8_t* copied_data = new uint8_t[size];
-		memcpy(copied_data, data, size);
-
-		m_entries.insert(std::pair<uint32_t, uint8*>(cache_id, copied_data));
-		return true;
-
-	}
-	else
-	{
-		delete[] find_it->second;
-
-		uint8_t* copied_data = new uint8_t[size];
-		memcpy(copied_data, data, size);
-
-		find_it->second = copied_data;
-
-		return false;
-	}
-}
-
-bool UGhostTreeFormatReader::ReaderMemoryCache::Remove(uint32_t cache_id)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = m_entries.find(cache_id);
-	if (it != m_entries.end())
-	{
-		delete[] it->second;
-		m_entries.erase(it);
-		return true;
-	}
-
-	return false;
-}
-
-const uint8_t* UGhostTreeFormatReader::ReaderMemoryCache::Get(uint32_t cache_id)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = m_entries.find(cache_id);
-	if (it != m_entries.end())
-	{
-		return it->second;
-	}
-
-	return nullptr;
-}
-
-const uint8_t* UGhostTreeFormatReader::ReaderMemoryCache::GetRange(uint32_t cache_id, uint32_t offset, uint32_t size)
-{
-	std::lock_guard<std::recursive_mutex> guard(m_lock);
-	auto it = m_entries.find(cache_id);
-	if (it != m_entries.end())
-	{
-		uint8_t* buf = it->second;
-		return buf + offset;
-	}
-
-	return nullptr;
-}
-
 //////////////////////////////////////////////////////////////////////////////////////////
 // UGhostTreeFormatReader
 UGhostTreeFormatReader* UGhostTreeFormatReader::Create(bool inEditor, UAudioComponent* audioComponent, int32 maxCacheSizeInMB, UObject* Outter)
@@ -484,6 +187,7 @@ UGhostTreeFormatReader::UGhostTreeFormatReader(const FObjectInitializer&) :
 	m_instance(InvalidHandle),
 	m_inEditor(false),
 	m_currMode(OperatingMode::None),
+	m_asyncFileHandle(nullptr),
 	m_isMesh(false),
 	m_isMeshWithNormals(false),
 	m_mainChannelId(-1),
@@ -512,6 +216,15 @@ UGhostTreeFormatReader::UGhostTreeFormatReader(const FObjectInitializer&) :
 	m_desiredFrameRate(HIGHEST_FRAMERATE),
 	m_forceMemoryCache(false),
 	m_maxCacheSizeInMB(1024),
+	m_maxConcurrentHttpRequests(4),
+	m_maxHttpRetries(3),
+	m_httpTimeoutInSeconds(5.0f),
+	m_usePersistentCache(false),
+	m_adaptiveBitRate(false),
+	m_segmentDuration(1.0),
+	m_cachedUntil(0),
+	m_lastSegmentIndex(-1),
+	m_pendingRepresentationId(-1),
 	m_preferExternalVideoData(false)
 {
 }
@@ -535,6 +248,19 @@ UGhostTreeFormatReader::~UGhostTreeFormatReader()
 	FinishPendingBlocks();
 	ProcessRequestResults();
 
+	// Outstanding reads write into GhostTree's buffers and the cache, cancel and drain them before either goes away
+	CloseFileStream();
+	if (m_httpScheduler)
+	{
+		if (m_usePersistentCache)
+		{
+			ReaderPersistentCache::Get().CancelLookups(this);
+		}
+		m_httpScheduler->CancelAll();
+		m_httpScheduler.reset();
+	}
+	DiscardRequestResults();
+
 	m_dataDecoder = nullptr;
 	release_reader_instance(m_instance);
 	s_readerRegistry.erase(m_instance);
@@ -547,14 +273,6 @@ UGhostTreeFormatReader::~UGhostTreeFormatReader()
 		m_cache = nullptr;
 	}
 
-	m_savedHttpRequestList.clear();
-
-	if (m_fileStream)
-	{
-		m_fileStream->Close();
-		m_fileStream.Reset();
-	}
-
 	m_currMode = OperatingMode::None;
 	m_statusCallback = nullptr;
 
@@ -696,6 +414,26 @@ bool UGhostTreeFormatReader::OnOpenConnection(uint32_t conn_handle, const char*
 	
 	if (m_dataURL.rfind("http://", 0) == 0 || m_dataURL.rfind("https://", 0) == 0)
 	{
+		HttpRangeSchedulerConfig config;
+		config.maxRequestsInFlight = m_maxConcurrentHttpRequests;
+		config.maxRetries = m_maxHttpRetries;
+		config.timeoutInSeconds = m_inEditor ? 0.0f : m_httpTimeoutInSeconds;
+
+		UGhostTreeFormatReader* reader = this;
+		m_httpScheduler = std::make_shared<HttpRangeScheduler>(FString(m_dataURL.c_str()), config,
+			[reader](const ReadRequest& readRequest, const uint8_t* data, uint32_t size, const FString& etag, bool succeeded) {
+				reader->OnHttpRangeComplete(readRequest, data, size, etag, succeeded);
+			});
+		if (m_adaptiveBitRate)
+		{
+			m_httpScheduler->SetThroughputCallback([reader](uint64_t bytes, double durationInSeconds) {
+				std::lock_guard<std::recursive_mutex> guard(reader->m_readerLock);
+				if (reader->m_abrController)
+				{
+					reader->m_abrController->AddThroughputSample(bytes, durationInSeconds);
+				}
+			});
+		}
 		m_currMode = OperatingMode::HTTP;
 		return true;
 	}
@@ -713,18 +451,17 @@ bool UGhostTreeFormatReader::OnOpenConnection(uint32_t conn_handle, const char*
 
 		UE_LOG(EvercoastReaderLog, Log, TEXT("Open local converted path: %s"), *pathURL);
 	
-		FArchive* ar = IFileManager::Get().CreateFileReader(*pathURL);
-		if (ar)
+		// Async handles don't report a missing file until the first read, so check up front
+		if (IFileManager::Get().FileSize(*pathURL) >= 0)
 		{
-			m_fileStream = MakeShareable(ar);
-			if (!m_fileStream->GetError() && m_fileStream->IsLoading())
+			m_asyncFileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenAsyncRead(*pathURL);
+			if (m_asyncFileHandle)
 			{
 				m_currMode = OperatingMode::FileSystem;
 				return true;
 			}
 
 			UE_LOG(EvercoastReaderLog, Error, TEXT("Open with error: %s"), *pathURL);
-			m_fileStream->ClearError();
 		}
 		else
 		{
@@ -739,18 +476,28 @@ bool UGhostTreeFormatReader::OnCloseConnection(uint32_t conn_handle)
 {
 	UE_LOG(EvercoastReaderLog, Log, TEXT("Close connection: %s"), *FString(m_dataURL.c_str()));
 
-	if (m_currMode == OperatingMode::HTTP)
+	if (m_currMode == OperatingMode::HTTP && m_httpScheduler)
 	{
-		m_savedHttpRequestList.clear();
+		if (m_usePersistentCache)
+		{
+			// A lookup falling back to HTTP still uses the scheduler
+			ReaderPersistentCache::Get().CancelLookups(this);
+		}
+		m_httpScheduler->CancelAll();
+		m_httpScheduler.reset();
+		if (m_usePersistentCache)
+		{
+			// keep the index on disk up to date in case the app doesn't shut down gracefully
+			ReaderPersistentCache::Get().Flush();
+		}
 	}
 	else if (m_currMode == OperatingMode::FileSystem)
 	{
-		m_fileStream->Close();
-		m_fileStream.Reset();
+		CloseFileStream();
 	}
 	else
 	{
-		check(!m_fileStream && m_savedHttpRequestList.size() == 0);
+		check(!m_asyncFileHandle && !m_httpScheduler);
 	}
 
 	if (m_playbackReady)
@@ -787,127 +534,253 @@ bool UGhostTreeFormatReader::OnReaderReadFromConnection(uint32_t conn_handle, Re
 			}
 			return false;
 		}
-		uint64_t rangeStart = readRequest.offset;
-		uint64_t rangeEnd = readRequest.offset + readRequest.size - 1;
-		const float timeout = m_inEditor ? 0.0f : 5.0f;
-		auto httpRequest = NewHttpRequest(FString(m_dataURL.c_str()), rangeStart, rangeEnd, timeout);
-		auto savedHttpRequest = std::make_shared<SavedHttpRequest>(httpRequest);
-		m_savedHttpRequestList.emplace_back(savedHttpRequest);
 
-		// Need to use raw pointer to prevent lambda from keeping the shared_ptr SavedHttpRequest from being destoryed when
-		// container cleared.
-		SavedHttpRequest* pSavedHttpRequest = savedHttpRequest.get();
+		if (m_usePersistentCache && ReadFromPersistentCache(readRequest))
+		{
+			return true;
+		}
 
-		UGhostTreeFormatReader* reader = this;
-		httpRequest->OnProcessRequestComplete().BindLambda([readRequest, reader, pSavedHttpRequest](auto httpReq, auto httpResp, bool succeeded) {
+		// Dispatched on Tick(), adjacent ranges are merged into one HTTP request
+		m_httpScheduler->Enqueue(readRequest);
+		return true;
+	}
+	else if (m_currMode == OperatingMode::FileSystem)
+	{
+		uint8_t* destination = readRequest.buffer;
+		if (destination == nullptr)
+		{
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("File cache id: %d"), readRequest.cache_id);
+			// Read straight into the cache's storage, no intermediate buffer
+			destination = m_cache->Reserve(readRequest.cache_id, readRequest.size);
+		}
 
-			if (!reader->IsValidLowLevel())
+		if (destination && m_asyncFileHandle)
+		{
+			UGhostTreeFormatReader* reader = this;
+			FAsyncFileCallBack callback = [readRequest, reader](bool wasCancelled, IAsyncReadRequest* asyncRequest)
 			{
-				return;
-			}
+				// Runs on an IO thread, results are handed back to GhostTree on Tick()
+				std::lock_guard<std::recursive_mutex> guard(reader->m_readerLock);
+				auto pending = reader->m_pendingFileReads.find(readRequest.request_id);
+				// Gone, or the id was reused after this one got cancelled
+				if (pending == reader->m_pendingFileReads.end() || (pending->second.asyncRequest != nullptr && pending->second.asyncRequest != asyncRequest))
+				{
+					// Cancelled, GhostTree doesn't expect to hear about it any more
+					UE_LOG(EvercoastReaderLog, Verbose, TEXT("File request cancelled id %d"), readRequest.request_id);
+					if (readRequest.buffer == nullptr)
+					{
+						reader->m_cache->Remove(readRequest.cache_id);
+					}
+					return;
+				}
+				pending->second.completed = true;
 
-			bool successRead = false;
-			if (succeeded && httpResp->GetResponseCode() >= 200 && httpResp->GetResponseCode() < 300)
-			{
-				if (readRequest.buffer != nullptr)
+				bool successRead = !wasCancelled && asyncRequest->GetReadResults() != nullptr;
+				if (successRead)
 				{
-					// copy response content to readRequest.buffer, no caching, reader api needs some validation before giving cacheable data
-					memcpy(readRequest.buffer, httpResp->GetContent().GetData(), std::min(readRequest.size, (uint32_t)httpResp->GetContentLength()));
-					successRead = true;
+					UE_LOG(EvercoastReaderLog, Verbose, TEXT("File request successful id %d"), readRequest.request_id);
+					if (readRequest.buffer == nullptr)
+					{
+						reader->m_cache->Unpin(readRequest.cache_id);
+					}
+					reader->m_processedRequestId.push(
+						{
+							readRequest.request_id,
+							readRequest.size
+						});
 				}
 				else
 				{
-					UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP got cache id: %d"), readRequest.cache_id);
-					successRead = reader->m_cache->CopyAdd(readRequest.cache_id, httpResp->GetContent().GetData(), std::min(readRequest.size, (uint32_t)httpResp->GetContentLength()));
+					UE_LOG(EvercoastReaderLog, Warning, TEXT("File request failed id %d"), readRequest.request_id);
+					if (readRequest.buffer == nullptr)
+					{
+						reader->m_cache->Remove(readRequest.cache_id);
+					}
+					reader->m_failedRequestId.push(readRequest.request_id);
 				}
-				
+			};
+
+			// Tracked before issuing, the callback may run before ReadRequest() returns
+			std::unique_lock<std::recursive_mutex> guard(m_readerLock);
+			m_pendingFileReads[readRequest.request_id] = PendingFileRead();
+			guard.unlock();
+
+			IAsyncReadRequest* asyncRequest = m_asyncFileHandle->ReadRequest(readRequest.offset, readRequest.size, AIOP_Normal, &callback, destination);
+
+			guard.lock();
+			if (asyncRequest)
+			{
+				m_pendingFileReads[readRequest.request_id].asyncRequest = asyncRequest;
+				return true;
 			}
+			m_pendingFileReads.erase(readRequest.request_id);
+			guard.unlock();
 
-			if (successRead)
+			if (readRequest.buffer == nullptr)
 			{
-				UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP request successful id %d"), readRequest.request_id);
-				std::lock_guard<std::recursive_mutex> guard(reader->m_readerLock);
-				reader->m_processedRequestId.push(
+				m_cache->Remove(readRequest.cache_id);
+			}
+		}
+
+		UE_LOG(EvercoastReaderLog, Error, TEXT("File read request cannot be issued, cache id = %d, size = %d"), readRequest.cache_id, readRequest.size);
+		std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("File request failed id %d"), readRequest.request_id);
+		m_failedRequestId.push(readRequest.request_id);
+	}
+	else
+	{
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("Unknown operating mode: %d"), (int)m_currMode);
+	}
+		
+	return false;
+}
+
+bool UGhostTreeFormatReader::ReadFromPersistentCache(const ReadRequest& readRequest)
+{
+	ReaderPersistentCache& persistentCache = ReaderPersistentCache::Get();
+	const FString url(m_dataURL.c_str());
+	if (!persistentCache.Contains(url, readRequest.offset, readRequest.size))
+		return false;
+
+	uint8_t* destination = readRequest.buffer;
+	if (destination == nullptr)
+	{
+		destination = m_cache->Reserve(readRequest.cache_id, readRequest.size);
+		if (destination == nullptr)
+			return false;
+	}
+
+	// Read on the cache's IO thread, a miss falls back to HTTP from there
+	std::shared_ptr<HttpRangeScheduler> httpScheduler = m_httpScheduler;
+	persistentCache.LookupAsync(this, readRequest.request_id, url, readRequest.offset, readRequest.size, destination,
+		[this, readRequest, httpScheduler](ReaderPersistentCache::LookupResult result)
+		{
+			if (result == ReaderPersistentCache::LookupResult::Hit)
+			{
+				if (readRequest.buffer == nullptr)
+				{
+					m_cache->Unpin(readRequest.cache_id);
+				}
+
+				UE_LOG(EvercoastReaderLog, Verbose, TEXT("Persistent cache hit id %d"), readRequest.request_id);
+				std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+				m_processedRequestId.push(
 					{
 						readRequest.request_id,
 						readRequest.size
 					});
+				return;
 			}
-			else
+
+			if (readRequest.buffer == nullptr)
 			{
-				UE_LOG(EvercoastReaderLog, Warning, TEXT("HTTP request failed id %d"), readRequest.request_id);
-				std::lock_guard<std::recursive_mutex> guard(reader->m_readerLock);
-				reader->m_failedRequestId.push(readRequest.request_id);
+				m_cache->Remove(readRequest.cache_id);
 			}
 
-			pSavedHttpRequest->MarkAsFinished();
+			if (result == ReaderPersistentCache::LookupResult::Miss)
+			{
+				httpScheduler->Enqueue(readRequest);
+			}
 		});
+	return true;
+}
 
-		return httpRequest->ProcessRequest();
-	}
-	else if (m_currMode == OperatingMode::FileSystem)
+bool UGhostTreeFormatReader::OnCancelConnectionRequest(uint32_t conn_handle, uint32_t requestId)
+{
+	if (m_currMode == OperatingMode::HTTP && m_httpScheduler)
 	{
-		bool successRead = false;
+		if (m_usePersistentCache && ReaderPersistentCache::Get().CancelLookup(this, requestId))
+		{
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("Cancel request id %d: cancelled persistent cache lookup"), requestId);
+			return true;
+		}
 
-		m_fileStream->Seek(readRequest.offset);
-		if (!m_fileStream->GetError())
+		// Cancelled requests are never reported back, either dropped from the queue or aborted in flight
+		bool cancelled = m_httpScheduler->Cancel(requestId);
+		UE_LOG(EvercoastReaderLog, Verbose, TEXT("Cancel request id %d: %s"), requestId, cancelled ? TEXT("cancelled") : TEXT("not found"));
+		return cancelled;
+	}
+
+	if (m_currMode == OperatingMode::FileSystem)
+	{
+		IAsyncReadRequest* asyncRequest = nullptr;
 		{
-			
-			if (readRequest.buffer != nullptr)
+			std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+			auto it = m_pendingFileReads.find(requestId);
+			// Already completed, its result gets reported on Tick() as usual
+			if (it == m_pendingFileReads.end() || it->second.completed || !it->second.asyncRequest)
 			{
-				m_fileStream->Serialize((char*)readRequest.buffer, readRequest.size);
-				successRead = !m_fileStream->GetError();
+				UE_LOG(EvercoastReaderLog, Verbose, TEXT("Cancel request id %d: not found"), requestId);
+				return false;
 			}
-			else
-			{
-				UE_LOG(EvercoastReaderLog, Verbose, TEXT("File cache id: %d"), readRequest.cache_id);
+			asyncRequest = it->second.asyncRequest;
+			// No longer tracked, so the completion gets dropped
+			m_pendingFileReads.erase(it);
+		}
 
-				uint8_t* buffer = new uint8_t[readRequest.size];
-				m_fileStream->Serialize(buffer, readRequest.size);
-				if (!m_fileStream->GetError())
-				{
-					successRead = true;
-					m_cache->CopyAdd(readRequest.cache_id, buffer, readRequest.size);
-				}
-				else
-				{
-					UE_LOG(EvercoastReaderLog, Error, TEXT("File stream read error, cache id = %d, size = %d"), readRequest.cache_id, readRequest.size);
-				}
+		// GhostTree may reuse the request's buffer once we return, so wait out the read. Not under the lock,
+		// which the completion callback takes.
+		asyncRequest->Cancel();
+		asyncRequest->WaitCompletion();
+		delete asyncRequest;
+		UE_LOG(EvercoastReaderLog, Verbose, TEXT("Cancel request id %d: cancelled"), requestId);
+		return true;
+	}
 
-				delete[] buffer;
+	return false;
+}
 
-			}
+// Can be called from HTTP threads
+void UGhostTreeFormatReader::OnHttpRangeComplete(const ReadRequest& readRequest, const uint8_t* data, uint32_t size, const FString& etag, bool succeeded)
+{
+	bool successRead = false;
+	if (succeeded)
+	{
+		if (m_usePersistentCache)
+		{
+			ReaderPersistentCache::Get().Store(FString(m_dataURL.c_str()), etag, readRequest.offset, size, data);
 		}
 
-		if (successRead)
+		if (readRequest.buffer != nullptr)
 		{
-			std::lock_guard<std::recursive_mutex> guard(m_readerLock);
-			UE_LOG(EvercoastReaderLog, Verbose, TEXT("File request successful id %d"), readRequest.request_id);
-			m_processedRequestId.push(
-				{
-					readRequest.request_id,
-					readRequest.size
-				});
-			return true;
+			// copy response content to readRequest.buffer, no caching, reader api needs some validation before giving cacheable data
+			memcpy(readRequest.buffer, data, size);
+			successRead = true;
 		}
 		else
 		{
-			std::lock_guard<std::recursive_mutex> guard(m_readerLock);
-			UE_LOG(EvercoastReaderLog, Warning, TEXT("File request failed id %d"), readRequest.request_id);
-			m_failedRequestId.push(readRequest.request_id);
-			m_fileStream->ClearError();
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP got cache id: %d"), readRequest.cache_id);
+			uint8_t* destination = m_cache->Reserve(readRequest.cache_id, size);
+			if (destination)
+			{
+				memcpy(destination, data, size);
+				m_cache->Unpin(readRequest.cache_id);
+				successRead = true;
+			}
 		}
 	}
+
+	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	if (successRead)
+	{
+		UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP request successful id %d"), readRequest.request_id);
+		m_processedRequestId.push(
+			{
+				readRequest.request_id,
+				size
+			});
+	}
 	else
 	{
-		UE_LOG(EvercoastReaderLog, Warning, TEXT("Unknown operating mode: %d"), (int)m_currMode);
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("HTTP request failed id %d"), readRequest.request_id);
+		m_failedRequestId.push(readRequest.request_id);
 	}
-		
-	return false;
 }
 
 void UGhostTreeFormatReader::OnPlaybackInfoReceived(PlaybackInfo playback_info)
 {
+	// Representation switches happen on segment boundaries, VOD content doesn't report segments so use 1 sec
+	m_segmentDuration = playback_info.segmentDuration > 0 ? playback_info.segmentDuration : 1.0;
 	if (playback_info.isLive)
 	{
 		UE_LOG(EvercoastReaderLog, Log, TEXT("PlaybackInfo: Live Segment Duration=%f"), playback_info.segmentDuration);
@@ -1019,6 +892,11 @@ void UGhostTreeFormatReader::OnChannelsReceived(uint32_t count, ChannelInfo* cha
 
 				m_mainChannelSampleRate = sampleRate;
 
+				if (m_adaptiveBitRate && m_currMode == OperatingMode::HTTP)
+				{
+					SetupAdaptiveBitRate(info, selectedRepresentationId);
+				}
+
 				mainChannelSelected = true;
 
 				if (meshWithNormals)
@@ -1269,10 +1147,22 @@ void UGhostTreeFormatReader::OnBlockReceived(ChannelDataBlock data_block)
 	UE_LOG(EvercoastReaderLog, Verbose, TEXT("Block Received: block_id: %d, channel_id: %d"), data_block.block_id, data_block.channel_id);
 
 	uint32_t data_size = data_block.size;
-	const uint8_t* data = m_cache->GetRange(data_block.cache_id, data_block.offset, data_block.size);
+	// Keep the entry from being evicted by reads completing meanwhile, the decoders copy the data in Receive()
+	const bool pinned = m_cache->Pin(data_block.cache_id);
+	const uint8_t* data = pinned ? m_cache->GetRange(data_block.cache_id, data_block.offset, data_block.size) : nullptr;
+	ON_SCOPE_EXIT
+	{
+		if (pinned)
+		{
+			m_cache->Unpin(data_block.cache_id);
+		}
+	};
 	if (!data)
 	{
-		UE_LOG(EvercoastReaderLog, Error, TEXT("No cache found by cache_id %d"), data_block.cache_id);
+		// Evicted to make room for newer reads, only this block is lost so drop it and carry on
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("No cache found by cache_id %d, dropped block: %d"), data_block.cache_id, data_block.block_id);
+		std::lock_guard<std::recursive_mutex> guard(m_pendingReleaseBlocksLock);
+		m_pendingDataBlocksToRelease.push_back(data_block);
 		return;
 	}
 
@@ -1337,6 +1227,11 @@ void UGhostTreeFormatReader::OnBlockReceived(ChannelDataBlock data_block)
 
 		m_currRepresentationId = data_block.representation_id;
 
+		if (m_abrController)
+		{
+			EvaluateAdaptiveBitRate(data_block.timestamp);
+		}
+
 		// check if the seeking target meets
 		if (m_inSeeking)
 		{
@@ -1500,6 +1395,17 @@ bool UGhostTreeFormatReader::RequestFrameOnTimestamp(float timestamp)
 
 		m_currSeekingTarget = timestamp;
 
+		{
+			// The buffer ahead is gone, evaluate again at the first segment landing after the seek. A pending
+			// switch still applies, the controller already moved on to it.
+			std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+			if (m_abrController)
+			{
+				m_abrController->Reset();
+			}
+			m_lastSegmentIndex = -1;
+		}
+
 		// Always set to the real timestamp to 1 sec before the requrested, this is aligned with the frame caching algorithm
 		float timestampIncludingPrecache = timestamp - 1.0f;
 		if (timestampIncludingPrecache < 0)
@@ -1597,7 +1503,80 @@ void UGhostTreeFormatReader::OnLastBlock(uint32_t channel_id)
 
 void UGhostTreeFormatReader::OnCacheUpdate(double cached_until)
 {
-	UE_LOG(EvercoastReaderLog, VeryVerbose, TEXT("Cache updated till: %f"), cached_until);
+	m_cachedUntil = cached_until;
+	UE_LOG(EvercoastReaderLog, VeryVerbose, TEXT("Cache updated till: %f, occupancy: %llu bytes"), cached_until, (unsigned long long)GetCacheOccupancyInBytes());
+}
+
+void UGhostTreeFormatReader::SetupAdaptiveBitRate(const ChannelInfo& info, uint32_t selectedRepresentationId)
+{
+	// Candidates share the selected frame rate so switching never changes timing, user's bit rate limit still applies
+	std::vector<AbrRepresentation> candidates;
+	for (uint32_t j = 0; j < info.representation_count; ++j)
+	{
+		const auto& representation = info.representations[j];
+		if (representation.sample_rate == m_mainChannelSampleRate && representation.bit_rate < m_volumetricChannelBitRateThreshold)
+		{
+			candidates.push_back({ representation.representation_id, representation.bit_rate });
+			m_representationIds[representation.representation_id] = representation.sample_rate;
+		}
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	if (candidates.size() < 2)
+	{
+		UE_LOG(EvercoastReaderLog, Log, TEXT("Adaptive bit rate: only %d representation at %d fps, nothing to adapt."), (int)candidates.size(), m_mainChannelSampleRate);
+		m_abrController.reset();
+		return;
+	}
+
+	if (!m_abrController)
+	{
+		m_abrController = std::make_shared<AdaptiveBitRateController>();
+	}
+	m_abrController->SetRepresentations(candidates, selectedRepresentationId);
+	m_lastSegmentIndex = -1;
+	m_pendingRepresentationId = -1;
+	UE_LOG(EvercoastReaderLog, Log, TEXT("Adaptive bit rate: %d representations at %d fps"), (int)candidates.size(), m_mainChannelSampleRate);
+}
+
+void UGhostTreeFormatReader::EvaluateAdaptiveBitRate(double timestamp)
+{
+	const int64_t segmentIndex = (int64_t)floor(timestamp / m_segmentDuration);
+	if (segmentIndex == m_lastSegmentIndex)
+		return;
+	m_lastSegmentIndex = segmentIndex;
+
+	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	m_abrController->SetBufferLevel(std::max(0.0, m_cachedUntil - timestamp));
+
+	uint32_t representationId = 0;
+	if (m_abrController->Evaluate(FPlatformTime::Seconds(), representationId))
+	{
+		UE_LOG(EvercoastReaderLog, Log, TEXT("Adaptive bit rate: switching to representation %d at %.2f, throughput %.2f Mbps, buffered %.2fs"),
+			representationId, timestamp, m_abrController->GetEstimatedThroughput() / (1024.0 * 1024.0), m_abrController->GetBufferLevel());
+		// Can't change representations from inside GhostTree's callback, apply on Tick()
+		m_pendingRepresentationId = representationId;
+	}
+}
+
+void UGhostTreeFormatReader::ApplyPendingRepresentationSwitch()
+{
+	if (m_pendingRepresentationId < 0 || m_mainChannelId == (uint32_t)-1)
+		return;
+
+	uint32_t representationId = (uint32_t)m_pendingRepresentationId;
+	m_pendingRepresentationId = -1;
+	// Keep cached data of the previous representation, blocks already downloaded are still playable
+	reader_enable_channel_representations(m_instance, m_mainChannelId, 1, &representationId, false);
+}
+
+void UGhostTreeFormatReader::ResetAdaptiveBitRate()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	m_abrController.reset();
+	m_cachedUntil = 0;
+	m_lastSegmentIndex = -1;
+	m_pendingRepresentationId = -1;
 }
 
 void UGhostTreeFormatReader::OnFinishedWithCacheId(uint32_t cache_id)
@@ -1608,7 +1587,7 @@ void UGhostTreeFormatReader::OnFinishedWithCacheId(uint32_t cache_id)
 	}
 	else
 	{
-		UE_LOG(EvercoastReaderLog, Warning, TEXT("Unable to remove cache id: %d"), cache_id);
+		UE_LOG(EvercoastReaderLog, Verbose, TEXT("Cache id already evicted: %d"), cache_id);
 	}
 }
 
@@ -1630,6 +1609,7 @@ bool UGhostTreeFormatReader::OpenFromLocation(const FString& urlOrFilePath, Read
 	m_audioChannelId = -1;
 	m_currRepresentationId = -1;
 	m_representationIds.clear();
+	ResetAdaptiveBitRate();
 	m_currExternalPostfix.Empty();
 	m_textureChannelId = -1;
 
@@ -1647,11 +1627,12 @@ void UGhostTreeFormatReader::CreateCache()
 
 	if (m_forceMemoryCache)
 	{
-		m_cache = std::make_shared<ReaderMemoryCache>();
+		m_cache = std::make_shared<ReaderMemoryCache>(1024ull * 1024ull * m_maxCacheSizeInMB);
 	}
 	else
 	{
-		m_cache = std::make_shared<ReaderDiskCache>();
+		FString cacheFileFullpath = FPaths::CreateTempFilename(FGenericPlatformMisc::GamePersistentDownloadDir(), GHOSTTREE_DISKCACHE_PREFIX, GHOSTTREE_DISKCACHE_EXTENSION);
+		m_cache = std::make_shared<ReaderDiskCache>(cacheFileFullpath, 1024ull * 1024ull * m_maxCacheSizeInMB);
 	}
 }
 
@@ -1672,18 +1653,31 @@ void UGhostTreeFormatReader::Close()
 	FinishPendingBlocks();
 
 	ProcessRequestResults();
-	reader_close(m_instance);
 
-	if (m_currMode == OperatingMode::HTTP)
+	// Cancel and drain the outstanding reads before GhostTree frees the buffers they write into
+	if (m_currMode == OperatingMode::HTTP && m_httpScheduler)
 	{
-		m_savedHttpRequestList.clear();
+		if (m_usePersistentCache)
+		{
+			// A lookup falling back to HTTP still uses the scheduler
+			ReaderPersistentCache::Get().CancelLookups(this);
+		}
+		m_httpScheduler->CancelAll();
+		m_httpScheduler.reset();
+		if (m_usePersistentCache)
+		{
+			// keep the index on disk up to date in case the app doesn't shut down gracefully
+			ReaderPersistentCache::Get().Flush();
+		}
 	}
 
 	if (m_currMode == OperatingMode::FileSystem)
 	{
-		m_fileStream->Close();
-		m_fileStream.Reset();
+		CloseFileStream();
 	}
+	DiscardRequestResults();
+
+	reader_close(m_instance);
 
 	if (m_cache)
 	{
@@ -1722,6 +1716,7 @@ void UGhostTreeFormatReader::Close()
 	m_audioChannelId = -1;
 	m_currRepresentationId = -1;
 	m_representationIds.clear();
+	ResetAdaptiveBitRate();
 	m_currExternalPostfix.Empty();
 	m_textureChannelId = -1;
 
@@ -1734,34 +1729,105 @@ void UGhostTreeFormatReader::Tick()
 {
 	ProcessRequestResults();
 
-	// remove finished http requests from the list
-	m_savedHttpRequestList.erase(
-		std::remove_if(m_savedHttpRequestList.begin(), m_savedHttpRequestList.end(), [](std::shared_ptr<SavedHttpRequest> request) {
-			return request->IsFinished();
-			}), 
-		m_savedHttpRequestList.end());
+	ReleaseFinishedFileReadRequests();
 
 	// process all pending blocks
 	FinishPendingBlocks();
+
+	ApplyPendingRepresentationSwitch();
+
+	// issue the reads requested by the blocks above
+	if (m_httpScheduler)
+	{
+		m_httpScheduler->Tick();
+	}
 }
 
 
-void UGhostTreeFormatReader::ProcessRequestResults()
+void UGhostTreeFormatReader::ReleaseFinishedFileReadRequests()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	for (auto it = m_pendingFileReads.begin(); it != m_pendingFileReads.end();)
+	{
+		IAsyncReadRequest* request = it->second.asyncRequest;
+		// Requests can only be deleted after completion, not from inside their callbacks
+		if (request && it->second.completed && request->PollCompletion())
+		{
+			delete request;
+			it = m_pendingFileReads.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void UGhostTreeFormatReader::CloseFileStream()
+{
+	std::vector<IAsyncReadRequest*> outstanding;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+		for (auto& pending : m_pendingFileReads)
+		{
+			if (pending.second.asyncRequest)
+			{
+				outstanding.push_back(pending.second.asyncRequest);
+			}
+		}
+		// Untracked, so the completions still to come get dropped
+		m_pendingFileReads.clear();
+	}
+
+	// Waiting can't be done under the lock, the completion callbacks take it
+	for (IAsyncReadRequest* request : outstanding)
+	{
+		request->Cancel();
+	}
+	for (IAsyncReadRequest* request : outstanding)
+	{
+		request->WaitCompletion();
+		delete request;
+	}
+
+	if (m_asyncFileHandle)
+	{
+		delete m_asyncFileHandle;
+		m_asyncFileHandle = nullptr;
+	}
+}
+
+void UGhostTreeFormatReader::DiscardRequestResults()
 {
 	std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+	std::queue<RequestRecord>().swap(m_processedRequestId);
+	std::queue<uint32_t>().swap(m_failedRequestId);
+}
+
+void UGhostTreeFormatReader::ProcessRequestResults()
+{
+	// Taken out under the lock and handed over without it, GhostTree may cancel a file read from its callbacks,
+	// which waits on the IO thread that needs the lock to complete
+	std::queue<RequestRecord> processedRequestId;
+	std::queue<uint32_t> failedRequestId;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_readerLock);
+		processedRequestId.swap(m_processedRequestId);
+		failedRequestId.swap(m_failedRequestId);
+	}
 
-	while (!m_processedRequestId.empty())
+	while (!processedRequestId.empty())
 	{
-		auto& record = m_processedRequestId.front();
+		auto& record = processedRequestId.front();
 		reader_read_complete(m_instance, record.id, record.amount);
-		m_processedRequestId.pop();
+		processedRequestId.pop();
 	}
 
-	while (!m_failedRequestId.empty())
+	while (!failedRequestId.empty())
 	{
-		uint32_t id = m_failedRequestId.front();
+		uint32_t id = failedRequestId.front();
 		reader_read_failed(m_instance, id);
-		m_failedRequestId.pop();
+		failedRequestId.pop();
 	}
 }
 
@@ -1862,6 +1928,11 @@ uint32_t UGhostTreeFormatReader::GetTextureChannelId() const
 	return m_textureChannelId;
 }
 
+uint64_t UGhostTreeFormatReader::GetCacheOccupancyInBytes() const
+{
+	return m_cache ? m_cache->GetOccupancyInBytes() : 0;
+}
+
 GTHandle UGhostTreeFormatReader::GetRawHandle() const
 {
 	return m_instance;
@@ -1882,24 +1953,6 @@ UAudioComponent* UGhostTreeFormatReader::GetReceivingAudioComponent() const
 	return m_audioComponent;
 }
 
-TSharedRef<IHttpRequest, ESPMode::ThreadSafe> UGhostTreeFormatReader::NewHttpRequest(const FString& url, uint64_t rangeStart, uint64_t rangeEnd, float timeout)
-{
-	char buf[256];
-	std::snprintf(buf, 256, "bytes=%" PRIu64 "-%" PRIu64, rangeStart, rangeEnd);
-	auto httpRequest = FHttpModule::Get().CreateRequest();
-	httpRequest->SetURL(url);
-	httpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/octet-stream"));
-	httpRequest->SetHeader(TEXT("User-Agent"), TEXT("X-UnrealEngine-Agent"));
-	httpRequest->SetHeader(TEXT("Accepts"), TEXT("application/octet-stream"));
-	httpRequest->SetHeader(TEXT("Origin"), TEXT("evercoast.com"));
-	if (timeout > 0)
-		httpRequest->SetTimeout(timeout);
-	httpRequest->SetHeader(TEXT("Range"), FString(buf));
-	httpRequest->SetVerb(TEXT("GET"));
-
-	return httpRequest;
-}
-
 // This callback will be forced to run on game thread
 void UGhostTreeFormatReader::OnRuntimeAudioResult(URuntimeAudio* newRuntimeAudio, ERuntimeAudioFactoryResult result)
 {
@@ -0,0 +1,367 @@
+#include "HttpRangeScheduler.h"
+#include "GhostTreeFormatReader.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HAL/PlatformTime.h"
+#include <algorithm>
+#include <cstdio>
+#include <inttypes.h>
+
+HttpRangeScheduler::HttpRangeScheduler(const FString& url, const HttpRangeSchedulerConfig& config, CompletionCallback completionCallback) :
+	m_url(url),
+	m_config(config),
+	m_completionCallback(completionCallback),
+	m_throughputSampleStart(0)
+{
+	if (m_config.maxRequestsInFlight == 0)
+		m_config.maxRequestsInFlight = 1;
+}
+
+HttpRangeScheduler::~HttpRangeScheduler()
+{
+	CancelAll();
+}
+
+void HttpRangeScheduler::UnbindAndCancel(InFlightBatch& batch)
+{
+	// Unbind all lambdas before shutting down the request
+	batch.httpRequest->OnProcessRequestComplete().Unbind();
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+	batch.httpRequest->OnRequestProgress64().Unbind();
+#else
+	batch.httpRequest->OnRequestProgress().Unbind();
+#endif
+	batch.httpRequest->OnRequestWillRetry().Unbind();
+	batch.httpRequest->OnHeaderReceived().Unbind();
+	batch.httpRequest->CancelRequest();
+	batch.finished = true;
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRangeScheduler::NewHttpRequest(uint64_t rangeStart, uint64_t rangeEnd) const
+{
+	char buf[256];
+	std::snprintf(buf, 256, "bytes=%" PRIu64 "-%" PRIu64, rangeStart, rangeEnd);
+	auto httpRequest = FHttpModule::Get().CreateRequest();
+	httpRequest->SetURL(m_url);
+	httpRequest->SetHeader(TEXT("Content-Type"), TEXT("application/octet-stream"));
+	httpRequest->SetHeader(TEXT("User-Agent"), TEXT("X-UnrealEngine-Agent"));
+	httpRequest->SetHeader(TEXT("Accepts"), TEXT("application/octet-stream"));
+	httpRequest->SetHeader(TEXT("Origin"), TEXT("evercoast.com"));
+	if (m_config.timeoutInSeconds > 0)
+		httpRequest->SetTimeout(m_config.timeoutInSeconds);
+	httpRequest->SetHeader(TEXT("Range"), FString(buf));
+	httpRequest->SetVerb(TEXT("GET"));
+
+	return httpRequest;
+}
+
+void HttpRangeScheduler::Enqueue(const ReadRequest& request)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	ScheduledRange range;
+	range.request = request;
+	m_pending.push_back(range);
+}
+
+bool HttpRangeScheduler::Cancel(uint32_t requestId)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	for (auto it = m_pending.begin(); it != m_pending.end(); ++it)
+	{
+		if (it->request.request_id == requestId)
+		{
+			m_pending.erase(it);
+			return true;
+		}
+	}
+
+	for (auto& batch : m_inFlight)
+	{
+		if (batch->finished)
+			continue;
+
+		bool found = false;
+		bool allCancelled = true;
+		for (auto& range : batch->ranges)
+		{
+			if (range.request.request_id == requestId)
+			{
+				range.cancelled = true;
+				found = true;
+			}
+			allCancelled &= range.cancelled;
+		}
+
+		if (found)
+		{
+			// Only abort the transfer when nobody else is waiting on it
+			if (allCancelled)
+			{
+				UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP range %llu-%llu aborted"), (unsigned long long)batch->rangeStart, (unsigned long long)batch->rangeEnd);
+				UnbindAndCancel(*batch);
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void HttpRangeScheduler::CancelAll()
+{
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		m_pending.clear();
+		for (auto& batch : m_inFlight)
+		{
+			if (!batch->finished)
+			{
+				UnbindAndCancel(*batch);
+			}
+		}
+		m_inFlight.clear();
+	}
+
+	// Wait out a completion being delivered on another thread, the caller may free the requests' buffers next
+	std::lock_guard<std::recursive_mutex> deliveryGuard(m_deliveryLock);
+}
+
+void HttpRangeScheduler::SetThroughputCallback(ThroughputCallback throughputCallback)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	m_throughputCallback = throughputCallback;
+}
+
+uint32_t HttpRangeScheduler::GetPendingCount() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	return (uint32_t)m_pending.size();
+}
+
+uint32_t HttpRangeScheduler::GetInFlightCount() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	return (uint32_t)std::count_if(m_inFlight.begin(), m_inFlight.end(), [](const std::shared_ptr<InFlightBatch>& batch) {
+		return !batch->finished;
+		});
+}
+
+void HttpRangeScheduler::Tick()
+{
+	BatchList failedBatches;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+
+		// remove finished http requests from the list
+		m_inFlight.erase(
+			std::remove_if(m_inFlight.begin(), m_inFlight.end(), [](const std::shared_ptr<InFlightBatch>& batch) {
+				return batch->finished;
+				}),
+			m_inFlight.end());
+
+		Dispatch(FPlatformTime::Seconds(), failedBatches);
+	}
+
+	CompleteFailedBatches(failedBatches);
+}
+
+void HttpRangeScheduler::CompleteFailedBatches(BatchList& failedBatches)
+{
+	for (auto& batch : failedBatches)
+	{
+		OnBatchComplete(batch, nullptr, false);
+	}
+	failedBatches.clear();
+}
+
+void HttpRangeScheduler::Dispatch(double now, BatchList& outFailedBatches)
+{
+	while (m_inFlight.size() < m_config.maxRequestsInFlight)
+	{
+		// Oldest range which is not waiting out a retry backoff
+		auto first = std::find_if(m_pending.begin(), m_pending.end(), [now](const ScheduledRange& range) {
+			return range.notBefore <= now;
+			});
+		if (first == m_pending.end())
+			break;
+
+		auto batch = std::make_shared<InFlightBatch>();
+		batch->rangeStart = first->request.offset;
+		batch->rangeEnd = first->request.offset + first->request.size;
+		batch->ranges.push_back(*first);
+		m_pending.erase(first);
+
+		// Grow the batch with ranges adjacent to either end
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (auto it = m_pending.begin(); it != m_pending.end(); ++it)
+			{
+				if (it->notBefore > now)
+					continue;
+
+				const uint64_t start = it->request.offset;
+				const uint64_t end = it->request.offset + it->request.size;
+				if (end - start + batch->rangeEnd - batch->rangeStart > m_config.maxCoalescedSize)
+					continue;
+
+				if (start == batch->rangeEnd)
+				{
+					batch->rangeEnd = end;
+				}
+				else if (end == batch->rangeStart)
+				{
+					batch->rangeStart = start;
+				}
+				else
+				{
+					continue;
+				}
+
+				batch->ranges.push_back(*it);
+				m_pending.erase(it);
+				merged = true;
+				break;
+			}
+		}
+
+		auto httpRequest = NewHttpRequest(batch->rangeStart, batch->rangeEnd - 1);
+		batch->httpRequest = httpRequest;
+
+		if (batch->ranges.size() > 1)
+		{
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("HTTP range %llu-%llu coalesced %d requests"), (unsigned long long)batch->rangeStart, (unsigned long long)batch->rangeEnd, (int)batch->ranges.size());
+		}
+
+		// Weak, so the lambda keeps neither the batch nor the scheduler alive. Tick() may have dropped the batch,
+		// or the owner the scheduler, by the time a late completion comes in, which then has nothing to do.
+		// Holding the scheduler while completing keeps it alive up to taking m_deliveryLock.
+		std::weak_ptr<HttpRangeScheduler> weakSelf = weak_from_this();
+		std::weak_ptr<InFlightBatch> weakBatch = batch;
+		httpRequest->OnProcessRequestComplete().BindLambda([weakSelf, weakBatch](auto httpReq, auto httpResp, bool succeeded) {
+			std::shared_ptr<HttpRangeScheduler> self = weakSelf.lock();
+			std::shared_ptr<InFlightBatch> batch = weakBatch.lock();
+			if (self && batch)
+			{
+				self->OnBatchComplete(batch, httpResp, succeeded);
+			}
+		});
+
+		// Connection was idle, start measuring from now
+		if (std::none_of(m_inFlight.begin(), m_inFlight.end(), [](const std::shared_ptr<InFlightBatch>& inFlight) { return !inFlight->finished; }))
+		{
+			m_throughputSampleStart = now;
+		}
+
+		m_inFlight.push_back(batch);
+		if (!httpRequest->ProcessRequest())
+		{
+			// Completing it here would call back into the reader under m_lock
+			outFailedBatches.push_back(batch);
+		}
+	}
+}
+
+void HttpRangeScheduler::RetryOrFail(ScheduledRange& range, double now, std::vector<Completion>& outCompletions)
+{
+	if (range.attempts < m_config.maxRetries)
+	{
+		range.notBefore = now + m_config.retryBackoffInSeconds * (double)(1u << range.attempts);
+		range.attempts++;
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("HTTP request id %d failed, retry %d in %.2fs"), range.request.request_id, range.attempts, range.notBefore - now);
+		m_pending.push_front(range);
+	}
+	else
+	{
+		outCompletions.push_back({ range.request, nullptr, 0, false });
+	}
+}
+
+void HttpRangeScheduler::OnBatchComplete(const std::shared_ptr<InFlightBatch>& batch, FHttpResponsePtr response, bool succeeded)
+{
+	std::lock_guard<std::recursive_mutex> deliveryGuard(m_deliveryLock);
+
+	std::vector<Completion> completions;
+	BatchList failedBatches;
+	FString etag;
+	uint64_t deliveredBytes = 0;
+	double busySeconds = 0;
+	ThroughputCallback throughputCallback;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_lock);
+		if (batch->finished)
+			return;
+		batch->finished = true;
+
+		const double now = FPlatformTime::Seconds();
+		const uint64_t batchSize = batch->rangeEnd - batch->rangeStart;
+
+		const uint8_t* content = nullptr;
+		uint64_t contentSize = 0;
+		if (succeeded && response.IsValid() && response->GetResponseCode() >= 200 && response->GetResponseCode() < 300)
+		{
+			content = response->GetContent().GetData();
+			contentSize = response->GetContent().Num();
+			etag = response->GetHeader(TEXT("ETag"));
+			if (etag.IsEmpty())
+			{
+				etag = response->GetHeader(TEXT("Last-Modified"));
+			}
+			// Server ignored Range header and sent the whole file
+			if (response->GetResponseCode() == 200 && contentSize > batchSize && contentSize >= batch->rangeEnd)
+			{
+				content += batch->rangeStart;
+				contentSize -= batch->rangeStart;
+			}
+		}
+
+		if (content)
+		{
+			deliveredBytes = std::min(contentSize, batchSize);
+			busySeconds = now - m_throughputSampleStart;
+			m_throughputSampleStart = now;
+			throughputCallback = m_throughputCallback;
+		}
+
+		for (auto& range : batch->ranges)
+		{
+			if (range.cancelled)
+				continue;
+
+			const uint64_t offsetInBatch = range.request.offset - batch->rangeStart;
+			if (content && offsetInBatch + range.request.size <= contentSize)
+			{
+				completions.push_back({ range.request, content + offsetInBatch, range.request.size, true });
+			}
+			else
+			{
+				RetryOrFail(range, now, completions);
+			}
+		}
+
+		// The slot is free now, send out what's pending rather than waiting for the next tick
+		m_inFlight.erase(
+			std::remove_if(m_inFlight.begin(), m_inFlight.end(), [&batch](const std::shared_ptr<InFlightBatch>& inFlight) {
+				return inFlight == batch;
+				}),
+			m_inFlight.end());
+		Dispatch(now, failedBatches);
+	}
+
+	if (throughputCallback)
+	{
+		throughputCallback(deliveredBytes, busySeconds);
+	}
+
+	// Deliver outside the lock, the response content stays alive till we return
+	if (m_completionCallback)
+	{
+		for (auto& completion : completions)
+		{
+			m_completionCallback(completion.request, completion.data, completion.size, etag, completion.succeeded);
+		}
+	}
+
+	CompleteFailedBatches(failedBatches);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+#include "ec_reading_compatibility.h"
+
+struct HttpRangeSchedulerConfig
+{
+	// How many HTTP requests can be outstanding at the same time
+	uint32_t maxRequestsInFlight = 4;
+	// Adjacent ranges get merged into one HTTP request up to this size
+	uint32_t maxCoalescedSize = 8 * 1024 * 1024;
+	// Retries per range after the first failed attempt
+	uint32_t maxRetries = 3;
+	// Delay before the first retry, doubled on every subsequent one
+	float retryBackoffInSeconds = 0.25f;
+	// 0 for no timeout
+	float timeoutInSeconds = 5.0f;
+};
+
+// Schedules GhostTree's read requests onto HTTP range requests. Pending requests are dispatched on Tick(), merging
+// adjacent ranges and keeping at most maxRequestsInFlight outstanding, and straight from the completion of a request
+// as a slot frees up. Cancelled requests are dropped from the queue or aborted in flight, and failed ones are retried
+// with exponential backoff before being reported failed.
+// Must be owned by a shared_ptr, in flight requests only hold a weak reference to it. A completion running on another
+// thread may hold the last reference for a moment, so owners call CancelAll() before letting go.
+class HttpRangeScheduler : public std::enable_shared_from_this<HttpRangeScheduler>
+{
+public:
+	// data/size are only valid during the callback. Not called for cancelled requests, nor once CancelAll() or the
+	// destructor returned, both wait for a delivery in progress on another thread.
+	// etag is the response's validator(ETag, or Last-Modified when there's no ETag), empty if the server gave none.
+	typedef std::function<void(const ReadRequest& request, const uint8_t* data, uint32_t size, const FString& etag, bool succeeded)> CompletionCallback;
+
+	// Delivered bytes over the time the connection was busy since the last sample, concurrent requests add up
+	typedef std::function<void(uint64_t bytes, double durationInSeconds)> ThroughputCallback;
+
+	HttpRangeScheduler(const FString& url, const HttpRangeSchedulerConfig& config, CompletionCallback completionCallback);
+	~HttpRangeScheduler();
+
+	void Enqueue(const ReadRequest& request);
+	// Return true if the request was pending or in flight
+	bool Cancel(uint32_t requestId);
+	void CancelAll();
+	void SetThroughputCallback(ThroughputCallback throughputCallback);
+	// Dispatch pending requests, expected to be called on game thread
+	void Tick();
+
+	uint32_t GetPendingCount() const;
+	uint32_t GetInFlightCount() const;
+private:
+	HttpRangeScheduler(const HttpRangeScheduler&) = delete;
+	HttpRangeScheduler& operator=(const HttpRangeScheduler&) = delete;
+
+	struct ScheduledRange
+	{
+		ReadRequest request;
+		uint32_t attempts = 0;
+		double notBefore = 0;
+		bool cancelled = false;
+	};
+
+	struct InFlightBatch
+	{
+		TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> httpRequest;
+		std::vector<ScheduledRange> ranges;
+		uint64_t rangeStart = 0;
+		uint64_t rangeEnd = 0; // exclusive
+		bool finished = false;
+	};
+
+	struct Completion
+	{
+		ReadRequest request;
+		const uint8_t* data;
+		uint32_t size;
+		bool succeeded;
+	};
+
+	typedef std::vector<std::shared_ptr<InFlightBatch>> BatchList;
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> NewHttpRequest(uint64_t rangeStart, uint64_t rangeEnd) const;
+	// Batches failing to start are returned in outFailedBatches, to be completed once m_lock is released
+	void Dispatch(double now, BatchList& outFailedBatches);
+	void CompleteFailedBatches(BatchList& failedBatches);
+	void OnBatchComplete(const std::shared_ptr<InFlightBatch>& batch, FHttpResponsePtr response, bool succeeded);
+	void RetryOrFail(ScheduledRange& range, double now, std::vector<Completion>& outCompletions);
+	static void UnbindAndCancel(InFlightBatch& batch);
+
+	FString m_url;
+	HttpRangeSchedulerConfig m_config;
+	CompletionCallback m_completionCallback;
+	ThroughputCallback m_throughputCallback;
+	// Start of the current throughput sample, either the last completion or when requests started going out
+	double m_throughputSampleStart;
+
+	std::deque<ScheduledRange> m_pending;
+	BatchList m_inFlight;
+	mutable std::recursive_mutex m_lock;
+	// Held while completions are delivered, never taken with m_lock held. Recursive since a completion callback
+	// may end up in CancelAll().
+	std::recursive_mutex m_deliveryLock;
+};
@@ -0,0 +1,658 @@
+#include "ReaderCache.h"
+#include "GhostTreeFormatReader.h"
+#include "HAL/FileManager.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// ReaderDiskCache
+//
+ReaderDiskCache::ReaderDiskCache(const FString& cacheFileFullpath, uint64_t capacityInBytes, uint32_t slabSize) :
+	m_cacheFileFullpath(cacheFileFullpath),
+	m_slabSize(slabSize > 0 ? slabSize : DEFAULT_SLAB_SIZE),
+	m_slabCount(0),
+	m_mappedSize(0),
+	m_mappedBase(nullptr),
+	m_occupiedBytes(0),
+	m_evictionCount(0),
+#if PLATFORM_WINDOWS
+	m_fileHandle(INVALID_HANDLE_VALUE),
+	m_mappingHandle(nullptr)
+#else
+	m_fileDescriptor(-1)
+#endif
+{
+	uint64_t slabCount = (capacityInBytes + m_slabSize - 1) / m_slabSize;
+	if (slabCount == 0)
+		slabCount = 1;
+	if (slabCount > (uint64_t)UINT32_MAX)
+		slabCount = UINT32_MAX;
+
+	m_slabCount = (uint32_t)slabCount;
+	m_mappedSize = (uint64_t)m_slabCount * m_slabSize;
+
+	if (MapCacheFile())
+	{
+		m_freeRuns[0] = m_slabCount;
+	}
+	else
+	{
+		UE_LOG(EvercoastReaderLog, Error, TEXT("Cannot map cache file '%s' with size %llu. Disk cache is unavailable."), *m_cacheFileFullpath, (unsigned long long)m_mappedSize);
+		m_slabCount = 0;
+		m_mappedSize = 0;
+	}
+}
+
+ReaderDiskCache::~ReaderDiskCache()
+{
+	Reset();
+	UnmapCacheFile();
+	IFileManager::Get().Delete(*m_cacheFileFullpath);
+}
+
+#if PLATFORM_WINDOWS
+bool ReaderDiskCache::MapCacheFile()
+{
+	HANDLE fileHandle = CreateFileW(*m_cacheFileFullpath, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// Creating the mapping larger than the file extends the file to the mapping size
+	HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READWRITE, (DWORD)(m_mappedSize >> 32), (DWORD)(m_mappedSize & 0xFFFFFFFF), nullptr);
+	if (!mappingHandle)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	void* base = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)m_mappedSize);
+	if (!base)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_fileHandle = fileHandle;
+	m_mappingHandle = mappingHandle;
+	m_mappedBase = (uint8_t*)base;
+	return true;
+}
+
+void ReaderDiskCache::UnmapCacheFile()
+{
+	if (m_mappedBase)
+	{
+		UnmapViewOfFile(m_mappedBase);
+		m_mappedBase = nullptr;
+	}
+	if (m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+		m_mappingHandle = nullptr;
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+}
+#else
+bool ReaderDiskCache::MapCacheFile()
+{
+	int fd = open(TCHAR_TO_UTF8(*m_cacheFileFullpath), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// Sparse file, disk blocks only get allocated once slabs are written
+	if (ftruncate(fd, (off_t)m_mappedSize) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* base = mmap(nullptr, (size_t)m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+
+	m_fileDescriptor = fd;
+	m_mappedBase = (uint8_t*)base;
+	return true;
+}
+
+void ReaderDiskCache::UnmapCacheFile()
+{
+	if (m_mappedBase)
+	{
+		munmap(m_mappedBase, (size_t)m_mappedSize);
+		m_mappedBase = nullptr;
+	}
+	if (m_fileDescriptor >= 0)
+	{
+		close(m_fileDescriptor);
+		m_fileDescriptor = -1;
+	}
+}
+#endif
+
+void ReaderDiskCache::Reset()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	m_entries.clear();
+	m_lru.clear();
+	m_freeRuns.clear();
+	m_occupiedBytes = 0;
+	if (m_slabCount > 0)
+	{
+		m_freeRuns[0] = m_slabCount;
+	}
+}
+
+uint32_t ReaderDiskCache::GetFreeSlabCount() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	uint32_t count = 0;
+	for (const auto& run : m_freeRuns)
+	{
+		count += run.second;
+	}
+	return count;
+}
+
+int64_t ReaderDiskCache::AllocateSlabs(uint32_t slabCount)
+{
+	// First fit, the free list is kept coalesced so it stays short
+	for (auto it = m_freeRuns.begin(); it != m_freeRuns.end(); ++it)
+	{
+		if (it->second >= slabCount)
+		{
+			uint32_t firstSlab = it->first;
+			uint32_t remaining = it->second - slabCount;
+			m_freeRuns.erase(it);
+			if (remaining > 0)
+			{
+				m_freeRuns[firstSlab + slabCount] = remaining;
+			}
+			return firstSlab;
+		}
+	}
+	return -1;
+}
+
+void ReaderDiskCache::FreeSlabs(uint32_t firstSlab, uint32_t slabCount)
+{
+	auto inserted = m_freeRuns.emplace(firstSlab, slabCount).first;
+
+	// merge with the following run
+	auto next = std::next(inserted);
+	if (next != m_freeRuns.end() && inserted->first + inserted->second == next->first)
+	{
+		inserted->second += next->second;
+		m_freeRuns.erase(next);
+	}
+
+	// merge with the previous run
+	if (inserted != m_freeRuns.begin())
+	{
+		auto prev = std::prev(inserted);
+		if (prev->first + prev->second == inserted->first)
+		{
+			prev->second += inserted->second;
+			m_freeRuns.erase(inserted);
+		}
+	}
+}
+
+bool ReaderDiskCache::EvictLeastRecentlyUsed()
+{
+	// Pinned entries are being written or read through a pointer, skip them
+	for (auto it = m_lru.rbegin(); it != m_lru.rend(); ++it)
+	{
+		uint32_t victim = *it;
+		if (m_entries.at(victim).pinCount == 0)
+		{
+			UE_LOG(EvercoastReaderLog, Verbose, TEXT("Disk cache full, evicting cache id: %d"), victim);
+			Remove(victim);
+			m_evictionCount++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ReaderDiskCache::Touch(uint32_t cache_id)
+{
+	auto it = m_entries.find(cache_id);
+	if (it != m_entries.end())
+	{
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+	}
+}
+
+bool ReaderDiskCache::CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	bool isNewEntry = false;
+	uint8_t* storage = Reserve(cache_id, size, &isNewEntry);
+	if (!storage)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(storage, data, size);
+	Unpin(cache_id);
+	return isNewEntry;
+}
+
+uint8_t* ReaderDiskCache::Reserve(uint32_t cache_id, uint32_t size, bool* outIsNewEntry)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	if (outIsNewEntry)
+		*outIsNewEntry = false;
+
+	if (!m_mappedBase)
+	{
+		return nullptr;
+	}
+
+	uint32_t slabCount = SlabCountForSize(size);
+	if (slabCount == 0)
+		slabCount = 1;
+	if (slabCount > m_slabCount)
+	{
+		UE_LOG(EvercoastReaderLog, Error, TEXT("Cache id %d of size %u exceeds the disk cache capacity %llu"), cache_id, size, (unsigned long long)m_mappedSize);
+		return nullptr;
+	}
+
+	auto existing = m_entries.find(cache_id);
+	if (existing != m_entries.end())
+	{
+		// existing entry, update the cache in place if it still fits
+		DiskCacheRecord& record = existing->second;
+		if (slabCount <= record.slabCount)
+		{
+			if (slabCount < record.slabCount)
+			{
+				FreeSlabs(record.firstSlab + slabCount, record.slabCount - slabCount);
+				record.slabCount = slabCount;
+			}
+			m_occupiedBytes += size;
+			m_occupiedBytes -= record.size;
+			record.size = size;
+			record.pinCount++;
+			Touch(cache_id);
+			return m_mappedBase + (uint64_t)record.firstSlab * m_slabSize;
+		}
+
+		// Pins are held by whoever is still using the entry, they carry over to the moved one
+		uint32_t pinCount = record.pinCount;
+		Remove(cache_id);
+		uint8_t* storage = Reserve(cache_id, size, nullptr);
+		if (storage)
+		{
+			m_entries.at(cache_id).pinCount += pinCount;
+		}
+		return storage;
+	}
+
+	int64_t firstSlab = AllocateSlabs(slabCount);
+	while (firstSlab < 0)
+	{
+		if (!EvictLeastRecentlyUsed())
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Disk cache is full of pinned entries, unable to allocate %u slabs for cache id %d. Free slabs: %u"), slabCount, cache_id, GetFreeSlabCount());
+			return nullptr;
+		}
+		firstSlab = AllocateSlabs(slabCount);
+	}
+
+	m_lru.push_front(cache_id);
+	m_occupiedBytes += size;
+
+	DiskCacheRecord record;
+	record.firstSlab = (uint32_t)firstSlab;
+	record.slabCount = slabCount;
+	record.size = size;
+	record.pinCount = 1;
+	record.lruIt = m_lru.begin();
+	m_entries.insert(std::make_pair(cache_id, record));
+
+	if (outIsNewEntry)
+		*outIsNewEntry = true;
+	return m_mappedBase + (uint64_t)firstSlab * m_slabSize;
+}
+
+bool ReaderDiskCache::Remove(uint32_t cache_id)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	auto it = m_entries.find(cache_id);
+	if (it != m_entries.end())
+	{
+		FreeSlabs(it->second.firstSlab, it->second.slabCount);
+		m_lru.erase(it->second.lruIt);
+		m_occupiedBytes -= it->second.size;
+		m_entries.erase(it);
+		return true;
+	}
+
+	return false;
+}
+
+const uint8_t* ReaderDiskCache::Get(uint32_t cache_id)
+{
+	return GetRange(cache_id, 0, 0);
+}
+
+const uint8_t* ReaderDiskCache::GetRange(uint32_t cache_id, uint32_t offset, uint32_t size)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	auto it = m_entries.find(cache_id);
+	if (it != m_entries.end())
+	{
+		const DiskCacheRecord& record = it->second;
+		if ((uint64_t)offset + size > record.size)
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Range %u+%u is out of cache id %d of size %u"), offset, size, cache_id, record.size);
+			return nullptr;
+		}
+
+		Touch(cache_id);
+		return m_mappedBase + (uint64_t)record.firstSlab * m_slabSize + offset;
+	}
+
+	return nullptr;
+}
+
+bool ReaderDiskCache::Pin(uint32_t cache_id)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	auto it = m_entries.find(cache_id);
+	if (it != m_entries.end())
+	{
+		it->second.pinCount++;
+		return true;
+	}
+
+	return false;
+}
+
+void ReaderDiskCache::Unpin(uint32_t cache_id)
+{
+	std::lock_guard<std::recursive_mutex> guard(m_lock);
+	auto it = m_entries.find(cache_id);
+	if (it != m_entries.end() && it->second.pinCount > 0)
+	{
+		it->second.pinCount--;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// ReaderMemoryCache
+ReaderMemoryCache::ReaderMemoryCache(uint64_t capacityInBytes) :
+	m_capacityInBytes(capacityInBytes),
+	m_occupiedBytes(0),
+	m_slackBytes(0),
+	m_retainedBytes(0)
+{
+}
+
+
+ReaderMemoryCache::~ReaderMemoryCache()
+{
+	Reset();
+	TrimRetained(UINT64_MAX);
+}
+
+int32_t ReaderMemoryCache::SizeClassForSize(uint32_t size)
+{
+	uint32_t shift = MIN_SIZE_CLASS_SHIFT;
+	while (shift <= MAX_SIZE_CLASS_SHIFT && (1ull << shift) < size)
+	{
+		++shift;
+	}
+
+	if (shift > MAX_SIZE_CLASS_SHIFT)
+		return -1;
+
+	return (int32_t)(shift - MIN_SIZE_CLASS_SHIFT);
+}
+
+bool ReaderMemoryCache::AllocateBlock(uint32_t size, MemoryCacheBlock& outBlock)
+{
+	int32_t sizeClass = SizeClassForSize(size);
+	uint64_t capacity = sizeClass >= 0 ? CapacityOfSizeClass(sizeClass) : size;
+
+	// Reserve the bytes first, so concurrent adds can't overshoot the capacity together
+	uint64_t occupied = m_occupiedBytes.fetch_add(size) + size;
+	if (occupied > m_capacityInBytes)
+	{
+		m_occupiedBytes.fetch_sub(size);
+		return false;
+	}
+
+	uint8_t* data = nullptr;
+	if (sizeClass >= 0)
+	{
+		SizeClassFreeList& freeList = m_freeLists[sizeClass];
+		std::lock_guard<std::mutex> guard(freeList.lock);
+		if (!freeList.blocks.empty())
+		{
+			data = freeList.blocks.back();
+			freeList.blocks.pop_back();
+			m_retainedBytes.fetch_sub(capacity);
+		}
+	}
+
+	if (!data)
+	{
+		// Retained blocks count towards the capacity too, make room in them before going to the heap.
+		// Slack doesn't, it's bounded by the live entries themselves
+		uint64_t retained = m_retainedBytes.load();
+		if (occupied + retained > m_capacityInBytes)
+		{
+			TrimRetained(occupied + retained - m_capacityInBytes);
+		}
+
+		data = (uint8_t*)FMemory::Malloc(capacity);
+		if (!data)
+		{
+			m_occupiedBytes.fetch_sub(size);
+			return false;
+		}
+	}
+
+	m_slackBytes.fetch_add(capacity - size);
+
+	outBlock.data = data;
+	outBlock.size = size;
+	outBlock.capacity = capacity;
+	outBlock.sizeClass = sizeClass;
+	return true;
+}
+
+void ReaderMemoryCache::ReleaseBlock(MemoryCacheBlock& block)
+{
+	if (!block.data)
+		return;
+
+	if (block.sizeClass >= 0)
+	{
+		SizeClassFreeList& freeList = m_freeLists[block.sizeClass];
+		std::lock_guard<std::mutex> guard(freeList.lock);
+		freeList.blocks.push_back(block.data);
+		m_retainedBytes.fetch_add(block.capacity);
+	}
+	else
+	{
+		FMemory::Free(block.data);
+	}
+
+	m_occupiedBytes.fetch_sub(block.size);
+	m_slackBytes.fetch_sub(block.capacity - block.size);
+	block = MemoryCacheBlock();
+}
+
+void ReaderMemoryCache::TrimRetained(uint64_t bytesNeeded)
+{
+	uint64_t released = 0;
+	// Largest blocks first, fewer frees for the same amount of memory
+	for (int32_t sizeClass = SIZE_CLASS_COUNT - 1; sizeClass >= 0 && released < bytesNeeded; --sizeClass)
+	{
+		SizeClassFreeList& freeList = m_freeLists[sizeClass];
+		std::lock_guard<std::mutex> guard(freeList.lock);
+		while (!freeList.blocks.empty() && released < bytesNeeded)
+		{
+			FMemory::Free(freeList.blocks.back());
+			freeList.blocks.pop_back();
+
+			uint64_t capacity = CapacityOfSizeClass(sizeClass);
+			m_retainedBytes.fetch_sub(capacity);
+			released += capacity;
+		}
+	}
+}
+
+void ReaderMemoryCache::Reset()
+{
+	for (Shard& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		for (auto& entry : shard.entries)
+		{
+			ReleaseBlock(entry.second);
+		}
+		shard.entries.clear();
+	}
+}
+
+bool ReaderMemoryCache::CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size)
+{
+	bool isNewEntry = false;
+	uint8_t* storage = Reserve(cache_id, size, &isNewEntry);
+	if (!storage)
+	{
+		return false;
+	}
+
+	memcpy(storage, data, size);
+	return isNewEntry;
+}
+
+uint8_t* ReaderMemoryCache::Reserve(uint32_t cache_id, uint32_t size, bool* outIsNewEntry)
+{
+	if (outIsNewEntry)
+		*outIsNewEntry = false;
+
+	Shard& shard = ShardFor(cache_id);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	bool isNewEntry = true;
+	auto find_it = shard.entries.find(cache_id);
+	if (find_it != shard.entries.end())
+	{
+		isNewEntry = false;
+		// existing entry, reuse its block if big enough
+		MemoryCacheBlock& block = find_it->second;
+		if (size <= block.capacity)
+		{
+			if (size > block.size)
+			{
+				uint64_t growth = size - block.size;
+				if (m_occupiedBytes.fetch_add(growth) + growth > m_capacityInBytes)
+				{
+					m_occupiedBytes.fetch_sub(growth);
+					UE_LOG(EvercoastReaderLog, Error, TEXT("Memory cache is full (%llu of %llu bytes). Unable to grow cache id %d to size %u"),
+						(unsigned long long)GetOccupancyInBytes(), (unsigned long long)m_capacityInBytes, cache_id, size);
+					return nullptr;
+				}
+				m_slackBytes.fetch_sub(growth);
+			}
+			else
+			{
+				uint64_t shrink = block.size - size;
+				m_occupiedBytes.fetch_sub(shrink);
+				m_slackBytes.fetch_add(shrink);
+			}
+			block.size = size;
+			return block.data;
+		}
+
+		ReleaseBlock(block);
+		shard.entries.erase(find_it);
+	}
+
+	MemoryCacheBlock block;
+	if (!AllocateBlock(size, block))
+	{
+		UE_LOG(EvercoastReaderLog, Error, TEXT("Memory cache is full (%llu of %llu bytes). Unable to add cache id %d of size %u"),
+			(unsigned long long)GetOccupancyInBytes(), (unsigned long long)m_capacityInBytes, cache_id, size);
+		return nullptr;
+	}
+
+	shard.entries.insert(std::make_pair(cache_id, block));
+	if (outIsNewEntry)
+		*outIsNewEntry = isNewEntry;
+	return block.data;
+}
+
+bool ReaderMemoryCache::Remove(uint32_t cache_id)
+{
+	Shard& shard = ShardFor(cache_id);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	auto it = shard.entries.find(cache_id);
+	if (it != shard.entries.end())
+	{
+		ReleaseBlock(it->second);
+		shard.entries.erase(it);
+		return true;
+	}
+
+	return false;
+}
+
+bool ReaderMemoryCache::Pin(uint32_t cache_id)
+{
+	Shard& shard = ShardFor(cache_id);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	return shard.entries.find(cache_id) != shard.entries.end();
+}
+
+const uint8_t* ReaderMemoryCache::Get(uint32_t cache_id)
+{
+	return GetRange(cache_id, 0, 0);
+}
+
+const uint8_t* ReaderMemoryCache::GetRange(uint32_t cache_id, uint32_t offset, uint32_t size)
+{
+	Shard& shard = ShardFor(cache_id);
+	std::lock_guard<std::mutex> guard(shard.lock);
+	auto it = shard.entries.find(cache_id);
+	if (it != shard.entries.end())
+	{
+		const MemoryCacheBlock& block = it->second;
+		if ((uint64_t)offset + size > block.size)
+		{
+			UE_LOG(EvercoastReaderLog, Error, TEXT("Range %u+%u is out of cache id %d of size %u"), offset, size, cache_id, block.size);
+			return nullptr;
+		}
+		return block.data + offset;
+	}
+
+	return nullptr;
+}
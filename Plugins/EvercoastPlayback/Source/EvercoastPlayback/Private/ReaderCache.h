@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include "CoreMinimal.h"
+
+// The cache GhostTree reader uses to hold downloaded/read data, indexed by GhostTree's cache_id
+class IReaderCache
+{
+public:
+	virtual ~IReaderCache() {}
+	virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) = 0;
+	// Create or resize the entry and return its storage for the caller to fill in directly, nullptr on failure.
+	// The content is undefined until the caller finishes writing it. The entry comes back pinned, Unpin() it once
+	// written.
+	virtual uint8_t* Reserve(uint32_t cache_id, uint32_t size, bool* outIsNewEntry = nullptr) = 0;
+	virtual bool Remove(uint32_t cache_id) = 0;
+	virtual const uint8_t* Get(uint32_t cache_id) = 0;
+	virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) = 0;
+	// Pinned entries are never evicted, pin around reading through a pointer from Get()/GetRange(). Pins nest.
+	// Returns false when there's no such entry.
+	virtual bool Pin(uint32_t cache_id) = 0;
+	virtual void Unpin(uint32_t cache_id) = 0;
+	virtual void Reset() = 0;
+	// Bytes requested by the live entries, not counting what the storage rounds them up to
+	virtual uint64_t GetOccupancyInBytes() const = 0;
+};
+
+// A disk cache backed by a memory mapped file. The file is carved into fixed-size slabs, each entry takes a
+// contiguous run of slabs so Get()/GetRange() can return a pointer straight into the mapping without copying.
+// Removed entries give their slabs back to the free list, and when there's no room the least recently used
+// unpinned entries get evicted, so the file never grows beyond the capacity given on construction.
+class ReaderDiskCache : public IReaderCache
+{
+public:
+	static constexpr uint32_t DEFAULT_SLAB_SIZE = 256 * 1024;
+
+	ReaderDiskCache(const FString& cacheFileFullpath, uint64_t capacityInBytes, uint32_t slabSize = DEFAULT_SLAB_SIZE);
+	virtual ~ReaderDiskCache();
+	// Allocate and copy data on the fly. Return true for new cache entry, false for existing entry updated or allocation failure
+	virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) override;
+	virtual uint8_t* Reserve(uint32_t cache_id, uint32_t size, bool* outIsNewEntry = nullptr) override;
+	virtual bool Remove(uint32_t cache_id) override;
+	// Returned pointers point into the mapping, valid until the entry gets removed or, unless pinned, evicted
+	virtual const uint8_t* Get(uint32_t cache_id) override;
+	virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) override;
+	virtual bool Pin(uint32_t cache_id) override;
+	virtual void Unpin(uint32_t cache_id) override;
+
+	virtual void Reset() override;
+	virtual uint64_t GetOccupancyInBytes() const override
+	{
+		return m_occupiedBytes.load(std::memory_order_relaxed);
+	}
+
+	uint32_t GetSlabSize() const
+	{
+		return m_slabSize;
+	}
+
+	uint32_t GetSlabCount() const
+	{
+		return m_slabCount;
+	}
+
+	uint32_t GetFreeSlabCount() const;
+	bool IsMapped() const
+	{
+		return m_mappedBase != nullptr;
+	}
+
+	uint64_t GetEvictionCount() const
+	{
+		return m_evictionCount.load(std::memory_order_relaxed);
+	}
+private:
+	ReaderDiskCache(const ReaderDiskCache&) = delete;
+	ReaderDiskCache& operator=(const ReaderDiskCache&) = delete;
+
+	bool MapCacheFile();
+	void UnmapCacheFile();
+
+	// Returns the first slab index of a free run of slabCount slabs, or -1
+	int64_t AllocateSlabs(uint32_t slabCount);
+	void FreeSlabs(uint32_t firstSlab, uint32_t slabCount);
+	bool EvictLeastRecentlyUsed();
+	void Touch(uint32_t cache_id);
+	uint32_t SlabCountForSize(uint32_t size) const
+	{
+		return (size + m_slabSize - 1) / m_slabSize;
+	}
+
+	struct DiskCacheRecord
+	{
+		uint32_t firstSlab = 0;
+		uint32_t slabCount = 0;
+		uint32_t size = 0;
+		uint32_t pinCount = 0;
+		std::list<uint32_t>::iterator lruIt;
+	};
+
+	std::map<uint32_t, DiskCacheRecord> m_entries;
+	// Most recently used at the front
+	std::list<uint32_t> m_lru;
+	// Free runs of slabs: first slab -> slab count. Adjacent runs are always coalesced.
+	std::map<uint32_t, uint32_t> m_freeRuns;
+
+	FString m_cacheFileFullpath;
+	uint32_t m_slabSize;
+	uint32_t m_slabCount;
+	uint64_t m_mappedSize;
+	uint8_t* m_mappedBase;
+	std::atomic<uint64_t> m_occupiedBytes;
+	std::atomic<uint64_t> m_evictionCount;
+#if PLATFORM_WINDOWS
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+	mutable std::recursive_mutex m_lock;
+};
+
+// Memory only cache, to reduce IO pressure.
+// Entry storage comes from a size-classed arena: blocks are power-of-two sized and recycled through per-class
+// free lists instead of going back to the heap. Entries are sharded by cache_id, each shard with its own lock,
+// so HTTP completion callbacks adding entries don't serialise against game thread range reads and removes.
+// Only the requested bytes count against the capacity, which matches GhostTree's own budget. The rounding up to
+// the size class is tracked separately as slack, so the heap footprint is the capacity plus the slack.
+class ReaderMemoryCache : public IReaderCache
+{
+public:
+	static constexpr uint32_t MIN_SIZE_CLASS_SHIFT = 12;	// 4KB
+	static constexpr uint32_t MAX_SIZE_CLASS_SHIFT = 26;	// 64MB, larger entries are allocated individually
+	static constexpr uint32_t SIZE_CLASS_COUNT = MAX_SIZE_CLASS_SHIFT - MIN_SIZE_CLASS_SHIFT + 1;
+	static constexpr uint32_t SHARD_COUNT = 16;
+
+	explicit ReaderMemoryCache(uint64_t capacityInBytes);
+	virtual ~ReaderMemoryCache();
+	// Allocate and copy data on the fly. Return true for new cache entry, false for existing entry updated or exceeding capacity
+	virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) override;
+	virtual uint8_t* Reserve(uint32_t cache_id, uint32_t size, bool* outIsNewEntry = nullptr) override;
+	virtual bool Remove(uint32_t cache_id) override;
+	virtual const uint8_t* Get(uint32_t cache_id) override;
+	virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) override;
+	// Nothing is ever evicted, entries only go on Remove() and adds over the capacity are refused
+	virtual bool Pin(uint32_t cache_id) override;
+	virtual void Unpin(uint32_t cache_id) override
+	{
+	}
+	virtual uint64_t GetOccupancyInBytes() const override
+	{
+		return m_occupiedBytes.load(std::memory_order_relaxed);
+	}
+
+	virtual void Reset() override;
+
+	// Bytes held in the free lists, ready to be reused
+	uint64_t GetRetainedBytes() const
+	{
+		return m_retainedBytes.load(std::memory_order_relaxed);
+	}
+
+	// Bytes the live entries' blocks hold beyond what was requested
+	uint64_t GetSlackBytes() const
+	{
+		return m_slackBytes.load(std::memory_order_relaxed);
+	}
+private:
+	ReaderMemoryCache(const ReaderMemoryCache&) = delete;
+	ReaderMemoryCache& operator=(const ReaderMemoryCache&) = delete;
+
+	struct MemoryCacheBlock
+	{
+		uint8_t* data = nullptr;
+		uint32_t size = 0;
+		uint64_t capacity = 0;
+		int32_t sizeClass = -1; // -1 for oversized blocks which are not pooled
+	};
+
+	struct Shard
+	{
+		std::unordered_map<uint32_t, MemoryCacheBlock> entries;
+		std::mutex lock;
+	};
+
+	struct SizeClassFreeList
+	{
+		std::vector<uint8_t*> blocks;
+		std::mutex lock;
+	};
+
+	static int32_t SizeClassForSize(uint32_t size);
+	static uint64_t CapacityOfSizeClass(int32_t sizeClass)
+	{
+		return 1ull << (sizeClass + MIN_SIZE_CLASS_SHIFT);
+	}
+
+	Shard& ShardFor(uint32_t cache_id)
+	{
+		return m_shards[cache_id % SHARD_COUNT];
+	}
+
+	bool AllocateBlock(uint32_t size, MemoryCacheBlock& outBlock);
+	void ReleaseBlock(MemoryCacheBlock& block);
+	// Give retained free blocks back to the heap until at least bytesNeeded is released or free lists are empty
+	void TrimRetained(uint64_t bytesNeeded);
+
+	Shard m_shards[SHARD_COUNT];
+	SizeClassFreeList m_freeLists[SIZE_CLASS_COUNT];
+
+	uint64_t m_capacityInBytes;
+	std::atomic<uint64_t> m_occupiedBytes;
+	std::atomic<uint64_t> m_slackBytes;
+	std::atomic<uint64_t> m_retainedBytes;
+};
@@ -0,0 +1,717 @@
+#include "ReaderPersistentCache.h"
+#include "GhostTreeFormatReader.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Hash/CityHash.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include <algorithm>
+#include <vector>
+
+static constexpr uint32 PERSISTENT_CACHE_INDEX_MAGIC = 0x43504345; // "ECPC"
+static constexpr uint32 PERSISTENT_CACHE_INDEX_VERSION = 2;
+static const TCHAR* PERSISTENT_CACHE_DIRNAME = TEXT("EC_PersistentCache");
+static const TCHAR* PERSISTENT_CACHE_INDEX_FILENAME = TEXT("index.dat");
+static const TCHAR* PERSISTENT_CACHE_ENTRY_EXTENSION = TEXT(".bin");
+
+static std::unique_ptr<ReaderPersistentCache> s_persistentCache;
+static std::mutex s_persistentCacheLock;
+
+ReaderPersistentCache& ReaderPersistentCache::Get()
+{
+	std::lock_guard<std::mutex> guard(s_persistentCacheLock);
+	if (!s_persistentCache)
+	{
+		FString cacheDir = FPaths::Combine(FGenericPlatformMisc::GamePersistentDownloadDir(), PERSISTENT_CACHE_DIRNAME);
+		s_persistentCache.reset(new ReaderPersistentCache(cacheDir));
+	}
+	return *s_persistentCache;
+}
+
+void ReaderPersistentCache::ShutdownIfLoaded()
+{
+	std::lock_guard<std::mutex> guard(s_persistentCacheLock);
+	s_persistentCache.reset();
+}
+
+std::unique_ptr<ReaderPersistentCache> ReaderPersistentCache::CreateStandalone(const FString& cacheDir)
+{
+	return std::unique_ptr<ReaderPersistentCache>(new ReaderPersistentCache(cacheDir));
+}
+
+ReaderPersistentCache::ReaderPersistentCache(const FString& cacheDir) :
+	m_cacheDir(cacheDir),
+	m_capacityInBytes(DEFAULT_CAPACITY),
+	m_occupiedBytes(0),
+	m_nextGeneration(0),
+	m_indexDirty(false),
+	m_runningOwner(nullptr),
+	m_runningRequestId(0),
+	m_busy(false),
+	m_running(true),
+	m_thread(nullptr)
+{
+	// First thing on the IO thread, lookups just miss till it's loaded
+	IOJob job;
+	job.work = [this]()
+	{
+		IFileManager::Get().MakeDirectory(*m_cacheDir, true);
+		LoadIndex();
+	};
+	Enqueue(std::move(job));
+
+	m_thread = FRunnableThread::Create(this, TEXT("EvercoastPersistentCacheIO"), 0, TPri_BelowNormal);
+}
+
+ReaderPersistentCache::~ReaderPersistentCache()
+{
+	Flush();
+
+	if (m_thread)
+	{
+		// Queued IO is finished before the thread exits
+		m_thread->Kill(true);
+		delete m_thread;
+		m_thread = nullptr;
+	}
+}
+
+uint32 ReaderPersistentCache::Run()
+{
+	while (true)
+	{
+		IOJob job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueLock);
+			m_queueCondition.wait(lock, [this]() { return !m_jobs.empty() || !m_running; });
+			if (m_jobs.empty())
+				break;
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_busy = true;
+			m_runningOwner = job.owner;
+			m_runningRequestId = job.requestId;
+		}
+
+		job.work();
+
+		{
+			std::lock_guard<std::mutex> guard(m_queueLock);
+			m_busy = false;
+			m_runningOwner = nullptr;
+			m_runningRequestId = 0;
+		}
+		m_queueCondition.notify_all();
+	}
+
+	return 0;
+}
+
+void ReaderPersistentCache::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_queueLock);
+		m_running = false;
+	}
+	m_queueCondition.notify_all();
+}
+
+void ReaderPersistentCache::Enqueue(IOJob&& job)
+{
+	{
+		std::lock_guard<std::mutex> guard(m_queueLock);
+		m_jobs.push_back(std::move(job));
+	}
+	m_queueCondition.notify_all();
+}
+
+void ReaderPersistentCache::WaitForIdle()
+{
+	std::unique_lock<std::mutex> lock(m_queueLock);
+	m_queueCondition.wait(lock, [this]() { return m_jobs.empty() && !m_busy; });
+}
+
+uint64_t ReaderPersistentCache::HashUrl(const FString& url)
+{
+	FTCHARToUTF8 utf8(*url);
+	return CityHash64(utf8.Get(), utf8.Length());
+}
+
+uint64_t ReaderPersistentCache::MakeKey(uint64_t urlHash, const FString& etag, uint64_t chunkIndex)
+{
+	FTCHARToUTF8 utf8(*FString::Printf(TEXT("%s|%llu"), *etag, (unsigned long long)chunkIndex));
+	return CityHash64WithSeed(utf8.Get(), utf8.Length(), urlHash);
+}
+
+FString ReaderPersistentCache::ChunkFilename(uint64_t key) const
+{
+	return FPaths::Combine(m_cacheDir, FString::Printf(TEXT("%016llx%s"), (unsigned long long)key, PERSISTENT_CACHE_ENTRY_EXTENSION));
+}
+
+FString ReaderPersistentCache::IndexFilename() const
+{
+	return FPaths::Combine(m_cacheDir, PERSISTENT_CACHE_INDEX_FILENAME);
+}
+
+uint64_t ReaderPersistentCache::KeyForLocked(const FString& url, uint64_t chunkIndex) const
+{
+	const uint64_t urlHash = HashUrl(url);
+	auto etagIt = m_etags.find(urlHash);
+	return MakeKey(urlHash, etagIt != m_etags.end() ? etagIt->second : FString(), chunkIndex);
+}
+
+const ReaderPersistentCache::RangeRecord* ReaderPersistentCache::FindRangeLocked(const ChunkRecord& chunk, uint32_t offsetInChunk, uint32_t size, uint32_t& outRangeOffset) const
+{
+	// Any written range covering the requested one, they're few per chunk
+	auto it = chunk.ranges.upper_bound(offsetInChunk);
+	while (it != chunk.ranges.begin())
+	{
+		--it;
+		if (it->second.written && (uint64_t)it->first + it->second.size >= (uint64_t)offsetInChunk + size)
+		{
+			outRangeOffset = it->first;
+			return &it->second;
+		}
+	}
+	return nullptr;
+}
+
+void ReaderPersistentCache::SetCapacity(uint64_t capacityInBytes)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_capacityInBytes = capacityInBytes;
+	EvictLocked(0);
+}
+
+bool ReaderPersistentCache::Contains(const FString& url, uint64_t offset, uint32_t size)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	const uint64_t chunkIndex = offset / CHUNK_SIZE;
+	auto it = m_chunks.find(KeyForLocked(url, chunkIndex));
+	if (it == m_chunks.end() || it->second.chunkIndex != chunkIndex)
+		return false;
+
+	uint32_t rangeOffset = 0;
+	return FindRangeLocked(it->second, (uint32_t)(offset - chunkIndex * CHUNK_SIZE), size, rangeOffset) != nullptr;
+}
+
+void ReaderPersistentCache::LookupAsync(const void* owner, uint32_t requestId, const FString& url, uint64_t offset, uint32_t size, uint8_t* destination, LookupCallback callback)
+{
+	IOJob job;
+	job.owner = owner;
+	job.requestId = requestId;
+	job.work = [this, url, offset, size, destination, callback]()
+	{
+		callback(ReadRange(url, offset, size, destination) ? LookupResult::Hit : LookupResult::Miss);
+	};
+	job.cancel = [callback]()
+	{
+		callback(LookupResult::Cancelled);
+	};
+	Enqueue(std::move(job));
+}
+
+bool ReaderPersistentCache::CancelLookup(const void* owner, uint32_t requestId)
+{
+	IOJob cancelled;
+	{
+		std::unique_lock<std::mutex> lock(m_queueLock);
+		auto it = std::find_if(m_jobs.begin(), m_jobs.end(), [owner, requestId](const IOJob& job) {
+			return job.owner == owner && job.requestId == requestId;
+			});
+		if (it == m_jobs.end())
+		{
+			// Running, it may be writing into the caller's buffer
+			m_queueCondition.wait(lock, [this, owner, requestId]() {
+				return !(m_busy && m_runningOwner == owner && m_runningRequestId == requestId);
+				});
+			return false;
+		}
+
+		cancelled = std::move(*it);
+		m_jobs.erase(it);
+	}
+
+	cancelled.cancel();
+	return true;
+}
+
+void ReaderPersistentCache::CancelLookups(const void* owner)
+{
+	std::vector<IOJob> cancelled;
+	{
+		std::unique_lock<std::mutex> lock(m_queueLock);
+		for (auto it = m_jobs.begin(); it != m_jobs.end();)
+		{
+			if (it->owner == owner)
+			{
+				cancelled.push_back(std::move(*it));
+				it = m_jobs.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		m_queueCondition.wait(lock, [this, owner]() {
+			return !(m_busy && m_runningOwner == owner);
+			});
+	}
+
+	for (IOJob& job : cancelled)
+	{
+		job.cancel();
+	}
+}
+
+bool ReaderPersistentCache::ReadRange(const FString& url, uint64_t offset, uint32_t size, uint8_t* destination)
+{
+	const uint64_t chunkIndex = offset / CHUNK_SIZE;
+	const uint32_t offsetInChunk = (uint32_t)(offset - chunkIndex * CHUNK_SIZE);
+	uint64_t key = 0;
+	uint64_t generation = 0;
+	uint32_t rangeOffset = 0;
+	RangeRecord range;
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		key = KeyForLocked(url, chunkIndex);
+		auto it = m_chunks.find(key);
+		if (it == m_chunks.end() || it->second.chunkIndex != chunkIndex)
+			return false;
+
+		const RangeRecord* found = FindRangeLocked(it->second, offsetInChunk, size, rangeOffset);
+		if (!found)
+			return false;
+
+		generation = it->second.generation;
+		range = *found;
+	}
+
+	// The whole stored range is read to check its CRC, straight into destination when that's all of it
+	bool valid = false;
+	std::unique_ptr<IFileHandle> file(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*ChunkFilename(key)));
+	if (file && file->Seek(rangeOffset))
+	{
+		if (rangeOffset == offsetInChunk && range.size == size)
+		{
+			valid = file->Read(destination, size) && FCrc::MemCrc32(destination, size) == range.crc;
+		}
+		else
+		{
+			std::vector<uint8_t> buffer(range.size);
+			valid = file->Read(buffer.data(), range.size) && FCrc::MemCrc32(buffer.data(), range.size) == range.crc;
+			if (valid)
+			{
+				FMemory::Memcpy(destination, buffer.data() + (offsetInChunk - rangeOffset), size);
+			}
+		}
+	}
+	file.reset();
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (!valid)
+	{
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("Persistent cache range %u+%u of chunk %016llx is corrupted or missing, dropped."), rangeOffset, range.size, (unsigned long long)key);
+		RemoveRangeLocked(key, generation, rangeOffset);
+		return false;
+	}
+
+	auto it = m_chunks.find(key);
+	if (it != m_chunks.end() && it->second.generation == generation)
+	{
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lruIt);
+		m_indexDirty = true;
+	}
+	return true;
+}
+
+bool ReaderPersistentCache::Store(const FString& url, const FString& etag, uint64_t offset, uint32_t size, const uint8_t* data)
+{
+	const uint64_t chunkIndex = offset / CHUNK_SIZE;
+	const uint32_t offsetInChunk = (uint32_t)(offset - chunkIndex * CHUNK_SIZE);
+	uint64_t key = 0;
+	uint64_t generation = 0;
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (size == 0 || size > m_capacityInBytes)
+			return false;
+
+		const uint64_t urlHash = HashUrl(url);
+		auto etagIt = m_etags.find(urlHash);
+		if (etagIt == m_etags.end())
+		{
+			m_etags[urlHash] = etag;
+		}
+		else if (etagIt->second != etag)
+		{
+			UE_LOG(EvercoastReaderLog, Log, TEXT("Content of %s changed(ETag %s -> %s), dropping its persistent cache."), *url, *etagIt->second, *etag);
+			PurgeUrlLocked(urlHash);
+			m_etags[urlHash] = etag;
+		}
+		m_indexDirty = true;
+
+		key = MakeKey(urlHash, etag, chunkIndex);
+		auto existing = m_chunks.find(key);
+		if (existing != m_chunks.end())
+		{
+			// Queued or on disk already, written or not
+			auto rangeIt = existing->second.ranges.find(offsetInChunk);
+			if (rangeIt != existing->second.ranges.end() && rangeIt->second.size >= size)
+				return true;
+			uint32_t rangeOffset = 0;
+			if (FindRangeLocked(existing->second, offsetInChunk, size, rangeOffset))
+				return true;
+		}
+
+		EvictLocked(size);
+
+		auto chunkIt = m_chunks.find(key);
+		if (chunkIt == m_chunks.end())
+		{
+			ChunkRecord chunk;
+			chunk.urlHash = urlHash;
+			chunk.chunkIndex = chunkIndex;
+			chunk.generation = ++m_nextGeneration;
+			m_lru.push_front(key);
+			chunk.lruIt = m_lru.begin();
+			chunkIt = m_chunks.emplace(key, chunk).first;
+		}
+
+		ChunkRecord& chunk = chunkIt->second;
+		auto rangeIt = chunk.ranges.find(offsetInChunk);
+		if (rangeIt != chunk.ranges.end())
+		{
+			// A shorter range at the same offset, superseded
+			m_occupiedBytes -= rangeIt->second.size;
+			chunk.bytes -= rangeIt->second.size;
+		}
+		RangeRecord range;
+		range.size = size;
+		chunk.ranges[offsetInChunk] = range;
+		chunk.bytes += size;
+		m_occupiedBytes += size;
+		generation = chunk.generation;
+	}
+
+	// data is only valid during the call
+	std::shared_ptr<std::vector<uint8_t>> copy = std::make_shared<std::vector<uint8_t>>(data, data + size);
+	IOJob job;
+	job.work = [this, key, generation, offsetInChunk, copy]()
+	{
+		WriteRange(key, generation, offsetInChunk, *copy);
+	};
+	Enqueue(std::move(job));
+	return true;
+}
+
+void ReaderPersistentCache::WriteRange(uint64_t key, uint64_t generation, uint32_t offsetInChunk, const std::vector<uint8_t>& data)
+{
+	const uint32_t size = (uint32_t)data.size();
+	const uint32_t crc = FCrc::MemCrc32(data.data(), size);
+
+	bool written = false;
+	std::unique_ptr<IFileHandle> file(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*ChunkFilename(key), true, false));
+	if (file && file->Seek(offsetInChunk))
+	{
+		written = file->Write(data.data(), size) && file->Flush();
+	}
+	file.reset();
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	auto chunkIt = m_chunks.find(key);
+	// Evicted or superseded meanwhile
+	if (chunkIt == m_chunks.end() || chunkIt->second.generation != generation)
+		return;
+
+	auto rangeIt = chunkIt->second.ranges.find(offsetInChunk);
+	if (rangeIt == chunkIt->second.ranges.end() || rangeIt->second.size != size)
+		return;
+
+	if (!written)
+	{
+		UE_LOG(EvercoastReaderLog, Warning, TEXT("Cannot write persistent cache chunk %s"), *ChunkFilename(key));
+		RemoveRangeLocked(key, generation, offsetInChunk);
+		return;
+	}
+
+	rangeIt->second.crc = crc;
+	rangeIt->second.written = true;
+	m_indexDirty = true;
+}
+
+void ReaderPersistentCache::RemoveChunkLocked(uint64_t key)
+{
+	auto it = m_chunks.find(key);
+	if (it == m_chunks.end())
+		return;
+
+	m_occupiedBytes -= it->second.bytes;
+	m_lru.erase(it->second.lruIt);
+	m_chunks.erase(it);
+	m_indexDirty = true;
+
+	// Queued after any write to the chunk, so it can't come back from the dead
+	IOJob job;
+	const FString filename = ChunkFilename(key);
+	job.work = [filename]()
+	{
+		IFileManager::Get().Delete(*filename, false, false, true);
+	};
+	Enqueue(std::move(job));
+}
+
+void ReaderPersistentCache::RemoveRangeLocked(uint64_t key, uint64_t generation, uint32_t offsetInChunk)
+{
+	auto it = m_chunks.find(key);
+	if (it == m_chunks.end() || it->second.generation != generation)
+		return;
+
+	ChunkRecord& chunk = it->second;
+	auto rangeIt = chunk.ranges.find(offsetInChunk);
+	if (rangeIt == chunk.ranges.end())
+		return;
+
+	m_occupiedBytes -= rangeIt->second.size;
+	chunk.bytes -= rangeIt->second.size;
+	chunk.ranges.erase(rangeIt);
+	m_indexDirty = true;
+
+	if (chunk.ranges.empty())
+	{
+		RemoveChunkLocked(key);
+	}
+}
+
+void ReaderPersistentCache::PurgeUrlLocked(uint64_t urlHash)
+{
+	std::vector<uint64_t> keys;
+	for (const auto& chunk : m_chunks)
+	{
+		if (chunk.second.urlHash == urlHash)
+			keys.push_back(chunk.first);
+	}
+
+	for (uint64_t key : keys)
+	{
+		RemoveChunkLocked(key);
+	}
+}
+
+void ReaderPersistentCache::EvictLocked(uint64_t bytesNeeded)
+{
+	while (!m_lru.empty() && m_occupiedBytes + bytesNeeded > m_capacityInBytes)
+	{
+		RemoveChunkLocked(m_lru.back());
+	}
+}
+
+void ReaderPersistentCache::Flush()
+{
+	std::shared_ptr<TArray<uint8>> bytes = std::make_shared<TArray<uint8>>();
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		if (!m_indexDirty)
+			return;
+
+		FMemoryWriter writer(*bytes);
+		uint32 magic = PERSISTENT_CACHE_INDEX_MAGIC;
+		uint32 version = PERSISTENT_CACHE_INDEX_VERSION;
+		writer << magic;
+		writer << version;
+
+		int32 etagCount = (int32)m_etags.size();
+		writer << etagCount;
+		for (auto& etag : m_etags)
+		{
+			uint64 urlHash = etag.first;
+			writer << urlHash;
+			writer << etag.second;
+		}
+
+		// LRU order, most recently used first. Ranges still queued for writing are left out.
+		int32 chunkCount = (int32)m_lru.size();
+		writer << chunkCount;
+		for (uint64_t lruKey : m_lru)
+		{
+			const ChunkRecord& chunk = m_chunks[lruKey];
+			uint64 key = lruKey;
+			uint64 urlHash = chunk.urlHash;
+			uint64 chunkIndex = chunk.chunkIndex;
+			int32 rangeCount = 0;
+			for (const auto& range : chunk.ranges)
+			{
+				rangeCount += range.second.written ? 1 : 0;
+			}
+			writer << key << urlHash << chunkIndex << rangeCount;
+
+			for (const auto& range : chunk.ranges)
+			{
+				if (!range.second.written)
+					continue;
+
+				uint32 offsetInChunk = range.first;
+				uint32 size = range.second.size;
+				uint32 crc = range.second.crc;
+				writer << offsetInChunk << size << crc;
+			}
+		}
+		m_indexDirty = false;
+	}
+
+	IOJob job;
+	job.work = [this, bytes]()
+	{
+		// Write aside and swap so a crash never leaves a half written index
+		const FString indexFilename = IndexFilename();
+		const FString tempFilename = indexFilename + TEXT(".tmp");
+		if (!FFileHelper::SaveArrayToFile(*bytes, *tempFilename) || !IFileManager::Get().Move(*indexFilename, *tempFilename, true, true))
+		{
+			UE_LOG(EvercoastReaderLog, Warning, TEXT("Cannot save persistent cache index %s"), *indexFilename);
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_indexDirty = true;
+		}
+	};
+	Enqueue(std::move(job));
+}
+
+void ReaderPersistentCache::LoadIndex()
+{
+	struct LoadedChunk
+	{
+		uint64_t key;
+		ChunkRecord record;
+	};
+	std::vector<LoadedChunk> loadedChunks;
+	std::map<uint64_t, FString> loadedEtags;
+
+	TArray<uint8> bytes;
+	if (FFileHelper::LoadFileToArray(bytes, *IndexFilename(), FILEREAD_Silent))
+	{
+		FMemoryReader reader(bytes);
+		uint32 magic = 0, version = 0;
+		reader << magic;
+		reader << version;
+		if (magic == PERSISTENT_CACHE_INDEX_MAGIC && version == PERSISTENT_CACHE_INDEX_VERSION)
+		{
+			int32 etagCount = 0;
+			reader << etagCount;
+			for (int32 i = 0; i < etagCount && !reader.IsError(); ++i)
+			{
+				uint64 urlHash = 0;
+				FString etag;
+				reader << urlHash;
+				reader << etag;
+				loadedEtags[urlHash] = etag;
+			}
+
+			int32 chunkCount = 0;
+			reader << chunkCount;
+			for (int32 i = 0; i < chunkCount && !reader.IsError(); ++i)
+			{
+				uint64 key = 0, urlHash = 0, chunkIndex = 0;
+				int32 rangeCount = 0;
+				reader << key << urlHash << chunkIndex << rangeCount;
+
+				LoadedChunk loaded;
+				loaded.key = key;
+				loaded.record.urlHash = urlHash;
+				loaded.record.chunkIndex = chunkIndex;
+				uint64_t chunkEnd = 0;
+				for (int32 r = 0; r < rangeCount && !reader.IsError(); ++r)
+				{
+					uint32 offsetInChunk = 0, size = 0, crc = 0;
+					reader << offsetInChunk << size << crc;
+
+					RangeRecord range;
+					range.size = size;
+					range.crc = crc;
+					range.written = true;
+					loaded.record.ranges[offsetInChunk] = range;
+					loaded.record.bytes += size;
+					chunkEnd = FMath::Max<uint64_t>(chunkEnd, (uint64_t)offsetInChunk + size);
+				}
+				if (reader.IsError())
+					break;
+
+				// Chunk files can be wiped by the OS or the user, contents are verified on lookup
+				if (loaded.record.ranges.empty() || IFileManager::Get().FileSize(*ChunkFilename(key)) < (int64)chunkEnd)
+					continue;
+
+				loadedChunks.push_back(std::move(loaded));
+			}
+		}
+
+		if (reader.IsError())
+		{
+			UE_LOG(EvercoastReaderLog, Warning, TEXT("Persistent cache index is corrupted, only %d chunks recovered."), (int)loadedChunks.size());
+		}
+	}
+
+	TArray<FString> files;
+	IFileManager::Get().FindFiles(files, *FPaths::Combine(m_cacheDir, FString(TEXT("*")) + PERSISTENT_CACHE_ENTRY_EXTENSION), true, false);
+
+	std::vector<FString> orphans;
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		// Anything stored before the index got here stays, and takes precedence
+		for (auto& etag : loadedEtags)
+		{
+			m_etags.emplace(etag.first, etag.second);
+		}
+
+		for (LoadedChunk& loaded : loadedChunks)
+		{
+			auto etagIt = m_etags.find(loaded.record.urlHash);
+			if (m_chunks.find(loaded.key) != m_chunks.end() || etagIt == m_etags.end() ||
+				MakeKey(loaded.record.urlHash, etagIt->second, loaded.record.chunkIndex) != loaded.key)
+				continue;
+
+			loaded.record.generation = ++m_nextGeneration;
+			m_lru.push_back(loaded.key);
+			loaded.record.lruIt = std::prev(m_lru.end());
+			m_occupiedBytes += loaded.record.bytes;
+			m_chunks.emplace(loaded.key, std::move(loaded.record));
+		}
+
+		// Entry files the index doesn't know about, e.g. written after the last flush or by an older version
+		for (const FString& filename : files)
+		{
+			const uint64_t key = FCString::Strtoui64(*FPaths::GetBaseFilename(filename), nullptr, 16);
+			if (m_chunks.find(key) == m_chunks.end())
+			{
+				orphans.push_back(FPaths::Combine(m_cacheDir, filename));
+			}
+		}
+
+		EvictLocked(0);
+		UE_LOG(EvercoastReaderLog, Log, TEXT("Persistent cache loaded %d chunks, %llu bytes."), (int)m_chunks.size(), (unsigned long long)m_occupiedBytes);
+	}
+
+	for (const FString& orphan : orphans)
+	{
+		IFileManager::Get().Delete(*orphan, false, false, true);
+	}
+}
+
+void ReaderPersistentCache::Clear()
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	while (!m_lru.empty())
+	{
+		RemoveChunkLocked(m_lru.back());
+	}
+	m_etags.clear();
+	m_indexDirty = true;
+}
+
+uint64_t ReaderPersistentCache::GetOccupancyInBytes() const
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	return m_occupiedBytes;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+class FRunnableThread;
+
+// Cross-session cache of HTTP streamed content, shared by all readers. Ranges are grouped by URL + ETag + chunk
+// of the content their offset falls in, one file per chunk under the persistent download dir, and checked against
+// a CRC per range when read back. The in-memory index(LRU order of the chunks and the last seen ETag of every URL)
+// is saved on Flush() so a restarted app can serve repeated plays without touching the network. When the server
+// reports a different ETag for a URL all of its chunks are dropped.
+// All disk access happens on the cache's own IO thread, in the order queued. Callers only ever touch the index,
+// and the index lock is never held across disk IO.
+class ReaderPersistentCache : public FRunnable
+{
+public:
+	static constexpr uint64_t DEFAULT_CAPACITY = 4096ull * 1024ull * 1024ull;
+	static constexpr uint64_t CHUNK_SIZE = 8ull * 1024ull * 1024ull;
+
+	enum class LookupResult
+	{
+		Hit,
+		// Not cached after all, e.g. evicted or corrupted since Contains()
+		Miss,
+		// By CancelLookup(s), called on the cancelling thread
+		Cancelled
+	};
+	typedef std::function<void(LookupResult result)> LookupCallback;
+
+	// Created on first use, the index gets loaded on the IO thread
+	static ReaderPersistentCache& Get();
+	// Save the index and stop the IO thread if the cache was ever used, called on module shutdown
+	static void ShutdownIfLoaded();
+	// An instance of its own on cacheDir instead of the shared one, for tests
+	static std::unique_ptr<ReaderPersistentCache> CreateStandalone(const FString& cacheDir);
+
+	virtual ~ReaderPersistentCache();
+
+	// Least recently used chunks get evicted until the cache fits
+	void SetCapacity(uint64_t capacityInBytes);
+
+	// Range of the URL's last known version is cached, from the index only
+	bool Contains(const FString& url, uint64_t offset, uint32_t size);
+	// Read the cached range into destination on the IO thread, which calls back when done. owner and requestId
+	// identify the lookup to cancel it. destination must stay valid until the callback.
+	void LookupAsync(const void* owner, uint32_t requestId, const FString& url, uint64_t offset, uint32_t size, uint8_t* destination, LookupCallback callback);
+	// Return true if the lookup was still queued, it calls back Cancelled. If it's running, wait for it to finish.
+	bool CancelLookup(const void* owner, uint32_t requestId);
+	// Cancel all of owner's lookups, nothing of owner's runs or calls back once this returns
+	void CancelLookups(const void* owner);
+	// The data is copied and written on the IO thread. etag can be empty if the server doesn't give any validator.
+	bool Store(const FString& url, const FString& etag, uint64_t offset, uint32_t size, const uint8_t* data);
+
+	// The index is written on the IO thread
+	void Flush();
+	void Clear();
+	// Block till all queued IO is done
+	void WaitForIdle();
+
+	uint64_t GetOccupancyInBytes() const;
+private:
+	explicit ReaderPersistentCache(const FString& cacheDir);
+	ReaderPersistentCache(const ReaderPersistentCache&) = delete;
+	ReaderPersistentCache& operator=(const ReaderPersistentCache&) = delete;
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+	struct RangeRecord
+	{
+		uint32_t size = 0;
+		uint32_t crc = 0;
+		// Still queued for writing, not served until it's on disk
+		bool written = false;
+	};
+
+	struct ChunkRecord
+	{
+		uint64_t urlHash = 0;
+		uint64_t chunkIndex = 0;
+		// Tells a chunk apart from an earlier evicted one of the same key, for IO queued before the eviction
+		uint64_t generation = 0;
+		uint64_t bytes = 0;
+		// Offset in chunk -> range
+		std::map<uint32_t, RangeRecord> ranges;
+		std::list<uint64_t>::iterator lruIt;
+	};
+
+	struct IOJob
+	{
+		// Lookups only, nullptr for the cache's own IO
+		const void* owner = nullptr;
+		uint32_t requestId = 0;
+		std::function<void()> work;
+		std::function<void()> cancel;
+	};
+
+	static uint64_t HashUrl(const FString& url);
+	static uint64_t MakeKey(uint64_t urlHash, const FString& etag, uint64_t chunkIndex);
+	FString ChunkFilename(uint64_t key) const;
+	FString IndexFilename() const;
+
+	// Below expect m_lock being held
+	uint64_t KeyForLocked(const FString& url, uint64_t chunkIndex) const;
+	const RangeRecord* FindRangeLocked(const ChunkRecord& chunk, uint32_t offsetInChunk, uint32_t size, uint32_t& outRangeOffset) const;
+	void RemoveChunkLocked(uint64_t key);
+	void RemoveRangeLocked(uint64_t key, uint64_t generation, uint32_t offsetInChunk);
+	void PurgeUrlLocked(uint64_t urlHash);
+	void EvictLocked(uint64_t bytesNeeded);
+
+	// Run on the IO thread
+	bool ReadRange(const FString& url, uint64_t offset, uint32_t size, uint8_t* destination);
+	void WriteRange(uint64_t key, uint64_t generation, uint32_t offsetInChunk, const std::vector<uint8_t>& data);
+	void LoadIndex();
+
+	void Enqueue(IOJob&& job);
+
+	FString m_cacheDir;
+	uint64_t m_capacityInBytes;
+	uint64_t m_occupiedBytes;
+	uint64_t m_nextGeneration;
+	bool m_indexDirty;
+
+	std::unordered_map<uint64_t, ChunkRecord> m_chunks;
+	// Most recently used at the front
+	std::list<uint64_t> m_lru;
+	// url hash -> last seen ETag
+	std::map<uint64_t, FString> m_etags;
+
+	mutable std::mutex m_lock;
+
+	// IO queue. Taken after m_lock when both are needed, never the other way round.
+	std::deque<IOJob> m_jobs;
+	const void* m_runningOwner;
+	uint32_t m_runningRequestId;
+	bool m_busy;
+	std::mutex m_queueLock;
+	std::condition_variable m_queueCondition;
+	std::atomic<bool> m_running;
+	FRunnableThread* m_thread;
+};
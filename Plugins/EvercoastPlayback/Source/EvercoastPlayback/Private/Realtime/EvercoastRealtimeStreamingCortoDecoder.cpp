@@ -9,10 +9,15 @@
 #include "HAL/RunnableThread.h"
 #include <thread>
 #include <chrono>
-#include "Misc/Optional.h" // iOS hates C++17?
 #include <mutex>
-
-// An asynchronised decode thread doing flipflop between decoding and output
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include "Realtime/RealtimeJitterBuffer.h"
+
+// An asynchronised decode thread taking frames out of a jitter buffer in frame number order and queueing up the results
 class RealtimeMeshImgSeqDecodeThread final : public FRunnable
 {
 public:
@@ -22,22 +27,21 @@ public:
 		int64_t frameIndex{ 0 };
 		TArray<uint8> data;
 	};
-	RealtimeMeshImgSeqDecodeThread(std::shared_ptr<CortoDecoder> meshDecoder, std::shared_ptr<WebpDecoder> imgDecoder, std::shared_ptr<EvercoastPerfCounter> perfCounter) :
-		m_meshDecoder(meshDecoder), m_imgDecoder(imgDecoder), m_outputFlipflop(-1), m_perfCounter(perfCounter)
+	RealtimeMeshImgSeqDecodeThread(std::shared_ptr<CortoDecoder> meshDecoder, std::shared_ptr<WebpDecoder> imgDecoder, std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency) :
+		m_meshDecoder(meshDecoder), m_imgDecoder(imgDecoder), m_jitterBuffer(jitterBufferLatency, JITTER_BUFFER_CAPACITY), m_perfCounter(perfCounter)
 	{
 	}
 
 	~RealtimeMeshImgSeqDecodeThread()
 	{
+		const auto& stats = m_jitterBuffer.GetStats();
+		UE_LOG(EvercoastRealtimeLog, Log, TEXT("Realtime mesh frames received: %llu decoded: %llu late: %llu duplicate: %llu overflow: %llu lost: %llu unconsumed: %llu"),
+			(unsigned long long)stats.Received, (unsigned long long)stats.Released, (unsigned long long)stats.Late, (unsigned long long)stats.Duplicate,
+			(unsigned long long)stats.Overflow, (unsigned long long)stats.Lost, (unsigned long long)m_unconsumedResultCount);
 	}
 
 	bool Init() override
 	{
-		for (int i = 0; i < 2; ++i)
-		{
-			m_output[i] = nullptr;
-		}
-		m_outputFlipflop = 0;
 		m_running = true;
 		return m_meshDecoder != nullptr;
 	}
@@ -46,41 +50,46 @@ public:
 	{
 		while (m_running)
 		{
-			TOptional<InputFrame> dataFrame;
+			InputFrame dataFrame;
+			int64_t frameNumber = 0;
+			bool hasFrame = false;
 			{
-				std::lock_guard<std::mutex> guardInput(m_inputMutex);
-				if (m_input.IsSet())
+				std::unique_lock<std::mutex> lock(m_inputMutex);
+				hasFrame = m_jitterBuffer.Pop(FPlatformTime::Seconds(), frameNumber, dataFrame);
+				if (!hasFrame)
 				{
-					dataFrame = m_input;
-					m_input.Reset();
+					if (!m_running)
+						break;
+
+					const double waitTime = m_jitterBuffer.GetTimeUntilNextRelease(FPlatformTime::Seconds());
+					if (waitTime < 0)
+						m_condition.wait(lock);
+					else
+						m_condition.wait_for(lock, std::chrono::microseconds((int64_t)(waitTime * 1000000.0) + 1));
+					continue;
 				}
 			}
 
-			if (dataFrame.IsSet() && dataFrame->data.Num() > 0)
+			if (dataFrame.data.Num() > 0)
 			{
 				CortoDecodeOption meshDecodeOption;
 				GenericDecodeOption imgDecodeOption;
 
-				int current = (m_outputFlipflop + 1) % 2;
-				std::lock_guard<std::mutex> guardOutput(m_outputMutex[current]);
-
-				if (!m_output[current])
-				{
-					m_output[current] = std::make_shared<CortoImageUnifiedDecodeResult>(CortoDecoder::DEFAULT_VERTEX_COUNT, CortoDecoder::DEFAULT_TRIANGLE_COUNT, 1024, 1024, 32);
-				}
+				std::shared_ptr<CortoImageUnifiedDecodeResult> output = AcquireResult();
 
-				m_meshDecoder->SetReceivingResult(m_output[current]->meshResult);
-				m_imgDecoder->SetReceivingResult(m_output[current]->imgResult);
+				m_meshDecoder->SetReceivingResult(output->meshResult);
+				m_imgDecoder->SetReceivingResult(output->imgResult);
 
 
-				RealtimeMeshingPacketHeaderV1* header = (RealtimeMeshingPacketHeaderV1*)dataFrame->data.GetData();
-				uint8_t* data = dataFrame->data.GetData();
+				RealtimeMeshingPacketHeaderV1* header = (RealtimeMeshingPacketHeaderV1*)dataFrame.data.GetData();
+				uint8_t* data = dataFrame.data.GetData();
 				// find offset and data size and feed respectively
 				uint8_t* cortoData = data + header->absoluteOffsetToCortoData;
 				uint8_t* webpData = data + header->absoluteOffsetToWepPData;
 				uint32_t cortoDataSize = header->cortoDataLength;
 				uint32_t webpDataSize = header->wepPDataLength;
 
+				bool decoded = false;
 				// Guard from "empty frames"
 				if (!cortoData || !webpData || cortoDataSize == 0 || webpDataSize == 0)
 				{
@@ -88,11 +97,11 @@ public:
 				}
 				else
 				{
-					if (m_meshDecoder->DecodeMemoryStream(cortoData, cortoDataSize, dataFrame->timestamp, dataFrame->frameIndex, &meshDecodeOption) &&
-						m_imgDecoder->DecodeMemoryStream(webpData, webpDataSize, dataFrame->timestamp, dataFrame->frameIndex, &imgDecodeOption))
+					if (m_meshDecoder->DecodeMemoryStream(cortoData, cortoDataSize, dataFrame.timestamp, dataFrame.frameIndex, &meshDecodeOption) &&
+						m_imgDecoder->DecodeMemoryStream(webpData, webpDataSize, dataFrame.timestamp, dataFrame.frameIndex, &imgDecodeOption))
 					{
-						m_output[current]->SyncWithMeshResult();
-						m_outputFlipflop = current;
+						output->SyncWithMeshResult();
+						decoded = true;
 
 						m_perfCounter->AddSample();
 					}
@@ -105,13 +114,25 @@ public:
 				m_meshDecoder->UnsetReceivingResult();
 				m_imgDecoder->UnsetReceivingResult();
 
+				if (decoded)
+				{
+					std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+					m_output.push_back(output);
+					// Nobody's consuming fast enough, keep the freshest
+					while (m_output.size() > OUTPUT_QUEUE_SIZE)
+					{
+						UE_LOG(EvercoastRealtimeLog, Verbose, TEXT("Result of frame %" PRId64 " not consumed in time, dropped"), m_output.front()->frameIndex);
+						m_unconsumedResultCount++;
+						RecycleResult(m_output.front());
+						m_output.pop_front();
+					}
+				}
+				else
+				{
+					std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+					RecycleResult(output);
+				}
 			}
-			else
-			{
-				std::unique_lock<std::mutex> newFrameLock(m_newFrameMutex);
-				m_condition.wait(newFrameLock);
-			}
-
 		}
 
 		return 0;
@@ -119,7 +140,10 @@ public:
 
 	void Stop() override
 	{
-		m_running = false;
+		{
+			std::lock_guard<std::mutex> guardInput(m_inputMutex);
+			m_running = false;
+		}
 		m_condition.notify_one();
 	}
 
@@ -132,15 +156,29 @@ public:
 
 	bool AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize)
 	{
+		// Ordered by the frame number the meshing server stamped, the transport's one as a fallback
+		int64_t frameNumber = frameIndex;
+		if (dataSize >= sizeof(RealtimeMeshingPacketHeaderV1))
+		{
+			frameNumber = ((const RealtimeMeshingPacketHeaderV1*)data)->frameNumber;
+		}
+
 		TArray<uint8> InputBuffer;
 		InputBuffer.AddUninitialized(dataSize);
 		FMemory::Memcpy(InputBuffer.GetData(), data, dataSize);
 
+		bool accepted;
 		{
 			std::lock_guard<std::mutex> guardInput(m_inputMutex);
-			m_input = InputFrame{
+			accepted = m_jitterBuffer.Push(frameNumber, FPlatformTime::Seconds(), InputFrame{
 				timestamp, frameIndex, std::move(InputBuffer)
-			};
+			});
+		}
+
+		if (!accepted)
+		{
+			UE_LOG(EvercoastRealtimeLog, Verbose, TEXT("Mesh frame %" PRId64 " arrived late or twice, dropped"), frameNumber);
+			return false;
 		}
 
 		m_condition.notify_one();
@@ -150,74 +188,110 @@ public:
 
 	std::shared_ptr<CortoImageUnifiedDecodeResult> PopResult()
 	{
-		std::lock_guard<std::mutex> guardOutput(m_outputMutex[m_outputFlipflop]);
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
 
-		if (m_output[m_outputFlipflop])
-		{
-			auto result = std::make_shared<CortoImageUnifiedDecodeResult>(*m_output[m_outputFlipflop]);
-			m_output[m_outputFlipflop] = nullptr;
-
-			return result;
-		}
-		else
-		{
+		if (m_output.empty())
 			return nullptr;
-		}
+
+		auto result = std::move(m_output.front());
+		m_output.pop_front();
+		return result;
 	}
 
 	std::shared_ptr<CortoImageUnifiedDecodeResult> PeekResult(int offsetFromTop) const
 	{
-		// don't have a queue, always return the current available
-		std::lock_guard<std::mutex> guardOutput(m_outputMutex[m_outputFlipflop]);
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+
+		if (offsetFromTop < 0 || offsetFromTop >= (int)m_output.size())
+			return nullptr;
+
+		return m_output[offsetFromTop];
+	}
 
-		if (m_output[m_outputFlipflop])
+	// The result comes back once the caller is done with it
+	void DisposeResult(std::shared_ptr<CortoImageUnifiedDecodeResult> result)
+	{
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+		RecycleResult(result);
+	}
+
+	void Reset()
+	{
 		{
-			return std::make_shared<CortoImageUnifiedDecodeResult>(*m_output[m_outputFlipflop]);
+			std::lock_guard<std::mutex> guardInput(m_inputMutex);
+			m_jitterBuffer.Reset();
 		}
-		else
+
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+		for (auto& result : m_output)
 		{
-			return nullptr;
+			RecycleResult(result);
 		}
+		m_output.clear();
 	}
 
-	void Reset()
+
+private:
+	static constexpr size_t JITTER_BUFFER_CAPACITY = 16;
+	static constexpr size_t OUTPUT_QUEUE_SIZE = 4;
+	static constexpr size_t FREE_RESULT_COUNT = 4;
+
+	std::shared_ptr<CortoImageUnifiedDecodeResult> AcquireResult()
 	{
-		for (int i = 0; i < 2; ++i)
 		{
-			std::lock_guard<std::mutex> guardOutput(m_outputMutex[i]);
-			if (m_output[i])
+			std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+			for (auto it = m_freeResults.begin(); it != m_freeResults.end(); ++it)
 			{
-				m_output[i]->InvalidateResult();
+				// Uploaded meshes can still be holding on to the buffers, see CortoLocalMeshFrame
+				if (it->use_count() == 1 && (*it)->meshResult.use_count() == 1 && (*it)->imgResult.use_count() == 1)
+				{
+					auto result = std::move(*it);
+					m_freeResults.erase(it);
+					// Nobody else sees it any more, safe to wipe
+					result->InvalidateResult();
+					return result;
+				}
 			}
-			m_outputFlipflop = 0;
 		}
+
+		return std::make_shared<CortoImageUnifiedDecodeResult>(CortoDecoder::DEFAULT_VERTEX_COUNT, CortoDecoder::DEFAULT_TRIANGLE_COUNT, 1024, 1024, 32);
 	}
 
+	// Needs m_outputMutex. Not invalidated here, a dropped result may have been handed out by PeekResult() and still
+	// be in use on the game thread. AcquireResult() only reuses it once that reference is gone.
+	void RecycleResult(const std::shared_ptr<CortoImageUnifiedDecodeResult>& result)
+	{
+		if (!result)
+			return;
 
-private:
+		if (m_freeResults.size() < FREE_RESULT_COUNT &&
+			std::find(m_freeResults.begin(), m_freeResults.end(), result) == m_freeResults.end())
+		{
+			m_freeResults.push_back(result);
+		}
+	}
 
 	std::shared_ptr<CortoDecoder> m_meshDecoder;
 	std::shared_ptr<WebpDecoder> m_imgDecoder;
 
-	TOptional<InputFrame> m_input;
-	std::shared_ptr<CortoImageUnifiedDecodeResult> m_output[2];
-	mutable std::mutex m_outputMutex[2];
-	int m_outputFlipflop;
+	RealtimeJitterBuffer<InputFrame> m_jitterBuffer;
+	std::deque<std::shared_ptr<CortoImageUnifiedDecodeResult>> m_output;
+	std::vector<std::shared_ptr<CortoImageUnifiedDecodeResult>> m_freeResults;
+	mutable std::mutex m_outputMutex;
+	uint64_t m_unconsumedResultCount = 0;
 
 	std::atomic<bool> m_running{ false };
 
 	std::mutex m_inputMutex;
-
-	std::mutex m_newFrameMutex;
 	std::condition_variable m_condition;
 	std::shared_ptr<EvercoastPerfCounter> m_perfCounter;
 };
 
 
-EvercoastRealtimeStreamingCortoDecoder::EvercoastRealtimeStreamingCortoDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter) :
+EvercoastRealtimeStreamingCortoDecoder::EvercoastRealtimeStreamingCortoDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency) :
 	m_baseMeshDecoder(CortoDecoder::Create()), m_baseImageDecoder(WebpDecoder::Create()), m_runnable(nullptr), m_runnableController(nullptr)
 {
-	m_runnable = new RealtimeMeshImgSeqDecodeThread(m_baseMeshDecoder, m_baseImageDecoder, perfCounter);
+	m_runnable = new RealtimeMeshImgSeqDecodeThread(m_baseMeshDecoder, m_baseImageDecoder, perfCounter, jitterBufferLatency);
 	m_runnableController = FRunnableThread::Create(m_runnable, TEXT("Evercoast Realtime Mesh Decode Thread"));
 }
 
@@ -253,7 +327,11 @@ std::shared_ptr<GenericDecodeResult> EvercoastRealtimeStreamingCortoDecoder::Pee
 
 void EvercoastRealtimeStreamingCortoDecoder::DisposeResult(std::shared_ptr<GenericDecodeResult> result)
 {
-	// no need to dispose, everything is copied out
+	if (!result || result->GetType() != DecodeResultType::DRT_CortoMesh_WebpImage_Unified)
+		return;
+
+	RealtimeMeshImgSeqDecodeThread* decodeThread = static_cast<RealtimeMeshImgSeqDecodeThread*>(m_runnable);
+	decodeThread->DisposeResult(std::static_pointer_cast<CortoImageUnifiedDecodeResult>(result));
 }
 
 void EvercoastRealtimeStreamingCortoDecoder::FlushAndDisposeResults()
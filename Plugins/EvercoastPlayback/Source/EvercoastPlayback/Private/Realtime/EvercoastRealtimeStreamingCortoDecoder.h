@@ -10,7 +10,8 @@ class EvercoastPerfCounter;
 class EvercoastRealtimeStreamingCortoDecoder : public IEvercoastRealtimeDataDecoder
 {
 public:
-	EvercoastRealtimeStreamingCortoDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter);
+	// jitterBufferLatency in seconds, how long frames are held to be put back in order
+	EvercoastRealtimeStreamingCortoDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency);
 	virtual ~EvercoastRealtimeStreamingCortoDecoder();
 	// ~Start of IEvercoastRealtimeDataDecoder~
 	virtual void Receive(double timestamp, int64_t frameIndex, const uint8_t* data, size_t data_size, uint32_t metadata) override;
@@ -7,9 +7,12 @@
 #include "HAL/RunnableThread.h"
 #include <thread>
 #include <chrono>
-#include "Misc/Optional.h" // iOS hates C++17?
+#include <condition_variable>
+#include <deque>
+#include <inttypes.h>
+#include "Realtime/RealtimeJitterBuffer.h"
 
-// An asynchronised decode thread but no control over what timestamp the frame it can get
+// An asynchronised decode thread taking frames out of a jitter buffer in frame number order and queueing up the results
 class RealtimeVoxelDecodeThread final : public FRunnable
 {
 public:
@@ -19,8 +22,8 @@ public:
 		int64_t frameIndex{ 0 };
 		TArray<uint8> data;
 	};
-	RealtimeVoxelDecodeThread(std::shared_ptr<IGenericDecoder> decoder, std::shared_ptr<EvercoastPerfCounter> perfCounter) :
-		m_baseDecoder(decoder), m_perfCounter(perfCounter)
+	RealtimeVoxelDecodeThread(std::shared_ptr<IGenericDecoder> decoder, std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency) :
+		m_baseDecoder(decoder), m_jitterBuffer(jitterBufferLatency, JITTER_BUFFER_CAPACITY), m_perfCounter(perfCounter)
 	{
 		auto voxelDecoder = std::static_pointer_cast<EvercoastVoxelDecoder>(m_baseDecoder);
 		m_baseDefinition = voxelDecoder->GetDefaultDefinition();
@@ -33,6 +36,10 @@ public:
 
 	~RealtimeVoxelDecodeThread()
 	{
+		const auto& stats = m_jitterBuffer.GetStats();
+		UE_LOG(EvercoastRealtimeLog, Log, TEXT("Realtime voxel frames received: %llu decoded: %llu late: %llu duplicate: %llu overflow: %llu lost: %llu unconsumed: %llu"),
+			(unsigned long long)stats.Received, (unsigned long long)stats.Released, (unsigned long long)stats.Late, (unsigned long long)stats.Duplicate,
+			(unsigned long long)stats.Overflow, (unsigned long long)stats.Lost, (unsigned long long)m_unconsumedResultCount);
 	}
 
 	bool Init() override
@@ -45,20 +52,28 @@ public:
 	{
 		while (m_running)
 		{
-			TOptional<InputFrame> dataFrame;
+			InputFrame dataFrame;
+			int64_t frameNumber = 0;
 			{
-				std::lock_guard<std::mutex> guardInput(m_inputMutex);
-				if (m_input.IsSet())
+				std::unique_lock<std::mutex> lock(m_inputMutex);
+				if (!m_jitterBuffer.Pop(FPlatformTime::Seconds(), frameNumber, dataFrame))
 				{
-					dataFrame =  m_input;
-					m_input.Reset();
+					if (!m_running)
+						break;
+
+					const double waitTime = m_jitterBuffer.GetTimeUntilNextRelease(FPlatformTime::Seconds());
+					if (waitTime < 0)
+						m_condition.wait(lock);
+					else
+						m_condition.wait_for(lock, std::chrono::microseconds((int64_t)(waitTime * 1000000.0) + 1));
+					continue;
 				}
 			}
 
-			if (dataFrame.IsSet() && dataFrame->data.Num() > 0)
+			if (dataFrame.data.Num() > 0)
 			{
 				EvercoastVoxelDecodeOption option(m_baseDefinition);
-				if (m_baseDecoder->DecodeMemoryStream(dataFrame->data.GetData(), dataFrame->data.Num(), dataFrame->timestamp, dataFrame->frameIndex, &option))
+				if (m_baseDecoder->DecodeMemoryStream(dataFrame.data.GetData(), dataFrame.data.Num(), dataFrame.timestamp, dataFrame.frameIndex, &option))
 				{
 					auto result = m_baseDecoder->TakeResult();
 					auto pResult = std::static_pointer_cast<EvercoastVoxelDecodeResult>(result);
@@ -66,7 +81,15 @@ public:
 
 					{
 						std::lock_guard<std::mutex> guardOutput(m_outputMutex);
-						m_output = pResult;
+						m_output.push_back(pResult);
+						// Nobody's consuming fast enough, keep the freshest
+						while (m_output.size() > OUTPUT_QUEUE_SIZE)
+						{
+							UE_LOG(EvercoastRealtimeLog, Verbose, TEXT("Result of frame %" PRId64 " not consumed in time, dropped"), m_output.front()->frameIndex);
+							m_unconsumedResultCount++;
+							// Not invalidated, PeekResult() may have handed it out. The frame is freed with the last reference.
+							m_output.pop_front();
+						}
 
 						m_perfCounter->AddSample();
 					}
@@ -76,12 +99,6 @@ public:
 					UE_LOG(EvercoastRealtimeLog, Warning, TEXT("Decode voxel failed"));
 				}
 			}
-			else
-			{
-				std::unique_lock<std::mutex> newFrameLock(m_newFrameMutex);
-				m_condition.wait(newFrameLock);
-			}
-
 		}
 
 		return 0;
@@ -89,7 +106,10 @@ public:
 
 	void Stop() override
 	{
-		m_running = false;
+		{
+			std::lock_guard<std::mutex> guardInput(m_inputMutex);
+			m_running = false;
+		}
 		m_condition.notify_one();
 	}
 
@@ -106,11 +126,19 @@ public:
 		InputBuffer.AddUninitialized(dataSize);
 		FMemory::Memcpy(InputBuffer.GetData(), data, dataSize);
 
+		// Voxel packets don't carry a frame number of their own, the transport's one orders them
+		bool accepted;
 		{
 			std::lock_guard<std::mutex> guardInput(m_inputMutex);
-			m_input = InputFrame{
+			accepted = m_jitterBuffer.Push(frameIndex, FPlatformTime::Seconds(), InputFrame{
 				timestamp, frameIndex, std::move(InputBuffer)
-			};
+			});
+		}
+
+		if (!accepted)
+		{
+			UE_LOG(EvercoastRealtimeLog, Verbose, TEXT("Voxel frame %" PRId64 " arrived late or twice, dropped"), frameIndex);
+			return false;
 		}
 
 		m_condition.notify_one();
@@ -121,9 +149,11 @@ public:
 	std::shared_ptr<EvercoastVoxelDecodeResult> PopResult()
 	{
 		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
-		if (m_output)
+		if (!m_output.empty())
 		{
-			return std::move(m_output);
+			auto result = std::move(m_output.front());
+			m_output.pop_front();
+			return result;
 		}
 		else
 		{
@@ -133,33 +163,53 @@ public:
 
 	std::shared_ptr<EvercoastVoxelDecodeResult> PeekResult(int offsetFromTop) const
 	{
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+		if (offsetFromTop >= 0 && offsetFromTop < (int)m_output.size())
+		{
+			return m_output[offsetFromTop];
+		}
+
 		return std::make_shared<EvercoastVoxelDecodeResult>(false, -1.0, -1, InvalidHandle);
 	}
 
+	void Reset()
+	{
+		{
+			std::lock_guard<std::mutex> guardInput(m_inputMutex);
+			m_jitterBuffer.Reset();
+		}
+
+		// Peeked results may still be in use, the frames are freed with their last reference
+		std::lock_guard<std::mutex> guardOutput(m_outputMutex);
+		m_output.clear();
+	}
+
 
 private:
+	static constexpr size_t JITTER_BUFFER_CAPACITY = 16;
+	static constexpr size_t OUTPUT_QUEUE_SIZE = 4;
 
 	std::shared_ptr<IGenericDecoder> m_baseDecoder;
 	Definition m_baseDefinition;
 
-	TOptional<InputFrame> m_input;
-	std::shared_ptr<EvercoastVoxelDecodeResult> m_output;
+	RealtimeJitterBuffer<InputFrame> m_jitterBuffer;
+	std::deque<std::shared_ptr<EvercoastVoxelDecodeResult>> m_output;
+	uint64_t m_unconsumedResultCount = 0;
 
 	std::atomic<bool> m_running{ false };
 
 	std::mutex m_inputMutex;
-	std::mutex m_outputMutex;
+	mutable std::mutex m_outputMutex;
 
-	std::mutex m_newFrameMutex;
 	std::condition_variable m_condition;
 
 	std::shared_ptr<EvercoastPerfCounter> m_perfCounter;
 };
 
-EvercoastRealtimeStreamingVoxelDecoder::EvercoastRealtimeStreamingVoxelDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter) :
+EvercoastRealtimeStreamingVoxelDecoder::EvercoastRealtimeStreamingVoxelDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency) :
 	m_baseVoxelDecoder(EvercoastVoxelDecoder::Create()), m_runnable(nullptr), m_runnableController(nullptr)
 {
-	m_runnable = new RealtimeVoxelDecodeThread(m_baseVoxelDecoder, perfCounter);
+	m_runnable = new RealtimeVoxelDecodeThread(m_baseVoxelDecoder, perfCounter, jitterBufferLatency);
 	m_runnableController = FRunnableThread::Create(m_runnable, TEXT("Evercoast Realtime Voxel Decode Thread"));
 }
 
@@ -199,6 +249,5 @@ void EvercoastRealtimeStreamingVoxelDecoder::DisposeResult(std::shared_ptr<Gener
 void EvercoastRealtimeStreamingVoxelDecoder::FlushAndDisposeResults()
 {
 	RealtimeVoxelDecodeThread* decodeThread = static_cast<RealtimeVoxelDecodeThread*>(m_runnable);
-	auto result = decodeThread->PopResult();
-	DisposeResult(result);
+	decodeThread->Reset();
 }
@@ -13,7 +13,8 @@ class EvercoastPerfCounter;
 class EvercoastRealtimeStreamingVoxelDecoder : public IEvercoastRealtimeDataDecoder
 {
 public:
-	EvercoastRealtimeStreamingVoxelDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter);
+	// jitterBufferLatency in seconds, how long frames are held to be put back in order
+	EvercoastRealtimeStreamingVoxelDecoder(std::shared_ptr<EvercoastPerfCounter> perfCounter, double jitterBufferLatency);
 	virtual ~EvercoastRealtimeStreamingVoxelDecoder();
 	// ~Start of IEvercoastRealtimeDataDecoder~
 	virtual void Receive(double timestamp, int64_t frameIndex, const uint8_t* data, size_t data_size, uint32_t metadata) override;
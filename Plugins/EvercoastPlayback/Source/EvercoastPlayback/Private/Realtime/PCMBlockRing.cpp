@@ -0,0 +1,249 @@
+#include "Realtime/PCMBlockRing.h"
+#include <algorithm>
+
+static uint32_t RoundUpToPowerOfTwo(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result < value)
+		result <<= 1;
+	return result;
+}
+
+PCMBlockRing::PCMBlockRing(uint32_t blockCount) :
+	m_blocks(RoundUpToPowerOfTwo(std::max(blockCount, 2u))),
+	m_mask((uint32_t)m_blocks.size() - 1)
+{
+}
+
+PCMBlock* PCMBlockRing::BeginWrite()
+{
+	const uint32_t head = m_head.load(std::memory_order_relaxed);
+	const uint32_t tail = m_tail.load(std::memory_order_acquire);
+	if (head - tail > m_mask)
+		return nullptr;
+
+	return &m_blocks[head & m_mask];
+}
+
+void PCMBlockRing::CommitWrite()
+{
+	const uint32_t head = m_head.load(std::memory_order_relaxed);
+	m_queuedSamples.fetch_add(m_blocks[head & m_mask].sampleCount, std::memory_order_relaxed);
+	m_head.store(head + 1, std::memory_order_release);
+}
+
+const PCMBlock* PCMBlockRing::Front() const
+{
+	const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	const uint32_t head = m_head.load(std::memory_order_acquire);
+	if (head == tail)
+		return nullptr;
+
+	return &m_blocks[tail & m_mask];
+}
+
+void PCMBlockRing::Pop()
+{
+	const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	m_queuedSamples.fetch_sub(m_blocks[tail & m_mask].sampleCount, std::memory_order_relaxed);
+	m_tail.store(tail + 1, std::memory_order_release);
+}
+
+uint32_t PCMBlockRing::GetSize() const
+{
+	return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+}
+
+int64_t PCMBlockRing::GetQueuedSamples() const
+{
+	return std::max<int64_t>(m_queuedSamples.load(std::memory_order_relaxed), 0);
+}
+
+static int16_t ClampToInt16(float value)
+{
+	return (int16_t)std::min(std::max(value, -32768.0f), 32767.0f);
+}
+
+// Gain of the repeated block at a frame into a gap of missingCount blocks. Gaps no longer than the fade dip and
+// come back up by their end, the packet after them is already here, rather than fading to near silence just before it
+static float ConcealGain(int32_t gapFrame, int32_t framesPerBlock, int32_t missingCount)
+{
+	const float fadeFrames = (float)(framesPerBlock * PCMConcealment::CONCEAL_FADE_BLOCKS);
+	float gain = 1.0f - gapFrame / fadeFrames;
+	if (missingCount <= PCMConcealment::CONCEAL_FADE_BLOCKS)
+	{
+		gain = std::max(gain, 1.0f - (missingCount * framesPerBlock - gapFrame) / fadeFrames);
+	}
+	return std::min(std::max(gain, 0.0f), 1.0f);
+}
+
+void PCMConcealment::Conceal(const int16_t* last, int32_t sampleCount, int32_t channels, int32_t missingIndex, int32_t missingCount, int16_t* out)
+{
+	const int32_t frames = sampleCount / channels;
+	const int32_t crossfadeFrames = std::min(CROSSFADE_FRAMES, frames);
+	for (int32_t f = 0; f < frames; ++f)
+	{
+		const float gain = ConcealGain(missingIndex * frames + f, frames, missingCount);
+		// Mirrors the tail around the seam so the waveform stays continuous there
+		const float fadeIn = f < crossfadeFrames ? (float)(f + 1) / (crossfadeFrames + 1) : 1.0f;
+		const float seamGain = f < crossfadeFrames ? ConcealGain(missingIndex * frames - 1 - f, frames, missingCount) : 0.0f;
+		for (int32_t c = 0; c < channels; ++c)
+		{
+			float value = last[f * channels + c] * gain * fadeIn;
+			if (f < crossfadeFrames)
+			{
+				value += last[(frames - 1 - f) * channels + c] * seamGain * (1.0f - fadeIn);
+			}
+			out[f * channels + c] = ClampToInt16(value);
+		}
+	}
+}
+
+void PCMConcealment::CrossfadeIn(const int16_t* last, int32_t lastSampleCount, int32_t channels, int32_t missingCount, int16_t* inOut, int32_t sampleCount)
+{
+	const int32_t lastFrames = lastSampleCount / channels;
+	const int32_t crossfadeFrames = std::min(std::min(CROSSFADE_FRAMES, lastFrames), sampleCount / channels);
+	for (int32_t f = 0; f < crossfadeFrames; ++f)
+	{
+		const float fadeIn = (float)(f + 1) / (crossfadeFrames + 1);
+		const float seamGain = ConcealGain(missingCount * lastFrames - 1 - f, lastFrames, missingCount);
+		for (int32_t c = 0; c < channels; ++c)
+		{
+			const float value = inOut[f * channels + c] * fadeIn + last[(lastFrames - 1 - f) * channels + c] * seamGain * (1.0f - fadeIn);
+			inOut[f * channels + c] = ClampToInt16(value);
+		}
+	}
+}
+
+void PCMDriftResampler::Reset(int32_t channels)
+{
+	m_channels = std::min(std::max(channels, 1), MAX_CHANNELS);
+	m_readOffset = 0;
+	m_pendingFrames = 0;
+	m_fraction = 0;
+	m_hasCurrent = false;
+	m_needsNext = true;
+	m_playheadTimestamp = 0;
+	m_nextTimestamp = 0;
+}
+
+void PCMDriftResampler::Discard(PCMBlockRing& ring, uint32_t epoch, double timestamp)
+{
+	while (const PCMBlock* block = ring.Front())
+	{
+		if (block->epoch == epoch && block->timestamp + block->duration >= timestamp)
+			break;
+
+		ring.Pop();
+		m_readOffset = 0;
+		m_hasCurrent = false;
+		m_needsNext = true;
+	}
+}
+
+bool PCMDriftResampler::FetchFrame(PCMBlockRing& ring, uint32_t epoch, double maxTimestamp, int32_t sampleRate)
+{
+	for (;;)
+	{
+		const PCMBlock* block = ring.Front();
+		if (!block)
+		{
+			m_pendingFrames = 0;
+			return false;
+		}
+
+		if (block->epoch != epoch || block->sampleCount < m_channels)
+		{
+			ring.Pop();
+			m_readOffset = 0;
+			continue;
+		}
+
+		// Not due yet, held back for audio/video sync
+		if (m_readOffset == 0 && block->timestamp > maxTimestamp)
+		{
+			m_pendingFrames = 0;
+			return false;
+		}
+
+		if (m_readOffset + m_channels > block->sampleCount)
+		{
+			ring.Pop();
+			m_readOffset = 0;
+			continue;
+		}
+
+		for (int32_t c = 0; c < m_channels; ++c)
+		{
+			m_next[c] = block->samples[m_readOffset + c];
+		}
+		m_nextTimestamp = block->timestamp + (double)(m_readOffset / m_channels) / sampleRate;
+		m_readOffset += m_channels;
+		m_pendingFrames = (block->sampleCount - m_readOffset) / m_channels;
+
+		if (m_readOffset >= block->sampleCount)
+		{
+			ring.Pop();
+			m_readOffset = 0;
+		}
+		return true;
+	}
+}
+
+int32_t PCMDriftResampler::Read(PCMBlockRing& ring, uint32_t epoch, double maxTimestamp, double ratio, int32_t sampleRate, int16_t* out, int32_t outFrames)
+{
+	if (m_channels <= 0 || sampleRate <= 0)
+		return 0;
+
+	if (!m_hasCurrent)
+	{
+		if (!FetchFrame(ring, epoch, maxTimestamp, sampleRate))
+			return 0;
+
+		std::copy(m_next, m_next + m_channels, m_current);
+		m_hasCurrent = true;
+		m_needsNext = true;
+		m_fraction = 0;
+	}
+
+	// Interpolation needs the frame after, wait for more rather than play a single frame
+	if (m_needsNext)
+	{
+		if (!FetchFrame(ring, epoch, maxTimestamp, sampleRate))
+			return 0;
+
+		m_needsNext = false;
+	}
+
+	int32_t written = 0;
+	while (written < outFrames)
+	{
+		const float t = (float)std::min(m_fraction, 1.0);
+		for (int32_t c = 0; c < m_channels; ++c)
+		{
+			out[written * m_channels + c] = ClampToInt16(m_current[c] + (m_next[c] - m_current[c]) * t);
+		}
+		++written;
+		m_playheadTimestamp = m_nextTimestamp;
+
+		m_fraction += ratio;
+		bool starved = false;
+		while (m_fraction >= 1.0)
+		{
+			m_fraction -= 1.0;
+			std::copy(m_next, m_next + m_channels, m_current);
+			if (!FetchFrame(ring, epoch, maxTimestamp, sampleRate))
+			{
+				// Resume from the last frame when more arrives
+				m_needsNext = true;
+				starved = true;
+				break;
+			}
+		}
+
+		if (starved)
+			break;
+	}
+
+	return written;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+
+// Interleaved 16 bit PCM in fixed size blocks, written by the network thread and read by the audio render thread
+// without locks. Nothing in here allocates after construction.
+struct PCMBlock
+{
+	static constexpr int32_t MAX_SAMPLES = 4096;
+
+	int64_t frameNum = -1;
+	double timestamp = 0;
+	double duration = 0;
+	// Blocks written before the last reset get skipped by the reader
+	uint32_t epoch = 0;
+	int32_t sampleCount = 0;
+	// Synthesised for a lost packet
+	bool concealed = false;
+	int16_t samples[MAX_SAMPLES];
+};
+
+// Single producer single consumer, wait free on both sides
+class PCMBlockRing
+{
+public:
+	// blockCount is rounded up to a power of two
+	explicit PCMBlockRing(uint32_t blockCount);
+
+	// Producer: a free block to fill, nullptr when full. Only visible to the consumer after CommitWrite()
+	PCMBlock* BeginWrite();
+	void CommitWrite();
+
+	// Consumer: oldest block, nullptr when empty
+	const PCMBlock* Front() const;
+	void Pop();
+
+	// Any thread, a snapshot which may be stale by the time it's used
+	uint32_t GetSize() const;
+	int64_t GetQueuedSamples() const;
+	uint32_t GetCapacity() const
+	{
+		return m_mask + 1;
+	}
+
+private:
+	std::vector<PCMBlock> m_blocks;
+	uint32_t m_mask;
+
+	alignas(64) std::atomic<uint32_t> m_head{ 0 };
+	alignas(64) std::atomic<uint32_t> m_tail{ 0 };
+	alignas(64) std::atomic<int64_t> m_queuedSamples{ 0 };
+};
+
+// Packet loss concealment, run on the network thread when the packet after a gap arrives so none of it lands
+// on the audio render thread. The last good block is repeated, fading out over CONCEAL_FADE_BLOCKS so long
+// gaps end in silence. Gaps of up to CONCEAL_FADE_BLOCKS fade back in towards their end instead, as the packet
+// after them is known to be there. Each seam is crossfaded against the time reversed tail of the block before it.
+namespace PCMConcealment
+{
+	static constexpr int32_t CONCEAL_FADE_BLOCKS = 3;
+	static constexpr int32_t CROSSFADE_FRAMES = 64;
+
+	// Block missingIndex(0 based) of missingCount lost after last. out takes sampleCount samples
+	void Conceal(const int16_t* last, int32_t sampleCount, int32_t channels, int32_t missingIndex, int32_t missingCount, int16_t* out);
+
+	// Blends the start of the first block after a concealed gap in from where the concealment left off
+	void CrossfadeIn(const int16_t* last, int32_t lastSampleCount, int32_t channels, int32_t missingCount, int16_t* inOut, int32_t sampleCount);
+}
+
+// Reads the ring on the audio render thread, linearly resampling by a ratio close to 1 so the amount of
+// buffered audio can be steered against clock drift between the sender and the local audio device
+class PCMDriftResampler
+{
+public:
+	static constexpr int32_t MAX_CHANNELS = 8;
+
+	void Reset(int32_t channels);
+
+	// Pops blocks of other epochs and those ending before timestamp
+	void Discard(PCMBlockRing& ring, uint32_t epoch, double timestamp);
+
+	// Writes up to outFrames frames, taking only blocks which start no later than maxTimestamp. ratio is input
+	// frames per output frame. Returns the frames written, fewer when the ring runs dry
+	int32_t Read(PCMBlockRing& ring, uint32_t epoch, double maxTimestamp, double ratio, int32_t sampleRate, int16_t* out, int32_t outFrames);
+
+	// Timestamp of the audio last written out
+	double GetPlayheadTimestamp() const
+	{
+		return m_playheadTimestamp;
+	}
+
+	// Frames of the block being read which haven't been played yet
+	int32_t GetPendingFrames() const
+	{
+		return m_pendingFrames;
+	}
+
+private:
+	bool FetchFrame(PCMBlockRing& ring, uint32_t epoch, double maxTimestamp, int32_t sampleRate);
+
+	int32_t m_channels = 0;
+	// Read position within the ring's front block, in samples
+	int32_t m_readOffset = 0;
+	int32_t m_pendingFrames = 0;
+	double m_fraction = 0;
+	// m_current holds the frame being played from, m_next the one after unless it still has to be fetched
+	bool m_hasCurrent = false;
+	bool m_needsNext = true;
+	int16_t m_current[MAX_CHANNELS] = {};
+	int16_t m_next[MAX_CHANNELS] = {};
+	double m_nextTimestamp = 0;
+	double m_playheadTimestamp = 0;
+};
@@ -1,13 +1,23 @@
 #include "Realtime/PicoAudioSoundWave.h"
+#include "Realtime/PCMBlockRing.h"
 #include "EvercoastPerfCounter.h"
 
 #include "AudioDevice.h"
 #include "Engine/Engine.h"
 #include <fstream>
 #include <string>
+#include <limits>
 
 DEFINE_LOG_CATEGORY(EvercoastRealtimeAudioLog);
 
+// About 1.3 sec of 20ms stereo 48KHz packets
+static constexpr uint32_t PCM_RING_BLOCK_COUNT = 64;
+// Drift compensation steers the buffered audio towards max(warm up time, this)
+static constexpr double DRIFT_TARGET_MIN_BUFFERED = 0.06;
+// At most +/-0.5% speed change, not audible as pitch
+static constexpr double DRIFT_MAX_RATIO_OFFSET = 0.005;
+static constexpr double DRIFT_RATIO_SMOOTHING = 0.05;
+
 UPicoAudioSoundWave::UPicoAudioSoundWave(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -16,6 +26,9 @@ UPicoAudioSoundWave::UPicoAudioSoundWave(const FObjectInitializer& ObjectInitial
 
 	SampleByteSize = 2;
 
+	m_ring = std::make_unique<PCMBlockRing>(PCM_RING_BLOCK_COUNT);
+	m_resampler = std::make_unique<PCMDriftResampler>();
+
 	VirtualizationMode = EVirtualizationMode::PlayWhenSilent;
 }
 
@@ -44,6 +57,16 @@ void UPicoAudioSoundWave::QueueAudio(double timestamp, uint64 frameNum, const ui
 	uint32 inSampleRate = 0;
 	FMemory::Memcpy(&inSampleRate, headerData + 2, sizeof(uint32));
 
+	// ResetAudio() may have been called from the game thread, start over on this side too
+	const uint32_t epoch = m_epoch.load();
+	if (epoch != m_writerEpoch)
+	{
+		m_writerEpoch = epoch;
+		m_initialised = false;
+		m_lastBlock.clear();
+		m_lastBlockTimestamp = -1;
+	}
+
 	int64_t frameNumDiff = 1;
 	if (!m_initialised)
 	{
@@ -79,52 +102,10 @@ void UPicoAudioSoundWave::QueueAudio(double timestamp, uint64 frameNum, const ui
 
 	m_prevFrameNum = frameNum;
 
-	
-
 	if (frameNumDiff > 0 && frameNumDiff < 10)
 	{
-		double duration = static_cast<double>(pcmDataSize) / (SampleByteSize * NumChannels * SampleRate);
-
-		TArray<uint8> newAudioBuffer;
-		newAudioBuffer.AddUninitialized(pcmDataSize);
-		FMemory::Memcpy(newAudioBuffer.GetData(), pcmData, pcmDataSize);
-
-		AudioSegment newAudioSegment = AudioSegment{
-			(int64_t)frameNum,
-			timestamp,
-			duration,
-			newAudioBuffer
-		};
-
-		float lastReceivedSegmentTimestamp;
-		{
-			std::lock_guard lock(m_mutex);
-
-			// NOTE: Save the last packet and linear interpolate the from the last -> newest packet
-			for (uint32_t i = 0; i < frameNumDiff; ++i)
-			{
-				AudioSegment interpolatedSegment{ -1, -1, -1 };
-				if (InterpolateAudio(newAudioSegment, i, interpolatedSegment))
-				{
-					m_segments.push(interpolatedSegment);
-				}
-				else
-				{
-					// No way to interpolate, has to repeat the latest segment
-					m_segments.push(newAudioSegment);
-				}
-			}
-
-			// Save the last segment
-			m_lastReceivedSegment = newAudioSegment;
-			lastReceivedSegmentTimestamp = newAudioSegment.timestamp;
-		}
-
-		{
-			std::lock_guard lock2(m_stats_mutex);
-			m_lastReceivedAudioTimestamp = lastReceivedSegmentTimestamp;
-		}
-
+		WriteBlocks(timestamp, (int64_t)frameNum, (const int16_t*)pcmData, (int32_t)(pcmDataSize / SampleByteSize), frameNumDiff - 1);
+		m_lastReceivedAudioTimestamp = timestamp;
 	}
 	else if (frameNumDiff >= 10)
 	{
@@ -140,187 +121,166 @@ void UPicoAudioSoundWave::QueueAudio(double timestamp, uint64 frameNum, const ui
 
 }
 
-// Precise method, which guarantees v = v1 when t = 1. This method is monotonic only when v0 * v1 < 0.
-// Lerping between same values might not produce the same value
-static float lerp(float v0, float v1, float t) {
-	return (1 - t) * v0 + t * v1;
-}
-
-UPicoAudioSoundWave::AudioSegment UPicoAudioSoundWave::AudioSegment::lerp(const AudioSegment& v0, float t) const
+void UPicoAudioSoundWave::WriteBlocks(double timestamp, int64_t frameNum, const int16_t* samples, int32_t sampleCount, int64_t missingFrames)
 {
-	AudioSegment out;
-	out.frame_num = (uint64_t)::lerp((float)v0.frame_num, (float)this->frame_num, t);
-	out.timestamp = (double)::lerp((float)v0.timestamp, (float)this->timestamp, t);
-	out.duration = (double)::lerp((float)v0.duration, (float)this->duration, t);
+	const int32_t channels = FMath::Max((int32_t)NumChannels, 1);
+	const uint32_t epoch = m_writerEpoch;
+	// Whole frames per block
+	const int32_t maxBlockSamples = PCMBlock::MAX_SAMPLES / channels * channels;
 
-	int32_t pcmDataCount = ::lerp((float)v0.pcm.Num(), (float)this->pcm.Num(), t);
-	int32_t remainder = pcmDataCount % 2;
-	pcmDataCount -= remainder;
-	check(pcmDataCount % 2 == 0);
-
-	for (int32_t i = 0; i < pcmDataCount; i+= 2)
+	const bool canConceal = missingFrames > 0 && !m_lastBlock.empty() && m_lastBlockTimestamp >= 0;
+	if (canConceal)
 	{
-		int v0_idx = (int)::lerp(0, v0.pcm.Num(), (float)i / pcmDataCount);
-		int v0_idx_remainder = v0_idx % 2;
-		v0_idx -= v0_idx_remainder;
-
-		int v1_idx = (int)::lerp(0, this->pcm.Num(), (float)i / pcmDataCount);
-		int v1_idx_remainder = v1_idx % 2;
-		v1_idx -= v1_idx_remainder;
-
-		if (v0_idx + 1 >= v0.pcm.Num() || v1_idx + 1 >= this->pcm.Num())
+		// Evenly spaced between the last packet and this one
+		const double interval = (timestamp - m_lastBlockTimestamp) / (missingFrames + 1);
+		const int32_t lastSampleCount = (int32_t)m_lastBlock.size();
+		for (int64_t i = 0; i < missingFrames; ++i)
 		{
-			continue;
-		}
-
-		int16_t v0_val = v0.pcm[v0_idx] + (v0.pcm[v0_idx + 1] << 8);
-		int16_t v1_val = this->pcm[v1_idx] + (this->pcm[v1_idx + 1] << 8);
+			PCMBlock* block = m_ring->BeginWrite();
+			if (!block)
+			{
+				m_overflowBlockCount++;
+				break;
+			}
 
-		int16_t interpolated_val = ::lerp(v0_val, v1_val, t);
-		out.pcm.Add(interpolated_val & 0xff);
-		out.pcm.Add(interpolated_val >> 8);
+			PCMConcealment::Conceal(m_lastBlock.data(), lastSampleCount, channels, (int32_t)i, (int32_t)missingFrames, block->samples);
+			block->frameNum = frameNum - missingFrames + i;
+			block->timestamp = m_lastBlockTimestamp + interval * (i + 1);
+			block->duration = (double)lastSampleCount / (channels * SampleRate);
+			block->epoch = epoch;
+			block->sampleCount = lastSampleCount;
+			block->concealed = true;
+			m_ring->CommitWrite();
+			m_concealedBlockCount++;
+		}
 	}
-	return out;
-}
 
-bool UPicoAudioSoundWave::InterpolateAudio(const AudioSegment& newSegment, int interpolatingFrame, AudioSegment& out)
-{
-	if (m_lastReceivedSegment.frame_num >= 0 && m_lastReceivedSegment.duration > 0)
+	bool first = true;
+	for (int32_t offset = 0; offset < sampleCount; offset += maxBlockSamples)
 	{
-		int totalFrameDiff = newSegment.frame_num - m_lastReceivedSegment.frame_num;
-		if (totalFrameDiff == 1)
+		const int32_t count = FMath::Min(maxBlockSamples, sampleCount - offset);
+		PCMBlock* block = m_ring->BeginWrite();
+		if (!block)
 		{
-			// shortcut, no need to interpolate
-			out = newSegment;
-			return true;
+			// The audio thread isn't taking any, e.g. not playing yet
+			m_overflowBlockCount++;
+			UE_LOG(EvercoastRealtimeAudioLog, Verbose, TEXT("Audio ring full, dropped audio of frame %" PRId64), frameNum);
+			break;
 		}
-		double t = (double)(interpolatingFrame + 1) / totalFrameDiff;
 
-		out = newSegment.lerp(m_lastReceivedSegment, t);
-		return true;
-	}
-
-
-	// invalid base
-	return false;
-}
-
-void UPicoAudioSoundWave::PumpQueuedAudio()
-{
-	double lastAudioBufferTimestamp = 0;
-	bool hasPumpedAudio = false;
-
-	{
-		std::lock_guard lock(m_mutex);
-		while (!m_segments.empty())
+		FMemory::Memcpy(block->samples, samples + offset, count * sizeof(int16_t));
+		if (first && canConceal)
 		{
-			const AudioSegment& segment = m_segments.front();
-
-			// Once the audio buffer delay is set to a positive value, the audio/geom difference should quickly converge to almost zero,
-			// because the audio timestamp is calculated from actually bits fed to audio PCM buffer. There's no enough audio buffer, the 
-			// audio timestmap won't progress. There seems no need to put m_audioBufferPumpDelay into the equation
-			if (m_audioBufferPumpDelay > 0 && segment.timestamp /* + segment.duration*/ > m_currVideoSyncingExtrapolatedTimestamp)// + m_audioBufferPumpDelay)
-			{
-				break;
-			}
-
-			m_audioBuffer.Append(m_segments.front().pcm);
-
-			lastAudioBufferTimestamp = m_segments.front().timestamp;
-			hasPumpedAudio = true;
-
-			m_segments.pop();
+			PCMConcealment::CrossfadeIn(m_lastBlock.data(), (int32_t)m_lastBlock.size(), channels, (int32_t)missingFrames, block->samples, count);
 		}
-	}
 
-	if (hasPumpedAudio)
-	{
-		std::lock_guard lock(m_stats_mutex);
-		m_lastAudioBufferTimestamp = lastAudioBufferTimestamp;
+		block->frameNum = frameNum;
+		block->timestamp = timestamp + (double)(offset / channels) / SampleRate;
+		block->duration = (double)count / (channels * SampleRate);
+		block->epoch = epoch;
+		block->sampleCount = count;
+		block->concealed = false;
+		m_ring->CommitWrite();
+		first = false;
 	}
+
+	// Keep the tail, concealment repeats at most one block
+	const int32_t keepCount = FMath::Min(sampleCount, maxBlockSamples);
+	m_lastBlock.assign(samples + sampleCount - keepCount, samples + sampleCount);
+	m_lastBlockTimestamp = timestamp;
 }
 
 int32 UPicoAudioSoundWave::GeneratePCMData(uint8* PCMData, const int32 SamplesNeeded)
 {
+	const uint32_t epoch = m_epoch.load();
+	const int32 channels = FMath::Clamp<int32>(NumChannels, 1, PCMDriftResampler::MAX_CHANNELS);
+
 	// Check if we've been told to reset our audio buffer
-	if (bReset)
+	if (bReset || channels != m_resamplerChannels)
 	{
 		bReset = false;
-		m_audioBuffer.Reset();
+		m_resampler->Reset(channels);
+		m_resamplerChannels = channels;
+		m_driftRatio = 1.0;
+		m_pendingResampleFrames = 0;
 	}
 
-	
 	if (m_hasInitialSynced)
 	{
-		PumpQueuedAudio();
-
-		Audio::EAudioMixerStreamDataFormat::Type Format = GetGeneratedPCMDataFormat();
-		SampleByteSize = (Format == Audio::EAudioMixerStreamDataFormat::Int16) ? 2 : 4;
-
-		int32 SamplesAvailable = m_audioBuffer.Num() / SampleByteSize;
-
-		// Wait until we have enough samples that are requested before starting.
-		if (SamplesAvailable > 0)
+		// Video is behind, hold back audio that's ahead of it
+		const bool gated = m_audioBufferPumpDelay > 0;
+		const double maxTimestamp = gated ? m_currVideoSyncingExtrapolatedTimestamp.load() : std::numeric_limits<double>::infinity();
+		UpdateDriftRatio(gated);
+
+		const int32 framesNeeded = SamplesNeeded / channels;
+		const int32 framesWritten = m_resampler->Read(*m_ring, epoch, maxTimestamp, m_driftRatio, SampleRate, (int16_t*)PCMData, framesNeeded);
+		const int32 samplesWritten = framesWritten * channels;
+		if (samplesWritten < SamplesNeeded)
 		{
-			const int32 SamplesToCopy = FMath::Min<int32>(SamplesNeeded, SamplesAvailable);
-			const int32 BytesToCopy = SamplesToCopy * SampleByteSize;
-
-			if (SamplesAvailable < SamplesNeeded)
-			{
-				UE_LOG(EvercoastRealtimeAudioLog, Warning, TEXT("Audio buffer left over elements: %d PCM buffer needs: %d. Will fill the rest with 0s"), m_audioBuffer.Num(), SamplesNeeded * SampleByteSize);
-			}
-			
-			FMemory::Memcpy((void*)PCMData, &m_audioBuffer[0], BytesToCopy);
-			m_audioBuffer.RemoveAt(0, BytesToCopy, false);
-
-			if (SamplesAvailable < SamplesNeeded)
+			// Fill the rest with zeros
+			FMemory::Memzero(PCMData + samplesWritten * SampleByteSize, (SamplesNeeded - samplesWritten) * SampleByteSize);
+			if (!gated)
 			{
-				// Fill the reset with zeros
-				FMemory::Memzero(PCMData + BytesToCopy, (SamplesNeeded - SamplesToCopy) * SampleByteSize);
+				m_underrunCount++;
+				UE_LOG(EvercoastRealtimeAudioLog, Verbose, TEXT("Audio buffer starving, filled %d of %d samples with 0s"), SamplesNeeded - samplesWritten, SamplesNeeded);
 			}
+		}
 
-			//check(BytesToCopy + (SamplesNeeded - SamplesToCopy) * SampleByteSize == SamplesNeeded * SampleByteSize);
+		if (framesWritten > 0)
+		{
+			// This should be the last sample sent to the hardware(or the lowest level of abstraction we can get) audio buffer
+			m_lastPCMGenerationFedTimestamp = m_resampler->GetPlayheadTimestamp();
+		}
+		m_pendingResampleFrames = m_resampler->GetPendingFrames();
 
-			{
-				// update this important matrics needs lock
-				std::lock_guard lock(m_stats_mutex);
+		// Should return the bytes written not the samples!
+		return SamplesNeeded * SampleByteSize;
+	}
 
-				// This should be the last sample sent to the hardware(or the lowest level of abstraction we can get) audio buffer
-				const int SamplesLeft = SamplesAvailable - SamplesToCopy;
-				m_lastPCMGenerationFedTimestamp = m_lastAudioBufferTimestamp - ((double)SamplesLeft / (NumChannels * SampleRate));
-			}
+	// Drop whatever was queued before the last reset
+	m_resampler->Discard(*m_ring, epoch, -std::numeric_limits<double>::infinity());
 
-			// Should return the bytes written not the samples!
-			return SamplesNeeded * SampleByteSize;
-		}
-		else
+	if (!m_isReady)
+	{
+		// Warm up, or as much as the ring holds when the warm up time is longer than that
+		if (SampleRate > 0 && (m_ring->GetQueuedSamples() >= (int64_t)(m_warmupTime * channels * SampleRate) || m_ring->GetSize() >= m_ring->GetCapacity()))
 		{
-			UE_LOG(EvercoastRealtimeAudioLog, Warning, TEXT("Zero available samples. Audio buffer starving. Will fill with 0s"));
-
-			// Fill the reset with zeros
-			int32 ActualCopiedSize = SamplesNeeded * SampleByteSize;
-			FMemory::Memzero(PCMData, ActualCopiedSize);
-
-			return ActualCopiedSize;
+			m_isReady = true;
 		}
-	} 
-	else if(!m_isReady)
+	}
+	else
 	{
-		Audio::EAudioMixerStreamDataFormat::Type Format = GetGeneratedPCMDataFormat();
-		SampleByteSize = (Format == Audio::EAudioMixerStreamDataFormat::Int16) ? 2 : 4;
-
-		// Warm up
-		PumpQueuedAudio();
-
-		if (m_audioBuffer.Num() >= (int32)(m_warmupTime * NumChannels * SampleRate * SampleByteSize))
+		// Sync() asked for a timestamp, drop the audio before it and start playing once there's some left
+		const double syncTimestamp = m_syncRequestTimestamp.load();
+		if (syncTimestamp >= 0)
 		{
-			m_isReady = true;
+			m_resampler->Discard(*m_ring, epoch, syncTimestamp);
+			if (m_ring->GetSize() > 0 && syncTimestamp >= m_initialTimestamp)
+			{
+				m_hasInitialSynced = true;
+			}
 		}
 	}
 
 	return 0;
 }
 
+void UPicoAudioSoundWave::UpdateDriftRatio(bool gated)
+{
+	double targetRatio = 1.0;
+	if (!gated && SampleRate > 0)
+	{
+		// Play slightly faster when more than the target is buffered and slower when less, so the sender's and
+		// the audio device's clocks drifting apart don't end up in underruns or ever growing latency
+		const double buffered = (double)m_ring->GetQueuedSamples() / (m_resamplerChannels * SampleRate);
+		const double target = FMath::Max((double)m_warmupTime, DRIFT_TARGET_MIN_BUFFERED);
+		const double error = FMath::Clamp((buffered - target) / target, -1.0, 1.0);
+		targetRatio = 1.0 + DRIFT_MAX_RATIO_OFFSET * error;
+	}
+
+	m_driftRatio += (targetRatio - m_driftRatio) * DRIFT_RATIO_SMOOTHING;
+}
+
 void UPicoAudioSoundWave::Tick(float DeltaTime)
 {
 	if (!m_isReady)
@@ -330,7 +290,7 @@ void UPicoAudioSoundWave::Tick(float DeltaTime)
 
 	if (m_hasInitialSynced)
 	{
-		m_currVideoSyncingExtrapolatedTimestamp += DeltaTime;
+		m_currVideoSyncingExtrapolatedTimestamp = m_currVideoSyncingExtrapolatedTimestamp.load() + DeltaTime;
 	}
 }
 
@@ -350,50 +310,35 @@ void UPicoAudioSoundWave::Sync(double timestamp)
 		return;
 	}
 
-	std::lock_guard lock(m_mutex);
-	while (!m_segments.empty())
-	{
-		const auto& entry = m_segments.front();
-		if (timestamp > (entry.timestamp + entry.duration))
-		{
-			UE_LOG(EvercoastRealtimeAudioLog, Log, TEXT("Discard sound during Sync(): %.3f > (%.3f + %.3f)"), timestamp, entry.timestamp, entry.duration);
-			m_segments.pop();
-		}
-		else
-		{
-			break;
-		}
-	}
-
-	if (!m_segments.empty() && timestamp >= m_initialTimestamp)
-	{
-		m_hasInitialSynced = true;
-	}
+	// Audio thread drops the audio before it and finishes the initial sync
+	m_syncRequestTimestamp = timestamp;
 }
 
 void UPicoAudioSoundWave::ResetAudio()
 {
+	if (m_underrunCount > 0 || m_concealedBlockCount > 0 || m_overflowBlockCount > 0)
 	{
-		std::lock_guard lock(m_mutex);
-		m_hasInitialSynced = false;
-		m_audioBufferPumpDelay = 0;
-		m_currVideoSyncingExtrapolatedTimestamp = 0;
-		m_segments = std::queue<AudioSegment>();
-		m_lastReceivedSegment = AudioSegment{ -1, -1, -1 };
-		m_initialTimestamp = 0;
-		m_audioBuffer.Reset();
-
-		m_initialised = false;
-		m_isReady = false;
-		bReset = true;
+		UE_LOG(EvercoastRealtimeAudioLog, Log, TEXT("Audio reset. Underruns: %llu concealed blocks: %llu dropped blocks: %llu"),
+			(unsigned long long)m_underrunCount.load(), (unsigned long long)m_concealedBlockCount.load(), (unsigned long long)m_overflowBlockCount.load());
 	}
 
-	{
-		std::lock_guard lock(m_stats_mutex);
-		m_lastAudioBufferTimestamp = 0;
-		m_lastPCMGenerationFedTimestamp = 0;
-		m_lastReceivedAudioTimestamp = 0;
-	}
+	// Blocks already in the ring get dropped by the audio thread as they're of an older epoch
+	m_epoch++;
+	bReset = true;
+
+	m_hasInitialSynced = false;
+	m_isReady = false;
+	m_audioBufferPumpDelay = 0;
+	m_currVideoSyncingExtrapolatedTimestamp = 0;
+	m_syncRequestTimestamp = -1;
+	m_initialTimestamp = 0;
+
+	m_lastPCMGenerationFedTimestamp = 0;
+	m_lastReceivedAudioTimestamp = 0;
+	m_pendingResampleFrames = 0;
+	m_underrunCount = 0;
+	m_concealedBlockCount = 0;
+	m_overflowBlockCount = 0;
 }
 
 int32 UPicoAudioSoundWave::GetResourceSizeForFormat(FName Format)
@@ -449,15 +394,11 @@ bool UPicoAudioSoundWave::InitAudioResource(FName Format)
 
 double UPicoAudioSoundWave::GetLastFedPCMTimestamp() const
 {
-	std::lock_guard lock(m_stats_mutex);
-
 	return m_lastPCMGenerationFedTimestamp;
 }
 
 double UPicoAudioSoundWave::GetLastReceivedPCMTimestamp() const
 {
-	std::lock_guard lock(m_stats_mutex);
-
 	return m_lastReceivedAudioTimestamp;
 }
 
@@ -469,8 +410,6 @@ void UPicoAudioSoundWave::SetMissingFrameCounter(std::shared_ptr<EvercoastPerfCo
 
 void UPicoAudioSoundWave::SetAudioBufferDelay(double delayInSeconds)
 {
-	std::lock_guard lock(m_mutex);
-
 	m_audioBufferPumpDelay = delayInSeconds;
 }
 
@@ -482,21 +421,22 @@ void UPicoAudioSoundWave::SetWarmupTime(float warmupTime)
 
 float UPicoAudioSoundWave::GetCachedAudioTime() const
 {
-	std::lock_guard lock(m_mutex);
-
-	if(!m_segments.empty())
+	if (NumChannels <= 0 || SampleRate <= 0)
 	{
-		// Assume every segments have the same duration
-		return m_segments.front().duration * m_segments.size();
+		return 0.0f;
 	}
 
-	return 0.0f;
+	return (float)m_ring->GetQueuedSamples() / (float)(NumChannels * SampleRate);
 }
 
 
 float UPicoAudioSoundWave::GetSecondaryCachedAudioTime() const
 {
-	std::lock_guard lock(m_mutex);
+	if (SampleRate <= 0)
+	{
+		return 0.0f;
+	}
 
-	return (float)m_audioBuffer.Num() / (float)(NumChannels * SampleRate * SampleByteSize);
+	// Read out of the ring already but not resampled yet
+	return (float)m_pendingResampleFrames / (float)SampleRate;
 }
@@ -31,6 +31,7 @@ ServerPort(6655),
 AutoConnect(true),
 DebugLogging(false),
 IgnoreAudio(false),
+JitterBufferLatency(0.05f),
 m_audioComponent(nullptr),
 m_sound(nullptr),
 m_SampledFrameNumStart(0),
@@ -492,12 +493,12 @@ std::shared_ptr<IEvercoastRealtimeDataDecoder> UPicoQuicStreamingReaderComp::Cre
 {
 	if (stream_type == 0x304D4345) // "ECM0"
 	{
-		m_dataDecoder = std::make_shared<EvercoastRealtimeStreamingCortoDecoder>(m_dataDecodingCounter);
+		m_dataDecoder = std::make_shared<EvercoastRealtimeStreamingCortoDecoder>(m_dataDecodingCounter, JitterBufferLatency);
 		m_decoderType = DT_CortoMesh;
 	}
 	else if (stream_type == 0x30564345) // "ECV0"
 	{
-		m_dataDecoder = std::make_shared<EvercoastRealtimeStreamingVoxelDecoder>(m_dataDecodingCounter);
+		m_dataDecoder = std::make_shared<EvercoastRealtimeStreamingVoxelDecoder>(m_dataDecodingCounter, JitterBufferLatency);
 		m_decoderType = DT_EvercoastVoxel;
 	}
 	else
@@ -652,6 +653,11 @@ float UPicoQuicStreamingReaderComp::GetVideoLaggingTime()
 	return (float)m_videoLaggingCounter->GetSampleAverageDoubleOnCount();
 }
 
+float UPicoQuicStreamingReaderComp::GetVideoLaggingTimePercentile(float percentile)
+{
+	return (float)m_videoLaggingCounter->GetSamplePercentile(percentile);
+}
+
 float UPicoQuicStreamingReaderComp::GetActualVideoBehindAudioTime()
 {
 	return (float)m_videoBehindAudioCounter->GetSampleAverageDoubleOnCount();
@@ -0,0 +1,338 @@
+#include "Realtime/RealtimeCapture.h"
+#include <algorithm>
+#include <cstring>
+
+// Anything bigger is a corrupt record rather than a frame
+static constexpr uint64_t MAX_RECORD_DATA_SIZE = 256ull * 1024 * 1024;
+
+RealtimeCaptureWriter::~RealtimeCaptureWriter()
+{
+	Close();
+}
+
+bool RealtimeCaptureWriter::Open(const std::string& path, std::string& outError)
+{
+	Close();
+
+	m_file.open(path, std::ofstream::binary | std::ofstream::trunc);
+	if (!m_file.is_open())
+	{
+		outError = "Cannot open " + path + " for writing";
+		return false;
+	}
+
+	RealtimeCaptureFileHeader header;
+	m_file.write((const char*)&header, sizeof(header));
+	m_firstArrivalTime = -1;
+	m_framesWritten = 0;
+	return m_file.good();
+}
+
+void RealtimeCaptureWriter::Close()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+}
+
+bool RealtimeCaptureWriter::Write(int connection, double arrivalTime, uint64_t frameNumber, uint64_t timestamp, uint64_t typeAndFlags,
+	const uint8_t* data, uint64_t dataSize, const uint8_t* userData, uint64_t userDataSize)
+{
+	if (!m_file.is_open())
+		return false;
+
+	if (m_firstArrivalTime < 0)
+	{
+		m_firstArrivalTime = arrivalTime;
+	}
+
+	RealtimeCaptureRecordHeader record;
+	record.connection = (uint8_t)connection;
+	record.arrivalTimeUs = (uint64_t)(std::max(arrivalTime - m_firstArrivalTime, 0.0) * 1000000.0);
+	record.frameNumber = frameNumber;
+	record.timestamp = timestamp;
+	record.typeAndFlags = typeAndFlags;
+	record.dataSize = data ? dataSize : 0;
+	record.userDataSize = userData ? userDataSize : 0;
+
+	m_file.write((const char*)&record, sizeof(record));
+	if (record.userDataSize > 0)
+		m_file.write((const char*)userData, (std::streamsize)record.userDataSize);
+	if (record.dataSize > 0)
+		m_file.write((const char*)data, (std::streamsize)record.dataSize);
+
+	if (!m_file.good())
+	{
+		// Disk full or similar, stop rather than leave a half written record in the middle
+		Close();
+		return false;
+	}
+
+	m_framesWritten++;
+	return true;
+}
+
+RealtimeCaptureReplayer::~RealtimeCaptureReplayer()
+{
+	Close();
+}
+
+bool RealtimeCaptureReplayer::Open(const std::string& path, const Options& options, std::string& outError)
+{
+	Close();
+
+	m_file.open(path, std::ifstream::binary);
+	if (!m_file.is_open())
+	{
+		outError = "Cannot open " + path;
+		return false;
+	}
+
+	RealtimeCaptureFileHeader header;
+	const RealtimeCaptureFileHeader expected;
+	m_file.read((char*)&header, sizeof(header));
+	if (!m_file.good() || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0)
+	{
+		outError = path + " is not a realtime capture";
+		Close();
+		return false;
+	}
+
+	if (header.version != expected.version)
+	{
+		outError = path + " has unsupported capture version " + std::to_string(header.version);
+		Close();
+		return false;
+	}
+
+	m_firstRecordOffset = (std::streamoff)m_file.tellg();
+
+	m_options = options;
+	m_options.timeScale = std::max(m_options.timeScale, 0.01);
+	m_options.lossRate = std::min(std::max(m_options.lossRate, 0.0), 1.0);
+	m_options.maxLossBurst = std::max(m_options.maxLossBurst, 1);
+	m_options.maxJitter = std::max(m_options.maxJitter, 0.0);
+	m_random.seed(m_options.seed);
+
+	m_endOfCapture = false;
+	m_started = false;
+	m_startTime = 0;
+	m_passStartTime = 0;
+	m_passLastArrival = 0;
+	m_passRecordCount = 0;
+	m_readAheadTime = 0;
+	for (auto& state : m_connections)
+	{
+		state = ConnectionState();
+	}
+	m_stats = Stats();
+	return true;
+}
+
+void RealtimeCaptureReplayer::Close()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+	m_file.clear();
+
+	for (auto& state : m_connections)
+	{
+		state.pending.clear();
+	}
+	m_endOfCapture = true;
+}
+
+bool RealtimeCaptureReplayer::ReadRecord(RealtimeCaptureFrame& outFrame)
+{
+	RealtimeCaptureRecordHeader record;
+	m_file.read((char*)&record, sizeof(record));
+	if (!m_file.good())
+		return false;
+
+	if (record.connection >= MAX_CONNECTIONS || record.dataSize > MAX_RECORD_DATA_SIZE || record.userDataSize > MAX_RECORD_DATA_SIZE)
+		return false;
+
+	outFrame.connection = record.connection;
+	outFrame.arrivalTime = record.arrivalTimeUs / 1000000.0;
+	outFrame.frameNumber = record.frameNumber;
+	outFrame.timestamp = record.timestamp;
+	outFrame.typeAndFlags = record.typeAndFlags;
+	outFrame.userData.resize((size_t)record.userDataSize);
+	outFrame.data.resize((size_t)record.dataSize);
+	if (record.userDataSize > 0)
+		m_file.read((char*)outFrame.userData.data(), (std::streamsize)record.userDataSize);
+	if (record.dataSize > 0)
+		m_file.read((char*)outFrame.data.data(), (std::streamsize)record.dataSize);
+
+	// Truncated at the end, e.g. the recording was killed
+	return m_file.good();
+}
+
+void RealtimeCaptureReplayer::Rewind()
+{
+	// Carry on right after the last pass, a record interval later, with numbering continuing past it so the
+	// receiving side sees one long stream rather than a restart
+	const double interval = m_passRecordCount > 1 ? m_passLastArrival / (m_passRecordCount - 1) : 0.0;
+	m_passStartTime += (m_passLastArrival + interval) * m_options.timeScale;
+	m_passLastArrival = 0;
+	m_passRecordCount = 0;
+
+	for (auto& state : m_connections)
+	{
+		if (state.passFrameCount > 0)
+		{
+			const uint64_t frameRange = state.lastFrameNumber - state.firstFrameNumber;
+			const uint64_t timestampRange = state.lastTimestamp - state.firstTimestamp;
+			state.frameNumberOffset += frameRange + 1;
+			state.timestampOffset += timestampRange + (state.passFrameCount > 1 ? timestampRange / (state.passFrameCount - 1) : 0);
+		}
+		state.passFrameCount = 0;
+	}
+
+	m_file.clear();
+	m_file.seekg(m_firstRecordOffset);
+	m_stats.Loops++;
+}
+
+void RealtimeCaptureReplayer::Fill(double playbackTime)
+{
+	while (!m_endOfCapture && m_readAheadTime <= playbackTime + m_options.maxJitter)
+	{
+		RealtimeCaptureFrame frame;
+		if (!ReadRecord(frame))
+		{
+			if (m_options.loop && m_passRecordCount > 0)
+			{
+				Rewind();
+				continue;
+			}
+
+			m_endOfCapture = true;
+			break;
+		}
+
+		m_stats.Read++;
+		m_passRecordCount++;
+		m_passLastArrival = frame.arrivalTime;
+		m_readAheadTime = m_passStartTime + frame.arrivalTime * m_options.timeScale;
+
+		ConnectionState& state = m_connections[frame.connection];
+		if (state.passFrameCount == 0)
+		{
+			state.firstFrameNumber = state.lastFrameNumber = frame.frameNumber;
+			state.firstTimestamp = state.lastTimestamp = frame.timestamp;
+		}
+		else
+		{
+			state.lastFrameNumber = std::max(state.lastFrameNumber, frame.frameNumber);
+			state.lastTimestamp = std::max(state.lastTimestamp, frame.timestamp);
+		}
+		state.passFrameCount++;
+
+		if (state.lossRemaining > 0)
+		{
+			state.lossRemaining--;
+			m_stats.Dropped++;
+			continue;
+		}
+
+		if (m_options.lossRate > 0 && std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < m_options.lossRate)
+		{
+			state.lossRemaining = std::uniform_int_distribution<int>(1, m_options.maxLossBurst)(m_random) - 1;
+			m_stats.Dropped++;
+			continue;
+		}
+
+		frame.frameNumber += state.frameNumberOffset;
+		frame.timestamp += state.timestampOffset;
+
+		double releaseTime = m_readAheadTime;
+		if (m_options.maxJitter > 0)
+		{
+			releaseTime += std::uniform_real_distribution<double>(0.0, m_options.maxJitter)(m_random);
+		}
+
+		// multimap keeps insertion order for equal keys, so frames without jitter come out as recorded
+		state.pending.emplace(releaseTime, std::move(frame));
+	}
+}
+
+bool RealtimeCaptureReplayer::Pop(int connection, double now, RealtimeCaptureFrame& outFrame)
+{
+	if (connection < 0 || connection >= MAX_CONNECTIONS)
+		return false;
+
+	if (!m_started)
+	{
+		m_started = true;
+		m_startTime = now;
+	}
+
+	const double playbackTime = now - m_startTime;
+	Fill(playbackTime);
+
+	ConnectionState& state = m_connections[connection];
+	if (state.pending.empty() || state.pending.begin()->first > playbackTime)
+		return false;
+
+	auto head = state.pending.begin();
+	outFrame = std::move(head->second);
+	state.pending.erase(head);
+
+	if (state.hasDelivered && outFrame.frameNumber < state.lastDeliveredFrameNumber)
+	{
+		m_stats.Reordered++;
+	}
+	else
+	{
+		state.lastDeliveredFrameNumber = outFrame.frameNumber;
+		state.hasDelivered = true;
+	}
+	m_stats.Delivered++;
+	return true;
+}
+
+double RealtimeCaptureReplayer::GetTimeUntilNextFrame(double now)
+{
+	if (!m_started)
+		return 0.0;
+
+	const double playbackTime = now - m_startTime;
+	Fill(playbackTime);
+
+	double nextTime = -1.0;
+	for (const auto& state : m_connections)
+	{
+		if (!state.pending.empty() && (nextTime < 0 || state.pending.begin()->first < nextTime))
+		{
+			nextTime = state.pending.begin()->first;
+		}
+	}
+
+	// Nothing held, the next unread record is due no earlier than the last one read
+	if (!m_endOfCapture && (nextTime < 0 || m_readAheadTime < nextTime))
+	{
+		nextTime = m_readAheadTime;
+	}
+
+	if (nextTime < 0)
+		return -1.0;
+
+	return std::max(nextTime - playbackTime, 0.0);
+}
+
+bool RealtimeCaptureReplayer::IsFinished() const
+{
+	if (!m_endOfCapture)
+		return false;
+
+	for (const auto& state : m_connections)
+	{
+		if (!state.pending.empty())
+			return false;
+	}
+	return true;
+}
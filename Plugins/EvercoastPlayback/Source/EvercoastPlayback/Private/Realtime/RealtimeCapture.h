@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <random>
+
+// Recording of the frames received over the realtime VCI connections, geometry and audio interleaved in arrival
+// order. Frame data is kept exactly as received, so RealtimePacketHeader/RealtimeMeshingPacketHeaderV1 framing
+// and the audio user data header go through untouched. Little endian, as written by the recorder.
+//
+// File: RealtimeCaptureFileHeader, then for each frame RealtimeCaptureRecordHeader, user data, data.
+#pragma pack(push)
+#pragma pack(1)
+struct RealtimeCaptureFileHeader
+{
+	char magic[8] = { 'E', 'C', 'R', 'T', 'C', 'A', 'P', 0 };
+	uint32_t version = 1;
+	uint32_t reserved = 0;
+};
+
+struct RealtimeCaptureRecordHeader
+{
+	// Index of the connection received on, 0 geometry 1 audio
+	uint8_t connection = 0;
+	uint8_t reserved[7] = {};
+	// Microseconds since the first recorded frame
+	uint64_t arrivalTimeUs = 0;
+	uint64_t frameNumber = 0;
+	// Sender's timestamp in microseconds
+	uint64_t timestamp = 0;
+	uint64_t typeAndFlags = 0;
+	uint64_t dataSize = 0;
+	uint64_t userDataSize = 0;
+};
+#pragma pack(pop)
+
+struct RealtimeCaptureFrame
+{
+	int connection = 0;
+	double arrivalTime = 0;
+	uint64_t frameNumber = 0;
+	uint64_t timestamp = 0;
+	uint64_t typeAndFlags = 0;
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> userData;
+};
+
+class RealtimeCaptureWriter
+{
+public:
+	~RealtimeCaptureWriter();
+
+	bool Open(const std::string& path, std::string& outError);
+	void Close();
+	bool IsOpen() const
+	{
+		return m_file.is_open();
+	}
+
+	// arrivalTime in seconds on any clock, stored relative to the first frame written
+	bool Write(int connection, double arrivalTime, uint64_t frameNumber, uint64_t timestamp, uint64_t typeAndFlags,
+		const uint8_t* data, uint64_t dataSize, const uint8_t* userData, uint64_t userDataSize);
+
+	uint64_t GetFramesWritten() const
+	{
+		return m_framesWritten;
+	}
+
+private:
+	std::ofstream m_file;
+	double m_firstArrivalTime = -1;
+	uint64_t m_framesWritten = 0;
+};
+
+// Plays a capture back with the frames coming out of Pop() at their recorded arrival times, optionally scaled,
+// with packets dropped in bursts and delivery jittered to simulate a bad network. Jitter larger than the frame
+// interval reorders frames, as it would on the wire. Frames are streamed off disk, only those due within the
+// jitter window are held. Not thread safe.
+class RealtimeCaptureReplayer
+{
+public:
+	static constexpr int MAX_CONNECTIONS = 2;
+
+	struct Options
+	{
+		// 2 plays at half speed, 0.5 double speed
+		double timeScale = 1.0;
+		// Chance of a loss burst starting at each frame
+		double lossRate = 0.0;
+		// Each burst drops between 1 and this many consecutive frames of a connection
+		int maxLossBurst = 1;
+		// Each frame is delayed by a uniformly random amount up to this, in seconds
+		double maxJitter = 0.0;
+		// Start over at the end, frame numbers and timestamps carry on increasing
+		bool loop = false;
+		uint32_t seed = 0;
+	};
+
+	struct Stats
+	{
+		uint64_t Read = 0;
+		uint64_t Delivered = 0;
+		uint64_t Dropped = 0;
+		// Delivered after a frame of a higher number on the same connection
+		uint64_t Reordered = 0;
+		uint64_t Loops = 0;
+	};
+
+	~RealtimeCaptureReplayer();
+
+	bool Open(const std::string& path, const Options& options, std::string& outError);
+	void Close();
+
+	// The next frame of the connection due at now(seconds, any clock, the first call starts the playback)
+	bool Pop(int connection, double now, RealtimeCaptureFrame& outFrame);
+
+	// Seconds till a frame is due on any connection, negative when nothing is left
+	double GetTimeUntilNextFrame(double now);
+
+	// All frames played, never when looping
+	bool IsFinished() const;
+
+	const Stats& GetStats() const
+	{
+		return m_stats;
+	}
+
+private:
+	struct ConnectionState
+	{
+		std::multimap<double, RealtimeCaptureFrame> pending;
+		int lossRemaining = 0;
+		uint64_t lastDeliveredFrameNumber = 0;
+		bool hasDelivered = false;
+
+		// Offsets applied on each loop, and the range seen in the pass being read
+		uint64_t frameNumberOffset = 0;
+		uint64_t timestampOffset = 0;
+		uint64_t firstFrameNumber = 0;
+		uint64_t lastFrameNumber = 0;
+		uint64_t firstTimestamp = 0;
+		uint64_t lastTimestamp = 0;
+		uint64_t passFrameCount = 0;
+	};
+
+	// Reads ahead until every frame that could be due before now(playback time) plus the jitter window is held
+	void Fill(double playbackTime);
+	bool ReadRecord(RealtimeCaptureFrame& outFrame);
+	void Rewind();
+
+	std::ifstream m_file;
+	std::streamoff m_firstRecordOffset = 0;
+	Options m_options;
+	std::mt19937 m_random;
+	bool m_endOfCapture = false;
+	bool m_started = false;
+	double m_startTime = 0;
+	// Playback time the pass being read started at, and the last arrival time read in it
+	double m_passStartTime = 0;
+	double m_passLastArrival = 0;
+	uint64_t m_passRecordCount = 0;
+	// Arrival time of the record read last, with time scale and pass start applied
+	double m_readAheadTime = 0;
+
+	ConnectionState m_connections[MAX_CONNECTIONS];
+	Stats m_stats;
+};
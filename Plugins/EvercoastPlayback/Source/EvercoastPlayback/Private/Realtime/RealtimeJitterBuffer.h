@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <algorithm>
+
+// Orders realtime packets by frame number and holds each for a target latency after it arrived, so a packet
+// overtaken on the wire can still slot in before it's released. With no latency packets pass straight through
+// in frame order. Times are seconds on whatever clock the caller uses. Not thread safe, guard it outside.
+template<typename PacketType>
+class RealtimeJitterBuffer
+{
+public:
+	struct Stats
+	{
+		uint64_t Received = 0;
+		uint64_t Released = 0;
+		// Arrived after a later frame was released already
+		uint64_t Late = 0;
+		uint64_t Duplicate = 0;
+		// Oldest packets dropped as the buffer ran over capacity
+		uint64_t Overflow = 0;
+		// Frame numbers skipped over as they never arrived in time
+		uint64_t Lost = 0;
+	};
+
+	RealtimeJitterBuffer(double targetLatency, size_t capacity) :
+		m_targetLatency(std::max(targetLatency, 0.0)), m_capacity(std::max(capacity, (size_t)1))
+	{
+	}
+
+	void SetTargetLatency(double targetLatency)
+	{
+		m_targetLatency = std::max(targetLatency, 0.0);
+	}
+
+	double GetTargetLatency() const
+	{
+		return m_targetLatency;
+	}
+
+	// Returns false when the packet was dropped as late or duplicate
+	bool Push(int64_t frameNumber, double arrivalTime, PacketType&& packet)
+	{
+		m_stats.Received++;
+
+		if (m_hasReleased && frameNumber < m_nextFrameNumber)
+		{
+			// Too far back to be a straggler, the sender must have restarted its numbering
+			if (m_nextFrameNumber - frameNumber > RESTART_DISTANCE)
+			{
+				Reset();
+			}
+			else
+			{
+				m_stats.Late++;
+				return false;
+			}
+		}
+
+		if (m_entries.find(frameNumber) != m_entries.end())
+		{
+			m_stats.Duplicate++;
+			return false;
+		}
+
+		m_entries.emplace(frameNumber, Entry{ arrivalTime, std::move(packet) });
+
+		while (m_entries.size() > m_capacity)
+		{
+			auto oldest = m_entries.begin();
+			m_stats.Overflow++;
+			SkipTo(oldest->first);
+			m_nextFrameNumber = oldest->first + 1;
+			m_entries.erase(oldest);
+		}
+
+		return true;
+	}
+
+	// Takes the lowest frame number once it has been held for the target latency
+	bool Pop(double now, int64_t& outFrameNumber, PacketType& outPacket)
+	{
+		if (m_entries.empty())
+			return false;
+
+		auto head = m_entries.begin();
+		if (now < head->second.arrivalTime + m_targetLatency)
+			return false;
+
+		SkipTo(head->first);
+
+		outFrameNumber = head->first;
+		outPacket = std::move(head->second.packet);
+		m_entries.erase(head);
+
+		m_nextFrameNumber = outFrameNumber + 1;
+		m_hasReleased = true;
+		m_stats.Released++;
+		return true;
+	}
+
+	// Seconds till Pop() would release something, negative when empty
+	double GetTimeUntilNextRelease(double now) const
+	{
+		if (m_entries.empty())
+			return -1.0;
+
+		return std::max(m_entries.begin()->second.arrivalTime + m_targetLatency - now, 0.0);
+	}
+
+	size_t GetSize() const
+	{
+		return m_entries.size();
+	}
+
+	const Stats& GetStats() const
+	{
+		return m_stats;
+	}
+
+	// Back to accepting any frame number, e.g. the sender restarted its numbering. Stats are kept.
+	void Reset()
+	{
+		m_entries.clear();
+		m_hasReleased = false;
+		m_nextFrameNumber = 0;
+	}
+
+private:
+	static constexpr int64_t RESTART_DISTANCE = 300;
+
+	struct Entry
+	{
+		double arrivalTime;
+		PacketType packet;
+	};
+
+	void SkipTo(int64_t frameNumber)
+	{
+		if (m_hasReleased && frameNumber > m_nextFrameNumber)
+		{
+			m_stats.Lost += (uint64_t)(frameNumber - m_nextFrameNumber);
+		}
+
+		if (!m_hasReleased || frameNumber > m_nextFrameNumber)
+		{
+			m_nextFrameNumber = frameNumber;
+			m_hasReleased = true;
+		}
+	}
+
+	std::map<int64_t, Entry> m_entries;
+	double m_targetLatency;
+	size_t m_capacity;
+	int64_t m_nextFrameNumber = 0;
+	bool m_hasReleased = false;
+	Stats m_stats;
+};
@@ -12,15 +12,35 @@
 #include "Realtime/PicoAudioSoundWave.h"
 #include "EvercoastPerfCounter.h"
 #include "Realtime/EvercoastRealtimeConfig.h"
+#include "Realtime/RealtimeCapture.h"
+#include "Realtime/RealtimeReceiveWait.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
 
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 
 DEFINE_LOG_CATEGORY(EvercoastRealtimeNetworkLog);
 
 static const char* USERNAME = "playback";
 static const char* SERVER_NI = "realtime.evercoast.com";
 
+// The VCI client exposes neither its socket nor a receive callback, the loop blocks on its wake event until the
+// next frame is expected instead, see RealtimeReceiveWait
+static constexpr std::chrono::milliseconds CONNECT_BACKOFF_MIN(10);
+static constexpr double STATS_LOG_INTERVAL = 10.0;
+
+// Address of the form replay://<capture file> plays a capture back instead of connecting
+static const char* REPLAY_SCHEME = "replay://";
+static constexpr double REPLAY_MAX_WAIT = 0.1;
+// Tells concurrent recorders and replays apart, for file names and loss/jitter seeds
+static std::atomic<uint32_t> s_instanceCounter{ 0 };
+
 class RealtimeRunnalble final : public FRunnable
 {
 public:
@@ -47,7 +67,11 @@ public:
 		, cached_callback(type_decision_callback)
 		, failure_callback(failure_callback)
 		, m_transmissionPerfCounter(transmissionPerfCounter)
-	{}
+		, m_instanceIndex(s_instanceCounter++)
+	{
+		m_stats[0].Name = TEXT("geometry");
+		m_stats[1].Name = TEXT("audio");
+	}
 
 	~RealtimeRunnalble() final = default;
 
@@ -61,16 +85,26 @@ public:
 	{
 		using namespace std::chrono_literals;
 
+		UEvercoastRealtimeConfig* config = NewObject<UEvercoastRealtimeConfig>();
+
+		if (!config->RecordCapturePath.IsEmpty())
+		{
+			OpenRecorder(config->RecordCapturePath);
+		}
+
+		if (m_address.rfind(REPLAY_SCHEME, 0) == 0)
+		{
+			RunReplay(config, m_address.substr(strlen(REPLAY_SCHEME)));
+			CloseRecorder();
+			return 0;
+		}
+
 		// Check if plugin module has been initialised
 		while (PicoQuic::create_connection == nullptr || PicoQuic::create_connection_2 == nullptr)
 		{
 			std::this_thread::sleep_for(1000ms);
 		}
 
-
-		UEvercoastRealtimeConfig* config = NewObject<UEvercoastRealtimeConfig>();
-
-		
 #if PLATFORM_WINDOWS
 		bool useOldPicoQuic = config->UseOldPicoQuic;
 #else
@@ -91,7 +125,14 @@ public:
 				(char*)USERNAME, (char*)m_accessToken.c_str(), m_certPath.c_str(), SERVER_NI);
 		}
 
-		const auto connections = { geoConn, audioConn };
+		RealtimeReceiveWait<CONNECTION_COUNT>::Options waitOptions;
+		waitOptions.maxIdleWait = FMath::Max(config->MaxIdleWaitMs, 0.05f) * 0.001;
+		RealtimeReceiveWait<CONNECTION_COUNT> receiveWait(waitOptions);
+		const auto maxConnectBackoff = std::chrono::milliseconds((int64_t)FMath::Max(config->MaxConnectBackoffMs, 10.0f));
+		auto connectBackoff = CONNECT_BACKOFF_MIN;
+		double lastStatsLogTime = FPlatformTime::Seconds();
+
+		const PicoQuic::vci_connection_handle_t connections[] = { geoConn, audioConn };
 		uint64 startTimestamp = 0;
 		while (m_running)
 		{
@@ -107,6 +148,11 @@ public:
 			if (currentStatus != m_status)
 			{
 				m_status = currentStatus;
+				if (currentStatus == PicoQuic::Status::Connected)
+				{
+					UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Connected to %s:%d"), ANSI_TO_TCHAR(m_address.c_str()), m_port);
+					connectBackoff = CONNECT_BACKOFF_MIN;
+				}
 			}
 
 			if (useOldPicoQuic)
@@ -114,7 +160,7 @@ public:
 				if (currentStatus != PicoQuic::Status::Connected)
 				{
 					// Wait for connection to be made
-					std::this_thread::sleep_for(200ms);
+					WaitForConnectBackoff(connectBackoff, maxConnectBackoff);
 					continue;
 				}
 			}
@@ -147,30 +193,31 @@ public:
 							{
 								UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Reconnect error: %d"), reconnResult);
 							}
-
-							std::this_thread::sleep_for(200ms);
 						}
 					}
-#else
-					std::this_thread::sleep_for(200ms);
 #endif
+					WaitForConnectBackoff(connectBackoff, maxConnectBackoff);
 					continue;
 				}
 				else if (currentStatus != PicoQuic::Status::Connected)
 				{
 					// Wait for connection to be made
-					std::this_thread::sleep_for(200ms);
+					WaitForConnectBackoff(connectBackoff, maxConnectBackoff);
 					continue;
 				}
 			}
 
-			for (const auto& conn : connections)
+			bool anyReceived = false;
+			for (int connIdx = 0; connIdx < CONNECTION_COUNT; ++connIdx)
 			{
-				if (PicoQuic::received_frame(conn))
+				const auto conn = connections[connIdx];
+				// Drain everything queued on this connection before looking at the other one
+				while (m_running && PicoQuic::received_frame(conn))
 				{
-					if (conn == geoConn)
-						m_transmissionPerfCounter->AddSample();
-					
+					anyReceived = true;
+					// Before handing it on, which can take a while
+					receiveWait.OnFrame(connIdx, FPlatformTime::Seconds());
+
 					PicoQuicFrame frame{};
 
 					frame.FrameNumber = PicoQuic::get_frame_number(conn);
@@ -181,84 +228,41 @@ public:
 					frame.UserData = PicoQuic::get_user_data(conn);
 					frame.UserDataSize = PicoQuic::get_user_data_size(conn);
 
-					if (startTimestamp == 0)
-					{
-						startTimestamp = frame.Timestamp;
-					}
-					double relTimetamp = static_cast<double>(static_cast<int64>(frame.Timestamp) - static_cast<int64>(startTimestamp)) * 0.001;
-
-					// volumetric/mesh frame
-					if (frame.UserDataSize == 0)
-					{
-						if (frame.DataSize < 1024)
-						{
-							// empty frame??
-							UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Received empty frame: %d"), frame.FrameNumber);
-						}
-						else
-							if (frame.TypeAndFlags == 0) // main frame
-							{
-								RealtimePacketHeader* header = (RealtimePacketHeader*)(frame.Data);
-								if (!m_decoder && cached_callback)
-								{
-									m_decoder = cached_callback(header->u32streamType);
-									cached_callback = nullptr;
-								}
-
-								check(m_decoder);
-								if (header->IsValid())
-								{
-									// realtime meshing or voxel
-									m_decoder->Receive(relTimetamp, frame.FrameNumber, frame.Data, (size_t)frame.DataSize, 0);
-								}
-								else
-								{
-									UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Unknown frame header or version: %d - %d"), header->headerType, header->headerVersion);
-								}
-							}
-							else
-							{
-								UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Unknown frame type: %d"), frame.TypeAndFlags);
-							}
-					}
-					else
-					{
-						// audio frame
-						if (frame.TypeAndFlags == 1)
-						{
-							if (m_sound)
-							{
-								m_sound->QueueAudio(relTimetamp, frame.FrameNumber, frame.UserData, frame.UserDataSize, frame.Data, frame.DataSize);
-							}
-							else
-							{
-								UE_LOG(EvercoastRealtimeNetworkLog, Verbose, TEXT("Realtime streaming has sound channel but this actor doesn't have AudioComponent."));
-							}
-						}
-					}
-
+					HandleFrame(connIdx, frame, startTimestamp);
 					PicoQuic::pop_frame(conn);
-
-				}
-				else
-				{
-					//UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("No realtime frame"));
-					//std::this_thread::sleep_for(5ms);
 				}
 			}
+
+			LogStatsPeriodically(lastStatsLogTime);
+
+			if (!anyReceived)
+			{
+				for (auto& stats : m_stats)
+					stats.IdleWaits++;
+			}
+
+			WaitForStop(std::chrono::microseconds((int64_t)(receiveWait.GetWait(FPlatformTime::Seconds()) * 1000000.0)));
 		}
 
+		for (const auto& stats : m_stats)
+			UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("%s"), *stats.Describe());
+
 		UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Delete geo connection: %d"), geoConn);
 		PicoQuic::delete_connection(geoConn);
 		UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Delete audio connection: %d"), audioConn);
 		PicoQuic::delete_connection(audioConn);
 
+		CloseRecorder();
 		return 0;
 	}
 
 	void Stop() final 
 	{
-		m_running = false;
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_running = false;
+		}
+		m_wakeCondition.notify_all();
 	}
 
 	void Exit() final 
@@ -269,7 +273,276 @@ public:
 	{
 		return m_status;
 	}
+
+	RealtimeReceiveStats GetReceiveStats(int connectionIndex) const
+	{
+		return m_stats[connectionIndex].Snapshot();
+	}
 private:
+	static constexpr int CONNECTION_COUNT = 2;
+
+	struct ConnectionStats
+	{
+		const TCHAR* Name = TEXT("");
+		std::atomic<uint64_t> FramesReceived{ 0 };
+		std::atomic<uint64_t> BytesReceived{ 0 };
+		std::atomic<uint64_t> IdleWaits{ 0 };
+		std::atomic<double> LastFrameTime{ 0 };
+		std::atomic<double> MaxFrameGap{ 0 };
+		std::atomic<double> TotalFrameGap{ 0 };
+
+		// Network thread only
+		void OnFrame(uint64_t size, double now)
+		{
+			const double last = LastFrameTime.load(std::memory_order_relaxed);
+			if (last > 0)
+			{
+				const double gap = now - last;
+				TotalFrameGap.store(TotalFrameGap.load(std::memory_order_relaxed) + gap, std::memory_order_relaxed);
+				if (gap > MaxFrameGap.load(std::memory_order_relaxed))
+					MaxFrameGap.store(gap, std::memory_order_relaxed);
+			}
+			LastFrameTime.store(now, std::memory_order_relaxed);
+			BytesReceived.fetch_add(size, std::memory_order_relaxed);
+			FramesReceived.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		RealtimeReceiveStats Snapshot() const
+		{
+			RealtimeReceiveStats stats;
+			stats.FramesReceived = FramesReceived.load(std::memory_order_relaxed);
+			stats.BytesReceived = BytesReceived.load(std::memory_order_relaxed);
+			stats.IdleWaits = IdleWaits.load(std::memory_order_relaxed);
+			stats.MaxFrameGapMs = MaxFrameGap.load(std::memory_order_relaxed) * 1000.0;
+			stats.AverageFrameGapMs = stats.FramesReceived > 1 ? TotalFrameGap.load(std::memory_order_relaxed) * 1000.0 / (stats.FramesReceived - 1) : 0;
+			return stats;
+		}
+
+		FString Describe() const
+		{
+			const RealtimeReceiveStats stats = Snapshot();
+			return FString::Printf(TEXT("%s connection: %llu frames, %llu bytes, %llu idle waits, frame gap avg %.2f ms max %.2f ms"),
+				Name, (unsigned long long)stats.FramesReceived, (unsigned long long)stats.BytesReceived, (unsigned long long)stats.IdleWaits,
+				stats.AverageFrameGapMs, stats.MaxFrameGapMs);
+		}
+	};
+
+	void HandleFrame(int connIdx, const PicoQuicFrame& frame, uint64& startTimestamp)
+	{
+		const double now = FPlatformTime::Seconds();
+		if (connIdx == 0)
+			m_transmissionPerfCounter->AddSample();
+
+		if (m_recorder.IsOpen())
+		{
+			if (!m_recorder.Write(connIdx, now, frame.FrameNumber, frame.Timestamp, frame.TypeAndFlags, frame.Data, frame.DataSize, frame.UserData, frame.UserDataSize))
+			{
+				UE_LOG(EvercoastRealtimeNetworkLog, Error, TEXT("Writing capture failed, recording stopped after %llu frames"), (unsigned long long)m_recorder.GetFramesWritten());
+			}
+		}
+
+		if (startTimestamp == 0)
+		{
+			startTimestamp = frame.Timestamp;
+		}
+		double relTimetamp = static_cast<double>(static_cast<int64>(frame.Timestamp) - static_cast<int64>(startTimestamp)) * 0.001;
+
+		// volumetric/mesh frame
+		if (frame.UserDataSize == 0)
+		{
+			if (frame.DataSize < 1024)
+			{
+				// empty frame??
+				UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Received empty frame: %d"), frame.FrameNumber);
+			}
+			else
+				if (frame.TypeAndFlags == 0) // main frame
+				{
+					RealtimePacketHeader* header = (RealtimePacketHeader*)(frame.Data);
+					if (!m_decoder && cached_callback)
+					{
+						m_decoder = cached_callback(header->u32streamType);
+						cached_callback = nullptr;
+					}
+
+					check(m_decoder);
+					if (header->IsValid())
+					{
+						// realtime meshing or voxel
+						m_decoder->Receive(relTimetamp, frame.FrameNumber, frame.Data, (size_t)frame.DataSize, 0);
+					}
+					else
+					{
+						UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Unknown frame header or version: %d - %d"), header->headerType, header->headerVersion);
+					}
+				}
+				else
+				{
+					UE_LOG(EvercoastRealtimeNetworkLog, Warning, TEXT("Unknown frame type: %d"), frame.TypeAndFlags);
+				}
+		}
+		else
+		{
+			// audio frame
+			if (frame.TypeAndFlags == 1)
+			{
+				if (m_sound)
+				{
+					m_sound->QueueAudio(relTimetamp, frame.FrameNumber, frame.UserData, frame.UserDataSize, frame.Data, frame.DataSize);
+				}
+				else
+				{
+					UE_LOG(EvercoastRealtimeNetworkLog, Verbose, TEXT("Realtime streaming has sound channel but this actor doesn't have AudioComponent."));
+				}
+			}
+		}
+
+		m_stats[connIdx].OnFrame(frame.DataSize + frame.UserDataSize, now);
+	}
+
+	// Stands in for the VCI connections, feeding frames of a capture through the same path at their recorded
+	// timing, with the loss and jitter set up in the config
+	void RunReplay(const UEvercoastRealtimeConfig* config, const std::string& capturePath)
+	{
+		RealtimeCaptureReplayer::Options options;
+		options.timeScale = config->ReplayTimeScale;
+		options.lossRate = config->ReplayLossRate;
+		options.maxLossBurst = config->ReplayMaxLossBurst;
+		options.maxJitter = config->ReplayMaxJitterMs * 0.001;
+		options.loop = config->ReplayLoop;
+		// Concurrent replays of the same capture shouldn't lose the same frames
+		options.seed = (uint32_t)config->ReplaySeed + m_instanceIndex;
+
+		RealtimeCaptureReplayer replayer;
+		std::string error;
+		if (!replayer.Open(capturePath, options, error))
+		{
+			UE_LOG(EvercoastRealtimeNetworkLog, Error, TEXT("Cannot replay capture: %s"), UTF8_TO_TCHAR(error.c_str()));
+			m_status = PicoQuic::Status::FailedToConnect;
+			return;
+		}
+
+		UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Replaying capture %s, time scale %.2f loss rate %.3f max jitter %.1f ms"),
+			UTF8_TO_TCHAR(capturePath.c_str()), options.timeScale, options.lossRate, config->ReplayMaxJitterMs);
+		m_status = PicoQuic::Status::Connected;
+
+		double lastStatsLogTime = FPlatformTime::Seconds();
+		uint64 startTimestamp = 0;
+		RealtimeCaptureFrame captured;
+		while (m_running)
+		{
+			const double now = FPlatformTime::Seconds();
+			bool anyReceived = false;
+			for (int connIdx = 0; connIdx < CONNECTION_COUNT; ++connIdx)
+			{
+				while (m_running && replayer.Pop(connIdx, now, captured))
+				{
+					anyReceived = true;
+
+					PicoQuicFrame frame{};
+					frame.FrameNumber = captured.frameNumber;
+					frame.Timestamp = captured.timestamp;
+					frame.TypeAndFlags = captured.typeAndFlags;
+					frame.Data = captured.data.data();
+					frame.DataSize = captured.data.size();
+					frame.UserData = captured.userData.empty() ? nullptr : captured.userData.data();
+					frame.UserDataSize = captured.userData.size();
+
+					HandleFrame(connIdx, frame, startTimestamp);
+				}
+			}
+
+			if (replayer.IsFinished())
+			{
+				UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Capture replay finished"));
+				m_status = PicoQuic::Status::Disconnected;
+				break;
+			}
+
+			LogStatsPeriodically(lastStatsLogTime);
+
+			if (!anyReceived)
+			{
+				for (auto& stats : m_stats)
+					stats.IdleWaits++;
+			}
+
+			const double untilNext = replayer.GetTimeUntilNextFrame(FPlatformTime::Seconds());
+			if (untilNext > 0)
+			{
+				WaitForStop(std::chrono::microseconds((int64_t)(FMath::Min(untilNext, REPLAY_MAX_WAIT) * 1000000.0)));
+			}
+		}
+
+		const RealtimeCaptureReplayer::Stats& replayStats = replayer.GetStats();
+		UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Capture replay: %llu frames read, %llu delivered, %llu dropped, %llu reordered, %llu loops"),
+			(unsigned long long)replayStats.Read, (unsigned long long)replayStats.Delivered, (unsigned long long)replayStats.Dropped,
+			(unsigned long long)replayStats.Reordered, (unsigned long long)replayStats.Loops);
+		for (const auto& stats : m_stats)
+			UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("%s"), *stats.Describe());
+	}
+
+	void OpenRecorder(const FString& configuredPath)
+	{
+		FString path = configuredPath;
+		if (FPaths::IsRelative(path))
+		{
+			path = FPaths::Combine(FPaths::ProjectSavedDir(), path);
+		}
+
+		// Every realtime actor records on its own
+		if (m_instanceIndex > 0)
+		{
+			path = FPaths::Combine(FPaths::GetPath(path), FString::Printf(TEXT("%s_%u.%s"), *FPaths::GetBaseFilename(path), m_instanceIndex, *FPaths::GetExtension(path)));
+		}
+
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(path), true);
+
+		std::string error;
+		if (m_recorder.Open(TCHAR_TO_UTF8(*path), error))
+		{
+			UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Recording realtime capture to %s"), *path);
+		}
+		else
+		{
+			UE_LOG(EvercoastRealtimeNetworkLog, Error, TEXT("Cannot record realtime capture: %s"), UTF8_TO_TCHAR(error.c_str()));
+		}
+	}
+
+	void CloseRecorder()
+	{
+		if (m_recorder.IsOpen())
+		{
+			UE_LOG(EvercoastRealtimeNetworkLog, Log, TEXT("Recorded %llu frames"), (unsigned long long)m_recorder.GetFramesWritten());
+			m_recorder.Close();
+		}
+	}
+
+	void LogStatsPeriodically(double& lastStatsLogTime)
+	{
+		const double now = FPlatformTime::Seconds();
+		if (now - lastStatsLogTime >= STATS_LOG_INTERVAL)
+		{
+			for (const auto& stats : m_stats)
+				UE_LOG(EvercoastRealtimeNetworkLog, Verbose, TEXT("%s"), *stats.Describe());
+			lastStatsLogTime = now;
+		}
+	}
+
+	// Returns early when stopped
+	template<typename Duration>
+	void WaitForStop(Duration duration)
+	{
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait_for(lock, duration, [this] { return !m_running; });
+	}
+
+	void WaitForConnectBackoff(std::chrono::milliseconds& backoff, std::chrono::milliseconds maxBackoff)
+	{
+		WaitForStop(backoff);
+		backoff = std::min(backoff * 2, maxBackoff);
+	}
+
 	std::string m_address;
 	int m_port{ 6655 };
 	std::string m_accessToken;
@@ -285,6 +558,13 @@ private:
 	std::function<void(void)> failure_callback;
 
 	std::shared_ptr<EvercoastPerfCounter> m_transmissionPerfCounter;
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	ConnectionStats m_stats[CONNECTION_COUNT];
+
+	uint32_t m_instanceIndex;
+	RealtimeCaptureWriter m_recorder;
 };
 
 bool RealtimeNetworkThread::Connect(const std::string& address, int port, const std::string& accessToken, const std::string& certificatePath, UPicoAudioSoundWave* sound,
@@ -322,3 +602,13 @@ PicoQuic::Status RealtimeNetworkThread::GetStatus() const
 
 	return PicoQuic::Status::NotYetConnected;
 }
+
+RealtimeReceiveStats RealtimeNetworkThread::GetReceiveStats(RealtimeConnection connection) const
+{
+	if (m_runnable)
+	{
+		return ((RealtimeRunnalble*)(m_runnable))->GetReceiveStats((int)connection);
+	}
+
+	return RealtimeReceiveStats();
+}
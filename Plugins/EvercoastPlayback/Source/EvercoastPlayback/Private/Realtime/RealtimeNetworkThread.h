@@ -14,6 +14,22 @@ class IEvercoastRealtimeDataDecoder;
 
 DECLARE_LOG_CATEGORY_EXTERN(EvercoastRealtimeNetworkLog, Log, All);
 
+enum class RealtimeConnection
+{
+	Geometry = 0,
+	Audio = 1
+};
+
+struct RealtimeReceiveStats
+{
+	uint64_t FramesReceived = 0;
+	uint64_t BytesReceived = 0;
+	// Times the loop woke up and found nothing on any connection
+	uint64_t IdleWaits = 0;
+	double AverageFrameGapMs = 0;
+	double MaxFrameGapMs = 0;
+};
+
 class RealtimeNetworkThread
 {
 public:
@@ -23,6 +39,7 @@ public:
 		std::shared_ptr<EvercoastPerfCounter> perfCounter);
 	void Disconnect();
 	PicoQuic::Status GetStatus() const;
+	RealtimeReceiveStats GetReceiveStats(RealtimeConnection connection) const;
 
 private:
 	std::function<std::shared_ptr<IEvercoastRealtimeDataDecoder>(uint32_t)> m_cachedCallback;
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// How long the realtime network loop can block before looking at its connections again. The VCI client exposes
+// neither its socket nor a receive callback, so frames can only be found by polling. They come at the sender's
+// cadence though: after each one the loop blocks until shortly before the next is expected on any connection, then
+// looks at a fine interval until it shows up.
+//
+// A frame already there on the first look of that window came early, or the expectation is running late, and the
+// margin ahead of it doubles. One caught by the fine looks shrinks it a little, so it settles around the jitter.
+// Connections that can't be predicted, still learning their cadence or overdue by more than an interval, are
+// looked at with a wait backing off up to the idle limit, as they were before there was any prediction.
+//
+// Call GetWait() after every look and OnFrame() for each frame found in it. Times are seconds on whatever clock the
+// caller uses. Not thread safe.
+template<int ConnectionCount>
+class RealtimeReceiveWait
+{
+public:
+	struct Options
+	{
+		// Between looks while a frame is due
+		double pollInterval = 0.0005;
+		// Least and most woken up ahead of an expected frame
+		double minMargin = 0.0005;
+		double maxMargin = 0.008;
+		// Longest wait while no frame is expected
+		double maxIdleWait = 0.002;
+	};
+
+	explicit RealtimeReceiveWait(const Options& options) :
+		m_options(options), m_backoff(options.pollInterval)
+	{
+		m_options.maxIdleWait = std::max(m_options.maxIdleWait, m_options.pollInterval);
+	}
+
+	void OnFrame(int connection, double now)
+	{
+		Cadence& cadence = m_cadence[connection];
+		const double gap = now - cadence.arrival;
+		// Frames drained in one look say nothing about the cadence
+		if (cadence.arrival >= 0 && gap <= m_options.pollInterval)
+			return;
+
+		if (cadence.interval > 0)
+		{
+			const double windowStart = cadence.arrival + cadence.interval - cadence.margin;
+			cadence.margin = m_lastLook <= windowStart ? std::min(cadence.margin * 2, m_options.maxMargin) : std::max(cadence.margin * MARGIN_DECAY, m_options.minMargin);
+		}
+		else
+		{
+			cadence.margin = m_options.minMargin;
+		}
+
+		// Neither does the gap over a stall
+		if (cadence.arrival >= 0 && (cadence.interval <= 0 || gap < cadence.interval * STALL_INTERVALS))
+		{
+			// Plain average over the first few, the first gaps can be off by a whole idle wait
+			cadence.gaps++;
+			cadence.interval += (gap - cadence.interval) * std::max(1.0 / cadence.gaps, SMOOTHING);
+		}
+		cadence.arrival = now;
+		m_backoff = m_options.pollInterval;
+	}
+
+	// Seconds to block for before looking again
+	double GetWait(double now)
+	{
+		m_lastLook = now;
+
+		double expectedWait = -1;
+		bool unexpected = false;
+		for (const Cadence& cadence : m_cadence)
+		{
+			// Never sent anything, a stream without audio say
+			if (cadence.arrival < 0)
+				continue;
+
+			const double expected = cadence.arrival + cadence.interval;
+			if (cadence.interval <= 0 || now > expected + cadence.interval)
+			{
+				unexpected = true;
+				continue;
+			}
+
+			const double margin = std::min(cadence.margin, cadence.interval * 0.5);
+			// Looks thin out the longer a late frame keeps the loop waiting, adding a quarter to its latency at most
+			const double untilLook = std::max({ expected - margin - now, (now - expected) * OVERDUE_POLL, m_options.pollInterval });
+			expectedWait = expectedWait < 0 ? untilLook : std::min(expectedWait, untilLook);
+		}
+
+		if (expectedWait >= 0 && !unexpected)
+		{
+			m_backoff = m_options.pollInterval;
+			return expectedWait;
+		}
+
+		const double wait = m_backoff;
+		m_backoff = std::min(m_backoff * 2, m_options.maxIdleWait);
+		return expectedWait >= 0 ? std::min(wait, expectedWait) : wait;
+	}
+
+	// Smoothed gap between frames of the connection, 0 until two have arrived
+	double GetInterval(int connection) const
+	{
+		return m_cadence[connection].interval;
+	}
+
+private:
+	static constexpr double SMOOTHING = 1.0 / 16;
+	static constexpr double STALL_INTERVALS = 4;
+	static constexpr double MARGIN_DECAY = 0.9;
+	static constexpr double OVERDUE_POLL = 0.25;
+
+	struct Cadence
+	{
+		// When the last frame was picked up
+		double arrival = -1;
+		double interval = 0;
+		double margin = 0;
+		uint32_t gaps = 0;
+	};
+
+	Options m_options;
+	Cadence m_cadence[ConnectionCount];
+	double m_backoff;
+	double m_lastLook = -1;
+};
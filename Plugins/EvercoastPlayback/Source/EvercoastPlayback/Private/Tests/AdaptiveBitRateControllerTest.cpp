@@ -0,0 +1,291 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "AdaptiveBitRateController.h"
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// AdaptiveBitRateController driven by synthetic bandwidth traces instead of the network. A simulated player fetches
+// 1 second segments back to back at the bit rate of the representation in use, through a link whose bandwidth
+// follows the trace, and evaluates at every segment boundary like UGhostTreeFormatReader does. Time is simulated,
+// so every run of a trace makes the same decisions.
+namespace AdaptiveBitRateControllerTest
+{
+	static constexpr double SEGMENT_DURATION = 1.0;
+	static constexpr double MAX_BUFFER = 10.0;
+	static constexpr double INITIAL_BUFFER = 2.0;
+	// Resolution the trace is integrated at while downloading
+	static constexpr double TRACE_STEP = 0.05;
+
+	static const std::vector<AbrRepresentation> REPRESENTATIONS =
+	{
+		{ 1, 2000000 },
+		{ 2, 4000000 },
+		{ 3, 8000000 },
+	};
+
+	typedef std::function<double(double now)> BandwidthTrace; // bits per second
+
+	struct Switch
+	{
+		double time;
+		uint32_t from;
+		uint32_t to;
+		double bufferedSeconds;
+
+		bool operator==(const Switch& other) const
+		{
+			return time == other.time && from == other.from && to == other.to && bufferedSeconds == other.bufferedSeconds;
+		}
+	};
+
+	struct SimulationResult
+	{
+		std::vector<Switch> switches;
+		double stalledSeconds = 0;
+		uint32_t finalRepresentationId = 0;
+	};
+
+	static uint32_t BitRateOf(uint32_t representationId)
+	{
+		for (const AbrRepresentation& representation : REPRESENTATIONS)
+		{
+			if (representation.representationId == representationId)
+				return representation.bitRate;
+		}
+		return 0;
+	}
+
+	static SimulationResult Simulate(const BandwidthTrace& trace, int segmentCount)
+	{
+		AdaptiveBitRateController controller;
+		// Listed out of order on purpose, the controller sorts them
+		controller.SetRepresentations({ REPRESENTATIONS[2], REPRESENTATIONS[0], REPRESENTATIONS[1] }, 1);
+
+		SimulationResult result;
+		uint32_t representationId = 1;
+		double now = 0;
+		double buffered = INITIAL_BUFFER;
+		for (int segment = 0; segment < segmentCount; ++segment)
+		{
+			const double bytes = BitRateOf(representationId) / 8.0;
+			double remaining = bytes;
+			double duration = 0;
+			while (remaining > 0)
+			{
+				const double stepBytes = trace(now + duration) / 8.0 * TRACE_STEP;
+				if (stepBytes >= remaining)
+				{
+					duration += TRACE_STEP * remaining / stepBytes;
+					remaining = 0;
+				}
+				else
+				{
+					remaining -= stepBytes;
+					duration += TRACE_STEP;
+				}
+			}
+			controller.AddThroughputSample((uint64_t)bytes, duration);
+
+			now += duration;
+			if (duration > buffered)
+			{
+				result.stalledSeconds += duration - buffered;
+				buffered = 0;
+			}
+			else
+			{
+				buffered -= duration;
+			}
+			buffered += SEGMENT_DURATION;
+			// Buffer full, the player idles till there's room for the next segment
+			if (buffered > MAX_BUFFER)
+			{
+				now += buffered - MAX_BUFFER;
+				buffered = MAX_BUFFER;
+			}
+
+			controller.SetBufferLevel(buffered);
+			uint32_t nextRepresentationId = 0;
+			if (controller.Evaluate(now, nextRepresentationId))
+			{
+				result.switches.push_back({ now, representationId, nextRepresentationId, buffered });
+				representationId = nextRepresentationId;
+			}
+		}
+
+		result.finalRepresentationId = representationId;
+		return result;
+	}
+
+	static FString Describe(const SimulationResult& result)
+	{
+		FString description = FString::Printf(TEXT("stalled %.2fs"), result.stalledSeconds);
+		for (const Switch& change : result.switches)
+		{
+			description += FString::Printf(TEXT(", %.2fs %u->%u(buffered %.2fs)"), change.time, change.from, change.to, change.bufferedSeconds);
+		}
+		return description;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAbrSteadyTraceTest, "Evercoast.GhostTree.AdaptiveBitRate.SteadyBandwidth", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAbrSteadyTraceTest::RunTest(const FString& Parameters)
+{
+	using namespace AdaptiveBitRateControllerTest;
+	const AdaptiveBitRateConfig config;
+
+	// Plenty of bandwidth: climbs one step at a time, spaced by the minimum switch interval
+	SimulationResult fast = Simulate([](double) { return 20e6; }, 120);
+	AddInfo(FString::Printf(TEXT("20 Mbps: %s"), *Describe(fast)));
+	TestEqual(TEXT("20 Mbps ends on the highest representation"), (int32)fast.finalRepresentationId, 3);
+	TestEqual(TEXT("20 Mbps switches"), (int32)fast.switches.size(), 2);
+	for (size_t i = 0; i < fast.switches.size(); ++i)
+	{
+		TestEqual(TEXT("Up switches are one step"), (int32)fast.switches[i].to, (int32)fast.switches[i].from + 1);
+		if (i > 0)
+		{
+			TestTrue(TEXT("Switches are spaced by the minimum interval"), fast.switches[i].time - fast.switches[i - 1].time >= config.minSwitchIntervalInSeconds);
+		}
+	}
+	TestEqual(TEXT("20 Mbps never stalls"), fast.stalledSeconds, 0.0);
+
+	// 4 Mbps would fit but not within the safety factor, so it never goes up
+	SimulationResult tight = Simulate([](double) { return 5e6; }, 120);
+	AddInfo(FString::Printf(TEXT("5 Mbps: %s"), *Describe(tight)));
+	TestEqual(TEXT("5 Mbps stays on the lowest representation"), (int32)tight.switches.size(), 0);
+	TestEqual(TEXT("5 Mbps never stalls"), tight.stalledSeconds, 0.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAbrDropTraceTest, "Evercoast.GhostTree.AdaptiveBitRate.BandwidthDrop", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAbrDropTraceTest::RunTest(const FString& Parameters)
+{
+	using namespace AdaptiveBitRateControllerTest;
+
+	// 20 Mbps -> 3 Mbps at 40s, the buffer absorbs the drop while stepping down
+	SimulationResult drop = Simulate([](double now) { return now < 40.0 ? 20e6 : 3e6; }, 160);
+	AddInfo(FString::Printf(TEXT("20 -> 3 Mbps: %s"), *Describe(drop)));
+	TestEqual(TEXT("Ends on what 3 Mbps sustains"), (int32)drop.finalRepresentationId, 1);
+	TestEqual(TEXT("No stall on a sustainable drop"), drop.stalledSeconds, 0.0);
+	const Switch* firstDown = nullptr;
+	for (const Switch& change : drop.switches)
+	{
+		if (change.to < change.from)
+		{
+			firstDown = &change;
+			break;
+		}
+	}
+	if (TestNotNull(TEXT("Switched down"), firstDown))
+	{
+		TestTrue(TEXT("Switched down within 10s of the drop"), firstDown->time >= 40.0 && firstDown->time < 50.0);
+	}
+
+	// 20 Mbps -> 1 Mbps, below every representation. The buffer runs low and the controller goes straight to the
+	// bottom without waiting out the switch interval.
+	SimulationResult cliff = Simulate([](double now) { return now < 40.0 ? 20e6 : 1e6; }, 80);
+	AddInfo(FString::Printf(TEXT("20 -> 1 Mbps: %s"), *Describe(cliff)));
+	TestEqual(TEXT("Cliff ends on the lowest representation"), (int32)cliff.finalRepresentationId, 1);
+	TestTrue(TEXT("Cliff has switches"), cliff.switches.size() >= 3);
+	if (cliff.switches.size() >= 3)
+	{
+		const Switch& down = cliff.switches[2];
+		TestEqual(TEXT("Cliff skips the middle representation"), (int32)down.from - (int32)down.to, 2);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAbrHysteresisTraceTest, "Evercoast.GhostTree.AdaptiveBitRate.Hysteresis", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAbrHysteresisTraceTest::RunTest(const FString& Parameters)
+{
+	using namespace AdaptiveBitRateControllerTest;
+
+	// Bandwidth swinging between 7 and 4.5 Mbps every 3s. The top representation fits in neither with the safety
+	// margin, the middle one fits the average: settle there instead of flapping.
+	SimulationResult oscillating = Simulate([](double now) { return std::fmod(now, 6.0) < 3.0 ? 7e6 : 4.5e6; }, 200);
+	AddInfo(FString::Printf(TEXT("7/4.5 Mbps: %s"), *Describe(oscillating)));
+	TestTrue(TEXT("Oscillating bandwidth doesn't flap"), oscillating.switches.size() <= 2);
+	TestEqual(TEXT("Oscillating bandwidth never stalls"), oscillating.stalledSeconds, 0.0);
+	TestTrue(TEXT("Oscillating bandwidth never picks the top representation"), oscillating.finalRepresentationId != 3);
+
+	// Slow start then a fast link, the slow average holds the climb back but it gets to the top
+	SimulationResult recovery = Simulate([](double now) { return now < 30.0 ? 2.5e6 : 30e6; }, 200);
+	AddInfo(FString::Printf(TEXT("2.5 -> 30 Mbps: %s"), *Describe(recovery)));
+	TestEqual(TEXT("Recovers to the highest representation"), (int32)recovery.finalRepresentationId, 3);
+	TestEqual(TEXT("Recovery never stalls"), recovery.stalledSeconds, 0.0);
+	for (const Switch& change : recovery.switches)
+	{
+		TestTrue(TEXT("Doesn't switch up before the bandwidth does"), change.time >= 30.0);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAbrSeekResetTest, "Evercoast.GhostTree.AdaptiveBitRate.SeekReset", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAbrSeekResetTest::RunTest(const FString& Parameters)
+{
+	using namespace AdaptiveBitRateControllerTest;
+	const AdaptiveBitRateConfig config;
+
+	AdaptiveBitRateController controller(config);
+	controller.SetRepresentations(REPRESENTATIONS, 1);
+	// 20 Mbps for 2s with plenty buffered, one step up
+	controller.AddThroughputSample(5000000, 2.0);
+	controller.SetBufferLevel(MAX_BUFFER);
+	uint32_t representationId = 0;
+	TestTrue(TEXT("Switched up"), controller.Evaluate(10.0, representationId) && representationId == 2);
+	TestFalse(TEXT("Next step up waits out the switch interval"), controller.Evaluate(11.0, representationId));
+
+	// Seek: the buffer ahead is gone and the switch interval starts over, the estimate and representation stay
+	const double throughput = controller.GetEstimatedThroughput();
+	controller.Reset();
+	TestEqual(TEXT("Buffer level dropped"), controller.GetBufferLevel(), 0.0);
+	TestEqual(TEXT("Throughput estimate kept"), controller.GetEstimatedThroughput(), throughput);
+	TestEqual(TEXT("Representation in use kept"), (int32)controller.GetCurrentRepresentationId(), 2);
+	TestFalse(TEXT("Empty buffer after the seek, no up switch"), controller.Evaluate(11.0, representationId));
+
+	// Once refilled it climbs straight away, the switch before the seek no longer throttles it
+	controller.SetBufferLevel(config.upSwitchMinBufferInSeconds);
+	TestTrue(TEXT("Switched up after the seek"), controller.Evaluate(12.0, representationId) && representationId == 3);
+	TestTrue(TEXT("Within the interval of the switch before the seek"), 12.0 - 10.0 < config.minSwitchIntervalInSeconds);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAbrDeterminismTest, "Evercoast.GhostTree.AdaptiveBitRate.Deterministic", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAbrDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace AdaptiveBitRateControllerTest;
+
+	// Pseudo random walk of the bandwidth between 1.5 and 25 Mbps, the same trace twice
+	auto trace = [](double now)
+	{
+		const uint32_t step = (uint32_t)(now / 2.0);
+		uint32_t state = 0x9e3779b9u;
+		double bandwidth = 8e6;
+		for (uint32_t i = 0; i <= step; ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			bandwidth *= 0.7 + 0.6 * (state >> 8) / 16777216.0;
+			bandwidth = FMath::Clamp(bandwidth, 1.5e6, 25e6);
+		}
+		return bandwidth;
+	};
+
+	SimulationResult first = Simulate(trace, 300);
+	SimulationResult second = Simulate(trace, 300);
+	AddInfo(FString::Printf(TEXT("Random walk: %s"), *Describe(first)));
+	TestTrue(TEXT("Random walk switches"), !first.switches.empty());
+	TestTrue(TEXT("Same trace, same decisions"), first.switches == second.switches);
+	TestEqual(TEXT("Same trace, same stalls"), first.stalledSeconds, second.stalledSeconds);
+	return true;
+}
+
+#endif
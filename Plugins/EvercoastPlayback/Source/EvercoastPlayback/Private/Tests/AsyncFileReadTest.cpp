@@ -0,0 +1,235 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Async/AsyncFileHandle.h"
+#include "ReaderCache.h"
+#include <atomic>
+#include <vector>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The FileSystem mode read path of UGhostTreeFormatReader without GhostTree: reads land straight in the cache's
+// storage through IAsyncReadFileHandle, compared against the synchronous read into a temporary buffer plus copy
+// it replaced. Runs against a local file written up front.
+namespace AsyncFileReadTest
+{
+	static constexpr uint32_t FILE_SIZE = 64 * 1024 * 1024;
+
+	static uint8_t ByteAt(uint64_t offset)
+	{
+		return (uint8_t)((offset * 2654435761ull) >> 13);
+	}
+
+	static FString WriteTestFile()
+	{
+		const FString path = FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("EvercoastAsyncFileReadTest.bin"));
+		TUniquePtr<FArchive> writer(IFileManager::Get().CreateFileWriter(*path));
+		if (!writer)
+			return FString();
+
+		std::vector<uint8_t> chunk(1024 * 1024);
+		for (uint64_t offset = 0; offset < FILE_SIZE; offset += chunk.size())
+		{
+			for (size_t i = 0; i < chunk.size(); ++i)
+			{
+				chunk[i] = ByteAt(offset + i);
+			}
+			writer->Serialize(chunk.data(), chunk.size());
+		}
+		writer->Close();
+		return path;
+	}
+
+	static bool Verify(const uint8_t* data, uint64_t offset, uint32_t size)
+	{
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			if (data[i] != ByteAt(offset + i))
+				return false;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAsyncFileReadBenchmark, "Evercoast.GhostTree.AsyncFileRead.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAsyncFileReadBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace AsyncFileReadTest;
+
+	const FString path = WriteTestFile();
+	if (!TestFalse(TEXT("Test file written"), path.IsEmpty()))
+		return false;
+
+	const uint32_t requestSizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+	for (uint32_t requestSize : requestSizes)
+	{
+		const uint32_t requestCount = FILE_SIZE / requestSize;
+
+		// Synchronous, into a temporary buffer then copied into the cache
+		double syncSeconds = 0;
+		{
+			ReaderMemoryCache cache(FILE_SIZE);
+			TUniquePtr<FArchive> reader(IFileManager::Get().CreateFileReader(*path));
+			TestNotNull(TEXT("Sync reader"), reader.Get());
+			if (!reader)
+				return false;
+
+			const double start = FPlatformTime::Seconds();
+			for (uint32_t i = 0; i < requestCount; ++i)
+			{
+				uint8_t* buffer = new uint8_t[requestSize];
+				reader->Seek((int64)i * requestSize);
+				reader->Serialize(buffer, requestSize);
+				cache.CopyAdd(i, buffer, requestSize);
+				delete[] buffer;
+			}
+			syncSeconds = FPlatformTime::Seconds() - start;
+
+			for (uint32_t i = 0; i < requestCount; ++i)
+			{
+				TestTrue(TEXT("Sync read content"), Verify(cache.Get(i), (uint64_t)i * requestSize, requestSize));
+			}
+		}
+
+		// Asynchronous, straight into the cache's storage, all requests issued up front like GhostTree's read ahead
+		double asyncSeconds = 0;
+		{
+			ReaderMemoryCache cache(FILE_SIZE);
+			IAsyncReadFileHandle* handle = FPlatformFileManager::Get().GetPlatformFile().OpenAsyncRead(*path);
+			TestNotNull(TEXT("Async handle"), handle);
+			if (!handle)
+				return false;
+
+			std::atomic<uint32_t> succeeded{ 0 };
+			FAsyncFileCallBack callback = [&succeeded](bool wasCancelled, IAsyncReadRequest* request)
+			{
+				if (!wasCancelled && request->GetReadResults() != nullptr)
+				{
+					succeeded.fetch_add(1);
+				}
+			};
+
+			std::vector<IAsyncReadRequest*> requests;
+			requests.reserve(requestCount);
+			const double start = FPlatformTime::Seconds();
+			for (uint32_t i = 0; i < requestCount; ++i)
+			{
+				uint8_t* destination = cache.Reserve(i, requestSize);
+				requests.push_back(handle->ReadRequest((int64)i * requestSize, requestSize, AIOP_Normal, &callback, destination));
+			}
+			for (IAsyncReadRequest* request : requests)
+			{
+				if (request)
+				{
+					request->WaitCompletion();
+				}
+			}
+			asyncSeconds = FPlatformTime::Seconds() - start;
+
+			for (IAsyncReadRequest* request : requests)
+			{
+				delete request;
+			}
+			delete handle;
+
+			TestEqual(TEXT("Async reads succeeded"), (int32)succeeded.load(), (int32)requestCount);
+			for (uint32_t i = 0; i < requestCount; ++i)
+			{
+				TestTrue(TEXT("Async read content"), Verify(cache.Get(i), (uint64_t)i * requestSize, requestSize));
+			}
+		}
+
+		const double megabytes = FILE_SIZE / (1024.0 * 1024.0);
+		AddInfo(FString::Printf(TEXT("%u KB requests: sync+copy %.1f MB/s, async zero-copy %.1f MB/s"),
+			requestSize / 1024, megabytes / syncSeconds, megabytes / asyncSeconds));
+	}
+
+	// Numbers are warm page cache reads, the file was just written
+	IFileManager::Get().Delete(*path);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAsyncFileReadCancelTest, "Evercoast.GhostTree.AsyncFileRead.Cancel", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAsyncFileReadCancelTest::RunTest(const FString& Parameters)
+{
+	using namespace AsyncFileReadTest;
+
+	const FString path = WriteTestFile();
+	if (!TestFalse(TEXT("Test file written"), path.IsEmpty()))
+		return false;
+
+	IAsyncReadFileHandle* handle = FPlatformFileManager::Get().GetPlatformFile().OpenAsyncRead(*path);
+	TestNotNull(TEXT("Async handle"), handle);
+	if (!handle)
+		return false;
+
+	// What OnCancelConnectionRequest relies on: once Cancel() and WaitCompletion() return, the callback has run
+	// and nothing writes into the destination any more, so GhostTree can take its buffer back
+	const uint32_t requestSize = 1024 * 1024;
+	const uint32_t requestCount = FILE_SIZE / requestSize;
+	std::vector<uint8_t> destination((size_t)FILE_SIZE);
+	std::atomic<uint32_t> callbacks{ 0 };
+	FAsyncFileCallBack callback = [&callbacks](bool wasCancelled, IAsyncReadRequest* request)
+	{
+		callbacks.fetch_add(1);
+	};
+
+	std::vector<IAsyncReadRequest*> requests;
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		requests.push_back(handle->ReadRequest((int64)i * requestSize, requestSize, AIOP_Normal, &callback, destination.data() + (size_t)i * requestSize));
+	}
+
+	for (uint32_t i = 0; i < requestCount; i += 2)
+	{
+		if (requests[i])
+		{
+			requests[i]->Cancel();
+			requests[i]->WaitCompletion();
+			// Poison the buffer, a late write would show up below
+			FMemory::Memset(destination.data() + (size_t)i * requestSize, 0xcd, requestSize);
+		}
+	}
+
+	for (IAsyncReadRequest* request : requests)
+	{
+		if (request)
+		{
+			request->WaitCompletion();
+		}
+	}
+
+	TestEqual(TEXT("Every request called back once"), (int32)callbacks.load(), (int32)requestCount);
+	for (uint32_t i = 0; i < requestCount; ++i)
+	{
+		const uint8_t* data = destination.data() + (size_t)i * requestSize;
+		if (i % 2 == 0)
+		{
+			bool untouched = true;
+			for (uint32_t b = 0; b < requestSize && untouched; ++b)
+			{
+				untouched = data[b] == 0xcd;
+			}
+			TestTrue(TEXT("Cancelled read doesn't write after completion"), untouched);
+		}
+		else
+		{
+			TestTrue(TEXT("Read content"), Verify(data, (uint64_t)i * requestSize, requestSize));
+		}
+	}
+
+	for (IAsyncReadRequest* request : requests)
+	{
+		delete request;
+	}
+	delete handle;
+	IFileManager::Get().Delete(*path);
+	return true;
+}
+
+#endif
@@ -0,0 +1,282 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "EvercoastAsyncStreamingDataDecoder.h"
+#include "EvercoastEncodedDataFrame.h"
+#include "GenericDecoder.h"
+#include "HAL/PlatformTime.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+// ResultCache and ResultPresorter of EvercoastAsyncStreamingDataDecoder without any decoder behind them. Results are
+// plain GenericDecodeResults whose frame index is their ticket sequence, one frame interval apart, so the order they
+// reached the cache in shows in their timestamps.
+namespace AsyncStreamingDataDecoderTest
+{
+	typedef EvercoastAsyncStreamingDataDecoder::ResultCache ResultCache;
+	typedef EvercoastAsyncStreamingDataDecoder::ResultPresorter ResultPresorter;
+
+	static constexpr double FRAME_INTERVAL = 1.0 / 30.0;
+	static constexpr double HALF_FRAME_INTERVAL = FRAME_INTERVAL * 0.5;
+
+	static double TimestampOf(uint64_t sequence)
+	{
+		return sequence * FRAME_INTERVAL;
+	}
+
+	static std::shared_ptr<GenericDecodeResult> MakeResult(const EvercoastDecodeTicket& ticket)
+	{
+		return std::make_shared<GenericDecodeResult>(true, TimestampOf(ticket.sequence), (int64_t)ticket.sequence);
+	}
+
+	// The newest result in the ring is the one of sequence
+	static bool LastAddedIs(const ResultCache& cache, uint64_t sequence)
+	{
+		return !cache.IsBeyond(TimestampOf(sequence), HALF_FRAME_INTERVAL) && cache.IsBeyond(TimestampOf(sequence + 1), HALF_FRAME_INTERVAL);
+	}
+
+	static bool Holds(ResultCache& cache, uint64_t sequence)
+	{
+		std::shared_ptr<GenericDecodeResult> result = cache.Query(TimestampOf(sequence), HALF_FRAME_INTERVAL);
+		return result && result->frameIndex == (int64_t)sequence;
+	}
+
+	static void AddFrame(ResultCache& cache, uint64_t frame)
+	{
+		cache.Add(std::make_shared<GenericDecodeResult>(true, TimestampOf(frame), (int64_t)frame));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastResultPresorterOrderTest, "Evercoast.Decoder.ResultPresorter.Order", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastResultPresorterOrderTest::RunTest(const FString& Parameters)
+{
+	using namespace AsyncStreamingDataDecoderTest;
+
+	ResultCache cache(64);
+	cache.Resize(64, FRAME_INTERVAL);
+	ResultPresorter presorter(cache);
+
+	std::vector<EvercoastDecodeTicket> tickets;
+	for (int i = 0; i < 8; ++i)
+	{
+		tickets.push_back(presorter.Issue());
+	}
+
+	// Later tickets finishing first wait for the earlier ones
+	presorter.Add(tickets[2], MakeResult(tickets[2]));
+	presorter.Add(tickets[1], MakeResult(tickets[1]));
+	presorter.Skip(tickets[3]);
+	TestEqual(TEXT("Nothing delivered before ticket 0"), cache.Size(), 0);
+	TestEqual(TEXT("Held back"), presorter.GetPendingCount(), 3);
+
+	// Ticket 0 releases the run behind it, the skipped ticket included
+	presorter.Add(tickets[0], MakeResult(tickets[0]));
+	TestEqual(TEXT("0 to 2 delivered"), cache.Size(), 3);
+	TestEqual(TEXT("Nothing held back"), presorter.GetPendingCount(), 0);
+	TestTrue(TEXT("2 added last"), LastAddedIs(cache, 2));
+	TestTrue(TEXT("Holds 0"), Holds(cache, 0));
+	TestTrue(TEXT("Holds 1"), Holds(cache, 1));
+	TestFalse(TEXT("Skipped 3 has no result"), Holds(cache, 3));
+
+	presorter.Add(tickets[5], MakeResult(tickets[5]));
+	TestEqual(TEXT("5 waits for 4"), cache.Size(), 3);
+	presorter.Add(tickets[4], MakeResult(tickets[4]));
+	TestEqual(TEXT("4 and 5 delivered"), cache.Size(), 5);
+	TestTrue(TEXT("5 added last"), LastAddedIs(cache, 5));
+
+	// Flushing starts a new epoch, results of earlier tickets are dropped and invalidated
+	presorter.DisposeAndReinit();
+	TestTrue(TEXT("Flushed"), cache.IsEmpty());
+	std::shared_ptr<GenericDecodeResult> stale = MakeResult(tickets[6]);
+	presorter.Add(tickets[6], stale);
+	TestEqual(TEXT("Stale result dropped"), cache.Size(), 0);
+	TestFalse(TEXT("Stale result invalidated"), stale->IsValid());
+	presorter.Skip(tickets[7]);
+	TestEqual(TEXT("Stale skip ignored"), presorter.GetPendingCount(), 0);
+
+	const EvercoastDecodeTicket fresh = presorter.Issue();
+	TestEqual(TEXT("New epoch"), (int64)fresh.epoch, (int64)tickets[0].epoch + 1);
+	TestEqual(TEXT("Sequence starts over"), (int64)fresh.sequence, (int64)0);
+	presorter.Add(fresh, MakeResult(fresh));
+	TestEqual(TEXT("New epoch delivered"), cache.Size(), 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastResultPresorterWorkersTest, "Evercoast.Decoder.ResultPresorter.ConcurrentWorkers", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastResultPresorterWorkersTest::RunTest(const FString& Parameters)
+{
+	using namespace AsyncStreamingDataDecoderTest;
+
+	// Tickets dealt round robin to workers finishing them in a scrambled order of their own, every 7th one fails
+	const uint32_t ticketCount = 2000;
+	const uint32_t workerCount = 4;
+	ResultCache cache(ticketCount + 1);
+	cache.Resize(ticketCount + 1, FRAME_INTERVAL);
+	ResultPresorter presorter(cache);
+
+	std::vector<std::vector<EvercoastDecodeTicket>> workerTickets(workerCount);
+	for (uint32_t i = 0; i < ticketCount; ++i)
+	{
+		workerTickets[i % workerCount].push_back(presorter.Issue());
+	}
+
+	std::vector<std::thread> workers;
+	for (uint32_t w = 0; w < workerCount; ++w)
+	{
+		workers.emplace_back([&presorter, &workerTickets, w]()
+		{
+			std::vector<EvercoastDecodeTicket>& tickets = workerTickets[w];
+			uint32_t state = 0x9e3779b9u + w;
+			for (size_t i = tickets.size(); i > 1; --i)
+			{
+				state = state * 1664525u + 1013904223u;
+				std::swap(tickets[i - 1], tickets[(state >> 8) % i]);
+			}
+
+			for (const EvercoastDecodeTicket& ticket : tickets)
+			{
+				if (ticket.sequence % 7 == 6)
+				{
+					presorter.Skip(ticket);
+				}
+				else
+				{
+					presorter.Add(ticket, MakeResult(ticket));
+				}
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	TestEqual(TEXT("Nothing held back"), presorter.GetPendingCount(), 0);
+	TestEqual(TEXT("Every decoded frame delivered"), cache.Size(), (int32)(ticketCount - ticketCount / 7));
+	TestTrue(TEXT("Last ticket added last"), LastAddedIs(cache, ticketCount - 1));
+	bool allFound = true;
+	bool skippedMissing = true;
+	for (uint64_t sequence = 0; sequence < ticketCount; ++sequence)
+	{
+		if (sequence % 7 == 6)
+		{
+			skippedMissing = skippedMissing && !Holds(cache, sequence);
+		}
+		else
+		{
+			allFound = allFound && Holds(cache, sequence);
+		}
+	}
+	TestTrue(TEXT("Every decoded frame found"), allFound);
+	TestTrue(TEXT("Failed frames missing"), skippedMissing);
+
+	// Delivered in ticket order, so trimming around a frame keeps its neighbours in the ring
+	TestTrue(TEXT("Trimmed around frame 1001"), cache.Trim(TimestampOf(1001), HALF_FRAME_INTERVAL, 10));
+	TestTrue(TEXT("Neighbour before kept"), Holds(cache, 996));
+	TestTrue(TEXT("Neighbour after kept"), Holds(cache, 1005));
+	TestFalse(TEXT("Far frame trimmed"), Holds(cache, 900));
+	TestFalse(TEXT("Far frame after trimmed"), Holds(cache, 1100));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastResultCacheFrameIndexTest, "Evercoast.Decoder.ResultCache.FrameIndex", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastResultCacheFrameIndexTest::RunTest(const FString& Parameters)
+{
+	using namespace AsyncStreamingDataDecoderTest;
+
+	// 32 slots, so a direct-mapped table of 64: frame 64 lands on the slot of frame 0
+	ResultCache cache(32);
+	cache.Resize(32, FRAME_INTERVAL);
+	for (uint64_t frame = 0; frame < 20; ++frame)
+	{
+		AddFrame(cache, frame);
+	}
+
+	bool allFound = true;
+	for (uint64_t frame = 0; frame < 20; ++frame)
+	{
+		// Anywhere within half a frame interval, either side
+		for (double jitter : { -0.45, 0.0, 0.45 })
+		{
+			std::shared_ptr<GenericDecodeResult> result = cache.Query(TimestampOf(frame) + jitter * FRAME_INTERVAL, HALF_FRAME_INTERVAL);
+			allFound = allFound && result && result->frameIndex == (int64_t)frame;
+		}
+	}
+	TestTrue(TEXT("Every frame found within half an interval"), allFound);
+	TestFalse(TEXT("Past the last frame"), Holds(cache, 21));
+	TestTrue(TEXT("Between frames"), cache.Query(TimestampOf(30) + 0.5 * FRAME_INTERVAL, HALF_FRAME_INTERVAL) == nullptr);
+
+	// Looping back in the content, two frames share a slot and both are still found
+	AddFrame(cache, 64);
+	TestTrue(TEXT("Colliding frame found"), Holds(cache, 64));
+	TestTrue(TEXT("Frame it evicted from the slot found"), Holds(cache, 0));
+
+	// Trimming rebuilds the index from what's left in the ring
+	TestTrue(TEXT("Trimmed"), cache.Trim(TimestampOf(10), HALF_FRAME_INTERVAL, 3));
+	TestTrue(TEXT("Median kept"), Holds(cache, 10));
+	TestTrue(TEXT("Within the width kept"), Holds(cache, 7) && Holds(cache, 12));
+	TestFalse(TEXT("Head trimmed"), Holds(cache, 2));
+	TestFalse(TEXT("Tail trimmed"), Holds(cache, 18));
+	TestFalse(TEXT("Looped back frame trimmed"), Holds(cache, 64));
+
+	// Overflowing the ring empties it, the index with it
+	const int32_t untilOverflow = 32 - cache.Size();
+	for (int32_t i = 0; i < untilOverflow; ++i)
+	{
+		AddFrame(cache, 100 + i);
+	}
+	TestTrue(TEXT("Overflown ring reads empty"), cache.IsEmpty());
+	TestFalse(TEXT("Nothing found after overflow"), Holds(cache, 120));
+
+	// No frame interval, the sorted index alone serves the queries
+	ResultCache sortedOnly(32);
+	sortedOnly.Resize(32, 0);
+	for (uint64_t frame = 0; frame < 20; ++frame)
+	{
+		AddFrame(sortedOnly, frame * 3);
+	}
+	TestTrue(TEXT("Sorted index finds a frame"), Holds(sortedOnly, 30));
+	TestFalse(TEXT("Sorted index misses a gap"), Holds(sortedOnly, 31));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastResultCacheQueryBenchmark, "Evercoast.Decoder.ResultCache.QueryBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastResultCacheQueryBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace AsyncStreamingDataDecoderTest;
+
+	// Query cost shouldn't grow with the cache, the direct-mapped index answers in one probe at any size
+	const int32_t queryCount = 1000000;
+	for (int32_t bufferCount : { 30, 240, 1920 })
+	{
+		ResultCache cache(bufferCount);
+		cache.Resize(bufferCount, FRAME_INTERVAL);
+		for (int32_t frame = 0; frame < bufferCount - 1; ++frame)
+		{
+			AddFrame(cache, frame);
+		}
+
+		uint32_t state = 0x9e3779b9u;
+		int32_t found = 0;
+		const double start = FPlatformTime::Seconds();
+		for (int32_t i = 0; i < queryCount; ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			found += cache.Query(TimestampOf((state >> 8) % (bufferCount - 1)), HALF_FRAME_INTERVAL) ? 1 : 0;
+		}
+		const double seconds = FPlatformTime::Seconds() - start;
+
+		TestEqual(*FString::Printf(TEXT("%d slots: every query found"), bufferCount), found, queryCount);
+		AddInfo(FString::Printf(TEXT("%d slots: %.1f ns per query"), bufferCount, seconds * 1e9 / queryCount));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "CortoDecoder.h"
+#include "CortoLocalMeshFrame.h"
+#include "CortoPostProcess.h"
+#include "CortoWebpUnifiedDecodeResult.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Corto mesh hand-off from the decode result to the render proxy. Buffers are filled the way Corto leaves them, then
+// go through ApplyResult and CortoLocalMeshFrame like CortoDecoder and the renderer drive them. The only per frame copy
+// left is the proxy's upload into the locked RHI buffers, everything before it has to alias the decoder's buffers.
+namespace CortoMeshHandoffTest
+{
+	static constexpr uint32_t VERTEX_COUNT = 1001;
+	static constexpr uint32_t TRIANGLE_COUNT = 1999;
+
+	// Corto space mesh, in metres with y up
+	static void FillAsDecoded(CortoDecodeResult& mesh, uint32_t seed)
+	{
+		uint32_t state = seed;
+		auto next = [&state]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		};
+
+		for (uint32_t i = 0; i < TRIANGLE_COUNT * 3; ++i)
+		{
+			mesh.IndexBuffer[i] = next() % VERTEX_COUNT;
+		}
+		for (uint32_t i = 0; i < VERTEX_COUNT; ++i)
+		{
+			mesh.PositionBuffer[i] = FVector3f(next() / 16777216.0f - 0.5f, next() / 16777216.0f * 2.0f, next() / 16777216.0f - 0.5f);
+			mesh.UVBuffer[i] = FVector2f(next() / 16777216.0f, next() / 16777216.0f);
+			mesh.NormalBuffer[i] = FVector3f(0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	static bool SameBytes(const void* a, const void* b, size_t size)
+	{
+		return size == 0 || std::memcmp(a, b, size) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastCortoMeshHandoffTest, "Evercoast.Corto.MeshHandoff.ZeroCopy", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastCortoMeshHandoffTest::RunTest(const FString& Parameters)
+{
+	using namespace CortoMeshHandoffTest;
+
+	CortoWebpUnifiedDecodeResult result(VERTEX_COUNT, TRIANGLE_COUNT, 0, 0, 4);
+	CortoDecodeResult& mesh = *result.meshResult;
+	FillAsDecoded(mesh, 1);
+
+	const uint32_t* indices = mesh.IndexBuffer.data();
+	const FVector3f* positions = mesh.PositionBuffer.data();
+	const FVector2f* uvs = mesh.UVBuffer.data();
+	const FVector3f* normals = mesh.NormalBuffer.data();
+
+	// Reference conversion out of place, through the scalar kernel
+	std::vector<uint32_t> expectedIndices(TRIANGLE_COUNT * 3);
+	std::vector<FVector3f> expectedPositions(VERTEX_COUNT), expectedNormals(VERTEX_COUNT);
+	const std::vector<FVector2f> expectedUVs(mesh.UVBuffer.begin(), mesh.UVBuffer.begin() + VERTEX_COUNT);
+	CortoPostProcess::MeshBounds expectedBounds = CortoPostProcess::ProcessScalar(indices, expectedIndices.data(), TRIANGLE_COUNT, true,
+		positions, expectedPositions.data(), normals, expectedNormals.data(), VERTEX_COUNT, CortoDecoder::POSITION_SCALE);
+
+	// In place, no buffer moves
+	mesh.ApplyResult(true, 0.5, 15, VERTEX_COUNT, TRIANGLE_COUNT, true, true, CortoDecoder::POSITION_SCALE);
+	result.SyncWithMeshResult();
+	TestTrue(TEXT("Conversion keeps the decoded buffers"), mesh.IndexBuffer.data() == indices && mesh.PositionBuffer.data() == positions &&
+		mesh.UVBuffer.data() == uvs && mesh.NormalBuffer.data() == normals);
+	TestTrue(TEXT("In place indices match out of place"), SameBytes(indices, expectedIndices.data(), expectedIndices.size() * sizeof(uint32_t)));
+	TestTrue(TEXT("In place positions match out of place"), SameBytes(positions, expectedPositions.data(), expectedPositions.size() * sizeof(FVector3f)));
+	TestTrue(TEXT("In place normals match out of place"), SameBytes(normals, expectedNormals.data(), expectedNormals.size() * sizeof(FVector3f)));
+	TestTrue(TEXT("Bounds"), mesh.BoundsMin == expectedBounds.Min && mesh.BoundsMax == expectedBounds.Max && !mesh.BoundsHasNaN);
+
+	// The frame handed to the renderer is a view of the same buffers
+	CortoLocalMeshFrame frame(&result);
+	TestEqual(TEXT("Index count"), (int32)frame.GetIndexCount(), (int32)(TRIANGLE_COUNT * 3));
+	TestEqual(TEXT("Vertex count"), (int32)frame.GetVertexCount(), (int32)VERTEX_COUNT);
+	TestTrue(TEXT("Frame aliases the decoded buffers"), frame.GetIndexData() == indices && frame.GetPositionData() == positions &&
+		frame.GetUVData() == uvs && frame.GetNormalData() == normals);
+	TestTrue(TEXT("Frame uvs untouched"), SameBytes(frame.GetUVData(), expectedUVs.data(), expectedUVs.size() * sizeof(FVector2f)));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastCortoMeshDetachTest, "Evercoast.Corto.MeshHandoff.DetachSharedMesh", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastCortoMeshDetachTest::RunTest(const FString& Parameters)
+{
+	using namespace CortoMeshHandoffTest;
+
+	CortoWebpUnifiedDecodeResult result(VERTEX_COUNT, TRIANGLE_COUNT, 0, 0, 4);
+	FillAsDecoded(*result.meshResult, 2);
+	result.meshResult->ApplyResult(true, 0.0, 0, VERTEX_COUNT, TRIANGLE_COUNT, false, false, CortoDecoder::POSITION_SCALE);
+	result.SyncWithMeshResult();
+
+	// Nobody holds the mesh, the pool reuses it as is
+	const CortoDecodeResult* firstMesh = result.meshResult.get();
+	result.DetachSharedMesh();
+	TestTrue(TEXT("Unshared mesh is reused"), result.meshResult.get() == firstMesh);
+
+	// A renderer shows it, the result gets reused for the next frame
+	std::unique_ptr<CortoLocalMeshFrame> frame = std::make_unique<CortoLocalMeshFrame>(&result);
+	const std::vector<uint32_t> shownIndices(frame->GetIndexData(), frame->GetIndexData() + frame->GetIndexCount());
+	const std::vector<FVector3f> shownPositions(frame->GetPositionData(), frame->GetPositionData() + frame->GetVertexCount());
+	TestTrue(TEXT("Shown frame has no normals"), frame->GetNormalData() == nullptr);
+
+	// Evicted from the result cache first, which only clears flags, then handed out by the pool
+	result.InvalidateResult();
+	result.DetachSharedMesh();
+	TestTrue(TEXT("Shared mesh is left to the frame"), result.meshResult.get() != firstMesh && frame->m_mesh.get() == firstMesh);
+	TestEqual(TEXT("New mesh keeps the reservation"), (int32)result.meshResult->VertexReserved, (int32)VERTEX_COUNT);
+
+	// Next frame decoded into the new mesh, the shown one is unaffected
+	FillAsDecoded(*result.meshResult, 3);
+	result.meshResult->ApplyResult(true, 1.0, 1, VERTEX_COUNT / 2, TRIANGLE_COUNT / 2, true, true, CortoDecoder::POSITION_SCALE);
+	TestEqual(TEXT("Shown frame keeps its vertex count"), (int32)frame->GetVertexCount(), (int32)VERTEX_COUNT);
+	TestTrue(TEXT("Shown indices unchanged"), SameBytes(frame->GetIndexData(), shownIndices.data(), shownIndices.size() * sizeof(uint32_t)));
+	TestTrue(TEXT("Shown positions unchanged"), SameBytes(frame->GetPositionData(), shownPositions.data(), shownPositions.size() * sizeof(FVector3f)));
+
+	// Once the renderer lets go, the new mesh is the only one left and gets reused again
+	frame.reset();
+	const CortoDecodeResult* secondMesh = result.meshResult.get();
+	result.DetachSharedMesh();
+	TestTrue(TEXT("Released mesh is reused"), result.meshResult.get() == secondMesh);
+	return true;
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "CortoMeshRendererComp.h"
+#include "CortoDecoder.h"
+#include "CortoLocalMeshFrame.h"
+#include "CortoWebpUnifiedDecodeResult.h"
+#include "Engine/World.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "RenderingThread.h"
+#include <memory>
+#include <vector>
+
+// Mesh frames handed to a registered UCortoMeshRendererComp while the render thread is held up. SetMeshData() has to
+// return straight away with the updates queued, and they all have to land once the render thread moves again.
+namespace CortoMeshUpdateTest
+{
+	static constexpr uint32_t VERTEX_COUNT = 1001;
+	static constexpr uint32_t TRIANGLE_COUNT = 1999;
+	static constexpr int32 FRAME_COUNT = 8;
+	// Long enough that a wait in SetMeshData() shows up, short enough that a regression fails instead of hanging
+	static constexpr uint32 STALL_MILLISECONDS = 2000;
+
+	static std::unique_ptr<CortoWebpUnifiedDecodeResult> MakeDecodedMesh(uint32_t seed)
+	{
+		auto result = std::make_unique<CortoWebpUnifiedDecodeResult>(VERTEX_COUNT, TRIANGLE_COUNT, 0, 0, 4);
+		CortoDecodeResult& mesh = *result->meshResult;
+
+		uint32_t state = seed;
+		auto next = [&state]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		};
+		for (uint32_t i = 0; i < TRIANGLE_COUNT * 3; ++i)
+		{
+			mesh.IndexBuffer[i] = next() % VERTEX_COUNT;
+		}
+		for (uint32_t i = 0; i < VERTEX_COUNT; ++i)
+		{
+			mesh.PositionBuffer[i] = FVector3f(next() / 16777216.0f - 0.5f, next() / 16777216.0f * 2.0f, next() / 16777216.0f - 0.5f);
+			mesh.UVBuffer[i] = FVector2f(next() / 16777216.0f, next() / 16777216.0f);
+		}
+
+		mesh.ApplyResult(true, seed / 30.0, seed, VERTEX_COUNT, TRIANGLE_COUNT, false, false, CortoDecoder::POSITION_SCALE);
+		result->SyncWithMeshResult();
+		return result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastCortoMeshUpdateNoWaitTest, "Evercoast.Corto.MeshUpdate.NoGameThreadWait", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastCortoMeshUpdateNoWaitTest::RunTest(const FString& Parameters)
+{
+	using namespace CortoMeshUpdateTest;
+
+	if (!GIsThreadedRendering)
+	{
+		AddInfo(TEXT("Rendering runs on the game thread here, there's no render thread to get ahead of"));
+		return true;
+	}
+
+	std::vector<std::unique_ptr<CortoWebpUnifiedDecodeResult>> decoded;
+	std::vector<std::shared_ptr<CortoLocalMeshFrame>> frames;
+	for (int32 i = 0; i < FRAME_COUNT; ++i)
+	{
+		decoded.push_back(MakeDecodedMesh(i + 1));
+		frames.push_back(std::make_shared<CortoLocalMeshFrame>(decoded.back().get()));
+	}
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false);
+	UCortoMeshRendererComp* component = NewObject<UCortoMeshRendererComp>(world);
+	// No capture targets needed to upload meshes
+	component->bGenerateNormal = false;
+	component->RegisterComponentWithWorld(world);
+	world->SendAllEndOfFrameUpdates();
+	FlushRenderingCommands();
+
+	if (TestNotNull(TEXT("Scene proxy"), component->SceneProxy))
+	{
+		// Holds the render thread until the game thread is done queueing, or the stall runs out
+		FEvent* release = FPlatformProcess::GetSynchEventFromPool(true);
+		ENQUEUE_RENDER_COMMAND(EvercoastStallRenderThread)([release](FRHICommandListImmediate& RHICmdList)
+			{
+				release->Wait(STALL_MILLISECONDS);
+			});
+
+		const double start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < FRAME_COUNT; ++i)
+		{
+			component->SetMeshData(frames[i]);
+		}
+		const double elapsed = FPlatformTime::Seconds() - start;
+		const int32 queued = component->GetMeshUpdatesInFlight();
+
+		release->Trigger();
+		FlushRenderingCommands();
+		FPlatformProcess::ReturnSynchEventToPool(release);
+
+		AddInfo(FString::Printf(TEXT("%d mesh updates queued behind a stalled render thread in %.3f ms, %.1f us each"),
+			FRAME_COUNT, elapsed * 1000.0, elapsed * 1e6 / FRAME_COUNT));
+		TestEqual(TEXT("Every update queued, none waited for"), queued, FRAME_COUNT);
+		TestTrue(TEXT("Returned before the render thread was released"), elapsed * 1000.0 < STALL_MILLISECONDS / 2);
+		TestEqual(TEXT("All updates applied after a flush"), component->GetMeshUpdatesInFlight(), 0);
+	}
+
+	component->UnregisterComponent();
+	world->DestroyWorld(false);
+	FlushRenderingCommands();
+	return true;
+}
+
+#endif
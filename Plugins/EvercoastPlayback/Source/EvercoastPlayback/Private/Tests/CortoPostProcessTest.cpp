@@ -0,0 +1,173 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "CortoPostProcess.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// CortoPostProcess::Process, whichever kernel set is compiled in, against ProcessScalar on the same input. Outputs
+// and bounds are compared bit for bit, over vertex counts hitting every tail length of the 4-wide loops and inputs
+// salted with NaN, infinities and zeros of both signs.
+namespace CortoPostProcessTest
+{
+	struct Mesh
+	{
+		std::vector<uint32_t> indices;
+		std::vector<FVector3f> positions;
+		std::vector<FVector3f> normals;
+	};
+
+	static uint32_t Next(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return state;
+	}
+
+	static float RandomFloat(uint32_t& state, bool specials)
+	{
+		const uint32_t pick = Next(state) >> 24;
+		if (specials)
+		{
+			switch (pick)
+			{
+			case 0: return std::numeric_limits<float>::quiet_NaN();
+			case 1: return std::numeric_limits<float>::infinity();
+			case 2: return -std::numeric_limits<float>::infinity();
+			case 3: return 0.0f;
+			case 4: return -0.0f;
+			default: break;
+			}
+		}
+		return ((Next(state) >> 8) / 16777216.0f - 0.5f) * 200.0f;
+	}
+
+	static Mesh MakeMesh(uint32_t vertexCount, uint32_t triangleCount, bool specials, uint32_t seed)
+	{
+		uint32_t state = seed;
+		Mesh mesh;
+		for (uint32_t i = 0; i < triangleCount * 3; ++i)
+		{
+			mesh.indices.push_back(vertexCount > 0 ? Next(state) % vertexCount : 0);
+		}
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			mesh.positions.push_back(FVector3f(RandomFloat(state, specials), RandomFloat(state, specials), RandomFloat(state, specials)));
+			mesh.normals.push_back(FVector3f(RandomFloat(state, false), RandomFloat(state, false), RandomFloat(state, false)));
+		}
+		return mesh;
+	}
+
+	static bool SameBits(const void* a, const void* b, size_t size)
+	{
+		return size == 0 || memcmp(a, b, size) == 0;
+	}
+
+	static bool SameBounds(const CortoPostProcess::MeshBounds& a, const CortoPostProcess::MeshBounds& b)
+	{
+		return SameBits(&a.Min, &b.Min, sizeof(FVector3f)) && SameBits(&a.Max, &b.Max, sizeof(FVector3f)) && a.bHasNaN == b.bHasNaN;
+	}
+
+	// Empty string if the kernels agree, what differs otherwise
+	static FString Compare(const Mesh& mesh, bool flipWinding, bool withNormals, bool inPlace, float scale)
+	{
+		const uint32_t vertexCount = (uint32_t)mesh.positions.size();
+		const uint32_t triangleCount = (uint32_t)mesh.indices.size() / 3;
+
+		Mesh reference = mesh;
+		const CortoPostProcess::MeshBounds referenceBounds = CortoPostProcess::ProcessScalar(mesh.indices.data(), reference.indices.data(), triangleCount, flipWinding,
+			mesh.positions.data(), reference.positions.data(), withNormals ? mesh.normals.data() : nullptr, reference.normals.data(), vertexCount, scale);
+
+		Mesh output = mesh;
+		const Mesh& input = inPlace ? output : mesh;
+		const CortoPostProcess::MeshBounds bounds = CortoPostProcess::Process(input.indices.data(), output.indices.data(), triangleCount, flipWinding,
+			input.positions.data(), output.positions.data(), withNormals ? input.normals.data() : nullptr, output.normals.data(), vertexCount, scale);
+
+		FString differences;
+		if (!SameBits(output.indices.data(), reference.indices.data(), output.indices.size() * sizeof(uint32_t)))
+			differences += TEXT(" indices");
+		if (!SameBits(output.positions.data(), reference.positions.data(), output.positions.size() * sizeof(FVector3f)))
+			differences += TEXT(" positions");
+		if (!SameBits(output.normals.data(), reference.normals.data(), output.normals.size() * sizeof(FVector3f)))
+			differences += TEXT(" normals");
+		if (!SameBounds(bounds, referenceBounds))
+			differences += TEXT(" bounds");
+		return differences;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastCortoPostProcessBitExactTest, "Evercoast.Decoder.CortoPostProcess.BitExact", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastCortoPostProcessBitExactTest::RunTest(const FString& Parameters)
+{
+	using namespace CortoPostProcessTest;
+
+	AddInfo(FString::Printf(TEXT("Kernels: %s"), CortoPostProcess::GetKernelName()));
+
+	// Every tail length of the 4-wide loops on both indices and vertices, and one mesh big enough to matter
+	std::vector<uint32_t> vertexCounts = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 1001 };
+	uint32_t seed = 1;
+	int32_t mismatches = 0;
+	for (uint32_t vertexCount : vertexCounts)
+	{
+		for (uint32_t triangleCount : { vertexCount, vertexCount + 1, vertexCount * 2 + 3 })
+		{
+			for (bool specials : { false, true })
+			{
+				const Mesh mesh = MakeMesh(vertexCount, triangleCount, specials, seed++);
+				for (int32_t variant = 0; variant < 8; ++variant)
+				{
+					const bool flipWinding = (variant & 1) != 0;
+					const bool withNormals = (variant & 2) != 0;
+					const bool inPlace = (variant & 4) != 0;
+					const FString differences = Compare(mesh, flipWinding, withNormals, inPlace, 100.0f);
+					if (!differences.IsEmpty())
+					{
+						++mismatches;
+						AddError(FString::Printf(TEXT("%u vertices, %u triangles%s%s%s%s: differs in%s"), vertexCount, triangleCount,
+							specials ? TEXT(", special values") : TEXT(""), flipWinding ? TEXT(", flipped") : TEXT(""),
+							withNormals ? TEXT(", normals") : TEXT(""), inPlace ? TEXT(", in place") : TEXT(""), *differences));
+					}
+				}
+			}
+		}
+	}
+	TestEqual(TEXT("Kernels agree bit for bit"), mismatches, 0);
+
+	// Bounds on their own: a NaN is flagged but never lands in the bounds, no matter which lane it's in
+	for (uint32_t nanAt = 0; nanAt < 9; ++nanAt)
+	{
+		std::vector<FVector3f> positions(9, FVector3f(1.0f, 2.0f, 3.0f));
+		positions[4] = FVector3f(-5.0f, 6.0f, -7.0f);
+		positions[nanAt].Y = std::numeric_limits<float>::quiet_NaN();
+		std::vector<FVector3f> output(positions.size());
+		const CortoPostProcess::MeshBounds bounds = CortoPostProcess::Process(nullptr, nullptr, 0, false,
+			positions.data(), output.data(), nullptr, nullptr, (uint32_t)positions.size(), 1.0f);
+		TestTrue(*FString::Printf(TEXT("NaN at %u flagged"), nanAt), bounds.bHasNaN);
+		TestFalse(*FString::Printf(TEXT("NaN at %u kept out of the bounds"), nanAt),
+			std::isnan(bounds.Min.X) || std::isnan(bounds.Min.Y) || std::isnan(bounds.Min.Z) ||
+			std::isnan(bounds.Max.X) || std::isnan(bounds.Max.Y) || std::isnan(bounds.Max.Z));
+		if (nanAt != 4)
+		{
+			// Swapped y<->z
+			TestTrue(*FString::Printf(TEXT("NaN at %u bounds"), nanAt), bounds.Min == FVector3f(-5.0f, -7.0f, 2.0f) && bounds.Max == FVector3f(1.0f, 3.0f, 6.0f));
+		}
+	}
+
+	// Zeros of both signs: whichever a variant keeps, the bounds come out as +0
+	{
+		std::vector<FVector3f> positions = { FVector3f(0.0f, 0.0f, 0.0f), FVector3f(-0.0f, -0.0f, -0.0f), FVector3f(0.0f, -0.0f, 0.0f),
+			FVector3f(-0.0f, 0.0f, -0.0f), FVector3f(-0.0f, -0.0f, 0.0f) };
+		std::vector<FVector3f> output(positions.size());
+		const CortoPostProcess::MeshBounds bounds = CortoPostProcess::Process(nullptr, nullptr, 0, false,
+			positions.data(), output.data(), nullptr, nullptr, (uint32_t)positions.size(), 1.0f);
+		const FVector3f zero(0.0f, 0.0f, 0.0f);
+		TestTrue(TEXT("Signed zero bounds are +0"), SameBits(&bounds.Min, &zero, sizeof(FVector3f)) && SameBits(&bounds.Max, &zero, sizeof(FVector3f)));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "DecodeResultPool.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// DecodeResultPool with a stand-in result that counts its instances and flags itself while handed out, so an object
+// given to two holders at once or leaked on the way back shows up.
+namespace DecodeResultPoolTest
+{
+	static std::atomic<int32_t> s_liveCount{ 0 };
+
+	struct TestResult
+	{
+		std::vector<uint8_t> buffer;
+		std::atomic<bool> inUse{ false };
+		int32_t invalidations = 0;
+
+		explicit TestResult(size_t size) :
+			buffer(size)
+		{
+			s_liveCount.fetch_add(1);
+		}
+
+		~TestResult()
+		{
+			s_liveCount.fetch_sub(1);
+		}
+
+		void InvalidateResult()
+		{
+			++invalidations;
+		}
+
+		uint64_t GetAllocatedBytes() const
+		{
+			return buffer.size();
+		}
+	};
+
+	typedef DecodeResultPool<TestResult> Pool;
+
+	static std::shared_ptr<Pool> MakePool(int32_t maxIdleCount)
+	{
+		return Pool::Create(maxIdleCount, []()
+			{
+				return new TestResult(1024);
+			});
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastDecodeResultPoolRecycleTest, "Evercoast.Decoder.ResultPool.Recycle", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastDecodeResultPoolRecycleTest::RunTest(const FString& Parameters)
+{
+	using namespace DecodeResultPoolTest;
+
+	const int32_t liveBefore = s_liveCount.load();
+	{
+		std::shared_ptr<Pool> pool = MakePool(3);
+
+		// Released by the last holder, then handed out again as is
+		TestResult* first = nullptr;
+		{
+			std::shared_ptr<TestResult> result = pool->Acquire();
+			first = result.get();
+			result->buffer.resize(4096);
+			std::shared_ptr<TestResult> renderer = result;
+			result.reset();
+			TestEqual(TEXT("Still held by the renderer"), (int32)pool->GetStats().idleCount, 0);
+		}
+		Pool::Stats stats = pool->GetStats();
+		TestEqual(TEXT("Back in the pool"), (int32)stats.idleCount, 1);
+		TestEqual(TEXT("Idle bytes"), (int64)stats.bytesHeld, (int64)4096);
+		TestEqual(TEXT("Invalidated on the way back"), first->invalidations, 1);
+
+		std::shared_ptr<TestResult> again = pool->Acquire();
+		TestTrue(TEXT("Same object"), again.get() == first);
+		TestEqual(TEXT("Keeps its buffer"), (int64)again->buffer.size(), (int64)4096);
+		stats = pool->GetStats();
+		TestEqual(TEXT("One hit"), (int64)stats.hits, (int64)1);
+		TestEqual(TEXT("One miss"), (int64)stats.misses, (int64)1);
+		TestEqual(TEXT("Nothing idle"), (int64)stats.bytesHeld, (int64)0);
+		again.reset();
+
+		// Only maxIdleCount objects are kept, the rest go back to the heap
+		std::vector<std::shared_ptr<TestResult>> burst;
+		for (int i = 0; i < 6; ++i)
+		{
+			burst.push_back(pool->Acquire());
+		}
+		TestEqual(TEXT("Burst allocated"), s_liveCount.load() - liveBefore, 6);
+		burst.clear();
+		TestEqual(TEXT("Idle capped"), (int32)pool->GetStats().idleCount, 3);
+		TestEqual(TEXT("Over the cap deleted"), s_liveCount.load() - liveBefore, 3);
+
+		// A result outliving its pool is deleted when released
+		std::shared_ptr<TestResult> orphan = pool->Acquire();
+		pool.reset();
+		TestEqual(TEXT("Idle ones deleted with the pool"), s_liveCount.load() - liveBefore, 1);
+		orphan.reset();
+	}
+	TestEqual(TEXT("Nothing leaked"), s_liveCount.load(), liveBefore);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastDecodeResultPoolConcurrentTest, "Evercoast.Decoder.ResultPool.Concurrent", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastDecodeResultPoolConcurrentTest::RunTest(const FString& Parameters)
+{
+	using namespace DecodeResultPoolTest;
+
+	// Decode threads acquiring while another releases what they produce, like the game thread trimming the cache.
+	// Each keeps at most a few results outstanding, the way the bounded result cache holds them back.
+	const int32_t producerCount = 3;
+	const size_t maxOutstanding = 4;
+	const int32_t resultsPerProducer = 20000;
+	const int32_t liveBefore = s_liveCount.load();
+	std::atomic<int32_t> doubleHandouts{ 0 };
+	{
+		std::shared_ptr<Pool> pool = MakePool(16);
+		std::vector<std::shared_ptr<TestResult>> handoff[producerCount];
+		std::mutex handoffLock;
+		std::atomic<int32_t> producersDone{ 0 };
+
+		std::vector<std::thread> threads;
+		for (int32_t p = 0; p < producerCount; ++p)
+		{
+			threads.emplace_back([&, p]()
+			{
+				for (int32_t i = 0; i < resultsPerProducer; ++i)
+				{
+					std::shared_ptr<TestResult> result = pool->Acquire();
+					if (result->inUse.exchange(true))
+					{
+						doubleHandouts.fetch_add(1);
+					}
+					while (true)
+					{
+						{
+							std::lock_guard<std::mutex> guard(handoffLock);
+							if (handoff[p].size() < maxOutstanding)
+							{
+								handoff[p].push_back(std::move(result));
+								break;
+							}
+						}
+						std::this_thread::yield();
+					}
+				}
+				producersDone.fetch_add(1);
+			});
+		}
+
+		threads.emplace_back([&]()
+		{
+			std::vector<std::shared_ptr<TestResult>> taken;
+			while (true)
+			{
+				const bool done = producersDone.load() == producerCount;
+				{
+					std::lock_guard<std::mutex> guard(handoffLock);
+					for (auto& queue : handoff)
+					{
+						for (auto& result : queue)
+						{
+							taken.push_back(std::move(result));
+						}
+						queue.clear();
+					}
+				}
+				for (auto& result : taken)
+				{
+					result->inUse.store(false);
+				}
+				// Dropped outside the lock, straight back to the pool
+				taken.clear();
+				if (done)
+					break;
+				std::this_thread::yield();
+			}
+		});
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		const Pool::Stats stats = pool->GetStats();
+		AddInfo(FString::Printf(TEXT("%d results: %llu hits, %llu misses, %d idle"), producerCount * resultsPerProducer,
+			(unsigned long long)stats.hits, (unsigned long long)stats.misses, stats.idleCount));
+		TestEqual(TEXT("Every acquire counted"), (int64)(stats.hits + stats.misses), (int64)producerCount * resultsPerProducer);
+		TestTrue(TEXT("Idle within the cap"), stats.idleCount <= 16);
+		TestTrue(TEXT("Mostly recycled"), stats.hits > stats.misses);
+		TestEqual(TEXT("Only the idle ones are alive"), s_liveCount.load() - liveBefore, stats.idleCount);
+	}
+	TestEqual(TEXT("Never handed out twice"), doubleHandouts.load(), 0);
+	TestEqual(TEXT("Nothing leaked"), s_liveCount.load(), liveBefore);
+	return true;
+}
+
+#endif
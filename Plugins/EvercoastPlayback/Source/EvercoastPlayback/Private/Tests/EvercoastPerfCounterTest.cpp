@@ -0,0 +1,156 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "EvercoastPerfCounter.h"
+#include "HAL/PlatformTime.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// EvercoastPerfCounter's windowed histograms against exact answers, and the cost of adding a sample while several
+// threads feed the same counter like the network, decoder and game threads do
+namespace EvercoastPerfCounterTest
+{
+	// Log-linear buckets with 16 sub-buckets per power of two are within about 3%
+	static constexpr double RELATIVE_ERROR = 0.035;
+
+	static bool Near(double value, double expected)
+	{
+		return std::abs(value - expected) <= std::abs(expected) * RELATIVE_ERROR;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastPerfCounterAccuracyTest, "Evercoast.PerfCounter.Accuracy", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastPerfCounterAccuracyTest::RunTest(const FString& Parameters)
+{
+	using namespace EvercoastPerfCounterTest;
+
+	// Frame times around 50ms, spread by a deterministic LCG
+	EvercoastPerfCounter frameTimes("frameTimes", 60.0);
+	std::vector<double> samples;
+	uint32_t state = 1;
+	for (int32_t i = 0; i < 100000; ++i)
+	{
+		state = state * 1664525u + 1013904223u;
+		const double sample = 0.03 + 0.04 * (state >> 8) / 16777216.0;
+		samples.push_back(sample);
+		frameTimes.AddSampleAsDouble(sample);
+	}
+	std::sort(samples.begin(), samples.end());
+	double sum = 0;
+	for (double sample : samples)
+	{
+		sum += sample;
+	}
+
+	const EvercoastPerfCounter::Summary summary = frameTimes.GetSummary();
+	TestEqual(TEXT("Sample count"), (int64)summary.count, (int64)samples.size());
+	TestEqual(TEXT("Accumulated"), summary.accumulated, sum, sum * 1e-9);
+	TestEqual(TEXT("Average on count"), frameTimes.GetSampleAverageDoubleOnCount(), sum / samples.size(), 1e-9);
+	TestTrue(*FString::Printf(TEXT("p50 %.5f, exact %.5f"), summary.p50, samples[50000]), Near(summary.p50, samples[50000]));
+	TestTrue(*FString::Printf(TEXT("p95 %.5f, exact %.5f"), summary.p95, samples[95000]), Near(summary.p95, samples[95000]));
+	TestTrue(*FString::Printf(TEXT("p99 %.5f, exact %.5f"), summary.p99, samples[99000]), Near(summary.p99, samples[99000]));
+
+	// Integer sums stay exact, negative values get their own buckets
+	EvercoastPerfCounter offsets("offsets", 60.0);
+	int64_t intSum = 0;
+	for (int32_t i = -50; i <= 50; ++i)
+	{
+		offsets.AddSampleAsInt64(i * 1000);
+		intSum += i * 1000;
+	}
+	TestEqual(TEXT("Int64 accumulated"), (int64)offsets.GetSampleAccumulatedInt64(), (int64)intSum);
+	TestTrue(*FString::Printf(TEXT("Negative p1 %.0f"), offsets.GetSamplePercentile(0.01)), Near(offsets.GetSamplePercentile(0.01), -49000.0));
+	TestTrue(*FString::Printf(TEXT("Positive p99 %.0f"), offsets.GetSamplePercentile(0.99)), Near(offsets.GetSamplePercentile(0.99), 49000.0));
+
+	// Samples older than the time span drop out, from the histograms too once their slices come round again
+	EvercoastPerfCounter window("window", 0.4);
+	for (int32_t i = 0; i < 100; ++i)
+	{
+		window.AddSampleAsDouble(5.0);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	for (int32_t i = 0; i < 10; ++i)
+	{
+		window.AddSample();
+	}
+	TestEqual(TEXT("Window keeps the recent samples"), (int64)window.GetSampleCount(), (int64)10);
+	TestTrue(*FString::Printf(TEXT("Window p99 %.3f"), window.GetSamplePercentile(0.99)), Near(window.GetSamplePercentile(0.99), 1.0));
+
+	// Doubles beyond int64 saturate the integer sum
+	EvercoastPerfCounter extremes("extremes", 60.0);
+	extremes.AddSampleAsDouble(1e300);
+	extremes.AddSampleAsDouble(std::numeric_limits<double>::quiet_NaN());
+	extremes.AddSampleAsDouble(-std::numeric_limits<double>::infinity());
+	TestEqual(TEXT("Out of range doubles counted"), (int64)extremes.GetSampleCount(), (int64)3);
+	extremes.Reset();
+	extremes.AddSampleAsDouble(1e300);
+	TestEqual(TEXT("Int64 sum saturates"), (int64)extremes.GetSampleAccumulatedInt64(), (int64)9223372036854774784LL);
+
+	window.Reset();
+	TestEqual(TEXT("Empty after reset"), (int64)window.GetSampleCount(), (int64)0);
+	TestEqual(TEXT("No percentile without samples"), window.GetSamplePercentile(0.5), -1.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastPerfCounterContentionBenchmark, "Evercoast.PerfCounter.ContentionBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastPerfCounterContentionBenchmark::RunTest(const FString& Parameters)
+{
+	const int32_t samplesPerThread = 1000000;
+	const int32_t cores = std::max(1, (int32_t)std::thread::hardware_concurrency());
+	AddInfo(FString::Printf(TEXT("%d hardware threads"), cores));
+
+	for (int32_t threadCount : { 1, 2, 4, 8 })
+	{
+		// Long enough that nothing ages out while the threads run
+		EvercoastPerfCounter counter("contended", 600.0);
+		std::vector<std::thread> threads;
+		const double start = FPlatformTime::Seconds();
+		for (int32_t t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back([&counter, samplesPerThread, t]()
+				{
+					for (int32_t i = 0; i < samplesPerThread; ++i)
+					{
+						counter.AddSampleAsDouble((t + 1) * 1e-3 + i * 1e-9);
+					}
+				});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		const double elapsed = FPlatformTime::Seconds() - start;
+
+		// Threads beyond the core count only time slice, so charge each record the cores actually busy
+		const int64_t total = (int64_t)threadCount * samplesPerThread;
+		const double nsPerRecord = elapsed * 1e9 * std::min(threadCount, cores) / total;
+		AddInfo(FString::Printf(TEXT("%d threads: %.1f ns per record, %.1fM records/s"), threadCount, nsPerRecord, total / elapsed / 1e6));
+
+		TestEqual(*FString::Printf(TEXT("No sample lost, %d threads"), threadCount), (int64)counter.GetSampleCount(), (int64)total);
+		TestTrue(*FString::Printf(TEXT("Record stays under a microsecond, %d threads"), threadCount), nsPerRecord < 1000.0);
+	}
+
+	// Reading merges every shard and slice, it runs once per frame at most
+	EvercoastPerfCounter counter("read", 2.0);
+	for (int32_t i = 0; i < 1000; ++i)
+	{
+		counter.AddSampleAsDouble(i * 1e-3);
+	}
+	const int32_t reads = 1000;
+	const double start = FPlatformTime::Seconds();
+	for (int32_t i = 0; i < reads; ++i)
+	{
+		counter.GetSummary();
+	}
+	AddInfo(FString::Printf(TEXT("GetSummary: %.1f us"), (FPlatformTime::Seconds() - start) * 1e6 / reads));
+	return true;
+}
+
+#endif
@@ -0,0 +1,475 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "FFmpegDecodingThread.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// FFFmpegDecodingThread on the CPU only: frames end in the convert callback instead of textures, so what's measured is
+// demux, decode and pixel format conversion. The clip is encoded up front with FFmpeg's own MPEG-4 part 2 encoder,
+// the LGPL build has no H.264 encoder. Slow moving gradients under noise, so frames don't decode for free.
+namespace FFmpegDecodingThreadTest
+{
+	static constexpr int FRAME_RATE = 30;
+	static constexpr int GOP_SIZE = 30;
+	static constexpr double WAIT_TIMEOUT = 60.0;
+
+	static FString ClipPath(int width, int height)
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectIntermediateDir(), FString::Printf(TEXT("EvercoastFFmpegTest_%dx%d.mp4"), width, height)));
+	}
+
+	static void FillFrame(AVFrame* frame, int frameIndex)
+	{
+		uint32_t state = 0x9e3779b9u + frameIndex;
+		for (int y = 0; y < frame->height; ++y)
+		{
+			uint8_t* row = frame->data[0] + (size_t)y * frame->linesize[0];
+			for (int x = 0; x < frame->width; ++x)
+			{
+				state = state * 1664525u + 1013904223u;
+				row[x] = (uint8_t)(x / 4 + y / 2 + frameIndex * 3 + (state >> 29));
+			}
+		}
+		for (int plane = 1; plane < 3; ++plane)
+		{
+			for (int y = 0; y < frame->height / 2; ++y)
+			{
+				uint8_t* row = frame->data[plane] + (size_t)y * frame->linesize[plane];
+				for (int x = 0; x < frame->width / 2; ++x)
+				{
+					row[x] = (uint8_t)(128 + (plane == 1 ? x : y) / 8 - frameIndex);
+				}
+			}
+		}
+	}
+
+	static bool WriteClip(const FString& path, int width, int height, int frameCount)
+	{
+		const FTCHARToUTF8 utf8Path(*path);
+		AVFormatContext* formatCtx = nullptr;
+		if (avformat_alloc_output_context2(&formatCtx, nullptr, "mp4", utf8Path.Get()) < 0)
+			return false;
+
+		const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+		AVStream* stream = codec ? avformat_new_stream(formatCtx, nullptr) : nullptr;
+		AVCodecContext* codecCtx = stream ? avcodec_alloc_context3(codec) : nullptr;
+		AVFrame* frame = av_frame_alloc();
+		AVPacket* packet = av_packet_alloc();
+		bool succeeded = codecCtx && frame && packet;
+		bool headerWritten = false;
+		if (succeeded)
+		{
+			codecCtx->width = width;
+			codecCtx->height = height;
+			codecCtx->time_base = av_make_q(1, FRAME_RATE);
+			codecCtx->framerate = av_make_q(FRAME_RATE, 1);
+			codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
+			codecCtx->gop_size = GOP_SIZE;
+			codecCtx->max_b_frames = 0;
+			codecCtx->bit_rate = (int64_t)width * height * FRAME_RATE / 4;
+			if (formatCtx->oformat->flags & AVFMT_GLOBALHEADER)
+				codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+			succeeded = avcodec_open2(codecCtx, codec, nullptr) >= 0 && avcodec_parameters_from_context(stream->codecpar, codecCtx) >= 0;
+			stream->time_base = codecCtx->time_base;
+		}
+
+		succeeded = succeeded && avio_open(&formatCtx->pb, utf8Path.Get(), AVIO_FLAG_WRITE) >= 0;
+		headerWritten = succeeded && avformat_write_header(formatCtx, nullptr) >= 0;
+		succeeded = headerWritten;
+		if (succeeded)
+		{
+			frame->format = codecCtx->pix_fmt;
+			frame->width = width;
+			frame->height = height;
+			succeeded = av_frame_get_buffer(frame, 0) >= 0;
+		}
+
+		auto writePackets = [&]()
+		{
+			while (avcodec_receive_packet(codecCtx, packet) == 0)
+			{
+				av_packet_rescale_ts(packet, codecCtx->time_base, stream->time_base);
+				packet->stream_index = stream->index;
+				succeeded &= av_interleaved_write_frame(formatCtx, packet) >= 0;
+			}
+		};
+
+		for (int i = 0; i < frameCount && succeeded; ++i)
+		{
+			succeeded = av_frame_make_writable(frame) >= 0;
+			FillFrame(frame, i);
+			frame->pts = i;
+			succeeded = succeeded && avcodec_send_frame(codecCtx, frame) >= 0;
+			writePackets();
+		}
+		if (succeeded)
+		{
+			avcodec_send_frame(codecCtx, nullptr);
+			writePackets();
+		}
+
+		if (headerWritten)
+			succeeded &= av_write_trailer(formatCtx) >= 0;
+
+		av_packet_free(&packet);
+		av_frame_free(&frame);
+		avcodec_free_context(&codecCtx);
+		if (formatCtx->pb)
+			avio_closep(&formatCtx->pb);
+		avformat_free_context(formatCtx);
+		return succeeded;
+	}
+
+	static bool WaitFor(const std::function<bool()>& condition)
+	{
+		const double deadline = FPlatformTime::Seconds() + WAIT_TIMEOUT;
+		while (!condition())
+		{
+			if (FPlatformTime::Seconds() > deadline)
+				return false;
+			FPlatformProcess::Sleep(0.0001f);
+		}
+		return true;
+	}
+
+	// FFFmpegDecodingThread the way UFFmpegVideoTextureHog drives it, minus the textures
+	class ScopedDecoder
+	{
+	public:
+		typedef std::function<void(double timestamp, int64_t frameIndex)> FrameCallback;
+
+		ScopedDecoder()
+		{
+			m_runnable = new FFFmpegDecodingThread();
+			m_thread = FRunnableThread::Create(m_runnable, TEXT("Evercoast FFmpeg Test Decoding Thread"));
+		}
+
+		~ScopedDecoder()
+		{
+			m_runnable->Stop();
+			m_thread->Kill(true);
+			delete m_thread;
+			delete m_runnable;
+		}
+
+		// Blocks till the video is open, frames and the end of stream are reported on the decoding thread
+		bool Open(const FString& path, FrameCallback onFrame)
+		{
+			m_onFrame = onFrame;
+			m_runnable->CommandOpenFile(TCHAR_TO_ANSI(*path),
+				[this](int64_t, int32_t, int, int) { m_opened = true; },
+				[this](int64_t) { m_endReached = true; },
+				[this](double timestamp, int64_t frameIndex, int64_t, int, int, uint32_t, uint32_t, uint32_t, uint8_t*, uint8_t*, uint8_t*, YUVConversion::Matrix, bool, std::shared_ptr<void>)
+				{
+					// The frame reference drops right here, the planes go back to their pool
+					m_onFrame(timestamp, frameIndex);
+				},
+				[this]() { return m_paused.load(); },
+				[](bool) {},
+				false);
+			return WaitFor([this]() { return m_opened.load(); });
+		}
+
+		FFFmpegDecodingThread* operator->()
+		{
+			return m_runnable;
+		}
+
+		// Decoding stops at its next step while set, like the hog's ring buffer being full
+		std::atomic<bool> m_paused{ false };
+		std::atomic<bool> m_endReached{ false };
+
+	private:
+		FFFmpegDecodingThread* m_runnable;
+		FRunnableThread* m_thread;
+		FrameCallback m_onFrame;
+		std::atomic<bool> m_opened{ false };
+	};
+
+	// What the decoding thread did before frame threading: slice threads only, same demux and decode loop
+	static int DecodeWithSliceThreads(const FString& path)
+	{
+		AVFormatContext* formatCtx = nullptr;
+		if (avformat_open_input(&formatCtx, TCHAR_TO_ANSI(*path), nullptr, nullptr) < 0)
+			return -1;
+
+		int frames = -1;
+		const int streamIndex = avformat_find_stream_info(formatCtx, nullptr) >= 0 ? av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0) : -1;
+		const AVCodec* codec = streamIndex >= 0 ? avcodec_find_decoder(formatCtx->streams[streamIndex]->codecpar->codec_id) : nullptr;
+		AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+		if (codecCtx && avcodec_parameters_to_context(codecCtx, formatCtx->streams[streamIndex]->codecpar) >= 0)
+		{
+			codecCtx->thread_count = FGenericPlatformMisc::NumberOfCoresIncludingHyperthreads();
+			codecCtx->thread_type = FF_THREAD_SLICE;
+			if (avcodec_open2(codecCtx, codec, nullptr) >= 0)
+			{
+				frames = 0;
+				AVPacket* packet = av_packet_alloc();
+				AVFrame* frame = av_frame_alloc();
+				while (av_read_frame(formatCtx, packet) >= 0)
+				{
+					if (packet->stream_index == streamIndex && avcodec_send_packet(codecCtx, packet) >= 0)
+					{
+						while (avcodec_receive_frame(codecCtx, frame) == 0)
+						{
+							frames++;
+						}
+					}
+					av_packet_unref(packet);
+				}
+				avcodec_send_packet(codecCtx, nullptr);
+				while (avcodec_receive_frame(codecCtx, frame) == 0)
+				{
+					frames++;
+				}
+				av_frame_free(&frame);
+				av_packet_free(&packet);
+			}
+		}
+
+		avcodec_free_context(&codecCtx);
+		avformat_close_input(&formatCtx);
+		return frames;
+	}
+
+	// What seeking did before the keyframe index: always av_seek_frame() back from the target and a flush, then every
+	// frame decoded up to the target. Same threading as the decoding thread.
+	class SeekBaseline
+	{
+	public:
+		~SeekBaseline()
+		{
+			av_frame_free(&m_frame);
+			av_packet_free(&m_packet);
+			avcodec_free_context(&m_codecCtx);
+			avformat_close_input(&m_formatCtx);
+		}
+
+		bool Open(const FString& path)
+		{
+			if (avformat_open_input(&m_formatCtx, TCHAR_TO_ANSI(*path), nullptr, nullptr) < 0 || avformat_find_stream_info(m_formatCtx, nullptr) < 0)
+				return false;
+
+			m_streamIndex = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+			const AVCodec* codec = m_streamIndex >= 0 ? avcodec_find_decoder(m_formatCtx->streams[m_streamIndex]->codecpar->codec_id) : nullptr;
+			m_codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+			if (!m_codecCtx || avcodec_parameters_to_context(m_codecCtx, m_formatCtx->streams[m_streamIndex]->codecpar) < 0)
+				return false;
+
+			m_codecCtx->thread_count = FMath::Clamp(FGenericPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, 16);
+			m_codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+			m_packet = av_packet_alloc();
+			m_frame = av_frame_alloc();
+			return avcodec_open2(m_codecCtx, codec, nullptr) >= 0;
+		}
+
+		// Frames decoded till the one showing timestamp, -1 if it was never reached
+		int SeekTo(double timestamp)
+		{
+			const AVRational timeBase = m_formatCtx->streams[m_streamIndex]->time_base;
+			const int64_t targetPts = (int64_t)(timestamp * timeBase.den / timeBase.num);
+			if (av_seek_frame(m_formatCtx, m_streamIndex, targetPts, AVSEEK_FLAG_BACKWARD) < 0)
+				return -1;
+			avcodec_flush_buffers(m_codecCtx);
+
+			int decoded = 0;
+			while (av_read_frame(m_formatCtx, m_packet) >= 0)
+			{
+				const bool sent = m_packet->stream_index == m_streamIndex && avcodec_send_packet(m_codecCtx, m_packet) >= 0;
+				av_packet_unref(m_packet);
+				while (sent && avcodec_receive_frame(m_codecCtx, m_frame) == 0)
+				{
+					decoded++;
+					if (m_frame->pts + m_frame->pkt_duration > targetPts)
+						return decoded;
+				}
+			}
+			return -1;
+		}
+
+	private:
+		AVFormatContext* m_formatCtx = nullptr;
+		AVCodecContext* m_codecCtx = nullptr;
+		AVPacket* m_packet = nullptr;
+		AVFrame* m_frame = nullptr;
+		int m_streamIndex = -1;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastFFmpegDecodeBenchmark, "Evercoast.Video.FFmpegDecodingThread.DecodeBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastFFmpegDecodeBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace FFmpegDecodingThreadTest;
+
+	AddInfo(FString::Printf(TEXT("%d logical cores"), FGenericPlatformMisc::NumberOfCoresIncludingHyperthreads()));
+
+	struct Resolution
+	{
+		int width;
+		int height;
+	};
+	const Resolution resolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+	const int frameCount = 4 * FRAME_RATE;
+	for (const Resolution& resolution : resolutions)
+	{
+		const FString path = ClipPath(resolution.width, resolution.height);
+		if (!WriteClip(path, resolution.width, resolution.height, frameCount))
+		{
+			AddWarning(TEXT("FFmpeg build can't encode MPEG-4 into mp4, nothing to decode"));
+			IFileManager::Get().Delete(*path);
+			return true;
+		}
+
+		// Before: slice threads only
+		double start = FPlatformTime::Seconds();
+		const int sliceFrames = DecodeWithSliceThreads(path);
+		const double sliceSeconds = FPlatformTime::Seconds() - start;
+		TestEqual(TEXT("Slice threaded decode gets every frame"), sliceFrames, frameCount);
+
+		// Now: the decoding thread with frame and slice threads, draining at the end of stream
+		std::atomic<int> frames{ 0 };
+		std::atomic<int64_t> lastFrameIndex{ -1 };
+		std::atomic<bool> inOrder{ true };
+		double decoderSeconds = 0;
+		{
+			ScopedDecoder decoder;
+			if (!TestTrue(TEXT("Opened"), decoder.Open(path, [&](double, int64_t frameIndex)
+				{
+					inOrder = inOrder && frameIndex == lastFrameIndex + 1;
+					lastFrameIndex = frameIndex;
+					frames++;
+				})))
+			{
+				IFileManager::Get().Delete(*path);
+				return false;
+			}
+
+			start = FPlatformTime::Seconds();
+			decoder->CommandResumeDecoding();
+			TestTrue(TEXT("Reached the end"), WaitFor([&decoder]() { return decoder.m_endReached.load(); }));
+			decoderSeconds = FPlatformTime::Seconds() - start;
+		}
+		TestEqual(TEXT("Every frame out of the decoding thread, the drained ones too"), frames.load(), frameCount);
+		TestTrue(TEXT("Frame indices in order"), inOrder.load());
+
+		AddInfo(FString::Printf(TEXT("%dx%d, %d frames: slice threads %.1f fps, decoding thread %.1f fps"), resolution.width, resolution.height,
+			frameCount, sliceFrames / sliceSeconds, frames.load() / decoderSeconds));
+		IFileManager::Get().Delete(*path);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastFFmpegSeekBenchmark, "Evercoast.Video.FFmpegDecodingThread.SeekBenchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastFFmpegSeekBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace FFmpegDecodingThreadTest;
+
+	const int width = 1920;
+	const int height = 1080;
+	const int frameCount = 10 * FRAME_RATE;
+	const FString path = ClipPath(width, height);
+	if (!WriteClip(path, width, height, frameCount))
+	{
+		AddWarning(TEXT("FFmpeg build can't encode MPEG-4 into mp4, nothing to seek in"));
+		IFileManager::Get().Delete(*path);
+		return true;
+	}
+
+	// Random jumps anywhere, then short hops forward within a GOP like scrubbing. Targets sit mid frame so the frame
+	// showing them is unambiguous.
+	std::vector<int> randomTargets;
+	uint32_t state = 12345;
+	for (int i = 0; i < 20; ++i)
+	{
+		state = state * 1664525u + 1013904223u;
+		randomTargets.push_back((int)((state >> 8) % (frameCount - 1)));
+	}
+	std::vector<int> forwardTargets;
+	for (int frame = 2; frame + 5 < frameCount && forwardTargets.size() < 40; frame += 5)
+	{
+		forwardTargets.push_back(frame);
+	}
+
+	struct Scenario
+	{
+		const TCHAR* name;
+		const std::vector<int>* targets;
+	};
+	const Scenario scenarios[] = { { TEXT("random"), &randomTargets }, { TEXT("forward by 5 frames"), &forwardTargets } };
+
+	ScopedDecoder decoder;
+	std::atomic<bool> reached{ false };
+	std::atomic<int64_t> firstFrameIndex{ -1 };
+	double seekStart = 0;
+	double seekLatency = 0;
+	if (!TestTrue(TEXT("Opened"), decoder.Open(path, [&](double, int64_t frameIndex)
+		{
+			if (reached)
+				return;
+			seekLatency = FPlatformTime::Seconds() - seekStart;
+			firstFrameIndex = frameIndex;
+			// Stops at the next decode step, like the hog's ring buffer filling up
+			decoder.m_paused = true;
+			reached = true;
+		})))
+	{
+		IFileManager::Get().Delete(*path);
+		return false;
+	}
+
+	SeekBaseline baseline;
+	TestTrue(TEXT("Baseline opened"), baseline.Open(path));
+
+	for (const Scenario& scenario : scenarios)
+	{
+		double decoderTotal = 0;
+		double decoderMax = 0;
+		double baselineTotal = 0;
+		double baselineMax = 0;
+		int baselineFrames = 0;
+		for (int target : *scenario.targets)
+		{
+			const double timestamp = (target + 0.5) / FRAME_RATE;
+
+			reached = false;
+			decoder.m_paused = false;
+			seekStart = FPlatformTime::Seconds();
+			decoder->CommandSeekTo(timestamp, []() {});
+			if (!TestTrue(*FString::Printf(TEXT("Seek to frame %d reached"), target), WaitFor([&reached]() { return reached.load(); })))
+				break;
+			TestEqual(*FString::Printf(TEXT("First frame after seeking to frame %d"), target), (int32)firstFrameIndex.load(), target);
+			decoderTotal += seekLatency;
+			decoderMax = FMath::Max(decoderMax, seekLatency);
+
+			const double start = FPlatformTime::Seconds();
+			const int decoded = baseline.SeekTo(timestamp);
+			const double baselineLatency = FPlatformTime::Seconds() - start;
+			TestTrue(*FString::Printf(TEXT("Baseline seek to frame %d reached"), target), decoded > 0);
+			baselineTotal += baselineLatency;
+			baselineMax = FMath::Max(baselineMax, baselineLatency);
+			baselineFrames += decoded;
+		}
+
+		const int count = (int)scenario.targets->size();
+		AddInfo(FString::Printf(TEXT("%dx%d, %d %s seeks: seek and decode %.2f ms mean %.2f ms max(%.1f frames decoded per seek), decoding thread %.2f ms mean %.2f ms max"),
+			width, height, count, scenario.name, baselineTotal * 1000.0 / count, baselineMax * 1000.0, (double)baselineFrames / count,
+			decoderTotal * 1000.0 / count, decoderMax * 1000.0));
+	}
+
+	IFileManager::Get().Delete(*path);
+	return true;
+}
+
+#endif
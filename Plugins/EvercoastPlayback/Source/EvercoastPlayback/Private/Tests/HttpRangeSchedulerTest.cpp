@@ -0,0 +1,401 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HttpRangeScheduler.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "HttpPath.h"
+#include "IHttpRouter.h"
+#include "HAL/PlatformTime.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// HttpRangeScheduler against a loopback server built on the engine's HTTPServer module, standing in for the CDN
+// serving an .ecm file. The content is synthetic, only the byte ranges matter to the scheduler.
+namespace HttpRangeSchedulerTest
+{
+	static constexpr uint32_t PORT = 18947;
+	static constexpr uint32_t CONTENT_SIZE = 4 * 1024 * 1024;
+	static const TCHAR* CONTENT_PATH = TEXT("/evercoast_test/sample.ecm");
+
+	static uint8_t ByteAt(uint64_t offset)
+	{
+		return (uint8_t)((offset * 2654435761ull) >> 11);
+	}
+
+	// Serves the content by Range, optionally failing the next few requests with 503
+	struct LoopbackServer
+	{
+		TSharedPtr<IHttpRouter> router;
+		FHttpRouteHandle route;
+		std::atomic<uint32_t> requestCount{ 0 };
+		std::atomic<uint32_t> failNext{ 0 };
+
+		bool Start()
+		{
+			router = FHttpServerModule::Get().GetHttpRouter(PORT);
+			if (!router.IsValid())
+				return false;
+
+			auto handler = [this](const FHttpServerRequest& request, const FHttpResultCallback& onComplete)
+			{
+				requestCount.fetch_add(1);
+
+				TUniquePtr<FHttpServerResponse> response = MakeUnique<FHttpServerResponse>();
+				uint32_t failing = failNext.load();
+				while (failing > 0 && !failNext.compare_exchange_weak(failing, failing - 1))
+				{
+				}
+				if (failing > 0)
+				{
+					response->Code = EHttpServerResponseCodes::ServiceUnavail;
+					onComplete(MoveTemp(response));
+					return true;
+				}
+
+				uint64 first = 0;
+				uint64 last = CONTENT_SIZE - 1;
+				const TArray<FString>* range = request.Headers.Find(TEXT("Range"));
+				if (range && range->Num() > 0)
+				{
+					FString spec = (*range)[0];
+					spec.RemoveFromStart(TEXT("bytes="));
+					FString firstText, lastText;
+					if (spec.Split(TEXT("-"), &firstText, &lastText))
+					{
+						LexFromString(first, *firstText);
+						LexFromString(last, *lastText);
+					}
+				}
+				last = FMath::Min<uint64>(last, CONTENT_SIZE - 1);
+
+				if (first > last)
+				{
+					response->Code = EHttpServerResponseCodes::BadRequest;
+					onComplete(MoveTemp(response));
+					return true;
+				}
+
+				response->Code = EHttpServerResponseCodes::PartialContent;
+				response->Headers.Add(TEXT("Content-Type"), { TEXT("application/octet-stream") });
+				response->Headers.Add(TEXT("Content-Range"), { FString::Printf(TEXT("bytes %llu-%llu/%u"), first, last, CONTENT_SIZE) });
+				response->Headers.Add(TEXT("ETag"), { TEXT("\"evercoast-test\"") });
+				response->Body.SetNumUninitialized((int32)(last - first + 1));
+				for (uint64 i = first; i <= last; ++i)
+				{
+					response->Body[(int32)(i - first)] = ByteAt(i);
+				}
+				onComplete(MoveTemp(response));
+				return true;
+			};
+
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4
+			route = router->BindRoute(FHttpPath(CONTENT_PATH), EHttpServerRequestVerbs::VERB_GET, FHttpRequestHandler::CreateLambda(handler));
+#else
+			route = router->BindRoute(FHttpPath(CONTENT_PATH), EHttpServerRequestVerbs::VERB_GET, handler);
+#endif
+			if (!route.IsValid())
+				return false;
+
+			FHttpServerModule::Get().StartAllListeners();
+			return true;
+		}
+
+		void Stop()
+		{
+			if (router.IsValid() && route.IsValid())
+			{
+				router->UnbindRoute(route);
+			}
+			route.Reset();
+			router.Reset();
+		}
+
+		static FString Url()
+		{
+			return FString::Printf(TEXT("http://127.0.0.1:%u%s"), PORT, CONTENT_PATH);
+		}
+	};
+
+	struct Result
+	{
+		bool succeeded = false;
+		bool contentMatches = false;
+		uint32_t completions = 0;
+	};
+
+	// One scheduler run, results keyed by request id. Completions may come in on HTTP threads.
+	struct Run
+	{
+		std::shared_ptr<HttpRangeScheduler> scheduler;
+		std::map<uint32_t, Result> results;
+		std::mutex lock;
+		double startTime = 0;
+
+		void Start(const HttpRangeSchedulerConfig& config)
+		{
+			startTime = FPlatformTime::Seconds();
+			scheduler = std::make_shared<HttpRangeScheduler>(LoopbackServer::Url(), config,
+				[this](const ReadRequest& request, const uint8_t* data, uint32_t size, const FString& etag, bool succeeded)
+				{
+					bool matches = succeeded && size == request.size;
+					for (uint32_t i = 0; matches && i < size; ++i)
+					{
+						matches = data[i] == ByteAt(request.offset + i);
+					}
+
+					std::lock_guard<std::mutex> guard(lock);
+					Result& result = results[request.request_id];
+					result.succeeded = succeeded;
+					result.contentMatches = matches;
+					result.completions++;
+				});
+		}
+
+		void Enqueue(uint32_t requestId, uint64_t offset, uint32_t size)
+		{
+			ReadRequest request;
+			request.request_id = requestId;
+			request.cache_id = requestId;
+			request.buffer = nullptr;
+			request.offset = offset;
+			request.size = size;
+			scheduler->Enqueue(request);
+		}
+
+		size_t CompletedCount()
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return results.size();
+		}
+
+		double Elapsed() const
+		{
+			return FPlatformTime::Seconds() - startTime;
+		}
+	};
+
+	static constexpr double TIMEOUT_SECONDS = 10.0;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastHttpRangeSchedulerLoopbackTest, "Evercoast.GhostTree.HttpRangeScheduler.Loopback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastHttpRangeSchedulerLoopbackTest::RunTest(const FString& Parameters)
+{
+	using namespace HttpRangeSchedulerTest;
+
+	std::shared_ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+	if (!TestTrue(TEXT("Loopback server started"), server->Start()))
+		return false;
+
+	// Adjacent ranges go out as a single HTTP request
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		const uint32_t rangeCount = 32;
+		const uint32_t rangeSize = 64 * 1024;
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, run, rangeCount, rangeSize]() -> bool
+		{
+			if (!run->scheduler)
+			{
+				server->requestCount = 0;
+				HttpRangeSchedulerConfig config;
+				config.maxRequestsInFlight = 4;
+				config.maxCoalescedSize = rangeCount * rangeSize;
+				run->Start(config);
+				// Out of order, the scheduler merges at either end of a batch
+				for (uint32_t i = 0; i < rangeCount; ++i)
+				{
+					uint32_t index = (i * 7) % rangeCount;
+					run->Enqueue(index, (uint64_t)index * rangeSize, rangeSize);
+				}
+			}
+
+			run->scheduler->Tick();
+			if (run->CompletedCount() < rangeCount && run->Elapsed() < TIMEOUT_SECONDS)
+				return false;
+
+			TestEqual(TEXT("Coalesced: all ranges completed"), (int32)run->CompletedCount(), (int32)rangeCount);
+			for (auto& entry : run->results)
+			{
+				TestTrue(TEXT("Coalesced: range succeeded with the right content"), entry.second.succeeded && entry.second.contentMatches);
+				TestEqual(TEXT("Coalesced: range completed once"), (int32)entry.second.completions, 1);
+			}
+			TestEqual(TEXT("Coalesced: one HTTP request"), (int32)server->requestCount.load(), 1);
+			run->scheduler.reset();
+			return true;
+		}));
+	}
+
+	// Cancelled ranges are never reported, whether still pending or in flight
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, run]() -> bool
+		{
+			const uint32_t rangeSize = 16 * 1024;
+			if (!run->scheduler)
+			{
+				HttpRangeSchedulerConfig config;
+				config.maxRequestsInFlight = 2;
+				run->Start(config);
+				// Gaps in between, so every range is a batch of its own
+				for (uint32_t i = 0; i < 8; ++i)
+				{
+					run->Enqueue(i, (uint64_t)i * rangeSize * 2, rangeSize);
+				}
+				// Pending
+				for (uint32_t i = 4; i < 8; ++i)
+				{
+					TestTrue(TEXT("Cancel: pending range found"), run->scheduler->Cancel(i));
+				}
+				// In flight after this tick
+				run->scheduler->Tick();
+				TestTrue(TEXT("Cancel: in flight range found"), run->scheduler->Cancel(0));
+				TestFalse(TEXT("Cancel: cancelled range is gone"), run->scheduler->Cancel(0));
+			}
+
+			run->scheduler->Tick();
+			// Some slack after the expected ones, in case a cancelled one turns up
+			if ((run->CompletedCount() < 3 || run->Elapsed() < 0.5) && run->Elapsed() < TIMEOUT_SECONDS)
+				return false;
+
+			TestEqual(TEXT("Cancel: only the others completed"), (int32)run->CompletedCount(), 3);
+			for (uint32_t i = 1; i < 4; ++i)
+			{
+				TestTrue(TEXT("Cancel: remaining range succeeded"), run->results[i].succeeded && run->results[i].contentMatches);
+			}
+			run->scheduler.reset();
+			return true;
+		}));
+	}
+
+	// Failures are retried with backoff, then reported once retries run out
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, run]() -> bool
+		{
+			if (!run->scheduler)
+			{
+				server->requestCount = 0;
+				server->failNext = 2;
+				HttpRangeSchedulerConfig config;
+				config.maxRetries = 3;
+				config.retryBackoffInSeconds = 0.05f;
+				run->Start(config);
+				run->Enqueue(0, 1000, 5000);
+			}
+
+			run->scheduler->Tick();
+			if (run->CompletedCount() < 1 && run->Elapsed() < TIMEOUT_SECONDS)
+				return false;
+
+			TestTrue(TEXT("Retry: succeeded after retries"), run->results[0].succeeded && run->results[0].contentMatches);
+			TestEqual(TEXT("Retry: two failed attempts then one good"), (int32)server->requestCount.load(), 3);
+			run->scheduler.reset();
+			return true;
+		}));
+	}
+
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, run]() -> bool
+		{
+			if (!run->scheduler)
+			{
+				server->requestCount = 0;
+				server->failNext = 100;
+				HttpRangeSchedulerConfig config;
+				config.maxRetries = 1;
+				config.retryBackoffInSeconds = 0.05f;
+				run->Start(config);
+				run->Enqueue(0, 0, 1024);
+			}
+
+			run->scheduler->Tick();
+			if (run->CompletedCount() < 1 && run->Elapsed() < TIMEOUT_SECONDS)
+				return false;
+
+			TestFalse(TEXT("Retry: reported failed when retries run out"), run->results[0].succeeded);
+			TestEqual(TEXT("Retry: reported once"), (int32)run->results[0].completions, 1);
+			TestEqual(TEXT("Retry: first attempt and one retry"), (int32)server->requestCount.load(), 2);
+			server->failNext = 0;
+			run->scheduler.reset();
+			return true;
+		}));
+	}
+
+	// Completions send out the pending ranges themselves, the scheduler is only ticked once
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		const uint32_t rangeCount = 6;
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, run, rangeCount]() -> bool
+		{
+			const uint32_t rangeSize = 16 * 1024;
+			if (!run->scheduler)
+			{
+				server->requestCount = 0;
+				HttpRangeSchedulerConfig config;
+				config.maxRequestsInFlight = 1;
+				run->Start(config);
+				// Gaps in between, one HTTP request per range, one at a time
+				for (uint32_t i = 0; i < rangeCount; ++i)
+				{
+					run->Enqueue(i, (uint64_t)i * rangeSize * 2, rangeSize);
+				}
+				run->scheduler->Tick();
+			}
+
+			if (run->CompletedCount() < rangeCount && run->Elapsed() < TIMEOUT_SECONDS)
+				return false;
+
+			TestEqual(TEXT("No tick: all ranges completed"), (int32)run->CompletedCount(), (int32)rangeCount);
+			for (auto& entry : run->results)
+			{
+				TestTrue(TEXT("No tick: range succeeded with the right content"), entry.second.succeeded && entry.second.contentMatches);
+			}
+			TestEqual(TEXT("No tick: one HTTP request per range"), (int32)server->requestCount.load(), (int32)rangeCount);
+			AddInfo(FString::Printf(TEXT("%u sequential ranges without ticking: %.1f ms"), rangeCount, run->Elapsed() * 1000.0));
+			run->scheduler.reset();
+			return true;
+		}));
+	}
+
+	// Cancelling and resetting the scheduler with requests in flight, as the reader does on close, must not call
+	// back afterwards
+	{
+		std::shared_ptr<Run> run = std::make_shared<Run>();
+		ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, server, run]() -> bool
+		{
+			if (run->startTime == 0)
+			{
+				HttpRangeSchedulerConfig config;
+				run->Start(config);
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					run->Enqueue(i, (uint64_t)i * 256 * 1024 * 2, 256 * 1024);
+				}
+				run->scheduler->Tick();
+				run->scheduler->CancelAll();
+				run->scheduler.reset();
+				TestEqual(TEXT("Reset: nothing reported"), (int32)run->CompletedCount(), 0);
+				return false;
+			}
+
+			if (run->Elapsed() < 1.0)
+				return false;
+
+			TestEqual(TEXT("Reset: nothing reported later either"), (int32)run->CompletedCount(), 0);
+			server->Stop();
+			return true;
+		}));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,302 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Realtime/PCMBlockRing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// PCMBlockRing, PCMConcealment and PCMDriftResampler the way PicoAudioSoundWave drives them: the network thread
+// writes 20ms packets of 48kHz stereo, concealing gaps when the packet after them arrives, and the audio render
+// thread reads 10ms at a time. The signal is a 440Hz sine, so a click shows up as a step far beyond its slope.
+namespace PCMBlockRingTest
+{
+	static constexpr int32_t CHANNELS = 2;
+	static constexpr int32_t SAMPLE_RATE = 48000;
+	static constexpr int32_t FRAMES_PER_PACKET = 960;
+	static constexpr double PACKET_DURATION = 0.02;
+	static constexpr double AMPLITUDE = 8000.0;
+	static constexpr double FREQUENCY = 440.0;
+	static const double PI_DOUBLE = 3.14159265358979323846;
+
+	// Largest step between consecutive samples of the clean sine
+	static double SineSlope()
+	{
+		return AMPLITUDE * 2.0 * PI_DOUBLE * FREQUENCY / SAMPLE_RATE;
+	}
+
+	struct ReplayResult
+	{
+		int32_t concealed = 0;
+		int64_t outFrames = 0;
+		double maxStep = 0;
+	};
+
+	// The producer side of PicoAudioSoundWave, single threaded: conceal the packets missing before this one, then
+	// write it crossfaded in from the concealment
+	class Producer
+	{
+	public:
+		explicit Producer(PCMBlockRing& ring) :
+			m_ring(ring)
+		{
+		}
+
+		void Receive(int64_t frameNum)
+		{
+			std::vector<int16_t> pcm(FRAMES_PER_PACKET * CHANNELS);
+			for (int32_t i = 0; i < FRAMES_PER_PACKET; ++i)
+			{
+				const double value = AMPLITUDE * std::sin(2.0 * PI_DOUBLE * FREQUENCY * (frameNum * FRAMES_PER_PACKET + i) / SAMPLE_RATE);
+				pcm[i * 2] = pcm[i * 2 + 1] = (int16_t)value;
+			}
+
+			const double timestamp = frameNum * PACKET_DURATION;
+			const int32_t missing = m_lastFrameNum < 0 ? 0 : (int32_t)(frameNum - m_lastFrameNum - 1);
+			if (missing > 0)
+			{
+				const double interval = (timestamp - m_lastTimestamp) / (missing + 1);
+				for (int32_t i = 0; i < missing; ++i)
+				{
+					PCMBlock* block = m_ring.BeginWrite();
+					if (!block)
+						break;
+					PCMConcealment::Conceal(m_last.data(), (int32_t)m_last.size(), CHANNELS, i, missing, block->samples);
+					block->frameNum = m_lastFrameNum + i + 1;
+					block->timestamp = m_lastTimestamp + interval * (i + 1);
+					block->duration = PACKET_DURATION;
+					block->epoch = 0;
+					block->sampleCount = (int32_t)m_last.size();
+					block->concealed = true;
+					m_ring.CommitWrite();
+					m_concealed++;
+				}
+			}
+
+			PCMBlock* block = m_ring.BeginWrite();
+			if (block)
+			{
+				std::memcpy(block->samples, pcm.data(), pcm.size() * sizeof(int16_t));
+				if (missing > 0)
+				{
+					PCMConcealment::CrossfadeIn(m_last.data(), (int32_t)m_last.size(), CHANNELS, missing, block->samples, (int32_t)pcm.size());
+				}
+				block->frameNum = frameNum;
+				block->timestamp = timestamp;
+				block->duration = PACKET_DURATION;
+				block->epoch = 0;
+				block->sampleCount = (int32_t)pcm.size();
+				block->concealed = false;
+				m_ring.CommitWrite();
+			}
+
+			m_last = std::move(pcm);
+			m_lastTimestamp = timestamp;
+			m_lastFrameNum = frameNum;
+		}
+
+		int32_t GetConcealedCount() const
+		{
+			return m_concealed;
+		}
+
+	private:
+		PCMBlockRing& m_ring;
+		std::vector<int16_t> m_last;
+		double m_lastTimestamp = 0;
+		int64_t m_lastFrameNum = -1;
+		int32_t m_concealed = 0;
+	};
+
+	template<typename DropFunc>
+	static ReplayResult Replay(int32_t packetCount, DropFunc isDropped)
+	{
+		PCMBlockRing ring(64);
+		Producer producer(ring);
+		PCMDriftResampler resampler;
+		resampler.Reset(CHANNELS);
+
+		ReplayResult result;
+		int16_t previous = 0;
+		bool hasPrevious = false;
+		// 10ms of audio like the render thread asks for, frames written
+		auto consume = [&]()
+		{
+			int16_t out[FRAMES_PER_PACKET / 2 * CHANNELS];
+			const int32_t frames = resampler.Read(ring, 0, std::numeric_limits<double>::infinity(), 1.0, SAMPLE_RATE, out, FRAMES_PER_PACKET / 2);
+			result.outFrames += frames;
+			for (int32_t i = 0; i < frames; ++i)
+			{
+				if (hasPrevious)
+				{
+					result.maxStep = std::max(result.maxStep, (double)std::abs(out[i * 2] - previous));
+				}
+				previous = out[i * 2];
+				hasPrevious = true;
+			}
+			return frames;
+		};
+
+		for (int32_t frameNum = 0; frameNum < packetCount; ++frameNum)
+		{
+			if (!isDropped(frameNum))
+			{
+				producer.Receive(frameNum);
+			}
+			consume();
+			consume();
+		}
+
+		// Whatever ran dry during a gap is still buffered, the ratio stays 1 so there's no drift steering catching up
+		while (consume() > 0)
+		{
+		}
+		result.concealed = producer.GetConcealedCount();
+		return result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastPCMBlockRingStressTest, "Evercoast.Realtime.PCMBlockRing.SPSCStress", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastPCMBlockRingStressTest::RunTest(const FString& Parameters)
+{
+	PCMBlockRing small(5);
+	TestEqual(TEXT("Capacity rounded up to a power of two"), (int32)small.GetCapacity(), 8);
+	for (uint32_t i = 0; i < small.GetCapacity(); ++i)
+	{
+		PCMBlock* block = small.BeginWrite();
+		if (!TestNotNull(TEXT("Free block"), block))
+			return false;
+		block->sampleCount = 2;
+		small.CommitWrite();
+	}
+	TestTrue(TEXT("Full ring has no free block"), small.BeginWrite() == nullptr);
+	TestEqual(TEXT("Queued samples"), (int64)small.GetQueuedSamples(), (int64)16);
+
+	// A small ring so both sides keep running into each other
+	PCMBlockRing ring(8);
+	const int64_t blockCount = 200000;
+	std::thread producer([&ring, blockCount]()
+		{
+			for (int64_t i = 0; i < blockCount;)
+			{
+				PCMBlock* block = ring.BeginWrite();
+				if (!block)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				block->frameNum = i;
+				block->sampleCount = 2;
+				block->samples[0] = (int16_t)i;
+				block->samples[1] = (int16_t)~i;
+				block->epoch = 0;
+				ring.CommitWrite();
+				++i;
+			}
+		});
+
+	int64_t outOfOrder = 0;
+	int64_t torn = 0;
+	for (int64_t expected = 0; expected < blockCount;)
+	{
+		const PCMBlock* block = ring.Front();
+		if (!block)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		outOfOrder += block->frameNum != expected ? 1 : 0;
+		torn += block->samples[0] != (int16_t)expected || block->samples[1] != (int16_t)~expected ? 1 : 0;
+		ring.Pop();
+		++expected;
+	}
+	producer.join();
+
+	TestEqual(TEXT("Blocks out of order"), (int64)outOfOrder, (int64)0);
+	TestEqual(TEXT("Blocks read before they were written"), (int64)torn, (int64)0);
+	TestEqual(TEXT("Drained"), (int32)ring.GetSize(), 0);
+	TestEqual(TEXT("No samples left queued"), (int64)ring.GetQueuedSamples(), (int64)0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastPCMBlockRingLossTest, "Evercoast.Realtime.PCMBlockRing.LossPatterns", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastPCMBlockRingLossTest::RunTest(const FString& Parameters)
+{
+	using namespace PCMBlockRingTest;
+
+	const int32_t packetCount = 500;
+	const int64_t expectedFrames = (int64_t)packetCount * FRAMES_PER_PACKET;
+	// Without concealment a gap steps up to twice the amplitude
+	const double clickThreshold = 2.0 * SineSlope();
+
+	struct Pattern
+	{
+		const TCHAR* name;
+		bool (*isDropped)(int32_t frameNum);
+		int32_t expectedConcealed;
+	};
+	const Pattern patterns[] =
+	{
+		{ TEXT("no loss"), [](int32_t) { return false; }, 0 },
+		{ TEXT("every 7th packet"), [](int32_t frameNum) { return frameNum % 7 == 3; }, 71 },
+		{ TEXT("bursts of 6 and 2"), [](int32_t frameNum) { return (frameNum >= 100 && frameNum < 106) || (frameNum >= 300 && frameNum < 302); }, 8 },
+	};
+
+	for (const Pattern& pattern : patterns)
+	{
+		const ReplayResult result = Replay(packetCount, pattern.isDropped);
+		AddInfo(FString::Printf(TEXT("%s: %d packets concealed, %lld frames out, largest step %.0f(clean sine %.0f)"),
+			pattern.name, result.concealed, (long long)result.outFrames, result.maxStep, SineSlope()));
+
+		TestEqual(*FString::Printf(TEXT("Concealed, %s"), pattern.name), (int32)result.concealed, pattern.expectedConcealed);
+		// Lost time is filled in, but for the last frame the resampler holds back to interpolate towards
+		TestEqual(*FString::Printf(TEXT("Audio length kept, %s"), pattern.name), (int64)result.outFrames, (int64)(expectedFrames - 1));
+		TestTrue(*FString::Printf(TEXT("No clicks, %s"), pattern.name), result.maxStep <= clickThreshold);
+	}
+
+	// A long gap fades to silence after CONCEAL_FADE_BLOCKS and stays there
+	const int16_t level = 4000;
+	std::vector<int16_t> last(FRAMES_PER_PACKET * CHANNELS, level);
+	std::vector<int16_t> concealed(last.size());
+	for (int32_t i = 0; i < 6; ++i)
+	{
+		PCMConcealment::Conceal(last.data(), (int32_t)last.size(), CHANNELS, i, 6, concealed.data());
+		const int16_t peak = *std::max_element(concealed.begin(), concealed.end(), [](int16_t a, int16_t b) { return std::abs(a) < std::abs(b); });
+		if (i >= PCMConcealment::CONCEAL_FADE_BLOCKS)
+		{
+			// But for the end of the fade mirrored into its seam, 40dB down
+			const auto seamEnd = concealed.begin() + PCMConcealment::CROSSFADE_FRAMES * CHANNELS;
+			TestTrue(*FString::Printf(TEXT("Block %d of a 6 packet gap is silent"), i), std::abs(peak) <= level / 100 &&
+				std::all_of(seamEnd, concealed.end(), [](int16_t sample) { return sample == 0; }));
+		}
+		else
+		{
+			TestTrue(*FString::Printf(TEXT("Block %d of a 6 packet gap still fades"), i), std::abs(peak) > 0);
+		}
+	}
+
+	// A short one dips and comes back up to meet the packet after it
+	for (int32_t missing = 1; missing <= PCMConcealment::CONCEAL_FADE_BLOCKS; ++missing)
+	{
+		int16_t quietest = level;
+		for (int32_t i = 0; i < missing; ++i)
+		{
+			PCMConcealment::Conceal(last.data(), (int32_t)last.size(), CHANNELS, i, missing, concealed.data());
+			quietest = std::min(quietest, *std::min_element(concealed.begin() + PCMConcealment::CROSSFADE_FRAMES * CHANNELS, concealed.end()));
+		}
+		const int16_t end = concealed.back();
+		AddInfo(FString::Printf(TEXT("%d packet gap: down to %d, ends at %d of %d"), missing, quietest, end, level));
+		TestTrue(*FString::Printf(TEXT("%d packet gap isn't silenced"), missing), quietest >= level / 2 - 1);
+		TestTrue(*FString::Printf(TEXT("%d packet gap ends near full level"), missing), end >= level * 95 / 100);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ReaderCache.h"
+#include "Misc/Paths.h"
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// ReaderDiskCache and ReaderMemoryCache through IReaderCache the way GhostTreeFormatReader drives them: entries
+// reserved, written, unpinned, read back under a pin. Small slabs keep the mapping tiny, the policy is the same as
+// with the default size.
+namespace ReaderCacheTest
+{
+	static constexpr uint32_t SLAB_SIZE = 4096;
+	static constexpr uint32_t SLAB_COUNT = 8;
+
+	static std::unique_ptr<ReaderDiskCache> MakeDiskCache(const TCHAR* name)
+	{
+		const FString path = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectIntermediateDir(), name));
+		return std::make_unique<ReaderDiskCache>(path, (uint64_t)SLAB_SIZE * SLAB_COUNT, SLAB_SIZE);
+	}
+
+	// Entry content derived from its id, so a block handed out twice or overwritten shows up
+	static std::vector<uint8_t> MakeContent(uint32_t cache_id, uint32_t size)
+	{
+		std::vector<uint8_t> content(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			content[i] = (uint8_t)(cache_id * 31 + i);
+		}
+		return content;
+	}
+
+	static bool Add(IReaderCache& cache, uint32_t cache_id, uint32_t size)
+	{
+		const std::vector<uint8_t> content = MakeContent(cache_id, size);
+		uint8_t* storage = cache.Reserve(cache_id, size);
+		if (!storage)
+			return false;
+		memcpy(storage, content.data(), size);
+		cache.Unpin(cache_id);
+		return true;
+	}
+
+	static bool HasContent(IReaderCache& cache, uint32_t cache_id, uint32_t size)
+	{
+		const uint8_t* data = cache.GetRange(cache_id, 0, size);
+		return data && memcmp(data, MakeContent(cache_id, size).data(), size) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderDiskCacheEvictionTest, "Evercoast.Reader.Cache.DiskEvictionOrder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderDiskCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderCacheTest;
+
+	std::unique_ptr<ReaderDiskCache> cache = MakeDiskCache(TEXT("EvercoastReaderCacheTest_Eviction.bin"));
+	if (!TestTrue(TEXT("Cache file mapped"), cache->IsMapped()))
+		return false;
+	TestEqual(TEXT("Mapping is the capacity"), (int64)cache->GetSlabCount() * SLAB_SIZE, (int64)SLAB_SIZE * SLAB_COUNT);
+
+	// Fill up, one slab each, ids 1 to 8 added in order
+	for (uint32_t id = 1; id <= SLAB_COUNT; ++id)
+	{
+		TestTrue(*FString::Printf(TEXT("Add %u"), id), Add(*cache, id, SLAB_SIZE - id));
+	}
+	TestEqual(TEXT("Full"), (int32)cache->GetFreeSlabCount(), 0);
+	TestEqual(TEXT("Nothing evicted yet"), (int64)cache->GetEvictionCount(), (int64)0);
+
+	// Reading 1 makes 2 the least recently used
+	TestTrue(TEXT("Read 1"), HasContent(*cache, 1, SLAB_SIZE - 1));
+	TestTrue(TEXT("Add 9"), Add(*cache, 9, SLAB_SIZE));
+	TestTrue(TEXT("Evicted 2"), cache->Get(2) == nullptr);
+	TestTrue(TEXT("Kept 1"), HasContent(*cache, 1, SLAB_SIZE - 1));
+
+	// Pinned entries are skipped, 3 is read through a pointer so 4 goes instead
+	TestTrue(TEXT("Pin 3"), cache->Pin(3));
+	const uint8_t* pinnedData = cache->Get(3);
+	TestTrue(TEXT("Add 10"), Add(*cache, 10, SLAB_SIZE));
+	TestTrue(TEXT("Evicted 4"), cache->Get(4) == nullptr);
+	TestTrue(TEXT("Pinned 3 stays where it was"), cache->Get(3) == pinnedData && HasContent(*cache, 3, SLAB_SIZE - 3));
+
+	// A reserved entry is pinned until written, unpinned entries go oldest first
+	uint8_t* writing = cache->Reserve(11, SLAB_SIZE);
+	TestNotNull(TEXT("Reserve 11"), writing);
+	TestTrue(TEXT("Evicted 5"), cache->Get(5) == nullptr);
+	TestTrue(TEXT("Add 12"), Add(*cache, 12, SLAB_SIZE));
+	TestTrue(TEXT("Evicted 6, not the reserved 11"), cache->Get(6) == nullptr && cache->Get(11) == writing);
+	cache->Unpin(11);
+	cache->Unpin(3);
+
+	// Two slabs need a contiguous run, unpinned entries go until one opens up
+	TestTrue(TEXT("Add 13 over two slabs"), Add(*cache, 13, SLAB_SIZE * 2));
+	TestTrue(TEXT("13 readable"), HasContent(*cache, 13, SLAB_SIZE * 2));
+
+	// Everything pinned, nothing can be evicted
+	std::vector<uint32_t> live;
+	for (uint32_t id = 1; id <= 13; ++id)
+	{
+		if (cache->Pin(id))
+		{
+			live.push_back(id);
+		}
+	}
+	TestTrue(TEXT("Full of pinned entries refuses"), cache->Reserve(14, SLAB_SIZE) == nullptr);
+	for (uint32_t id : live)
+	{
+		cache->Unpin(id);
+	}
+	TestTrue(TEXT("Accepts once unpinned"), Add(*cache, 14, SLAB_SIZE));
+
+	// Larger than the whole cache
+	TestTrue(TEXT("Oversized entry refused"), cache->Reserve(15, SLAB_SIZE * SLAB_COUNT + 1) == nullptr);
+
+	cache->Reset();
+	TestEqual(TEXT("Empty after reset"), (int64)cache->GetOccupancyInBytes(), (int64)0);
+	TestEqual(TEXT("All slabs free after reset"), (int32)cache->GetFreeSlabCount(), (int32)SLAB_COUNT);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderDiskCacheBoundTest, "Evercoast.Reader.Cache.DiskByteBound", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderDiskCacheBoundTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderCacheTest;
+
+	std::unique_ptr<ReaderDiskCache> cache = MakeDiskCache(TEXT("EvercoastReaderCacheTest_Bound.bin"));
+	if (!TestTrue(TEXT("Cache file mapped"), cache->IsMapped()))
+		return false;
+
+	// A long stream of entries of mixed sizes, a few finished with early like GhostTree does
+	const uint64_t capacity = (uint64_t)SLAB_SIZE * SLAB_COUNT;
+	std::map<uint32_t, uint32_t> sizes;
+	uint32_t state = 1;
+	int32_t refused = 0;
+	int32_t overBound = 0;
+	int32_t wrongOccupancy = 0;
+	for (uint32_t id = 0; id < 2000; ++id)
+	{
+		state = state * 1664525u + 1013904223u;
+		const uint32_t size = 1 + (state >> 8) % (SLAB_SIZE * 3);
+		refused += Add(*cache, id, size) ? 0 : 1;
+		sizes[id] = size;
+		if (id % 5 == 0)
+		{
+			cache->Remove(id - id / 10);
+		}
+
+		// Requested bytes of whatever is still there
+		uint64_t expected = 0;
+		for (auto it = sizes.begin(); it != sizes.end();)
+		{
+			if (cache->Get(it->first))
+			{
+				expected += it->second;
+				++it;
+			}
+			else
+			{
+				it = sizes.erase(it);
+			}
+		}
+		overBound += cache->GetOccupancyInBytes() > capacity ? 1 : 0;
+		wrongOccupancy += cache->GetOccupancyInBytes() != expected ? 1 : 0;
+	}
+
+	AddInfo(FString::Printf(TEXT("2000 entries through %llu bytes: %llu evicted, %d live"), (unsigned long long)capacity,
+		(unsigned long long)cache->GetEvictionCount(), (int32)sizes.size()));
+	TestEqual(TEXT("Nothing refused"), refused, 0);
+	TestEqual(TEXT("Never over the capacity"), overBound, 0);
+	TestEqual(TEXT("Occupancy is the requested bytes"), wrongOccupancy, 0);
+	TestTrue(TEXT("Evicted to stay bounded"), cache->GetEvictionCount() > 0);
+
+	// The most recent entry always survives
+	TestTrue(TEXT("Latest entry intact"), HasContent(*cache, 1999, sizes[1999]));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderMemoryCacheArenaTest, "Evercoast.Reader.Cache.MemoryArena", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderMemoryCacheArenaTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderCacheTest;
+
+	const uint64_t capacity = 64 * 1024;
+	ReaderMemoryCache cache(capacity);
+
+	// Blocks come back through the size class free list instead of the heap
+	TestTrue(TEXT("Add 5000 bytes"), Add(cache, 1, 5000));
+	const uint8_t* first = cache.Get(1);
+	TestEqual(TEXT("Requested bytes charged"), (int64)cache.GetOccupancyInBytes(), (int64)5000);
+	TestEqual(TEXT("Rounding up to 8KB is slack"), (int64)cache.GetSlackBytes(), (int64)(8192 - 5000));
+	cache.Remove(1);
+	TestEqual(TEXT("Removed block retained"), (int64)cache.GetRetainedBytes(), (int64)8192);
+	TestTrue(TEXT("Add 6000 bytes"), Add(cache, 2, 6000));
+	TestTrue(TEXT("Same size class reuses the block"), cache.Get(2) == first && HasContent(cache, 2, 6000));
+	TestEqual(TEXT("Nothing retained once reused"), (int64)cache.GetRetainedBytes(), (int64)0);
+
+	// Growing and shrinking in place moves bytes between the budget and the slack
+	TestNotNull(TEXT("Grow within the block"), cache.Reserve(2, 8000));
+	cache.Unpin(2);
+	TestTrue(TEXT("Grown in place"), cache.Get(2) == first);
+	TestEqual(TEXT("Grown entry charged"), (int64)cache.GetOccupancyInBytes(), (int64)8000);
+	TestEqual(TEXT("Grown entry slack"), (int64)cache.GetSlackBytes(), (int64)192);
+	cache.Remove(2);
+
+	// The budget is the requested bytes, rounding doesn't eat into it
+	uint32_t added = 0;
+	while (Add(cache, 100 + added, 4097))
+	{
+		++added;
+	}
+	TestEqual(TEXT("Entries of 4097 bytes fitting 64KB"), (int32)added, (int32)(capacity / 4097));
+	TestTrue(TEXT("Never over the capacity"), cache.GetOccupancyInBytes() <= capacity);
+	const uint64_t occupied = cache.GetOccupancyInBytes();
+	// 15 entries leave 4081 bytes, short of the 4095 growing one of them within its block takes
+	TestTrue(TEXT("Growing past the budget refused"), cache.Reserve(100, 8192) == nullptr);
+	TestEqual(TEXT("Refused growth leaves the budget alone"), (int64)cache.GetOccupancyInBytes(), (int64)occupied);
+
+	// Retained blocks count towards the capacity, a new size class trims them first
+	for (uint32_t i = 0; i < added; ++i)
+	{
+		cache.Remove(100 + i);
+	}
+	TestEqual(TEXT("Empty"), (int64)cache.GetOccupancyInBytes(), (int64)0);
+	TestTrue(TEXT("Add 40000 bytes"), Add(cache, 3, 40000));
+	TestTrue(TEXT("Retained trimmed to fit"), cache.GetOccupancyInBytes() + cache.GetRetainedBytes() <= capacity);
+
+	cache.Reset();
+	TestEqual(TEXT("Empty after reset"), (int64)cache.GetOccupancyInBytes(), (int64)0);
+	TestEqual(TEXT("No slack after reset"), (int64)cache.GetSlackBytes(), (int64)0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderMemoryCacheShardTest, "Evercoast.Reader.Cache.MemoryShards", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderMemoryCacheShardTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderCacheTest;
+
+	// Adders like HTTP completions against a reader like the game thread, each on its own ids
+	ReaderMemoryCache cache(64ull * 1024 * 1024);
+	const int32_t threadCount = 4;
+	const uint32_t entriesPerThread = 5000;
+	std::vector<int32_t> corrupted(threadCount, 0);
+	std::vector<std::thread> threads;
+	for (int32_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&cache, &corrupted, t, entriesPerThread]()
+			{
+				for (uint32_t i = 0; i < entriesPerThread; ++i)
+				{
+					const uint32_t id = t * entriesPerThread + i;
+					const uint32_t size = 1000 + (id * 7919) % 20000;
+					if (!Add(cache, id, size) || !HasContent(cache, id, size))
+					{
+						corrupted[t]++;
+					}
+					// Keep a few live so the shards hold entries of different sizes
+					if (i >= 8)
+					{
+						const uint32_t old = id - 8;
+						if (!HasContent(cache, old, 1000 + (old * 7919) % 20000) || !cache.Remove(old))
+						{
+							corrupted[t]++;
+						}
+					}
+				}
+			});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	int32_t totalCorrupted = 0;
+	uint64_t expected = 0;
+	for (int32_t t = 0; t < threadCount; ++t)
+	{
+		totalCorrupted += corrupted[t];
+		for (uint32_t i = entriesPerThread - 8; i < entriesPerThread; ++i)
+		{
+			const uint32_t id = t * entriesPerThread + i;
+			expected += 1000 + (id * 7919) % 20000;
+		}
+	}
+	TestEqual(TEXT("Entries intact"), totalCorrupted, 0);
+	TestEqual(TEXT("Occupancy of the live entries"), (int64)cache.GetOccupancyInBytes(), (int64)expected);
+	AddInfo(FString::Printf(TEXT("%d entries added and removed, %llu bytes retained for reuse"), threadCount * entriesPerThread,
+		(unsigned long long)cache.GetRetainedBytes()));
+	return true;
+}
+
+#endif
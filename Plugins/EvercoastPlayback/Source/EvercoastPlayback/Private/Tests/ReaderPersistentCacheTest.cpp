@@ -0,0 +1,256 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ReaderPersistentCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+// ReaderPersistentCache on a directory of its own under Intermediate, so the shared cache of the editor is left
+// alone. Lookups are waited for, the IO thread is drained with WaitForIdle() where the index has to settle.
+namespace ReaderPersistentCacheTest
+{
+	typedef ReaderPersistentCache::LookupResult LookupResult;
+
+	static const FString URL(TEXT("https://example.com/evercoast/test.ecz"));
+
+	static uint8_t ByteAt(uint64_t offset)
+	{
+		return (uint8_t)((offset * 2654435761ull) >> 13);
+	}
+
+	static std::vector<uint8_t> MakeContent(uint64_t offset, uint32_t size)
+	{
+		std::vector<uint8_t> content(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			content[i] = ByteAt(offset + i);
+		}
+		return content;
+	}
+
+	static FString MakeCacheDir(const TCHAR* name)
+	{
+		const FString dir = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectIntermediateDir(), name));
+		IFileManager::Get().DeleteDirectory(*dir, false, true);
+		return dir;
+	}
+
+	static bool Store(ReaderPersistentCache& cache, const FString& etag, uint64_t offset, uint32_t size)
+	{
+		const std::vector<uint8_t> content = MakeContent(offset, size);
+		return cache.Store(URL, etag, offset, size, content.data());
+	}
+
+	// Wait for the lookup, outContentMatches tells whether a hit read back what was stored
+	static LookupResult Lookup(ReaderPersistentCache& cache, uint64_t offset, uint32_t size, bool& outContentMatches)
+	{
+		std::vector<uint8_t> destination(size);
+		std::promise<LookupResult> done;
+		std::future<LookupResult> result = done.get_future();
+		cache.LookupAsync(&destination, 0, URL, offset, size, destination.data(), [&done](LookupResult lookupResult)
+		{
+			done.set_value(lookupResult);
+		});
+
+		const LookupResult lookupResult = result.get();
+		outContentMatches = destination == MakeContent(offset, size);
+		return lookupResult;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderPersistentCacheRoundTripTest, "Evercoast.Reader.PersistentCache.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderPersistentCacheRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderPersistentCacheTest;
+
+	const FString dir = MakeCacheDir(TEXT("EvercoastPersistentCacheTest_RoundTrip"));
+	const uint64_t chunkSize = ReaderPersistentCache::CHUNK_SIZE;
+	{
+		std::unique_ptr<ReaderPersistentCache> cache = ReaderPersistentCache::CreateStandalone(dir);
+		// Two ranges in the first chunk, one in the second
+		TestTrue(TEXT("Store 0"), Store(*cache, TEXT("v1"), 0, 64 * 1024));
+		TestTrue(TEXT("Store 100000"), Store(*cache, TEXT("v1"), 100000, 32 * 1024));
+		TestTrue(TEXT("Store next chunk"), Store(*cache, TEXT("v1"), chunkSize + 5, 16 * 1024));
+		cache->WaitForIdle();
+
+		TestEqual(TEXT("Occupancy is the stored bytes"), (int64)cache->GetOccupancyInBytes(), (int64)(64 + 32 + 16) * 1024);
+		TestTrue(TEXT("Contains stored range"), cache->Contains(URL, 100000, 32 * 1024));
+		TestTrue(TEXT("Contains part of a stored range"), cache->Contains(URL, 1000, 1000));
+		TestFalse(TEXT("Doesn't contain a range across two stored ones"), cache->Contains(URL, 60 * 1024, 50000));
+		TestFalse(TEXT("Doesn't contain other URLs"), cache->Contains(URL + TEXT("?other"), 0, 1024));
+
+		bool matches = false;
+		TestTrue(TEXT("Whole range hit"), Lookup(*cache, 0, 64 * 1024, matches) == LookupResult::Hit && matches);
+		TestTrue(TEXT("Part of a range hit"), Lookup(*cache, 100000 + 777, 4096, matches) == LookupResult::Hit && matches);
+		TestTrue(TEXT("Second chunk hit"), Lookup(*cache, chunkSize + 5, 16 * 1024, matches) == LookupResult::Hit && matches);
+		TestTrue(TEXT("Not stored misses"), Lookup(*cache, 200000, 1024, matches) == LookupResult::Miss);
+
+		// Saved on the IO thread, then read back by a new instance as on the next app start
+		cache->Flush();
+		cache->WaitForIdle();
+	}
+
+	{
+		std::unique_ptr<ReaderPersistentCache> cache = ReaderPersistentCache::CreateStandalone(dir);
+		cache->WaitForIdle();
+		TestEqual(TEXT("Reloaded occupancy"), (int64)cache->GetOccupancyInBytes(), (int64)(64 + 32 + 16) * 1024);
+		bool matches = false;
+		TestTrue(TEXT("Reloaded range hit"), Lookup(*cache, 100000, 32 * 1024, matches) == LookupResult::Hit && matches);
+		TestTrue(TEXT("Reloaded second chunk hit"), Lookup(*cache, chunkSize + 5, 16 * 1024, matches) == LookupResult::Hit && matches);
+	}
+
+	IFileManager::Get().DeleteDirectory(*dir, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderPersistentCacheInvalidationTest, "Evercoast.Reader.PersistentCache.Invalidation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderPersistentCacheInvalidationTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderPersistentCacheTest;
+
+	const FString dir = MakeCacheDir(TEXT("EvercoastPersistentCacheTest_Invalidation"));
+	std::unique_ptr<ReaderPersistentCache> cache = ReaderPersistentCache::CreateStandalone(dir);
+
+	// A new ETag drops everything cached of the URL
+	TestTrue(TEXT("Store v1"), Store(*cache, TEXT("v1"), 0, 8192));
+	TestTrue(TEXT("Store v1 elsewhere"), Store(*cache, TEXT("v1"), 3 * ReaderPersistentCache::CHUNK_SIZE, 8192));
+	cache->WaitForIdle();
+	TestTrue(TEXT("v1 cached"), cache->Contains(URL, 0, 8192));
+	TestTrue(TEXT("Store v2"), Store(*cache, TEXT("v2"), 65536, 4096));
+	cache->WaitForIdle();
+	TestFalse(TEXT("v1 dropped"), cache->Contains(URL, 0, 8192));
+	TestFalse(TEXT("v1 dropped in every chunk"), cache->Contains(URL, 3 * ReaderPersistentCache::CHUNK_SIZE, 8192));
+	TestTrue(TEXT("v2 cached"), cache->Contains(URL, 65536, 4096));
+	TestEqual(TEXT("Only v2 occupies the cache"), (int64)cache->GetOccupancyInBytes(), (int64)4096);
+
+	// A chunk file damaged on disk is a miss, and the range is dropped
+	TArray<FString> files;
+	IFileManager::Get().FindFiles(files, *FPaths::Combine(dir, TEXT("*.bin")), true, false);
+	if (!TestEqual(TEXT("One chunk file"), (int32)files.Num(), 1))
+		return false;
+	TArray<uint8> garbage;
+	garbage.Init(0xcd, 65536 + 4096);
+	TestTrue(TEXT("Chunk file overwritten"), FFileHelper::SaveArrayToFile(garbage, *FPaths::Combine(dir, files[0])));
+
+	bool matches = false;
+	TestTrue(TEXT("Corrupted range misses"), Lookup(*cache, 65536, 4096, matches) == LookupResult::Miss);
+	TestFalse(TEXT("Corrupted range dropped"), cache->Contains(URL, 65536, 4096));
+	TestEqual(TEXT("Nothing left"), (int64)cache->GetOccupancyInBytes(), (int64)0);
+
+	cache.reset();
+	IFileManager::Get().DeleteDirectory(*dir, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderPersistentCacheEvictionTest, "Evercoast.Reader.PersistentCache.EvictionOrder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderPersistentCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderPersistentCacheTest;
+
+	const FString dir = MakeCacheDir(TEXT("EvercoastPersistentCacheTest_Eviction"));
+	std::unique_ptr<ReaderPersistentCache> cache = ReaderPersistentCache::CreateStandalone(dir);
+	cache->WaitForIdle();
+
+	// Room for three chunks holding one range each, evicted a whole chunk at a time
+	const uint32_t rangeSize = 16 * 1024;
+	const uint64_t chunkSize = ReaderPersistentCache::CHUNK_SIZE;
+	cache->SetCapacity(3 * rangeSize);
+	for (uint64_t chunk = 0; chunk < 3; ++chunk)
+	{
+		TestTrue(*FString::Printf(TEXT("Store chunk %llu"), (unsigned long long)chunk), Store(*cache, TEXT("v1"), chunk * chunkSize, rangeSize));
+	}
+	cache->WaitForIdle();
+
+	// Reading chunk 0 makes chunk 1 the least recently used
+	bool matches = false;
+	TestTrue(TEXT("Read chunk 0"), Lookup(*cache, 0, rangeSize, matches) == LookupResult::Hit && matches);
+	TestTrue(TEXT("Store chunk 3"), Store(*cache, TEXT("v1"), 3 * chunkSize, rangeSize));
+	cache->WaitForIdle();
+	TestTrue(TEXT("Kept chunk 0"), cache->Contains(URL, 0, rangeSize));
+	TestFalse(TEXT("Evicted chunk 1"), cache->Contains(URL, chunkSize, rangeSize));
+	TestTrue(TEXT("Kept chunk 2"), cache->Contains(URL, 2 * chunkSize, rangeSize));
+	TestTrue(TEXT("Kept chunk 3"), cache->Contains(URL, 3 * chunkSize, rangeSize));
+	TestEqual(TEXT("Occupancy at the capacity"), (int64)cache->GetOccupancyInBytes(), (int64)3 * rangeSize);
+
+	// Evicted chunk files are deleted on the IO thread
+	TArray<FString> files;
+	IFileManager::Get().FindFiles(files, *FPaths::Combine(dir, TEXT("*.bin")), true, false);
+	TestEqual(TEXT("One file per cached chunk"), (int32)files.Num(), 3);
+
+	// Shrinking evicts right away
+	cache->SetCapacity(rangeSize);
+	TestEqual(TEXT("Shrunk occupancy"), (int64)cache->GetOccupancyInBytes(), (int64)rangeSize);
+	TestTrue(TEXT("Most recent chunk kept"), cache->Contains(URL, 3 * chunkSize, rangeSize));
+
+	cache.reset();
+	IFileManager::Get().DeleteDirectory(*dir, false, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastReaderPersistentCacheCancelTest, "Evercoast.Reader.PersistentCache.Cancel", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastReaderPersistentCacheCancelTest::RunTest(const FString& Parameters)
+{
+	using namespace ReaderPersistentCacheTest;
+
+	const FString dir = MakeCacheDir(TEXT("EvercoastPersistentCacheTest_Cancel"));
+	std::unique_ptr<ReaderPersistentCache> cache = ReaderPersistentCache::CreateStandalone(dir);
+	TestTrue(TEXT("Store"), Store(*cache, TEXT("v1"), 0, 4096));
+	cache->WaitForIdle();
+
+	// Another owner's lookup holds up the IO thread, so the ones behind it are still queued
+	int blockerOwner = 0;
+	int owner = 0;
+	std::promise<void> blockerStarted;
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::vector<uint8_t> blockerDestination(4096);
+	cache->LookupAsync(&blockerOwner, 0, URL, 0, 4096, blockerDestination.data(), [&blockerStarted, released](LookupResult result)
+	{
+		blockerStarted.set_value();
+		released.wait();
+	});
+	blockerStarted.get_future().wait();
+
+	const uint32_t lookupCount = 4;
+	std::vector<std::vector<uint8_t>> destinations(lookupCount, std::vector<uint8_t>(4096, 0xcd));
+	std::atomic<uint32_t> cancelled{ 0 };
+	std::atomic<uint32_t> other{ 0 };
+	for (uint32_t i = 0; i < lookupCount; ++i)
+	{
+		cache->LookupAsync(&owner, i + 1, URL, 0, 4096, destinations[i].data(), [&cancelled, &other](LookupResult result)
+		{
+			(result == LookupResult::Cancelled ? cancelled : other).fetch_add(1);
+		});
+	}
+
+	TestTrue(TEXT("Queued lookup cancelled"), cache->CancelLookup(&owner, 1));
+	cache->CancelLookups(&owner);
+	TestEqual(TEXT("All queued lookups called back cancelled"), (int32)cancelled.load(), (int32)lookupCount);
+
+	release.set_value();
+	cache->WaitForIdle();
+	TestEqual(TEXT("Nothing else called back"), (int32)other.load(), 0);
+	bool untouched = true;
+	for (const std::vector<uint8_t>& destination : destinations)
+	{
+		untouched = untouched && destination == std::vector<uint8_t>(4096, 0xcd);
+	}
+	TestTrue(TEXT("Cancelled lookups never wrote"), untouched);
+
+	cache.reset();
+	IFileManager::Get().DeleteDirectory(*dir, false, true);
+	return true;
+}
+
+#endif
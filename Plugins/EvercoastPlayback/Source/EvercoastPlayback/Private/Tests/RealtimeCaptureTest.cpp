@@ -0,0 +1,197 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Realtime/RealtimeCapture.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// RealtimeCaptureWriter and RealtimeCaptureReplayer on a two second capture shaped like a live session: geometry
+// frames at about 14Hz on connection 0 and 20ms audio packets with their user data header on connection 1. Playback
+// is driven with a simulated clock the way RealtimeNetworkThread polls it, so nothing here waits in real time.
+namespace RealtimeCaptureTest
+{
+	static constexpr uint64_t GEOMETRY_SIZE = 2000;
+	static constexpr uint64_t AUDIO_SIZE = 3840;
+	static const uint8_t AUDIO_USER_DATA[6] = { 16, 2, 0x80, 0xbb, 0, 0 };
+
+	static FString CapturePath()
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("EvercoastRealtimeCaptureTest.cap")));
+	}
+
+	// 129 frames over 1.96s: 29 geometry frames numbered from 1000, 100 audio packets numbered from 0
+	static bool WriteCapture(const std::string& path, std::string& outError)
+	{
+		RealtimeCaptureWriter writer;
+		if (!writer.Open(path, outError))
+			return false;
+
+		for (int32_t tick = 0; tick < 200; ++tick)
+		{
+			const double time = tick * 0.01;
+			if (tick % 7 == 0)
+			{
+				const std::vector<uint8_t> data(GEOMETRY_SIZE, (uint8_t)tick);
+				writer.Write(0, 100.0 + time, 1000 + tick / 7, (uint64_t)(time * 1e6), 0, data.data(), data.size(), nullptr, 0);
+			}
+			if (tick % 2 == 0)
+			{
+				const std::vector<uint8_t> data(AUDIO_SIZE, 1);
+				writer.Write(1, 100.0 + time, tick / 2, (uint64_t)(time * 1e6), 1, data.data(), data.size(), AUDIO_USER_DATA, sizeof(AUDIO_USER_DATA));
+			}
+		}
+		writer.Close();
+		return writer.GetFramesWritten() == 129;
+	}
+
+	struct PlaybackResult
+	{
+		uint64_t delivered[RealtimeCaptureReplayer::MAX_CONNECTIONS] = {};
+		uint64_t lastFrameNumber[RealtimeCaptureReplayer::MAX_CONNECTIONS] = {};
+		uint64_t lastGeometryTimestamp = 0;
+		// Frame numbers going backwards on a connection
+		uint64_t outOfOrder = 0;
+		// Frames handed out before their arrival time, or more than a poll after it
+		uint64_t mistimed = 0;
+		// Frames whose data or user data don't match what was written
+		uint64_t corrupted = 0;
+		double endTime = 0;
+		bool finished = false;
+		RealtimeCaptureReplayer::Stats stats;
+	};
+
+	// Polls like the network thread, sleeping until the next frame is due but at least a millisecond
+	static bool Play(const std::string& path, const RealtimeCaptureReplayer::Options& options, double duration, PlaybackResult& result, std::string& outError)
+	{
+		RealtimeCaptureReplayer replayer;
+		if (!replayer.Open(path, options, outError))
+			return false;
+
+		const double poll = 0.001;
+		double now = 0;
+		while (now < duration && !replayer.IsFinished())
+		{
+			RealtimeCaptureFrame frame;
+			for (int32_t connection = 0; connection < RealtimeCaptureReplayer::MAX_CONNECTIONS; ++connection)
+			{
+				while (replayer.Pop(connection, now, frame))
+				{
+					if (result.delivered[connection] > 0 && frame.frameNumber <= result.lastFrameNumber[connection])
+					{
+						result.outOfOrder++;
+					}
+					result.delivered[connection]++;
+					result.lastFrameNumber[connection] = frame.frameNumber;
+
+					if (options.maxJitter == 0 && !options.loop)
+					{
+						const double due = frame.arrivalTime * options.timeScale;
+						result.mistimed += now < due - 1e-9 || now > due + poll + 1e-9 ? 1 : 0;
+					}
+
+					const bool isGeometry = connection == 0;
+					const uint64_t expectedSize = isGeometry ? GEOMETRY_SIZE : AUDIO_SIZE;
+					const bool userDataIntact = isGeometry ? frame.userData.empty() :
+						frame.userData.size() == sizeof(AUDIO_USER_DATA) && std::equal(frame.userData.begin(), frame.userData.end(), AUDIO_USER_DATA);
+					result.corrupted += frame.data.size() != expectedSize || !userDataIntact || frame.connection != connection ? 1 : 0;
+					if (isGeometry)
+					{
+						result.lastGeometryTimestamp = frame.timestamp;
+					}
+				}
+			}
+
+			const double wait = replayer.GetTimeUntilNextFrame(now);
+			if (wait < 0)
+				break;
+			now += std::max(wait, poll);
+		}
+
+		result.endTime = now;
+		result.finished = replayer.IsFinished();
+		result.stats = replayer.GetStats();
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastRealtimeCaptureReplayTest, "Evercoast.Realtime.Capture.Replay", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastRealtimeCaptureReplayTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeCaptureTest;
+
+	const FString capturePath = CapturePath();
+	const std::string path = TCHAR_TO_UTF8(*capturePath);
+	std::string error;
+	if (!TestTrue(*FString::Printf(TEXT("Capture written %s"), UTF8_TO_TCHAR(error.c_str())), WriteCapture(path, error)))
+	{
+		IFileManager::Get().Delete(*capturePath);
+		return false;
+	}
+
+	// Original timing: everything in order, on time and byte for byte
+	{
+		PlaybackResult result;
+		TestTrue(TEXT("Open for playback"), Play(path, RealtimeCaptureReplayer::Options(), 10.0, result, error));
+		TestEqual(TEXT("Geometry frames delivered"), (int64)result.delivered[0], (int64)29);
+		TestEqual(TEXT("Audio packets delivered"), (int64)result.delivered[1], (int64)100);
+		TestEqual(TEXT("In order"), (int64)result.outOfOrder, (int64)0);
+		TestEqual(TEXT("Delivered at the recorded arrival times"), (int64)result.mistimed, (int64)0);
+		TestEqual(TEXT("Frames intact"), (int64)result.corrupted, (int64)0);
+		TestEqual(TEXT("Last geometry frame"), (int64)result.lastFrameNumber[0], (int64)1028);
+		TestTrue(TEXT("Finished"), result.finished);
+		TestEqual(TEXT("Played for the capture's length"), result.endTime, 1.96, 0.05);
+	}
+
+	// Loss bursts with jitter wider than the audio interval: what's lost is counted, the rest arrives intact,
+	// partly reordered, and the same seed gives the same network
+	{
+		RealtimeCaptureReplayer::Options options;
+		options.lossRate = 0.1;
+		options.maxLossBurst = 3;
+		options.maxJitter = 0.05;
+		options.seed = 7;
+		PlaybackResult result;
+		PlaybackResult again;
+		TestTrue(TEXT("Open with loss and jitter"), Play(path, options, 10.0, result, error) && Play(path, options, 10.0, again, error));
+		AddInfo(FString::Printf(TEXT("Loss and jitter: %llu of %llu dropped, %llu reordered"), (unsigned long long)result.stats.Dropped,
+			(unsigned long long)result.stats.Read, (unsigned long long)result.stats.Reordered));
+
+		TestEqual(TEXT("Every frame read"), (int64)result.stats.Read, (int64)129);
+		TestEqual(TEXT("Delivered or dropped"), (int64)(result.stats.Delivered + result.stats.Dropped), (int64)result.stats.Read);
+		TestEqual(TEXT("Delivered count matches the stats"), (int64)(result.delivered[0] + result.delivered[1]), (int64)result.stats.Delivered);
+		TestTrue(TEXT("Some frames dropped"), result.stats.Dropped > 0 && result.stats.Dropped < result.stats.Read / 4);
+		TestTrue(TEXT("Some frames reordered"), result.stats.Reordered > 0);
+		TestEqual(TEXT("Frames intact"), (int64)result.corrupted, (int64)0);
+		TestTrue(TEXT("Finished"), result.finished);
+		TestTrue(TEXT("Same seed, same network"), again.stats.Dropped == result.stats.Dropped && again.stats.Reordered == result.stats.Reordered &&
+			again.delivered[0] == result.delivered[0] && again.delivered[1] == result.delivered[1]);
+	}
+
+	// Looping at double speed: frame numbers and timestamps keep increasing across the loops and it never finishes
+	{
+		RealtimeCaptureReplayer::Options options;
+		options.loop = true;
+		options.timeScale = 0.5;
+		PlaybackResult result;
+		TestTrue(TEXT("Open looping"), Play(path, options, 5.0, result, error));
+		AddInfo(FString::Printf(TEXT("Looping: %llu loops, %llu geometry frames, last timestamp %.2fs"), (unsigned long long)result.stats.Loops,
+			(unsigned long long)result.delivered[0], result.lastGeometryTimestamp / 1e6));
+
+		TestTrue(TEXT("Looped"), result.stats.Loops >= 4);
+		TestFalse(TEXT("Never finishes"), result.finished);
+		TestEqual(TEXT("Frame numbers keep increasing"), (int64)result.outOfOrder, (int64)0);
+		TestTrue(TEXT("Timestamps carry on past the capture"), result.lastGeometryTimestamp > 2 * 1960000ull);
+		TestEqual(TEXT("Frames intact"), (int64)result.corrupted, (int64)0);
+	}
+
+	IFileManager::Get().Delete(*capturePath);
+	return true;
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Realtime/RealtimeJitterBuffer.h"
+#include <utility>
+#include <vector>
+
+// RealtimeJitterBuffer replaying recorded packet arrivals on a simulated clock, polled every millisecond the way the
+// realtime decode threads wake up
+namespace RealtimeJitterBufferTest
+{
+	struct Arrival
+	{
+		int64_t frameNumber;
+		double time;
+	};
+
+	static std::vector<int64_t> Replay(RealtimeJitterBuffer<int64_t>& buffer, const std::vector<Arrival>& arrivals, double duration, std::vector<double>* outReleaseTimes = nullptr)
+	{
+		std::vector<int64_t> released;
+		size_t next = 0;
+		for (int step = 0; step <= (int)(duration * 1000.0); ++step)
+		{
+			const double now = step / 1000.0;
+			while (next < arrivals.size() && arrivals[next].time <= now)
+			{
+				int64_t packet = arrivals[next].frameNumber;
+				buffer.Push(arrivals[next].frameNumber, arrivals[next].time, std::move(packet));
+				++next;
+			}
+
+			int64_t frameNumber = 0;
+			int64_t packet = 0;
+			while (buffer.Pop(now, frameNumber, packet))
+			{
+				released.push_back(frameNumber);
+				if (outReleaseTimes)
+				{
+					outReleaseTimes->push_back(now);
+				}
+			}
+		}
+		return released;
+	}
+
+	static FString Join(const std::vector<int64_t>& frameNumbers)
+	{
+		FString joined;
+		for (int64_t frameNumber : frameNumbers)
+		{
+			joined += FString::Printf(TEXT("%lld "), (long long)frameNumber);
+		}
+		return joined.TrimEnd();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastJitterBufferReorderTest, "Evercoast.Realtime.JitterBuffer.Reorder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastJitterBufferReorderTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeJitterBufferTest;
+
+	// 30 fps with 3 overtaken by 2 within the latency, 5 overtaken for longer than that and 8 delivered twice
+	const std::vector<Arrival> arrivals =
+	{
+		{ 0, 0.0 }, { 1, 0.033 }, { 3, 0.070 }, { 2, 0.075 }, { 4, 0.133 },
+		{ 6, 0.2 }, { 7, 0.233 }, { 5, 0.30 }, { 8, 0.3 }, { 8, 0.31 },
+	};
+
+	RealtimeJitterBuffer<int64_t> buffer(0.02, 8);
+	std::vector<double> releaseTimes;
+	const std::vector<int64_t> released = Replay(buffer, arrivals, 1.0, &releaseTimes);
+	TestEqual(TEXT("Release order"), Join(released), FString(TEXT("0 1 2 3 4 6 7 8")));
+
+	const auto& stats = buffer.GetStats();
+	TestEqual(TEXT("Received"), (int32)stats.Received, 10);
+	TestEqual(TEXT("Released"), (int32)stats.Released, 8);
+	TestEqual(TEXT("Late"), (int32)stats.Late, 1);
+	TestEqual(TEXT("Duplicate"), (int32)stats.Duplicate, 1);
+	TestEqual(TEXT("Overflow"), (int32)stats.Overflow, 0);
+	TestEqual(TEXT("Lost"), (int32)stats.Lost, 1);
+	TestEqual(TEXT("Drained"), (int32)buffer.GetSize(), 0);
+
+	// Nothing is released before it has been held for the target latency
+	for (size_t i = 0; i < released.size(); ++i)
+	{
+		for (const Arrival& arrival : arrivals)
+		{
+			if (arrival.frameNumber == released[i])
+			{
+				TestTrue(TEXT("Held for the target latency"), releaseTimes[i] + 1e-9 >= arrival.time + 0.02);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastJitterBufferPassthroughTest, "Evercoast.Realtime.JitterBuffer.PassthroughAndOverflow", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastJitterBufferPassthroughTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeJitterBufferTest;
+
+	// No latency, capacity 2: the third push drops the oldest
+	RealtimeJitterBuffer<int64_t> buffer(0.0, 2);
+	TestEqual(TEXT("Empty buffer has nothing to wait for"), buffer.GetTimeUntilNextRelease(0.0), -1.0);
+	for (int64_t frameNumber = 0; frameNumber < 3; ++frameNumber)
+	{
+		int64_t packet = frameNumber;
+		TestTrue(TEXT("Pushed"), buffer.Push(frameNumber, 0.0, std::move(packet)));
+	}
+	TestEqual(TEXT("Released right away"), buffer.GetTimeUntilNextRelease(0.0), 0.0);
+
+	std::vector<int64_t> released;
+	int64_t frameNumber = 0;
+	int64_t packet = 0;
+	while (buffer.Pop(0.0, frameNumber, packet))
+	{
+		TestEqual(TEXT("Packet matches its frame number"), (int32)packet, (int32)frameNumber);
+		released.push_back(frameNumber);
+	}
+	TestEqual(TEXT("Oldest dropped on overflow"), Join(released), FString(TEXT("1 2")));
+	TestEqual(TEXT("Overflow"), (int32)buffer.GetStats().Overflow, 1);
+	TestEqual(TEXT("Overflow isn't loss"), (int32)buffer.GetStats().Lost, 0);
+
+	// A gap is skipped once the frame after it is due, counted as lost
+	packet = 1000;
+	buffer.Push(1000, 0.0, std::move(packet));
+	packet = 3;
+	buffer.Push(3, 0.0, std::move(packet));
+	released.clear();
+	while (buffer.Pop(0.0, frameNumber, packet))
+	{
+		released.push_back(frameNumber);
+	}
+	TestEqual(TEXT("Gap skipped"), Join(released), FString(TEXT("3 1000")));
+	TestEqual(TEXT("Skipped frames counted as lost"), (int32)buffer.GetStats().Lost, 996);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastJitterBufferRestartTest, "Evercoast.Realtime.JitterBuffer.SenderRestart", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastJitterBufferRestartTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeJitterBufferTest;
+
+	// Frames 500..509, then the sender restarts from 0. A straggler of the old numbering is still late.
+	std::vector<Arrival> arrivals;
+	for (int64_t i = 0; i < 10; ++i)
+	{
+		arrivals.push_back({ 500 + i, i / 30.0 });
+	}
+	arrivals.push_back({ 400, 0.4 });
+	for (int64_t i = 0; i < 5; ++i)
+	{
+		arrivals.push_back({ i, 0.5 + i / 30.0 });
+	}
+
+	RealtimeJitterBuffer<int64_t> buffer(0.01, 16);
+	const std::vector<int64_t> released = Replay(buffer, arrivals, 1.0);
+	TestEqual(TEXT("Release order across the restart"), Join(released), FString(TEXT("500 501 502 503 504 505 506 507 508 509 0 1 2 3 4")));
+	TestEqual(TEXT("Straggler within the restart distance is late"), (int32)buffer.GetStats().Late, 1);
+	TestEqual(TEXT("Restart isn't loss"), (int32)buffer.GetStats().Lost, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Realtime/RealtimeReceiveWait.h"
+#include "HAL/PlatformTime.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The realtime network loop's wait against the fixed backoff it replaced. A loopback sender thread stands in for the
+// VCI client's receive thread, queueing geometry and audio frames at their cadence with some jitter, and the loop
+// under test can only poll that queue, as it can only poll the VCI connections. Reports wake ups and time spent
+// awake per second of stream, which is the loop's CPU cost, and the latency from queueing to pick up.
+namespace RealtimeReceiveWaitTest
+{
+	static constexpr int CONNECTION_COUNT = 2;
+	static constexpr double GEOMETRY_INTERVAL = 1.0 / 30;
+	static constexpr double AUDIO_INTERVAL = 0.02;
+	static constexpr double MAX_JITTER = 0.001;
+	static constexpr double STREAM_SECONDS = 2.0;
+
+	static double Random(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) / 16777216.0;
+	}
+
+	// Frames are only seen when the loop looks, like VCI's received_frame()
+	class LoopbackConnections
+	{
+	public:
+		void Push(int connection, double queuedTime)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queued[connection].push_back(queuedTime);
+		}
+
+		bool Pop(int connection, double& outQueuedTime)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_queued[connection].empty())
+				return false;
+			outQueuedTime = m_queued[connection].front();
+			m_queued[connection].pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::deque<double> m_queued[CONNECTION_COUNT];
+	};
+
+	struct LoopResult
+	{
+		uint64_t frames = 0;
+		uint64_t wakeUps = 0;
+		double awakeSeconds = 0;
+		double meanLatency = 0;
+		double p99Latency = 0;
+		double maxLatency = 0;
+	};
+
+	// Runs the receive loop the way RealtimeRunnalble::Run() does, with getWait(now, anyReceived) choosing the wait
+	static LoopResult RunLoop(std::function<double(double, bool)> getWait, std::function<void(int, double)> onFrame, uint32_t seed)
+	{
+		LoopbackConnections connections;
+		std::atomic<bool> sending{ true };
+		std::mutex wakeMutex;
+		std::condition_variable wakeCondition;
+
+		std::thread sender([&]()
+			{
+				uint32_t state = seed;
+				const double start = FPlatformTime::Seconds();
+				double next[CONNECTION_COUNT] = { 0, 0 };
+				const double interval[CONNECTION_COUNT] = { GEOMETRY_INTERVAL, AUDIO_INTERVAL };
+				while (true)
+				{
+					const int connection = next[0] <= next[1] ? 0 : 1;
+					const double due = next[connection] + Random(state) * MAX_JITTER;
+					if (due > STREAM_SECONDS)
+						break;
+					std::this_thread::sleep_for(std::chrono::duration<double>(std::max(due - (FPlatformTime::Seconds() - start), 0.0)));
+					connections.Push(connection, FPlatformTime::Seconds());
+					next[connection] += interval[connection];
+				}
+				sending = false;
+			});
+
+		LoopResult result;
+		std::vector<double> latencies;
+		double lastWake = FPlatformTime::Seconds();
+		while (true)
+		{
+			bool anyReceived = false;
+			double queuedTime;
+			for (int connection = 0; connection < CONNECTION_COUNT; ++connection)
+			{
+				while (connections.Pop(connection, queuedTime))
+				{
+					const double now = FPlatformTime::Seconds();
+					latencies.push_back(now - queuedTime);
+					onFrame(connection, now);
+					anyReceived = true;
+				}
+			}
+			if (!sending && !anyReceived)
+				break;
+
+			const double now = FPlatformTime::Seconds();
+			const double wait = getWait(now, anyReceived);
+			result.awakeSeconds += now - lastWake;
+
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			wakeCondition.wait_for(lock, std::chrono::duration<double>(wait));
+			lastWake = FPlatformTime::Seconds();
+			result.wakeUps++;
+		}
+		sender.join();
+
+		result.frames = latencies.size();
+		if (!latencies.empty())
+		{
+			std::sort(latencies.begin(), latencies.end());
+			double total = 0;
+			for (double latency : latencies)
+				total += latency;
+			result.meanLatency = total / latencies.size();
+			result.p99Latency = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+			result.maxLatency = latencies.back();
+		}
+		return result;
+	}
+
+	static FString Describe(const TCHAR* name, const LoopResult& result)
+	{
+		return FString::Printf(TEXT("%s: %llu frames, %.0f wake ups/s (%.1f per frame), awake %.2f ms/s, latency mean %.3f ms p99 %.3f ms max %.3f ms"),
+			name, (unsigned long long)result.frames, result.wakeUps / STREAM_SECONDS, (double)result.wakeUps / FMath::Max<uint64_t>(result.frames, 1),
+			result.awakeSeconds * 1000.0 / STREAM_SECONDS, result.meanLatency * 1000.0, result.p99Latency * 1000.0, result.maxLatency * 1000.0);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastRealtimeReceiveWaitCadenceTest, "Evercoast.Realtime.ReceiveWait.Cadence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastRealtimeReceiveWaitCadenceTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeReceiveWaitTest;
+
+	RealtimeReceiveWait<CONNECTION_COUNT>::Options options;
+	RealtimeReceiveWait<CONNECTION_COUNT> wait(options);
+
+	// Nothing known yet, backs off to the idle limit
+	double now = 10.0;
+	TestEqual(TEXT("First wait is a poll"), wait.GetWait(now), options.pollInterval);
+	double longest = 0;
+	for (int i = 0; i < 20; ++i)
+		longest = wait.GetWait(now);
+	TestEqual(TEXT("Backs off to the idle limit"), longest, options.maxIdleWait);
+
+	// Steady 30 fps geometry found by a loop on a simulated clock, a frame drained in the same look as another
+	// doesn't skew it
+	uint32_t state = 1;
+	double nextFrame = now;
+	int32 looks = 0;
+	for (int i = 0; i < 200; ++i)
+	{
+		nextFrame += GEOMETRY_INTERVAL + (Random(state) - 0.5) * 0.001;
+		while (now < nextFrame)
+		{
+			now += wait.GetWait(now);
+			++looks;
+		}
+		wait.OnFrame(0, now);
+		if (i % 50 == 0)
+			wait.OnFrame(0, now);
+	}
+	AddInfo(FString::Printf(TEXT("%.1f looks per frame"), looks / 200.0));
+	TestTrue(TEXT("A few looks per frame"), looks < 200 * 4);
+	TestTrue(TEXT("Interval learnt"), FMath::Abs(wait.GetInterval(0) - GEOMETRY_INTERVAL) < 0.0005);
+	TestEqual(TEXT("Audio interval unknown"), wait.GetInterval(1), 0.0);
+
+	// Blocks until just before the next frame, then polls
+	const double lastFrame = now;
+	const double firstWait = wait.GetWait(now);
+	AddInfo(FString::Printf(TEXT("Woken %.2f ms ahead of the expected frame"), (GEOMETRY_INTERVAL - firstWait) * 1000.0));
+	TestTrue(TEXT("Sleeps through most of the interval"), firstWait > GEOMETRY_INTERVAL - options.maxMargin && firstWait < GEOMETRY_INTERVAL - options.minMargin + 0.0005);
+	TestEqual(TEXT("Polls once the frame is due"), wait.GetWait(lastFrame + GEOMETRY_INTERVAL - 0.0001), options.pollInterval);
+	TestTrue(TEXT("Polls thin out while a frame is late"), wait.GetWait(lastFrame + GEOMETRY_INTERVAL * 1.5) > options.pollInterval);
+
+	// Stalled for longer than an interval, back to the idle backoff
+	TestEqual(TEXT("Stalled connection doesn't count"), wait.GetWait(lastFrame + GEOMETRY_INTERVAL * 2.5), options.pollInterval);
+	for (int i = 0; i < 20; ++i)
+		longest = wait.GetWait(lastFrame + GEOMETRY_INTERVAL * 2.5);
+	TestEqual(TEXT("Stall backs off to the idle limit"), longest, options.maxIdleWait);
+
+	// The stall isn't taken for the cadence
+	wait.OnFrame(0, lastFrame + GEOMETRY_INTERVAL * 6);
+	TestTrue(TEXT("Interval kept over a stall"), FMath::Abs(wait.GetInterval(0) - GEOMETRY_INTERVAL) < 0.0005);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastRealtimeReceiveWaitLoopbackTest, "Evercoast.Realtime.ReceiveWait.Loopback", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastRealtimeReceiveWaitLoopbackTest::RunTest(const FString& Parameters)
+{
+	using namespace RealtimeReceiveWaitTest;
+
+	// What the loop did before: 50us doubling up to 2ms while nothing arrives, reset on every frame
+	double backoff = 0.00005;
+	const LoopResult polled = RunLoop(
+		[&backoff](double now, bool anyReceived)
+		{
+			if (anyReceived)
+				backoff = 0.00005;
+			const double wait = backoff;
+			backoff = std::min(backoff * 2, 0.002);
+			return wait;
+		},
+		[](int, double) {}, 1);
+
+	RealtimeReceiveWait<CONNECTION_COUNT> receiveWait{ RealtimeReceiveWait<CONNECTION_COUNT>::Options() };
+	const LoopResult predicted = RunLoop(
+		[&receiveWait](double now, bool anyReceived) { return receiveWait.GetWait(now); },
+		[&receiveWait](int connection, double now) { receiveWait.OnFrame(connection, now); }, 1);
+
+	AddInfo(Describe(TEXT("Backoff"), polled));
+	AddInfo(Describe(TEXT("Expected frame"), predicted));
+
+	TestEqual(TEXT("Same frames delivered"), (int64)predicted.frames, (int64)polled.frames);
+	TestTrue(TEXT("At most two thirds of the wake ups"), predicted.wakeUps * 3 <= polled.wakeUps * 2);
+	// Sleep overshoot differs from one machine to the next, only a clear regression should fail
+	TestTrue(TEXT("Latency no worse than a millisecond over the backoff"), predicted.meanLatency <= polled.meanLatency + 0.001);
+	return true;
+}
+
+#endif
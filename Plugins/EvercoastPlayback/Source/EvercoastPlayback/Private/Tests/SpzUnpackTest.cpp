@@ -0,0 +1,228 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Gaussian/SpzUnpack.h"
+#include "HAL/PlatformTime.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// SpzUnpack kernels against the per point loops EvercoastGaussianSplatDecoder had before them, which are the
+// golden output: every kernel has to match byte for byte, whichever SIMD variant is compiled in
+namespace SpzUnpackTest
+{
+	static constexpr float POSITION_SCALAR = 1.0f / 4096.0f;
+
+	struct FrameData
+	{
+		uint32_t pointCount;
+		uint32_t shDim;
+		std::vector<uint8_t> bytes;
+		const uint8_t* positions;
+		const uint8_t* alphas;
+		const uint8_t* colours;
+		const uint8_t* scales;
+		const uint8_t* rotations;
+		const uint8_t* sh;
+	};
+
+	static FrameData MakeFrame(uint32_t pointCount, uint32_t shDim, uint32_t seed)
+	{
+		FrameData frame;
+		frame.pointCount = pointCount;
+		frame.shDim = shDim;
+		// No slack after the last point, the kernels' vector loads must stay in bounds
+		frame.bytes.resize((size_t)pointCount * (9 + 1 + 3 + 3 + 3 + shDim * 3));
+		uint32_t state = seed;
+		for (uint8_t& b : frame.bytes)
+		{
+			state = state * 1664525u + 1013904223u;
+			b = (uint8_t)(state >> 24);
+		}
+		frame.positions = frame.bytes.data();
+		frame.alphas = frame.positions + 9 * pointCount;
+		frame.colours = frame.alphas + pointCount;
+		frame.scales = frame.colours + 3 * pointCount;
+		frame.rotations = frame.scales + 3 * pointCount;
+		frame.sh = frame.rotations + 3 * pointCount;
+		return frame;
+	}
+
+	// The decoder's original helpers
+	static float ExtractScale(uint8_t value)
+	{
+		return expf(float(value) / 16.0f - 10.0f);
+	}
+
+	static float ExtractRotation(uint8_t value)
+	{
+		return float(value) / 127.5 - 1.0;
+	}
+
+	static bool SameBytes(const void* a, const void* b, size_t size)
+	{
+		return size == 0 || std::memcmp(a, b, size) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastSpzUnpackGoldenTest, "Evercoast.Gaussian.SpzUnpack.Golden", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastSpzUnpackGoldenTest::RunTest(const FString& Parameters)
+{
+	using namespace SpzUnpackTest;
+
+	AddInfo(FString::Printf(TEXT("Kernels: %s"), SpzUnpack::GetKernelName()));
+
+	// Odd counts leave tails after every vector width
+	const uint32_t pointCounts[] = { 0, 1, 2, 3, 5, 7, 16, 17, 33, 1000, 4099 };
+	for (uint32_t pointCount : pointCounts)
+	{
+		for (uint32_t shDegree = 0; shDegree <= 3; ++shDegree)
+		{
+			const uint32_t shDim = SpzUnpack::SHDimForDegree(shDegree);
+			const uint32_t stride = SpzUnpack::PaddedSHStride(shDim);
+			const FrameData frame = MakeFrame(pointCount, shDim, pointCount * 4 + shDegree + 1);
+			const FString context = FString::Printf(TEXT("%u points, SH degree %u"), pointCount, shDegree);
+
+			std::vector<float> goldenPositions(4 * pointCount), goldenColours(4 * pointCount), goldenScales(4 * pointCount), goldenRotations(4 * pointCount);
+			std::vector<uint8_t> goldenRgba(4 * pointCount), goldenPadded(12 * pointCount);
+			// Poisoned beyond the planes to catch overruns
+			std::vector<uint8_t> goldenSH(3 * 16 * pointCount + 1, 0xaa);
+			{
+				const uint8_t* in = frame.positions;
+				float* out = goldenPositions.data();
+				for (uint32_t i = 0; i < pointCount; ++i)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						int32_t fixed32 = *in++;
+						fixed32 |= *in++ << 8;
+						fixed32 |= *in++ << 16;
+						fixed32 |= fixed32 & 0x800000 ? (int32_t)0xff000000 : 0;
+						*out++ = (float)fixed32 * POSITION_SCALAR;
+					}
+					*out++ = 0.0f;
+				}
+
+				for (uint32_t i = 0; i < pointCount; ++i)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						goldenRgba[i * 4 + j] = frame.colours[i * 3 + j];
+						goldenColours[i * 4 + j] = (float)frame.colours[i * 3 + j] / 255.0f;
+						goldenScales[i * 4 + j] = ExtractScale(frame.scales[i * 3 + j]);
+						goldenRotations[i * 4 + j] = ExtractRotation(frame.rotations[i * 3 + j]);
+					}
+					goldenRgba[i * 4 + 3] = frame.alphas[i];
+					goldenColours[i * 4 + 3] = (float)frame.alphas[i] / 255.0f;
+					goldenScales[i * 4 + 3] = 0.0f;
+					float* q = &goldenRotations[i * 4];
+					q[3] = std::sqrt(std::max(0.0f, 1.0f - (q[0] * q[0] + q[1] * q[1] + q[2] * q[2])));
+				}
+
+				for (uint32_t t = 0; t < 3 * pointCount; ++t)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						goldenPadded[t * 4 + j] = frame.positions[t * 3 + j];
+					}
+					goldenPadded[t * 4 + 3] = 0;
+				}
+
+				const uint8_t* sh = frame.sh;
+				uint8_t* r = goldenSH.data();
+				uint8_t* g = r + stride * pointCount;
+				uint8_t* b = g + stride * pointCount;
+				for (uint32_t i = 0; i < pointCount; ++i)
+				{
+					uint32_t d = 0;
+					for (; d < shDim; ++d)
+					{
+						*r++ = *sh++;
+						*g++ = *sh++;
+						*b++ = *sh++;
+					}
+					for (; d < stride; ++d)
+					{
+						*r++ = 0;
+						*g++ = 0;
+						*b++ = 0;
+					}
+				}
+			}
+
+			std::vector<float> positions(4 * pointCount), colours(4 * pointCount), scales(4 * pointCount), rotations(4 * pointCount);
+			std::vector<uint8_t> rgba(4 * pointCount), padded(12 * pointCount);
+			std::vector<uint8_t> sh(3 * 16 * pointCount + 1, 0xaa);
+			SpzUnpack::DecodePositions(frame.positions, POSITION_SCALAR, positions.data(), pointCount);
+			SpzUnpack::InterleaveColourAlpha(frame.colours, frame.alphas, rgba.data(), pointCount);
+			SpzUnpack::DecodeColourAlphas(rgba.data(), colours.data(), pointCount);
+			SpzUnpack::DecodeScales(frame.scales, scales.data(), pointCount);
+			SpzUnpack::DecodeRotations(frame.rotations, rotations.data(), pointCount);
+			SpzUnpack::SplitSHCoefficients(frame.sh, shDim, stride, sh.data(), sh.data() + stride * pointCount, sh.data() + 2 * stride * pointCount, pointCount);
+			SpzUnpack::PadTriplets(frame.positions, padded.data(), 3 * pointCount);
+
+			TestTrue(TEXT("Positions, ") + context, SameBytes(positions.data(), goldenPositions.data(), positions.size() * sizeof(float)));
+			TestTrue(TEXT("Colour alpha interleave, ") + context, SameBytes(rgba.data(), goldenRgba.data(), rgba.size()));
+			TestTrue(TEXT("Colours, ") + context, SameBytes(colours.data(), goldenColours.data(), colours.size() * sizeof(float)));
+			TestTrue(TEXT("Scales, ") + context, SameBytes(scales.data(), goldenScales.data(), scales.size() * sizeof(float)));
+			TestTrue(TEXT("Rotations, ") + context, SameBytes(rotations.data(), goldenRotations.data(), rotations.size() * sizeof(float)));
+			TestTrue(TEXT("Padded triplets, ") + context, SameBytes(padded.data(), goldenPadded.data(), padded.size()));
+			// Including the poisoned byte after the planes
+			TestTrue(TEXT("SH planes, ") + context, SameBytes(sh.data(), goldenSH.data(), 3 * stride * pointCount + 1));
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastSpzUnpackBenchmark, "Evercoast.Gaussian.SpzUnpack.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastSpzUnpackBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace SpzUnpackTest;
+
+	AddInfo(FString::Printf(TEXT("Kernels: %s"), SpzUnpack::GetKernelName()));
+
+	const uint32_t pointCounts[] = { 10000, 100000, 1000000 };
+	const int iterations = 10;
+	for (uint32_t pointCount : pointCounts)
+	{
+		const uint32_t shDim = SpzUnpack::SHDimForDegree(3);
+		const uint32_t stride = SpzUnpack::PaddedSHStride(shDim);
+		const FrameData frame = MakeFrame(pointCount, shDim, pointCount);
+
+		std::vector<float> positions(4 * pointCount), colours(4 * pointCount), scales(4 * pointCount), rotations(4 * pointCount);
+		std::vector<uint8_t> rgba(4 * pointCount), sh(3 * stride * pointCount), padded(12 * pointCount);
+
+		// Passthrough: what's uploaded as is and unpacked on the GPU
+		double start = FPlatformTime::Seconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			SpzUnpack::PadTriplets(frame.positions, padded.data(), 3 * pointCount);
+			SpzUnpack::InterleaveColourAlpha(frame.colours, frame.alphas, rgba.data(), pointCount);
+			SpzUnpack::SplitSHCoefficients(frame.sh, shDim, stride, sh.data(), sh.data() + stride * pointCount, sh.data() + 2 * stride * pointCount, pointCount);
+		}
+		const double passthroughMs = (FPlatformTime::Seconds() - start) * 1000.0 / iterations;
+
+		// Full decode to floats
+		start = FPlatformTime::Seconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			SpzUnpack::DecodePositions(frame.positions, POSITION_SCALAR, positions.data(), pointCount);
+			SpzUnpack::InterleaveColourAlpha(frame.colours, frame.alphas, rgba.data(), pointCount);
+			SpzUnpack::DecodeColourAlphas(rgba.data(), colours.data(), pointCount);
+			SpzUnpack::DecodeScales(frame.scales, scales.data(), pointCount);
+			SpzUnpack::DecodeRotations(frame.rotations, rotations.data(), pointCount);
+			SpzUnpack::SplitSHCoefficients(frame.sh, shDim, stride, sh.data(), sh.data() + stride * pointCount, sh.data() + 2 * stride * pointCount, pointCount);
+		}
+		const double decodeMs = (FPlatformTime::Seconds() - start) * 1000.0 / iterations;
+
+		AddInfo(FString::Printf(TEXT("%u points, SH degree 3: passthrough %.3f ms, full decode %.3f ms"), pointCount, passthroughMs, decodeMs));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,199 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VoxelCompactPacking.h"
+#include "HAL/PlatformTime.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Compact voxel elements against the decoder layout they replace. Positions are rebuilt the way the voxel vertex
+// factory does, f16tof32 on the half then BoundsMin + coordinate * Rescale, and the error reported in world units.
+namespace VoxelCompactPackingTest
+{
+	static uint32_t Next(uint32_t& state)
+	{
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	}
+
+	// What f16tof32 gives for non-negative halves, written independently of the packer
+	static double HalfToDouble(uint16_t half)
+	{
+		const int exponent = (half >> 10) & 0x1f;
+		const int mantissa = half & 0x3ff;
+		if (exponent == 0)
+			return std::ldexp((double)mantissa, -24);
+		return std::ldexp(1024.0 + mantissa, exponent - 25);
+	}
+
+	struct Voxels
+	{
+		std::vector<uint16_t> coordinates;
+		std::vector<uint8_t> colours;
+	};
+
+	// Grid corners included, where rounding is the worst
+	static Voxels MakeVoxels(uint32_t count, uint32_t bitsPerVoxel, uint32_t seed)
+	{
+		const uint32_t gridMax = (1u << bitsPerVoxel) - 1;
+		uint32_t state = seed;
+		Voxels voxels;
+		voxels.coordinates.resize(count * 4);
+		voxels.colours.resize(count * 4);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				const uint32_t pick = Next(state) % 16;
+				voxels.coordinates[i * 4 + axis] = (uint16_t)(pick == 0 ? 0 : pick == 1 ? gridMax : Next(state) % (gridMax + 1));
+			}
+			voxels.coordinates[i * 4 + 3] = 0;
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				voxels.colours[i * 4 + channel] = (uint8_t)Next(state);
+			}
+		}
+		return voxels;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelCompactPackingToleranceTest, "Evercoast.Voxel.CompactPacking.Tolerance", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelCompactPackingToleranceTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelCompactPackingTest;
+
+	// Bounds of a typical capture, metres
+	const double boundsMin = -1.25;
+	const double boundsDim = 2.5;
+	const uint32_t voxelCount = 20000;
+
+	for (uint32_t bitsPerVoxel = 8; bitsPerVoxel <= 12; ++bitsPerVoxel)
+	{
+		const Voxels original = MakeVoxels(voxelCount, bitsPerVoxel, bitsPerVoxel);
+		std::vector<uint16_t> packed = original.coordinates;
+		VoxelCompactPacking::PackInPlace(packed.data(), original.colours.data(), voxelCount);
+
+		const double rescale = boundsDim / ((1 << bitsPerVoxel) - 1);
+		double maxPositionError = 0.0;
+		double maxGridError = 0.0;
+		int32 maxColourError[3] = { 0, 0, 0 };
+		for (uint32_t i = 0; i < voxelCount; ++i)
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				const double expected = boundsMin + original.coordinates[i * 4 + axis] * rescale;
+				const double rebuilt = boundsMin + HalfToDouble(packed[i * 4 + axis]) * rescale;
+				maxPositionError = std::max(maxPositionError, std::abs(rebuilt - expected));
+				maxGridError = std::max(maxGridError, std::abs(HalfToDouble(packed[i * 4 + axis]) - original.coordinates[i * 4 + axis]));
+			}
+
+			uint8_t colour[4];
+			VoxelCompactPacking::UnpackColour(packed[i * 4 + 3], colour);
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				maxColourError[channel] = std::max(maxColourError[channel], std::abs((int32)colour[channel] - (int32)original.colours[i * 4 + channel]));
+			}
+		}
+
+		// Halves have 11 significant bits: every coordinate below 2048 is exact, above it one grid step at most
+		const double gridTolerance = bitsPerVoxel <= 11 ? 0.0 : 1.0;
+		AddInfo(FString::Printf(TEXT("%u bits per voxel: position error %.3g mm (grid step %.3g mm), colour error Y %d Cb %d Cr %d"),
+			bitsPerVoxel, maxPositionError * 1000.0, rescale * 1000.0, maxColourError[0], maxColourError[1], maxColourError[2]));
+		TestTrue(*FString::Printf(TEXT("%u bits: positions within tolerance"), bitsPerVoxel), maxGridError <= gridTolerance);
+		// Half of a 6 bit and a 5 bit step, in 8 bit units
+		TestTrue(*FString::Printf(TEXT("%u bits: luma within tolerance"), bitsPerVoxel), maxColourError[0] <= 2);
+		TestTrue(*FString::Printf(TEXT("%u bits: chroma within tolerance"), bitsPerVoxel), maxColourError[1] <= 4 && maxColourError[2] <= 4);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelCompactPackingHalfTest, "Evercoast.Voxel.CompactPacking.Half", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelCompactPackingHalfTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelCompactPackingTest;
+
+	// Every coordinate: the nearest half, ties to even, and back to the nearest integer
+	int32 wrongHalves = 0;
+	int32 wrongCoordinates = 0;
+	for (uint32_t coordinate = 0; coordinate <= VoxelCompactPacking::MAX_COORDINATE; ++coordinate)
+	{
+		const uint16_t half = VoxelCompactPacking::CoordinateToHalf((uint16_t)coordinate);
+		const double value = HalfToDouble(half);
+		const double below = half > 0 ? HalfToDouble(half - 1) : -1.0;
+		const double above = half < 0x7bff ? HalfToDouble(half + 1) : 1e9;
+		const double error = std::abs(value - coordinate);
+		const bool nearest = error <= coordinate - below && error <= above - coordinate;
+		const bool tieToEven = (error != coordinate - below && error != above - coordinate) || (half & 1) == 0 || error == 0.0;
+		if (!nearest || !tieToEven)
+		{
+			if (wrongHalves++ < 5)
+				AddError(FString::Printf(TEXT("%u packed to %g"), coordinate, value));
+		}
+		if (VoxelCompactPacking::HalfToCoordinate(half) != (uint16_t)value)
+		{
+			++wrongCoordinates;
+		}
+	}
+	TestEqual(TEXT("Nearest half, ties to even"), wrongHalves, 0);
+	TestEqual(TEXT("Halves back to coordinates"), wrongCoordinates, 0);
+
+	TestEqual(TEXT("Zero"), (int32)VoxelCompactPacking::CoordinateToHalf(0), 0);
+	TestEqual(TEXT("2047 exact"), HalfToDouble(VoxelCompactPacking::CoordinateToHalf(2047)), 2047.0);
+	TestEqual(TEXT("2049 ties to even"), HalfToDouble(VoxelCompactPacking::CoordinateToHalf(2049)), 2048.0);
+	TestEqual(TEXT("2051 ties to even"), HalfToDouble(VoxelCompactPacking::CoordinateToHalf(2051)), 2052.0);
+	TestEqual(TEXT("Clamped, not infinity"), HalfToDouble(VoxelCompactPacking::CoordinateToHalf(65535)), 65504.0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelCompactPackingUnpackTest, "Evercoast.Voxel.CompactPacking.Unpack", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelCompactPackingUnpackTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelCompactPackingTest;
+
+	// Expanded back for the instanced cube path, which reads the decoder layout
+	const uint32_t voxelCount = 4099;
+	const Voxels original = MakeVoxels(voxelCount, 11, 7);
+	std::vector<uint16_t> packed = original.coordinates;
+	VoxelCompactPacking::PackInPlace(packed.data(), original.colours.data(), voxelCount);
+
+	std::vector<uint16_t> coordinates(voxelCount * 4, 0xcdcd);
+	std::vector<uint8_t> colours(voxelCount * 4, 0xcd);
+	VoxelCompactPacking::Unpack(packed.data(), coordinates.data(), colours.data(), voxelCount);
+
+	int32 wrongCoordinates = 0;
+	int32 maxColourError = 0;
+	int32 wrongAlpha = 0;
+	for (uint32_t i = 0; i < voxelCount; ++i)
+	{
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			wrongCoordinates += coordinates[i * 4 + axis] != original.coordinates[i * 4 + axis] ? 1 : 0;
+		}
+		wrongCoordinates += coordinates[i * 4 + 3] != 0 ? 1 : 0;
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			maxColourError = std::max(maxColourError, std::abs((int32)colours[i * 4 + channel] - (int32)original.colours[i * 4 + channel]));
+		}
+		wrongAlpha += colours[i * 4 + 3] != 255 ? 1 : 0;
+	}
+	TestEqual(TEXT("11 bit coordinates come back exact"), wrongCoordinates, 0);
+	TestTrue(TEXT("Colours within tolerance"), maxColourError <= 4);
+	TestEqual(TEXT("Opaque"), wrongAlpha, 0);
+
+	// Cost of the pass added to the decode thread
+	const uint32_t benchmarkCount = 1 << 20;
+	Voxels large = MakeVoxels(benchmarkCount, 11, 9);
+	const double start = FPlatformTime::Seconds();
+	VoxelCompactPacking::PackInPlace(large.coordinates.data(), large.colours.data(), benchmarkCount);
+	const double elapsed = FPlatformTime::Seconds() - start;
+	AddInfo(FString::Printf(TEXT("Packed %u voxels in %.2f ms, %.2f ns per voxel"), benchmarkCount, elapsed * 1000.0, elapsed * 1e9 / benchmarkCount));
+	return true;
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VoxelLODPolicy.h"
+#include <cmath>
+#include <vector>
+
+// VoxelLODPolicy without a viewport: a 1m radius capture seen through a 90 degree fov on a 1920 pixel wide screen,
+// moved away from the camera. Its four LODs quarter the voxel count each step, so at one voxel per pixel LOD0 fits
+// up to about 2.7m, LOD1 up to 5.4m and LOD2 up to 10.8m.
+namespace VoxelLODPolicyTest
+{
+	static constexpr double RADIUS = 100.0;
+	static constexpr double VIEWPORT_WIDTH = 1920.0;
+	static const double FOV = 3.14159265358979323846 * 0.5;
+	static const std::vector<uint32_t> LOD_VOXEL_COUNTS = { 400000, 100000, 25000, 6000 };
+
+	static VoxelLODRequest MakeRequest(double distance, uint32_t currentLOD)
+	{
+		VoxelLODRequest request;
+		request.projectedRadiusInPixels = VoxelLODPolicy::ProjectedRadiusInPixels(RADIUS, distance, FOV, VIEWPORT_WIDTH);
+		request.lodVoxelCounts = LOD_VOXEL_COUNTS;
+		request.currentLOD = currentLOD;
+		return request;
+	}
+
+	static uint32_t PickAt(const VoxelLODPolicy& policy, double distance, uint32_t currentLOD)
+	{
+		std::vector<uint32_t> lods;
+		policy.Evaluate({ MakeRequest(distance, currentLOD) }, lods);
+		return lods[0];
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelLODDistanceTest, "Evercoast.Voxel.LODPolicy.Distance", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelLODDistanceTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelLODPolicyTest;
+	const VoxelLODPolicy policy;
+
+	TestEqual(TEXT("Projected radius at 10m"), VoxelLODPolicy::ProjectedRadiusInPixels(RADIUS, 1000.0, FOV, VIEWPORT_WIDTH), 96.0, 1e-6);
+	TestEqual(TEXT("Camera inside the bounds covers the screen"), VoxelLODPolicy::ProjectedRadiusInPixels(RADIUS, 50.0, FOV, VIEWPORT_WIDTH), VIEWPORT_WIDTH);
+	TestEqual(TEXT("No viewport, nothing projected"), VoxelLODPolicy::ProjectedRadiusInPixels(RADIUS, 1000.0, FOV, 0.0), 0.0);
+
+	struct Expectation
+	{
+		double distance;
+		uint32_t lod;
+	};
+	const Expectation expectations[] = { { 50, 0 }, { 150, 0 }, { 400, 1 }, { 800, 2 }, { 1500, 3 }, { 5000, 3 } };
+	for (const Expectation& expectation : expectations)
+	{
+		TestEqual(*FString::Printf(TEXT("LOD at %.0fcm"), expectation.distance), (int32)PickAt(policy, expectation.distance, 0), (int32)expectation.lod);
+	}
+
+	// Walking away never gets finer, LODs change around the expected distances
+	uint32_t previous = 0;
+	for (double distance = 10.0; distance <= 3000.0; distance += 10.0)
+	{
+		const uint32_t lod = PickAt(policy, distance, previous);
+		TestTrue(*FString::Printf(TEXT("Coarser or same at %.0fcm"), distance), lod >= previous);
+		if (lod != previous)
+		{
+			AddInfo(FString::Printf(TEXT("LOD%u -> LOD%u at %.0fcm"), previous, lod, distance));
+		}
+		previous = lod;
+	}
+
+	// Off screen gets the coarsest, unknown counts keep the current LOD
+	VoxelLODRequest offScreen = MakeRequest(150, 0);
+	offScreen.projectedRadiusInPixels = 0;
+	VoxelLODRequest unknown;
+	unknown.currentLOD = 2;
+	std::vector<uint32_t> lods;
+	policy.Evaluate({ offScreen, unknown }, lods);
+	TestEqual(TEXT("Off screen"), (int32)lods[0], 3);
+	TestEqual(TEXT("Unknown counts"), (int32)lods[1], 2);
+
+	// Fewer pixels per voxel asks for more detail
+	VoxelLODRequest detailed = MakeRequest(400, 1);
+	detailed.targetPixelsPerVoxel = 0.25;
+	policy.Evaluate({ detailed }, lods);
+	TestEqual(TEXT("Quarter pixel per voxel at 4m"), (int32)lods[0], 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelLODHysteresisTest, "Evercoast.Voxel.LODPolicy.Hysteresis", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelLODHysteresisTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelLODPolicyTest;
+	const VoxelLODPolicy policy;
+
+	// Just inside the LOD0 threshold: reached from LOD0 it stays, from LOD1 it needs the margin first
+	TestEqual(TEXT("Stays on LOD0 at 2.6m"), (int32)PickAt(policy, 260, 0), 0);
+	TestEqual(TEXT("Doesn't upgrade to LOD0 at 2.6m"), (int32)PickAt(policy, 260, 1), 1);
+	TestEqual(TEXT("Upgrades to LOD0 at 2m"), (int32)PickAt(policy, 200, 1), 0);
+	// Going coarser has no margin
+	TestEqual(TEXT("Downgrades right past the threshold"), (int32)PickAt(policy, 280, 0), 1);
+
+	// Jittering around the threshold switches once
+	uint32_t lod = 0;
+	int switches = 0;
+	for (int frame = 0; frame < 100; ++frame)
+	{
+		const uint32_t next = PickAt(policy, frame % 2 ? 265.0 : 275.0, lod);
+		switches += next != lod ? 1 : 0;
+		lod = next;
+	}
+	TestEqual(TEXT("Switches while jittering around 2.7m"), switches, 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastVoxelLODBudgetTest, "Evercoast.Voxel.LODPolicy.GlobalBudget", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastVoxelLODBudgetTest::RunTest(const FString& Parameters)
+{
+	using namespace VoxelLODPolicyTest;
+
+	const std::vector<VoxelLODRequest> requests = { MakeRequest(150, 0), MakeRequest(250, 0) };
+	std::vector<uint32_t> lods;
+
+	// Both on LOD0 within the default budget
+	VoxelLODPolicy policy;
+	policy.Evaluate(requests, lods);
+	TestTrue(TEXT("Default budget"), lods[0] == 0 && lods[1] == 0);
+
+	// The farther one spends more voxels per pixel and is coarsened first
+	VoxelLODConfig config;
+	config.globalVoxelBudget = 500000;
+	policy.SetConfig(config);
+	policy.Evaluate(requests, lods);
+	TestTrue(TEXT("Farther reader coarsened"), lods[0] == 0 && lods[1] == 1);
+
+	// Can't fit at all, everyone ends on the coarsest
+	config.globalVoxelBudget = 1000;
+	policy.SetConfig(config);
+	policy.Evaluate(requests, lods);
+	TestTrue(TEXT("Unreachable budget"), lods[0] == 3 && lods[1] == 3);
+
+	// Same inputs, same answer
+	std::vector<uint32_t> again;
+	config.globalVoxelBudget = 300000;
+	policy.SetConfig(config);
+	policy.Evaluate(requests, lods);
+	policy.Evaluate(requests, again);
+	TestTrue(TEXT("Deterministic"), lods == again);
+	uint64_t total = 0;
+	for (size_t i = 0; i < lods.size(); ++i)
+	{
+		total += LOD_VOXEL_COUNTS[lods[i]];
+	}
+	TestTrue(TEXT("Within the budget"), total <= config.globalVoxelBudget);
+	return true;
+}
+
+#endif
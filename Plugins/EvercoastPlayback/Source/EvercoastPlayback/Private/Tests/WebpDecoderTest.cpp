@@ -0,0 +1,285 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "WebpDecoder.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// WebpDecoder writing into the pitch-aligned buffer its receiving result keeps across frames. The frames are lossless
+// encodes of Texel() made with the desktop libwebp (the Android one is decoder only), so decoded texels can be checked
+// byte for byte.
+namespace WebpDecoderTest
+{
+	static uint8_t Texel(int x, int y, int channel, uint32_t seed)
+	{
+		switch (channel)
+		{
+		case 0: return (uint8_t)(x + seed * 11);
+		case 1: return (uint8_t)(y * 3);
+		case 2: return (uint8_t)(seed * 37 + y / 5);
+		default: return 255;
+		}
+	}
+
+	// Texel(x, y, channel, 1), 97x33
+	static const uint8_t WEBP_97X33_1[] =
+	{
+		0x52, 0x49, 0x46, 0x46, 0x58, 0x00, 0x00, 0x00, 0x57, 0x45, 0x42, 0x50, 0x56, 0x50, 0x38, 0x4c, 0x4b, 0x00, 0x00, 0x00, 0x2f, 0x60, 0x00, 0x08,
+		0x00, 0x4d, 0x00, 0x44, 0xd2, 0xfe, 0xe8, 0x0b, 0x44, 0xf4, 0x3f, 0xfd, 0x85, 0x42, 0xb6, 0x11, 0xa0, 0xf9, 0x93, 0x1e, 0xc9, 0x4b, 0x30, 0x0a,
+		0x03, 0xde, 0xff, 0x09, 0xd0, 0x60, 0xdf, 0xa0, 0x07, 0x85, 0x6d, 0xdb, 0x20, 0xdd, 0xf6, 0xff, 0xe7, 0x8c, 0x12, 0x08, 0xa4, 0xb0, 0x61, 0x16,
+		0x90, 0x24, 0xf9, 0x7f, 0x73, 0x10, 0x42, 0x82, 0x04, 0xab, 0x4b, 0x70, 0x40, 0x7d, 0x42, 0x09, 0x48, 0x3e, 0xc7, 0x45, 0xac, 0x1e, 0x00, 0x00,
+	};
+
+	// Texel(x, y, channel, 2), 97x33
+	static const uint8_t WEBP_97X33_2[] =
+	{
+		0x52, 0x49, 0x46, 0x46, 0x58, 0x00, 0x00, 0x00, 0x57, 0x45, 0x42, 0x50, 0x56, 0x50, 0x38, 0x4c, 0x4b, 0x00, 0x00, 0x00, 0x2f, 0x60, 0x00, 0x08,
+		0x00, 0x4d, 0x00, 0x44, 0xd2, 0xfe, 0xe8, 0x0b, 0x44, 0xf4, 0x3f, 0xfd, 0x85, 0x42, 0xb6, 0x11, 0xa0, 0xf9, 0x93, 0x1e, 0xc9, 0x4b, 0x30, 0x0a,
+		0x03, 0xde, 0xff, 0x09, 0xd0, 0x60, 0xdf, 0xa0, 0x07, 0x85, 0x6d, 0xdb, 0x20, 0xdd, 0xf6, 0xff, 0xe7, 0x8c, 0x12, 0x08, 0xa4, 0xb0, 0xf5, 0x16,
+		0x90, 0x24, 0xf8, 0x7f, 0x73, 0x14, 0x42, 0x82, 0x04, 0xab, 0x4b, 0xf0, 0x40, 0x7d, 0x42, 0x09, 0x48, 0x3e, 0xc7, 0x45, 0xa4, 0x1e, 0x00, 0x00,
+	};
+
+	// Texel(x, y, channel, 3), 31x17
+	static const uint8_t WEBP_31X17_3[] =
+	{
+		0x52, 0x49, 0x46, 0x46, 0x4c, 0x00, 0x00, 0x00, 0x57, 0x45, 0x42, 0x50, 0x56, 0x50, 0x38, 0x4c, 0x40, 0x00, 0x00, 0x00, 0x2f, 0x1e, 0x00, 0x04,
+		0x00, 0x09, 0x80, 0x20, 0x06, 0xfc, 0x27, 0x6b, 0x88, 0xe8, 0x7f, 0xea, 0x02, 0x20, 0x08, 0xff, 0xe1, 0x1a, 0x22, 0xfa, 0x9f, 0x0a, 0xb5, 0x6d,
+		0xdb, 0x30, 0x02, 0xfc, 0xff, 0xe1, 0x76, 0xea, 0x28, 0x24, 0x48, 0x21, 0x2e, 0x56, 0x20, 0x90, 0xc2, 0x46, 0x39, 0xc4, 0x26, 0x04, 0x9b, 0x5c,
+		0xc2, 0x23, 0x53, 0x01, 0xa6, 0xcd, 0x51, 0xdc, 0xfc, 0xd3, 0x05, 0x00,
+	};
+
+	// Texel(x, y, channel, 4), 200x50
+	static const uint8_t WEBP_200X50_4[] =
+	{
+		0x52, 0x49, 0x46, 0x46, 0x52, 0x00, 0x00, 0x00, 0x57, 0x45, 0x42, 0x50, 0x56, 0x50, 0x38, 0x4c, 0x46, 0x00, 0x00, 0x00, 0x2f, 0xc7, 0x40, 0x0c,
+		0x00, 0x4d, 0x00, 0x49, 0x82, 0xff, 0xbf, 0x9b, 0x23, 0xfa, 0x9f, 0xb6, 0x0b, 0x21, 0x01, 0xe1, 0xff, 0x52, 0x53, 0x24, 0x79, 0x10, 0x06, 0xbc,
+		0xff, 0x13, 0xe0, 0x90, 0x5f, 0x81, 0xc2, 0xb6, 0x6d, 0x90, 0xb6, 0xfb, 0xff, 0x76, 0x06, 0x21, 0x41, 0x82, 0xff, 0xab, 0x83, 0xf7, 0x28, 0x84,
+		0x04, 0x89, 0x56, 0x96, 0xe0, 0xc0, 0x8b, 0x8d, 0xf6, 0xc8, 0xf2, 0xfe, 0x93, 0x3e, 0x21, 0xef, 0x3f, 0x01,
+	};
+
+	// Texel(x, y, channel, 5), 1100x1000
+	static const uint8_t WEBP_1100X1000_5[] =
+	{
+		0x52, 0x49, 0x46, 0x46, 0x6a, 0x02, 0x00, 0x00, 0x57, 0x45, 0x42, 0x50, 0x56, 0x50, 0x38, 0x4c, 0x5e, 0x02, 0x00, 0x00, 0x2f, 0x4b, 0xc4, 0xf9,
+		0x00, 0xcd, 0x00, 0x49, 0x82, 0xff, 0xef, 0x1b, 0x22, 0xfa, 0x9f, 0x7a, 0xd9, 0x08, 0x09, 0x08, 0xff, 0x97, 0xda, 0x22, 0x0b, 0x83, 0x30, 0xe0,
+		0xfd, 0x9f, 0x00, 0x87, 0xe0, 0x3c, 0x80, 0x61, 0xdb, 0x36, 0x8e, 0xae, 0xec, 0x3f, 0xfb, 0x7d, 0x15, 0x05, 0x02, 0x49, 0xfb, 0x13, 0x6d, 0xb7,
+		0x49, 0xa1, 0xb6, 0x6d, 0x1b, 0x46, 0x29, 0x13, 0x2f, 0x19, 0x1f, 0x7c, 0x49, 0x66, 0x73, 0xbd, 0xe2, 0x7f, 0x3b, 0x59, 0xf2, 0x8c, 0x43, 0xf8,
+		0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f, 0x29, 0x7d, 0xc2, 0x7f, 0xc2, 0x7f,
+		0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x49, 0xe9, 0x13, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0x13,
+		0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0x4a, 0x9f, 0xf0, 0x9f, 0xf0, 0x9f, 0xf0, 0x9f, 0xf0, 0x3f, 0xfe,
+		0x13, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0x52, 0xfa, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff, 0xf1, 0x9f, 0xf0, 0x9f,
+		0xf0, 0x9f, 0xf0, 0x3f, 0xfe, 0x13, 0xfe, 0x93, 0xd2, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x8f, 0xff, 0x84, 0xff, 0x84, 0xff, 0x84,
+		0xff, 0xf1, 0x9f, 0xf0, 0x9f, 0x94, 0x3e, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x7f, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x8f, 0xff,
+		0x84, 0xff, 0xa4, 0xf4, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x7f, 0xfc, 0x27, 0xfc, 0x27,
+		0xa5, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f, 0x29, 0x7d, 0xc2,
+		0x7f, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x49, 0xe9, 0x13, 0xfe, 0x13, 0xfe,
+		0x13, 0xfe, 0x13, 0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0x4a, 0x9f, 0xf0, 0x9f, 0xf0, 0x9f, 0xf0, 0x9f,
+		0xf0, 0x3f, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0x52, 0xfa, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff, 0xf1,
+		0x9f, 0xf0, 0x9f, 0xf0, 0x9f, 0xf0, 0x3f, 0xfe, 0x13, 0xfe, 0x93, 0xd2, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x8f, 0xff, 0x84, 0xff,
+		0x84, 0xff, 0x84, 0xff, 0xf1, 0x9f, 0xf0, 0x9f, 0x94, 0x3e, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x7f, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x27,
+		0xfc, 0x8f, 0xff, 0x84, 0xff, 0xa4, 0xf4, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x7f, 0xfc,
+		0x27, 0xfc, 0x27, 0xa5, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f,
+		0x29, 0x7d, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x49, 0xe9, 0x13,
+		0xfe, 0x13, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0xc2, 0x7f, 0xc2, 0xff, 0xf8, 0x4f, 0xf8, 0x4f, 0x4a, 0x9f, 0xf0, 0x9f, 0xf0,
+		0x9f, 0xf0, 0x9f, 0xf0, 0x3f, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0x13, 0xfe, 0xc7, 0x7f, 0xc2, 0x7f, 0x52, 0xfa, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff,
+		0x84, 0xff, 0xf1, 0x9f, 0xf0, 0x9f, 0xf0, 0x9f, 0xf0, 0x3f, 0xfe, 0x13, 0xfe, 0x93, 0xd2, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x27, 0xfc, 0x8f,
+		0xff, 0x84, 0xff, 0x84, 0xff, 0x84, 0xff, 0xf1, 0x9f, 0xf0, 0x9f, 0x94, 0x3e, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f, 0xe1, 0x7f, 0xfc, 0x27, 0xfc,
+		0x27, 0xfc, 0x27, 0xfc, 0x8f, 0xff, 0x84, 0xff, 0xa4, 0xf4, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0x09, 0xff, 0xe3, 0x3f, 0xe1, 0x3f, 0xe1, 0x3f,
+		0xe1, 0x7f, 0xfc, 0x27, 0xfc, 0x27, 0xa5, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x4f, 0xf8, 0x1f, 0xff, 0x09, 0xff, 0x09, 0xff, 0xc9, 0x71, 0xe3,
+		0x7f, 0x03,
+	};
+
+	struct Image
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<uint8_t> bgra;
+		std::vector<uint8_t> webp;
+	};
+
+	template<size_t N>
+	static Image MakeImage(int width, int height, uint32_t seed, const uint8_t (&webp)[N])
+	{
+		Image image;
+		image.width = width;
+		image.height = height;
+		image.bgra.resize((size_t)width * height * 4);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					image.bgra[((size_t)y * width + x) * 4 + channel] = Texel(x, y, channel, seed);
+				}
+			}
+		}
+		image.webp.assign(webp, webp + N);
+		return image;
+	}
+
+	static bool Decode(WebpDecoder& decoder, const std::shared_ptr<WebpDecodeResult>& result, const Image& image, int64_t frameIndex)
+	{
+		decoder.SetReceivingResult(result);
+		const bool success = decoder.DecodeMemoryStream(image.webp.data(), image.webp.size(), frameIndex / 30.0, frameIndex, nullptr);
+		decoder.UnsetReceivingResult();
+		return success;
+	}
+
+	// Every row of the result matches the source image, padding ignored
+	static bool SameTexels(const WebpDecodeResult& result, const Image& image)
+	{
+		if (result.Width != image.width || result.Height != image.height)
+			return false;
+
+		const size_t rowBytes = (size_t)image.width * 4;
+		for (int row = 0; row < image.height; ++row)
+		{
+			if (memcmp(result.RawTexelBuffer + (size_t)result.Pitch * row, image.bgra.data() + rowBytes * row, rowBytes) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	static bool IsAligned(const WebpDecodeResult& result)
+	{
+		return result.Pitch % WebpDecodeResult::PITCH_ALIGNMENT == 0 && result.Pitch >= result.Width * 4 &&
+			((uintptr_t)result.RawTexelBuffer % WebpDecodeResult::PITCH_ALIGNMENT) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastWebpDecoderReuseTest, "Evercoast.Decoder.Webp.ReuseBuffer", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastWebpDecoderReuseTest::RunTest(const FString& Parameters)
+{
+	using namespace WebpDecoderTest;
+
+	std::shared_ptr<WebpDecoder> decoder = WebpDecoder::Create();
+	std::shared_ptr<WebpDecodeResult> result = std::make_shared<WebpDecodeResult>(0, 0, 32);
+
+	// Odd width, so rows need padding to the pitch
+	const Image first = MakeImage(97, 33, 1, WEBP_97X33_1);
+	const Image second = MakeImage(97, 33, 2, WEBP_97X33_2);
+	TestTrue(TEXT("First frame decoded"), Decode(*decoder, result, first, 0));
+	TestTrue(TEXT("First frame texels"), SameTexels(*result, first));
+	TestTrue(TEXT("Pitch and rows aligned"), IsAligned(*result));
+	TestEqual(TEXT("Padded pitch"), result->Pitch, 448);
+	const uint8_t* buffer = result->RawTexelBuffer;
+	const size_t capacity = result->TexelCapacity;
+
+	// Same size frames land in the same buffer
+	for (int64_t frame = 1; frame < 30; ++frame)
+	{
+		const Image& next = frame % 2 ? second : first;
+		if (!Decode(*decoder, result, next, frame) || !SameTexels(*result, next))
+		{
+			AddError(FString::Printf(TEXT("Frame %lld decoded wrong"), (long long)frame));
+			break;
+		}
+	}
+	TestTrue(TEXT("Buffer kept across frames"), result->RawTexelBuffer == buffer && result->TexelCapacity == capacity);
+	TestEqual(TEXT("Frame index"), (int64)result->frameIndex, (int64)29);
+
+	// Smaller fits in what's there
+	const Image smaller = MakeImage(31, 17, 3, WEBP_31X17_3);
+	TestTrue(TEXT("Smaller frame decoded"), Decode(*decoder, result, smaller, 30));
+	TestTrue(TEXT("Smaller frame texels"), SameTexels(*result, smaller));
+	TestTrue(TEXT("Smaller frame reuses the buffer"), result->RawTexelBuffer == buffer && result->TexelCapacity == capacity);
+	TestEqual(TEXT("Smaller pitch"), result->Pitch, 128);
+
+	// Larger grows it once, and it stays grown
+	const Image larger = MakeImage(200, 50, 4, WEBP_200X50_4);
+	TestTrue(TEXT("Larger frame decoded"), Decode(*decoder, result, larger, 31));
+	TestTrue(TEXT("Larger frame texels"), SameTexels(*result, larger));
+	TestTrue(TEXT("Larger frame aligned"), IsAligned(*result));
+	TestTrue(TEXT("Grown to fit"), result->TexelCapacity >= (size_t)result->Pitch * larger.height);
+	const uint8_t* grown = result->RawTexelBuffer;
+	TestTrue(TEXT("Back to the first size"), Decode(*decoder, result, first, 32) && SameTexels(*result, first));
+	TestTrue(TEXT("Grown buffer kept"), result->RawTexelBuffer == grown);
+
+	// Above THREADED_DECODE_PIXEL_COUNT, with a padded pitch: libwebp's worker has to honour the stride too
+	const Image threaded = MakeImage(1100, 1000, 5, WEBP_1100X1000_5);
+	TestTrue(TEXT("Threaded path taken"), threaded.width * threaded.height >= WebpDecoder::THREADED_DECODE_PIXEL_COUNT);
+	TestTrue(TEXT("Threaded frame decoded"), Decode(*decoder, result, threaded, 33));
+	TestTrue(TEXT("Threaded frame texels"), SameTexels(*result, threaded));
+	TestTrue(TEXT("Threaded frame aligned"), IsAligned(*result) && result->Pitch != threaded.width * 4);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastWebpDecoderSharedCopyTest, "Evercoast.Decoder.Webp.SharedCopy", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastWebpDecoderSharedCopyTest::RunTest(const FString& Parameters)
+{
+	using namespace WebpDecoderTest;
+
+	std::shared_ptr<WebpDecoder> decoder = WebpDecoder::Create();
+	std::shared_ptr<WebpDecodeResult> result = std::make_shared<WebpDecodeResult>(0, 0, 32);
+
+	const Image first = MakeImage(97, 33, 1, WEBP_97X33_1);
+	const Image second = MakeImage(97, 33, 2, WEBP_97X33_2);
+	TestTrue(TEXT("First frame decoded"), Decode(*decoder, result, first, 0));
+
+	// A copy, like the realtime decoder's popped results, shares the texels instead of duplicating them
+	std::unique_ptr<WebpDecodeResult> copy = std::make_unique<WebpDecodeResult>(*result);
+	TestTrue(TEXT("Copy shares the texels"), copy->RawTexelBuffer == result->RawTexelBuffer && copy->TexelStorage == result->TexelStorage);
+	TestTrue(TEXT("Copy keeps the frame"), copy->frameIndex == 0 && copy->IsValid() && copy->Pitch == result->Pitch);
+
+	// Decoding the next frame moves the writer to a fresh buffer, the copy still sees the first frame
+	const uint8_t* shared = copy->RawTexelBuffer;
+	TestTrue(TEXT("Second frame decoded"), Decode(*decoder, result, second, 1));
+	TestTrue(TEXT("Writer moved off the shared buffer"), result->RawTexelBuffer != shared);
+	TestTrue(TEXT("Second frame texels"), SameTexels(*result, second));
+	TestTrue(TEXT("Copy untouched"), copy->RawTexelBuffer == shared && SameTexels(*copy, first));
+
+	// Once the copy is gone the writer's buffer is its own again and gets reused
+	copy.reset();
+	const uint8_t* own = result->RawTexelBuffer;
+	TestTrue(TEXT("Third frame decoded"), Decode(*decoder, result, first, 2));
+	TestTrue(TEXT("Unshared buffer reused"), result->RawTexelBuffer == own);
+	TestTrue(TEXT("Third frame texels"), SameTexels(*result, first));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastWebpDecoderFailureTest, "Evercoast.Decoder.Webp.Failure", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastWebpDecoderFailureTest::RunTest(const FString& Parameters)
+{
+	using namespace WebpDecoderTest;
+
+	std::shared_ptr<WebpDecoder> decoder = WebpDecoder::Create();
+	std::shared_ptr<WebpDecodeResult> result = std::make_shared<WebpDecodeResult>(0, 0, 32);
+
+	const Image image = MakeImage(97, 33, 1, WEBP_97X33_1);
+	TestTrue(TEXT("Good frame decoded"), Decode(*decoder, result, image, 0));
+
+	// Header intact, image data cut short: decoding starts and fails part way
+	Image truncated = image;
+	truncated.webp.resize(truncated.webp.size() / 2);
+	TestFalse(TEXT("Truncated frame fails"), Decode(*decoder, result, truncated, 1));
+	TestFalse(TEXT("Result marked failed"), result->IsValid());
+	TestEqual(TEXT("Failed frame index"), (int64)result->frameIndex, (int64)1);
+
+	// The result must come back unlocked on the failure path too
+	const bool unlocked = result->RWLock.try_lock();
+	TestTrue(TEXT("Unlocked after a failed decode"), unlocked);
+	if (unlocked)
+	{
+		result->RWLock.unlock();
+	}
+
+	// Not a WebP at all: rejected before the result is touched
+	const std::vector<uint8_t> garbage(256, 0x5a);
+	decoder->SetReceivingResult(result);
+	TestFalse(TEXT("Garbage rejected"), decoder->DecodeMemoryStream(garbage.data(), garbage.size(), 0.0, 2, nullptr));
+	decoder->UnsetReceivingResult();
+	TestEqual(TEXT("Result left alone"), (int64)result->frameIndex, (int64)1);
+
+	// And the next good frame decodes normally
+	TestTrue(TEXT("Recovers"), Decode(*decoder, result, image, 3) && SameTexels(*result, image));
+	return true;
+}
+
+#endif
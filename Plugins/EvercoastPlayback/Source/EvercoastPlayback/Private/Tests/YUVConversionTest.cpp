@@ -0,0 +1,154 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "YUVConversion.h"
+#include "HAL/PlatformTime.h"
+#include <cstring>
+#include <vector>
+
+// YUVConversion kernels against the scalar reference, which every SIMD variant has to match bit for bit, on frames
+// with pitches wider than the rows and sizes leaving tails after every vector width
+namespace YUVConversionTest
+{
+	struct Frame
+	{
+		std::vector<uint8_t> y;
+		std::vector<uint8_t> u;
+		std::vector<uint8_t> v;
+		YUVConversion::Planes planes;
+	};
+
+	static Frame MakeFrame(int width, int height, uint32_t pitchPadding, uint32_t seed)
+	{
+		Frame frame;
+		const uint32_t yPitch = width + pitchPadding;
+		const uint32_t chromaPitch = (width + 1) / 2 + pitchPadding;
+		const int chromaHeight = (height + 1) / 2;
+		frame.y.resize((size_t)yPitch * height);
+		frame.u.resize((size_t)chromaPitch * chromaHeight);
+		frame.v.resize((size_t)chromaPitch * chromaHeight);
+
+		uint32_t state = seed;
+		for (std::vector<uint8_t>* plane : { &frame.y, &frame.u, &frame.v })
+		{
+			for (uint8_t& b : *plane)
+			{
+				state = state * 1664525u + 1013904223u;
+				b = (uint8_t)(state >> 24);
+			}
+		}
+		frame.planes = { frame.y.data(), frame.u.data(), frame.v.data(), yPitch, chromaPitch, chromaPitch };
+		return frame;
+	}
+
+	static const TCHAR* MatrixName(YUVConversion::Matrix matrix)
+	{
+		return matrix == YUVConversion::Matrix::BT709 ? TEXT("BT.709") : TEXT("BT.601");
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastYUVConversionBitExactTest, "Evercoast.Video.YUVConversion.BitExact", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastYUVConversionBitExactTest::RunTest(const FString& Parameters)
+{
+	using namespace YUVConversionTest;
+
+	AddInfo(FString::Printf(TEXT("Kernels: %s"), YUVConversion::GetKernelName()));
+
+	const int widths[] = { 1, 2, 7, 8, 15, 16, 17, 33, 640, 1921 };
+	const int heights[] = { 1, 2, 3, 31, 65 };
+	const YUVConversion::Matrix matrices[] = { YUVConversion::Matrix::BT601, YUVConversion::Matrix::BT709 };
+	for (int width : widths)
+	{
+		for (int height : heights)
+		{
+			const Frame frame = MakeFrame(width, height, 5, width * 131 + height);
+			// Poisoned beyond the last row to catch overruns
+			const size_t outSize = (size_t)width * 4 * height + 8;
+			for (YUVConversion::Matrix matrix : matrices)
+			{
+				for (bool fullRange : { false, true })
+				{
+					std::vector<uint8_t> reference(outSize, 0xcd);
+					YUVConversion::ConvertToBGRAScalar(frame.planes, width, height, matrix, fullRange, reference.data(), width * 4);
+					for (bool parallelRows : { false, true })
+					{
+						std::vector<uint8_t> converted(outSize, 0xcd);
+						YUVConversion::ConvertToBGRA(frame.planes, width, height, matrix, fullRange, converted.data(), width * 4, parallelRows);
+						TestTrue(*FString::Printf(TEXT("%dx%d %s %s range%s"), width, height, MatrixName(matrix), fullRange ? TEXT("full") : TEXT("limited"),
+							parallelRows ? TEXT(", parallel rows") : TEXT("")), converted == reference);
+					}
+				}
+			}
+		}
+	}
+
+	// Reference points of limited range BT.601: white, black and red
+	const uint8_t y[2] = { 235, 16 };
+	const uint8_t u[1] = { 128 };
+	const uint8_t v[1] = { 128 };
+	uint8_t bgra[8];
+	YUVConversion::ConvertToBGRA({ y, u, v, 2, 1, 1 }, 2, 1, YUVConversion::Matrix::BT601, false, bgra, 8);
+	TestTrue(TEXT("Limited range white"), bgra[0] == 255 && bgra[1] == 255 && bgra[2] == 255 && bgra[3] == 255);
+	TestTrue(TEXT("Limited range black"), bgra[4] == 0 && bgra[5] == 0 && bgra[6] == 0 && bgra[7] == 255);
+
+	const uint8_t redY[2] = { 81, 81 };
+	const uint8_t redU[1] = { 90 };
+	const uint8_t redV[1] = { 240 };
+	YUVConversion::ConvertToBGRA({ redY, redU, redV, 2, 1, 1 }, 2, 1, YUVConversion::Matrix::BT601, false, bgra, 8);
+	TestTrue(*FString::Printf(TEXT("Limited range red, got B%d G%d R%d"), bgra[0], bgra[1], bgra[2]), bgra[0] <= 2 && bgra[1] <= 2 && bgra[2] >= 253);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastYUVConversionBenchmark, "Evercoast.Video.YUVConversion.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastYUVConversionBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace YUVConversionTest;
+
+	AddInfo(FString::Printf(TEXT("Kernels: %s"), YUVConversion::GetKernelName()));
+
+	struct Resolution
+	{
+		int width;
+		int height;
+	};
+	const Resolution resolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+	const int iterations = 20;
+	for (const Resolution& resolution : resolutions)
+	{
+		const int width = resolution.width;
+		const int height = resolution.height;
+		const Frame frame = MakeFrame(width, height, 0, width);
+		std::vector<uint8_t> bgra((size_t)width * 4 * height);
+
+		double start = FPlatformTime::Seconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			YUVConversion::ConvertToBGRAScalar(frame.planes, width, height, YUVConversion::Matrix::BT709, false, bgra.data(), width * 4);
+		}
+		const double scalarMs = (FPlatformTime::Seconds() - start) * 1000.0 / iterations;
+
+		start = FPlatformTime::Seconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			YUVConversion::ConvertToBGRA(frame.planes, width, height, YUVConversion::Matrix::BT709, false, bgra.data(), width * 4, false);
+		}
+		const double simdMs = (FPlatformTime::Seconds() - start) * 1000.0 / iterations;
+
+		start = FPlatformTime::Seconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			YUVConversion::ConvertToBGRA(frame.planes, width, height, YUVConversion::Matrix::BT709, false, bgra.data(), width * 4, true);
+		}
+		const double parallelMs = (FPlatformTime::Seconds() - start) * 1000.0 / iterations;
+
+		AddInfo(FString::Printf(TEXT("%dx%d: scalar %.2f ms, %s %.2f ms, %s parallel rows %.2f ms"), width, height, scalarMs,
+			YUVConversion::GetKernelName(), simdMs, YUVConversion::GetKernelName(), parallelMs));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,225 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Gaussian/ZstdWindowReader.h"
+#include "AlignedBlockPool.h"
+#include "HAL/PlatformTime.h"
+#include "zstd.h"
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// ZstdWindowReader against one-shot ZSTD_decompress, on synthetic frames laid out like ECSPZ: a header followed by
+// per point sections of 9(position), 1(alpha), 3(colour), 3(scale), 3(rotation) and 45(SH degree 3) bytes
+namespace ZstdWindowReaderTest
+{
+	static constexpr uint32_t HEADER_SIZE = 16;
+	static const uint32_t SECTION_ELEMENT_SIZES[] = { 9, 1, 3, 3, 3, 45 };
+	static constexpr uint32_t POINT_SIZE = 9 + 1 + 3 + 3 + 3 + 45;
+
+	// Smoothly varying attributes with some noise, compresses roughly like captured splats
+	static std::vector<uint8_t> MakeFrame(uint32_t pointCount, uint32_t seed)
+	{
+		std::vector<uint8_t> frame(HEADER_SIZE + (size_t)pointCount * POINT_SIZE);
+		uint32_t state = seed;
+		FMemory::Memcpy(frame.data(), &pointCount, sizeof(pointCount));
+		FMemory::Memcpy(frame.data() + 4, &seed, sizeof(seed));
+		for (size_t i = 8; i < frame.size(); ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			const uint8_t noise = (uint8_t)(state >> 28);
+			frame[i] = (uint8_t)((i / 7) + (i % 5) * 17) ^ noise;
+		}
+		return frame;
+	}
+
+	static std::vector<uint8_t> Compress(const std::vector<uint8_t>& frame)
+	{
+		std::vector<uint8_t> compressed(ZSTD_compressBound(frame.size()));
+		const size_t size = ZSTD_compress(compressed.data(), compressed.size(), frame.data(), frame.size(), 3);
+		compressed.resize(ZSTD_isError(size) ? 0 : size);
+		return compressed;
+	}
+
+	// Header, then every section through ForEachRun into output, which has the frame's layout
+	static bool ReadWindowed(ZstdWindowReader& reader, const std::vector<uint8_t>& compressed, uint32_t pointCount, uint8_t* output)
+	{
+		if (!reader.Begin(compressed.data(), compressed.size()) || !reader.Read(output, HEADER_SIZE))
+			return false;
+
+		uint8_t* sectionStart = output + HEADER_SIZE;
+		for (uint32_t elementSize : SECTION_ELEMENT_SIZES)
+		{
+			const bool read = reader.ForEachRun(elementSize, pointCount, [sectionStart, elementSize](const uint8_t* data, uint32_t firstElement, uint32_t count)
+				{
+					FMemory::Memcpy(sectionStart + (size_t)firstElement * elementSize, data, (size_t)count * elementSize);
+				});
+			if (!read)
+				return false;
+			sectionStart += (size_t)pointCount * elementSize;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastZstdWindowReaderTest, "Evercoast.Gaussian.ZstdWindowReader.Output", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastZstdWindowReaderTest::RunTest(const FString& Parameters)
+{
+	using namespace ZstdWindowReaderTest;
+
+	// Windows smaller than a section, not a multiple of any element size, and the default
+	const size_t windowSizes[] = { 4096, 100000, ZstdWindowReader::DEFAULT_WINDOW_SIZE };
+	const uint32_t pointCounts[] = { 1, 1000, 100003 };
+	for (size_t windowSize : windowSizes)
+	{
+		// One reader across all frames, its context has to come back clean every time
+		ZstdWindowReader reader(windowSize);
+		for (uint32_t pointCount : pointCounts)
+		{
+			const std::vector<uint8_t> frame = MakeFrame(pointCount, pointCount);
+			const std::vector<uint8_t> compressed = Compress(frame);
+			if (!TestFalse(TEXT("Compressed"), compressed.empty()))
+				return false;
+
+			std::vector<uint8_t> oneShot(frame.size());
+			TestEqual(TEXT("One-shot size"), (int64)ZSTD_decompress(oneShot.data(), oneShot.size(), compressed.data(), compressed.size()), (int64)frame.size());
+
+			const FString context = FString::Printf(TEXT("%u points, %llu byte window"), pointCount, (unsigned long long)windowSize);
+			std::vector<uint8_t> windowed(frame.size(), 0xcd);
+			TestTrue(TEXT("Windowed read, ") + context, ReadWindowed(reader, compressed, pointCount, windowed.data()));
+			TestTrue(TEXT("Windowed matches one-shot, ") + context, windowed == oneShot && oneShot == frame);
+
+			uint8_t extra = 0;
+			TestFalse(TEXT("Reading past the frame fails, ") + context, reader.Read(&extra, 1));
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastZstdWindowReaderBadInputTest, "Evercoast.Gaussian.ZstdWindowReader.BadInput", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastZstdWindowReaderBadInputTest::RunTest(const FString& Parameters)
+{
+	using namespace ZstdWindowReaderTest;
+
+	const uint32_t pointCount = 50000;
+	const std::vector<uint8_t> frame = MakeFrame(pointCount, 7);
+	const std::vector<uint8_t> compressed = Compress(frame);
+	std::vector<uint8_t> output(frame.size());
+	ZstdWindowReader reader;
+
+	// Truncated anywhere, the reader fails instead of running past the input
+	const size_t cuts[] = { 0, 3, compressed.size() / 2, compressed.size() - 1 };
+	for (size_t cut : cuts)
+	{
+		const std::vector<uint8_t> truncated(compressed.begin(), compressed.begin() + cut);
+		TestFalse(*FString::Printf(TEXT("Truncated at %llu of %llu fails"), (unsigned long long)cut, (unsigned long long)compressed.size()),
+			ReadWindowed(reader, truncated, pointCount, output.data()));
+	}
+
+	// Not zstd at all
+	std::vector<uint8_t> garbage(4096);
+	for (size_t i = 0; i < garbage.size(); ++i)
+	{
+		garbage[i] = (uint8_t)(i * 31);
+	}
+	TestFalse(TEXT("Garbage fails"), ReadWindowed(reader, garbage, pointCount, output.data()));
+
+	// Element larger than the window can never be served
+	ZstdWindowReader tinyReader(8);
+	TestTrue(TEXT("Tiny window begins"), tinyReader.Begin(compressed.data(), compressed.size()));
+	TestFalse(TEXT("Element larger than the window fails"), tinyReader.ForEachRun(9, 1, [](const uint8_t*, uint32_t, uint32_t) {}));
+
+	// And the reader is still good for the next frame
+	TestTrue(TEXT("Good frame after bad ones"), ReadWindowed(reader, compressed, pointCount, output.data()) && output == frame);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastAlignedBlockPoolTest, "Evercoast.Gaussian.AlignedBlockPool", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastAlignedBlockPoolTest::RunTest(const FString& Parameters)
+{
+	std::shared_ptr<AlignedBlockPool> pool = AlignedBlockPool::Create(2);
+
+	std::function<void(uint8_t*)> releaseA, releaseB, releaseC;
+	uint8_t* a = pool->Acquire(3 * 1024 * 1024 + 1, releaseA);
+	uint8_t* b = pool->Acquire(1000, releaseB);
+	TestTrue(TEXT("Aligned"), ((uintptr_t)a % AlignedBlockPool::ALIGNMENT) == 0 && ((uintptr_t)b % AlignedBlockPool::ALIGNMENT) == 0);
+	FMemory::Memset(a, 0x11, 3 * 1024 * 1024 + 1);
+	FMemory::Memset(b, 0x22, 1000);
+
+	releaseA(a);
+	releaseB(b);
+	TestEqual(TEXT("Idle bytes rounded up to the granularity"), (int64)pool->GetIdleBytes(), (int64)(4 + 1) * AlignedBlockPool::GRANULARITY);
+
+	// Smallest idle block that fits
+	uint8_t* c = pool->Acquire(512 * 1024, releaseC);
+	TestTrue(TEXT("Small request reuses the small block"), c == b);
+	uint8_t* d = pool->Acquire(2 * 1024 * 1024, releaseB);
+	TestTrue(TEXT("Larger request reuses the large block"), d == a);
+	TestEqual(TEXT("Nothing idle"), (int64)pool->GetIdleBytes(), (int64)0);
+
+	// Blocks outliving the pool are freed by their releaser
+	pool.reset();
+	releaseC(c);
+	releaseB(d);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEvercoastZstdWindowReaderBenchmark, "Evercoast.Gaussian.ZstdWindowReader.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FEvercoastZstdWindowReaderBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace ZstdWindowReaderTest;
+
+	// Corpus of frames per size, played through like a sequence
+	const uint32_t pointCounts[] = { 100000, 500000, 1000000 };
+	const int frameCount = 8;
+	for (uint32_t pointCount : pointCounts)
+	{
+		std::vector<std::vector<uint8_t>> corpus;
+		for (int i = 0; i < frameCount; ++i)
+		{
+			corpus.push_back(Compress(MakeFrame(pointCount, pointCount + i)));
+		}
+		const size_t frameSize = HEADER_SIZE + (size_t)pointCount * POINT_SIZE;
+
+		// What the decoder did before: a fresh buffer per frame, decompressed whole, then copied into the upload block
+		std::vector<uint8_t> upload(frameSize);
+		double start = FPlatformTime::Seconds();
+		for (const std::vector<uint8_t>& compressed : corpus)
+		{
+			uint8_t* decompressed = new uint8_t[frameSize];
+			ZSTD_decompress(decompressed, frameSize, compressed.data(), compressed.size());
+			FMemory::Memcpy(upload.data(), decompressed, frameSize);
+			delete[] decompressed;
+		}
+		const double oneShotSeconds = FPlatformTime::Seconds() - start;
+
+		// Windowed into pooled blocks, one reader for the whole sequence
+		std::shared_ptr<AlignedBlockPool> pool = AlignedBlockPool::Create(2);
+		ZstdWindowReader reader;
+		bool succeeded = true;
+		start = FPlatformTime::Seconds();
+		for (const std::vector<uint8_t>& compressed : corpus)
+		{
+			std::function<void(uint8_t*)> release;
+			uint8_t* block = pool->Acquire((uint32_t)frameSize, release);
+			succeeded &= ReadWindowed(reader, compressed, pointCount, block);
+			release(block);
+		}
+		const double windowedSeconds = FPlatformTime::Seconds() - start;
+		TestTrue(TEXT("Windowed reads succeeded"), succeeded);
+
+		const double megabytes = (double)frameSize * frameCount / (1024.0 * 1024.0);
+		AddInfo(FString::Printf(TEXT("%u points(%.1f MB/frame): one-shot+copy %.0f MB/s, windowed into pool %.0f MB/s"),
+			pointCount, megabytes / frameCount, megabytes / oneShotSeconds, megabytes / windowedSeconds));
+	}
+	return true;
+}
+
+#endif
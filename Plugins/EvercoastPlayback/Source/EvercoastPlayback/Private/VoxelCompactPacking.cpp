@@ -0,0 +1,74 @@
+#include "VoxelCompactPacking.h"
+#include <cstring>
+
+namespace VoxelCompactPacking
+{
+
+uint16_t CoordinateToHalf(uint16_t coordinate)
+{
+	const uint32_t value = coordinate < MAX_COORDINATE ? coordinate : MAX_COORDINATE;
+	if (value == 0)
+		return 0;
+
+	// Exact as a float, then drop 13 mantissa bits rounding to nearest even. 11 significant bits are left, exact
+	// below 2048; a carry out of the mantissa moves into the exponent, which is what rounding up should do.
+	const float asFloat = (float)value;
+	uint32_t bits;
+	memcpy(&bits, &asFloat, sizeof(bits));
+	bits += 0xfff + ((bits >> 13) & 1);
+	return (uint16_t)((((bits >> 23) - 112) << 10) | ((bits >> 13) & 0x3ff));
+}
+
+uint16_t HalfToCoordinate(uint16_t half)
+{
+	const uint32_t exponent = (half >> 10) & 0x1f;
+	if (exponent < 15)
+		return 0;
+
+	// Whole numbers only, anything below 1 is the zero CoordinateToHalf() never rounds to
+	const uint32_t significand = 1024 | (half & 0x3ff);
+	return (uint16_t)((significand << (exponent - 15)) >> 10);
+}
+
+uint16_t PackColour(const uint8_t* yCbCrA)
+{
+	const uint32_t y = (yCbCrA[0] * 63u + 127u) / 255u;
+	const uint32_t cb = (yCbCrA[1] * 31u + 127u) / 255u;
+	const uint32_t cr = (yCbCrA[2] * 31u + 127u) / 255u;
+	return (uint16_t)((y << 10) | (cb << 5) | cr);
+}
+
+void UnpackColour(uint16_t packed, uint8_t* outYCbCrA)
+{
+	outYCbCrA[0] = (uint8_t)(((packed >> 10) * 255u + 31u) / 63u);
+	outYCbCrA[1] = (uint8_t)((((packed >> 5) & 31u) * 255u + 15u) / 31u);
+	outYCbCrA[2] = (uint8_t)(((packed & 31u) * 255u + 15u) / 31u);
+	outYCbCrA[3] = 255;
+}
+
+void PackInPlace(uint16_t* coordinates, const uint8_t* colours, uint32_t voxelCount)
+{
+	for (uint32_t i = 0; i < voxelCount; ++i)
+	{
+		uint16_t* element = coordinates + i * 4;
+		element[0] = CoordinateToHalf(element[0]);
+		element[1] = CoordinateToHalf(element[1]);
+		element[2] = CoordinateToHalf(element[2]);
+		element[3] = PackColour(colours + i * 4);
+	}
+}
+
+void Unpack(const uint16_t* packed, uint16_t* outCoordinates, uint8_t* outColours, uint32_t voxelCount)
+{
+	for (uint32_t i = 0; i < voxelCount; ++i)
+	{
+		const uint16_t* element = packed + i * 4;
+		outCoordinates[i * 4 + 0] = HalfToCoordinate(element[0]);
+		outCoordinates[i * 4 + 1] = HalfToCoordinate(element[1]);
+		outCoordinates[i * 4 + 2] = HalfToCoordinate(element[2]);
+		outCoordinates[i * 4 + 3] = 0;
+		UnpackColour(element[3], outColours + i * 4);
+	}
+}
+
+}
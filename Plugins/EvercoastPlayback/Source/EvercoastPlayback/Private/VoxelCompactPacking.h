@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Compact voxel layout: one 8 byte element per voxel instead of the decoder's 8 byte coordinate plus 4 byte colour.
+// X, Y and Z grid coordinates are stored as half floats, exact up to 2048 and within one grid step up to 4096, and
+// the YCbCr colour is folded into the W slot as 6:5:5 bits. Packed in place over the decoder's coordinates, so the
+// colour stream no longer needs uploading; the voxel vertex factory reads the element as is.
+namespace VoxelCompactPacking
+{
+	constexpr uint32_t ELEMENT_SIZE = 8;
+
+	// Largest grid coordinate a half float holds, bigger ones are clamped to it
+	constexpr uint16_t MAX_COORDINATE = 65504;
+
+	// Half float bits of an integer grid coordinate, rounded to nearest even
+	uint16_t CoordinateToHalf(uint16_t coordinate);
+	// Nearest integer grid coordinate of half float bits produced by CoordinateToHalf()
+	uint16_t HalfToCoordinate(uint16_t half);
+
+	// YCbCr(A) bytes as the decoder outputs them in gfx compatibility mode, alpha is dropped
+	uint16_t PackColour(const uint8_t* yCbCrA);
+	// Back to bytes, alpha 255
+	void UnpackColour(uint16_t packed, uint8_t* outYCbCrA);
+
+	// XYZW uint16 coordinates turned into compact elements where they are, reading the colours alongside
+	void PackInPlace(uint16_t* coordinates, const uint8_t* colours, uint32_t voxelCount);
+
+	// Back to the decoder layout, for consumers that can't read compact elements. Outputs may not alias the input.
+	void Unpack(const uint16_t* packed, uint16_t* outCoordinates, uint8_t* outColours, uint32_t voxelCount);
+}
@@ -43,7 +43,7 @@ void VoxelDataUploader::Upload(const GenericDecodeResult* pVoxelResult)
 	{
 		if (!m_localVoxelFrame || !m_localVoxelFrame->ContainsVoxelFrame(pResult->resultFrame))
 		{
-			m_localVoxelFrame = std::make_shared<EvercoastLocalVoxelFrame>(pResult->resultFrame, true); // copy voxels
+			m_localVoxelFrame = std::make_shared<EvercoastLocalVoxelFrame>(pResult->resultFrameOwner);
 			ForceUpload();
 
 			m_lastUploadedFrameIndex = pResult->frameIndex;
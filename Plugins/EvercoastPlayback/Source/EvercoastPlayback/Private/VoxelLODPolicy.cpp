@@ -0,0 +1,90 @@
+#include "VoxelLODPolicy.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr double PI_DOUBLE = 3.14159265358979323846;
+
+VoxelLODPolicy::VoxelLODPolicy(const VoxelLODConfig& config) :
+	m_config(config)
+{
+}
+
+static double ProjectedArea(const VoxelLODRequest& request)
+{
+	return request.projectedRadiusInPixels > 0 ? PI_DOUBLE * request.projectedRadiusInPixels * request.projectedRadiusInPixels : 0;
+}
+
+uint32_t VoxelLODPolicy::PickLOD(const VoxelLODRequest& request) const
+{
+	const uint32_t lodCount = (uint32_t)request.lodVoxelCounts.size();
+	const double allowance = ProjectedArea(request) / std::max(request.targetPixelsPerVoxel, 1e-6);
+
+	for (uint32_t lod = 0; lod < lodCount; ++lod)
+	{
+		const double limit = lod < request.currentLOD ? allowance * m_config.upgradeMargin : allowance;
+		if (request.lodVoxelCounts[lod] <= limit)
+			return lod;
+	}
+
+	return lodCount - 1;
+}
+
+void VoxelLODPolicy::Evaluate(const std::vector<VoxelLODRequest>& requests, std::vector<uint32_t>& outLODs) const
+{
+	outLODs.resize(requests.size());
+
+	uint64_t totalVoxels = 0;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		if (requests[i].lodVoxelCounts.empty())
+		{
+			outLODs[i] = requests[i].currentLOD;
+			continue;
+		}
+
+		outLODs[i] = PickLOD(requests[i]);
+		totalVoxels += requests[i].lodVoxelCounts[outLODs[i]];
+	}
+
+	while (totalVoxels > m_config.globalVoxelBudget)
+	{
+		// Coarsen whoever gets the least out of its voxels
+		int64_t worstIdx = -1;
+		double worstDensity = -1;
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			const auto& counts = requests[i].lodVoxelCounts;
+			if (counts.empty() || outLODs[i] + 1 >= counts.size())
+				continue;
+
+			const double density = counts[outLODs[i]] / std::max(ProjectedArea(requests[i]), 1.0);
+			if (density > worstDensity)
+			{
+				worstDensity = density;
+				worstIdx = (int64_t)i;
+			}
+		}
+
+		// Everyone is at the coarsest already
+		if (worstIdx < 0)
+			break;
+
+		const auto& counts = requests[worstIdx].lodVoxelCounts;
+		totalVoxels -= counts[outLODs[worstIdx]];
+		outLODs[worstIdx]++;
+		totalVoxels += counts[outLODs[worstIdx]];
+	}
+}
+
+double VoxelLODPolicy::ProjectedRadiusInPixels(double radius, double distance, double fovInRadians, double viewportSizeInPixels)
+{
+	if (radius <= 0 || fovInRadians <= 0 || viewportSizeInPixels <= 0)
+		return 0;
+
+	// Camera inside the bounds, it can cover the whole screen
+	if (distance <= radius)
+		return viewportSizeInPixels;
+
+	const double halfExtent = std::tan(fovInRadians * 0.5) * distance;
+	return std::min(radius / halfExtent * viewportSizeInPixels * 0.5, (double)viewportSizeInPixels);
+}
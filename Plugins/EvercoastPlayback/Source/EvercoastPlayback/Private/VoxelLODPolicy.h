@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct VoxelLODConfig
+{
+	// Total voxels per frame of all readers together
+	uint64_t globalVoxelBudget = 16 * 1024 * 1024;
+	// Switching to a finer LOD requires its voxel count to fit in this portion of the reader's allowance
+	double upgradeMargin = 0.75;
+};
+
+struct VoxelLODRequest
+{
+	// Radius of the projected bounds, 0 when off screen
+	double projectedRadiusInPixels = 0;
+	// Screen pixels one decoded voxel is expected to cover, lower is more detailed
+	double targetPixelsPerVoxel = 1.0;
+	// Voxel count of each LOD of the latest decoded frame, LOD0 being the most detailed. Empty if not known yet.
+	std::vector<uint32_t> lodVoxelCounts;
+	uint32_t currentLOD = 0;
+};
+
+// Picks the LOD each voxel reader decodes at. A reader is allowed about one voxel per targetPixelsPerVoxel pixels of
+// its projected bounds and gets the most detailed LOD fitting in that, off screen readers get the coarsest. If all
+// together exceed the global budget, the reader spending the most voxels per pixel is coarsened a step at a time till
+// they fit. Going finer needs a margin(upgradeMargin) which going coarser doesn't, so a reader sitting right at a
+// threshold doesn't flip every frame. Deterministic given the same inputs. Not thread safe.
+class VoxelLODPolicy
+{
+public:
+	explicit VoxelLODPolicy(const VoxelLODConfig& config = VoxelLODConfig());
+
+	void SetConfig(const VoxelLODConfig& config)
+	{
+		m_config = config;
+	}
+
+	const VoxelLODConfig& GetConfig() const
+	{
+		return m_config;
+	}
+
+	// outLODs receives the chosen LOD of each request in the same order. Requests without voxel counts keep their
+	// current LOD and don't count towards the budget.
+	void Evaluate(const std::vector<VoxelLODRequest>& requests, std::vector<uint32_t>& outLODs) const;
+
+	// Radius in pixels of a sphere seen from distance, fov and viewport size taken along the same screen axis
+	static double ProjectedRadiusInPixels(double radius, double distance, double fovInRadians, double viewportSizeInPixels);
+
+private:
+	// Most detailed LOD fitting in the reader's own allowance
+	uint32_t PickLOD(const VoxelLODRequest& request) const;
+
+	VoxelLODConfig m_config;
+};
@@ -4,33 +4,26 @@
 WebpDecodeResult::WebpDecodeResult(int width, int height, uint8_t bpp) :
 	GenericDecodeResult(false, 0, 0),
 	Width(width), Height(height), BitPerPixel(bpp),
-	RawTexelBuffer(nullptr)
+	Pitch(0),
+	RawTexelBuffer(nullptr),
+	TexelCapacity(0)
 {
 }
 
 WebpDecodeResult::WebpDecodeResult(const WebpDecodeResult& rhs) :
 	GenericDecodeResult(rhs.DecodeSuccessful, rhs.frameTimestamp, rhs.frameIndex),
 	Width(rhs.Width), Height(rhs.Height), BitPerPixel(rhs.BitPerPixel),
-	RawTexelBuffer(nullptr)
+	Pitch(rhs.Pitch),
+	RawTexelBuffer(rhs.RawTexelBuffer),
+	TexelStorage(rhs.TexelStorage),
+	TexelCapacity(rhs.TexelCapacity)
 {
-	if (DecodeSuccessful)
-	{
-		size_t size = Width * Height * BitPerPixel / 8;
-		if (size > 0)
-		{
-			RawTexelBuffer = (uint8*)WebPMalloc(size);
-			FMemory::Memcpy(RawTexelBuffer, rhs.RawTexelBuffer, size);
-		}
-	}
 }
 
 WebpDecodeResult::~WebpDecodeResult()
 {
-	if (RawTexelBuffer)
-	{
-		WebPFree(RawTexelBuffer);
-		RawTexelBuffer = nullptr;
-	}
+	RawTexelBuffer = nullptr;
+	TexelStorage.reset();
 }
 
 void WebpDecodeResult::Lock() const
@@ -43,32 +36,36 @@ void WebpDecodeResult::Unlock() const
 	RWLock.unlock();
 }
 
-bool WebpDecodeResult::ApplyResult(bool success, double timestamp, int64_t frame_index, int width, int height, uint8_t bpp, uint8_t* data)
+uint8_t* WebpDecodeResult::PrepareTexels(int width, int height, uint8_t bpp)
 {
-	this->DecodeSuccessful = success;
-	this->frameTimestamp = timestamp;
-	this->frameIndex = frame_index;
+	const int rowBytes = width * bpp / 8;
+	const int pitch = (rowBytes + PITCH_ALIGNMENT - 1) / PITCH_ALIGNMENT * PITCH_ALIGNMENT;
+	const size_t size = (size_t)pitch * height;
 
-	if (DecodeSuccessful && data)
+	// A copy still looking at the previous frame keeps that buffer to itself
+	if (!TexelStorage || TexelStorage.use_count() > 1 || TexelCapacity < size)
 	{
-		this->Width = width;
-		this->Height = height;
-		this->BitPerPixel = bpp;
-
-		if (RawTexelBuffer)
-		{
-			WebPFree(RawTexelBuffer);
-			RawTexelBuffer = nullptr;
-		}
-
-		// ownership transferred here
-		RawTexelBuffer = data;
-		return true;
+		TexelStorage.reset((uint8_t*)FMemory::Malloc(size, PITCH_ALIGNMENT), [](uint8_t* p) { FMemory::Free(p); });
+		TexelCapacity = size;
 	}
 
-	return false;
+	this->Width = width;
+	this->Height = height;
+	this->BitPerPixel = bpp;
+	this->Pitch = pitch;
+	RawTexelBuffer = TexelStorage.get();
+	return RawTexelBuffer;
 }
 
+void WebpDecodeResult::ApplyResult(bool success, double timestamp, int64_t frame_index)
+{
+	this->DecodeSuccessful = success;
+	this->frameTimestamp = timestamp;
+	this->frameIndex = frame_index;
+}
+
+constexpr int WebpDecoder::THREADED_DECODE_PIXEL_COUNT;
+
 std::shared_ptr<WebpDecoder> WebpDecoder::Create()
 {
 	return std::make_shared<WebpDecoder>();
@@ -94,12 +91,35 @@ bool WebpDecoder::DecodeMemoryStream(const uint8_t* stream, size_t stream_size,
 
 	result->Lock();
 
-	// We can avoid a memcpy here too
-	if (!result->ApplyResult(true, timestamp, frameIndex, width, height, 32, WebPDecodeBGRA(stream, stream_size, &width, &height)))
-		return false;
+	// Decode right into the result's buffer, nothing allocated or copied per frame
+	uint8_t* texels = result->PrepareTexels(width, height, 32);
+	const size_t texelSize = (size_t)result->Pitch * height;
+	bool success = false;
+	if (width * height >= THREADED_DECODE_PIXEL_COUNT)
+	{
+		// Large images: libwebp moves filtering and output of finished rows to a worker thread, overlapping
+		// with parsing of the next ones
+		WebPDecoderConfig config;
+		if (WebPInitDecoderConfig(&config))
+		{
+			config.options.use_threads = 1;
+			config.output.colorspace = MODE_BGRA;
+			config.output.is_external_memory = 1;
+			config.output.u.RGBA.rgba = texels;
+			config.output.u.RGBA.stride = result->Pitch;
+			config.output.u.RGBA.size = texelSize;
+			success = WebPDecode(stream, stream_size, &config) == VP8_STATUS_OK;
+			WebPFreeDecBuffer(&config.output);
+		}
+	}
+	else
+	{
+		success = WebPDecodeBGRAInto(stream, stream_size, texels, texelSize, result->Pitch) != nullptr;
+	}
 
+	result->ApplyResult(success, timestamp, frameIndex);
 	result->Unlock();
-	return true;
+	return success;
 }
 
 
@@ -0,0 +1,238 @@
+#include "YUVConversion.h"
+#include "Async/ParallelFor.h"
+#include <cmath>
+
+#if defined(PLATFORM_ENABLE_VECTORINTRINSICS_NEON) && PLATFORM_ENABLE_VECTORINTRINSICS_NEON && defined(__aarch64__)
+#define YUV_CONVERSION_NEON 1
+#include <arm_neon.h>
+#elif defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1
+#define YUV_CONVERSION_SSE 1
+#include <smmintrin.h>
+#endif
+
+#ifndef YUV_CONVERSION_NEON
+#define YUV_CONVERSION_NEON 0
+#endif
+#ifndef YUV_CONVERSION_SSE
+#define YUV_CONVERSION_SSE 0
+#endif
+
+namespace
+{
+	using YUVConversion::Planes;
+	using YUVConversion::Matrix;
+
+	constexpr int FRACTION_BITS = 14;
+	// Rows per task when converting in parallel
+	constexpr int ROWS_PER_TASK = 32;
+
+	struct Coefficients
+	{
+		int32_t YOffset;
+		int32_t Y;
+		int32_t RV;
+		int32_t GU;
+		int32_t GV;
+		int32_t BU;
+	};
+
+	Coefficients MakeCoefficients(Matrix matrix, bool fullRange)
+	{
+		const double kr = matrix == Matrix::BT709 ? 0.2126 : 0.299;
+		const double kb = matrix == Matrix::BT709 ? 0.0722 : 0.114;
+		const double kg = 1.0 - kr - kb;
+		const double yScale = fullRange ? 1.0 : 255.0 / 219.0;
+		const double cScale = fullRange ? 1.0 : 255.0 / 224.0;
+		const double one = (double)(1 << FRACTION_BITS);
+
+		Coefficients c;
+		c.YOffset = fullRange ? 0 : 16;
+		c.Y = (int32_t)std::lround(yScale * one);
+		c.RV = (int32_t)std::lround(2.0 * (1.0 - kr) * cScale * one);
+		c.GU = (int32_t)std::lround(-2.0 * kb * (1.0 - kb) / kg * cScale * one);
+		c.GV = (int32_t)std::lround(-2.0 * kr * (1.0 - kr) / kg * cScale * one);
+		c.BU = (int32_t)std::lround(2.0 * (1.0 - kb) * cScale * one);
+		return c;
+	}
+
+	inline uint8_t ClampToByte(int32_t v)
+	{
+		return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+	}
+
+	void ConvertRowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* out, int begin, int end, const Coefficients& c)
+	{
+		for (int x = begin; x < end; ++x)
+		{
+			// Rounding is folded into the luma term, the SIMD variants do the same
+			const int32_t yTerm = (y[x] - c.YOffset) * c.Y + (1 << (FRACTION_BITS - 1));
+			const int32_t cu = u[x / 2] - 128;
+			const int32_t cv = v[x / 2] - 128;
+
+			uint8_t* pixel = out + x * 4;
+			pixel[0] = ClampToByte((yTerm + c.BU * cu) >> FRACTION_BITS);
+			pixel[1] = ClampToByte((yTerm + c.GU * cu + c.GV * cv) >> FRACTION_BITS);
+			pixel[2] = ClampToByte((yTerm + c.RV * cv) >> FRACTION_BITS);
+			pixel[3] = 255;
+		}
+	}
+
+#if YUV_CONVERSION_SSE
+	// 8 pixels at a time, returns how many pixels of the row are done
+	int ConvertRowSIMD(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* out, int width, const Coefficients& c)
+	{
+		const __m128i yOffset = _mm_set1_epi32(c.YOffset);
+		const __m128i yCoef = _mm_set1_epi32(c.Y);
+		const __m128i round = _mm_set1_epi32(1 << (FRACTION_BITS - 1));
+		const __m128i rvCoef = _mm_set1_epi32(c.RV);
+		const __m128i guCoef = _mm_set1_epi32(c.GU);
+		const __m128i gvCoef = _mm_set1_epi32(c.GV);
+		const __m128i buCoef = _mm_set1_epi32(c.BU);
+		const __m128i chromaOffset = _mm_set1_epi32(128);
+		const __m128i alpha = _mm_set1_epi8((char)0xff);
+
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			int32_t u4, v4;
+			FMemory::Memcpy(&u4, u + x / 2, 4);
+			FMemory::Memcpy(&v4, v + x / 2, 4);
+			const __m128i cu = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(u4)), chromaOffset);
+			const __m128i cv = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v4)), chromaOffset);
+
+			// Chroma terms of 4 pixel pairs, each then repeated for both pixels of its pair
+			const __m128i rc = _mm_mullo_epi32(cv, rvCoef);
+			const __m128i gc = _mm_add_epi32(_mm_mullo_epi32(cu, guCoef), _mm_mullo_epi32(cv, gvCoef));
+			const __m128i bc = _mm_mullo_epi32(cu, buCoef);
+
+			const __m128i y8 = _mm_loadl_epi64((const __m128i*)(y + x));
+			const __m128i yLo = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_cvtepu8_epi32(y8), yOffset), yCoef), round);
+			const __m128i yHi = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(y8, 4)), yOffset), yCoef), round);
+
+			const __m128i r16 = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(yLo, _mm_unpacklo_epi32(rc, rc)), FRACTION_BITS),
+				_mm_srai_epi32(_mm_add_epi32(yHi, _mm_unpackhi_epi32(rc, rc)), FRACTION_BITS));
+			const __m128i g16 = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(yLo, _mm_unpacklo_epi32(gc, gc)), FRACTION_BITS),
+				_mm_srai_epi32(_mm_add_epi32(yHi, _mm_unpackhi_epi32(gc, gc)), FRACTION_BITS));
+			const __m128i b16 = _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(yLo, _mm_unpacklo_epi32(bc, bc)), FRACTION_BITS),
+				_mm_srai_epi32(_mm_add_epi32(yHi, _mm_unpackhi_epi32(bc, bc)), FRACTION_BITS));
+
+			// Unsigned saturation clamps to 0-255 like the scalar path
+			const __m128i bg = _mm_unpacklo_epi8(_mm_packus_epi16(b16, b16), _mm_packus_epi16(g16, g16));
+			const __m128i ra = _mm_unpacklo_epi8(_mm_packus_epi16(r16, r16), alpha);
+			_mm_storeu_si128((__m128i*)(out + x * 4), _mm_unpacklo_epi16(bg, ra));
+			_mm_storeu_si128((__m128i*)(out + x * 4 + 16), _mm_unpackhi_epi16(bg, ra));
+		}
+		return x;
+	}
+#elif YUV_CONVERSION_NEON
+	// Luma term of 4 pixels, rounding included
+	inline int32x4_t LumaTerm(uint16x4_t y, const Coefficients& c)
+	{
+		const int32x4_t yc = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(y)), vdupq_n_s32(c.YOffset));
+		return vaddq_s32(vmulq_n_s32(yc, c.Y), vdupq_n_s32(1 << (FRACTION_BITS - 1)));
+	}
+
+	// 8 pixels of one channel from the luma terms and 4 chroma terms
+	inline uint8x8_t Channel(int32x4_t yLo, int32x4_t yHi, int32x4_t chroma)
+	{
+		const int32x4_t lo = vshrq_n_s32(vaddq_s32(yLo, vzip1q_s32(chroma, chroma)), FRACTION_BITS);
+		const int32x4_t hi = vshrq_n_s32(vaddq_s32(yHi, vzip2q_s32(chroma, chroma)), FRACTION_BITS);
+		// Unsigned saturation clamps to 0-255 like the scalar path
+		return vqmovun_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+
+	// 16 pixels at a time, returns how many pixels of the row are done
+	int ConvertRowSIMD(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* out, int width, const Coefficients& c)
+	{
+		int x = 0;
+		for (; x + 16 <= width; x += 16)
+		{
+			const int16x8_t cu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + x / 2))), vdupq_n_s16(128));
+			const int16x8_t cv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + x / 2))), vdupq_n_s16(128));
+			const int32x4_t cuLo = vmovl_s16(vget_low_s16(cu)), cuHi = vmovl_s16(vget_high_s16(cu));
+			const int32x4_t cvLo = vmovl_s16(vget_low_s16(cv)), cvHi = vmovl_s16(vget_high_s16(cv));
+
+			const int32x4_t rcLo = vmulq_n_s32(cvLo, c.RV), rcHi = vmulq_n_s32(cvHi, c.RV);
+			const int32x4_t gcLo = vaddq_s32(vmulq_n_s32(cuLo, c.GU), vmulq_n_s32(cvLo, c.GV));
+			const int32x4_t gcHi = vaddq_s32(vmulq_n_s32(cuHi, c.GU), vmulq_n_s32(cvHi, c.GV));
+			const int32x4_t bcLo = vmulq_n_s32(cuLo, c.BU), bcHi = vmulq_n_s32(cuHi, c.BU);
+
+			const uint8x16_t y16 = vld1q_u8(y + x);
+			const uint16x8_t yFirst = vmovl_u8(vget_low_u8(y16));
+			const uint16x8_t ySecond = vmovl_u8(vget_high_u8(y16));
+			const int32x4_t y0 = LumaTerm(vget_low_u16(yFirst), c);
+			const int32x4_t y1 = LumaTerm(vget_high_u16(yFirst), c);
+			const int32x4_t y2 = LumaTerm(vget_low_u16(ySecond), c);
+			const int32x4_t y3 = LumaTerm(vget_high_u16(ySecond), c);
+
+			uint8x16x4_t bgra;
+			bgra.val[0] = vcombine_u8(Channel(y0, y1, bcLo), Channel(y2, y3, bcHi));
+			bgra.val[1] = vcombine_u8(Channel(y0, y1, gcLo), Channel(y2, y3, gcHi));
+			bgra.val[2] = vcombine_u8(Channel(y0, y1, rcLo), Channel(y2, y3, rcHi));
+			bgra.val[3] = vdupq_n_u8(255);
+			vst4q_u8(out + x * 4, bgra);
+		}
+		return x;
+	}
+#endif
+
+	void ConvertRows(const Planes& planes, int width, int rowBegin, int rowEnd, const Coefficients& c, uint8_t* outBGRA, uint32_t outPitch, bool useSIMD)
+	{
+		for (int row = rowBegin; row < rowEnd; ++row)
+		{
+			const uint8_t* y = planes.Y + (size_t)row * planes.YPitch;
+			const uint8_t* u = planes.U + (size_t)(row / 2) * planes.UPitch;
+			const uint8_t* v = planes.V + (size_t)(row / 2) * planes.VPitch;
+			uint8_t* out = outBGRA + (size_t)row * outPitch;
+
+			int done = 0;
+#if YUV_CONVERSION_SSE || YUV_CONVERSION_NEON
+			if (useSIMD)
+				done = ConvertRowSIMD(y, u, v, out, width, c);
+#endif
+			ConvertRowScalar(y, u, v, out, done, width, c);
+		}
+	}
+}
+
+namespace YUVConversion
+{
+
+const TCHAR* GetKernelName()
+{
+#if YUV_CONVERSION_SSE
+	return TEXT("SSE4.1");
+#elif YUV_CONVERSION_NEON
+	return TEXT("NEON");
+#else
+	return TEXT("Scalar");
+#endif
+}
+
+void ConvertToBGRA(const Planes& planes, int width, int height, Matrix matrix, bool fullRange, uint8_t* outBGRA, uint32_t outPitch, bool parallelRows)
+{
+	const Coefficients c = MakeCoefficients(matrix, fullRange);
+
+	if (!parallelRows || height <= ROWS_PER_TASK)
+	{
+		ConvertRows(planes, width, 0, height, c, outBGRA, outPitch, true);
+		return;
+	}
+
+	const int taskCount = (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	ParallelFor(taskCount, [&](int32 task)
+		{
+			const int rowBegin = task * ROWS_PER_TASK;
+			ConvertRows(planes, width, rowBegin, FMath::Min(rowBegin + ROWS_PER_TASK, height), c, outBGRA, outPitch, true);
+		});
+}
+
+void ConvertToBGRAScalar(const Planes& planes, int width, int height, Matrix matrix, bool fullRange, uint8_t* outBGRA, uint32_t outPitch)
+{
+	ConvertRows(planes, width, 0, height, MakeCoefficients(matrix, fullRange), outBGRA, outPitch, false);
+}
+
+}
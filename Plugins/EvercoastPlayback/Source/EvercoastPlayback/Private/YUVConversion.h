@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include "CoreMinimal.h"
+
+// CPU conversion of planar YUV 4:2:0 frames to BGRA8, the layout of PF_B8G8R8A8 textures. For when no GPU runs
+// NV12TextureConversion.usf, e.g. NullRHI or FORCE_NV12_CPU_CONVERSION. 14 bit fixed point with nearest chroma,
+// SSE4.1 or NEON variant picked at compile time, the scalar one is the reference they match bit for bit.
+namespace YUVConversion
+{
+	enum class Matrix : uint8_t
+	{
+		BT601,
+		BT709
+	};
+
+	struct Planes
+	{
+		const uint8_t* Y;
+		const uint8_t* U;
+		const uint8_t* V;
+		uint32_t YPitch;
+		uint32_t UPitch;
+		uint32_t VPitch;
+	};
+
+	// Name of the kernel set compiled in, for logging
+	const TCHAR* GetKernelName();
+
+	// fullRange for 0-255 luma and chroma(JPEG), otherwise 16-235/16-240. parallelRows splits the rows across task graph workers.
+	void ConvertToBGRA(const Planes& planes, int width, int height, Matrix matrix, bool fullRange, uint8_t* outBGRA, uint32_t outPitch, bool parallelRows = false);
+
+	void ConvertToBGRAScalar(const Planes& planes, int width, int height, Matrix matrix, bool fullRange, uint8_t* outBGRA, uint32_t outPitch);
+}
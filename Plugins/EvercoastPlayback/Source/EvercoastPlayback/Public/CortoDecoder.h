@@ -30,8 +30,10 @@ public:
 	void Lock() const; 
 	// for thread safety
 	void Unlock() const;
-	// Applying result is doing memcpy for now
-	void ApplyResult(bool uccess, double timestamp, int64_t frameIndex, uint32_t vnum, uint32_t fnum, uint32_t* ib, FVector3f* pb, FVector2f* uvb, FVector3f* nb);
+	// Buffers already hold what Corto decoded, this brings them to engine space in place: positions scaled by
+	// positionScale with y<->z swapped, normals swapped likewise and triangle winding optionally flipped. Bounds are
+	// gathered on the way
+	void ApplyResult(bool uccess, double timestamp, int64_t frameIndex, uint32_t vnum, uint32_t fnum, bool hasNormals, bool flipWinding, float positionScale);
 	// Make it invalidate, still keeping the buffers tho
 	virtual void InvalidateResult() override;
 	// Normals are optional
@@ -53,7 +55,13 @@ public:
 	std::vector<uint32_t> IndexBuffer;
 	std::vector<FVector3f> PositionBuffer;
 	std::vector<FVector2f> UVBuffer;
-	std::vector<FVector3f> NormalBuffer;
+	std::vector<FVector3f> NormalBuffer; // always allocated, only valid when HasNormals()
+	bool NormalsValid;
+
+	// Bounds of PositionBuffer, zero when empty
+	FVector3f BoundsMin;
+	FVector3f BoundsMax;
+	bool BoundsHasNaN;
 
 	mutable std::mutex RWLock;
 };
@@ -63,6 +71,8 @@ class EVERCOASTPLAYBACK_API CortoDecoder : public IGenericDecoder
 public:
 	static constexpr int DEFAULT_VERTEX_COUNT = 100000;
 	static constexpr int DEFAULT_TRIANGLE_COUNT = DEFAULT_VERTEX_COUNT;
+	// Corto meshes are in metres, engine in centimetres
+	static constexpr float POSITION_SCALE = 100.0f;
 
 	static std::shared_ptr<CortoDecoder> Create();
 	virtual ~CortoDecoder();
@@ -86,13 +96,7 @@ public:
 	}
 private:
 	CortoDecoder();
-	void EnsureBuffers(int vertexCount, int traingleCount);
 
-	std::vector<uint32_t> index_buf;
-	std::vector<FVector3f> position_buf;
-	std::vector<FVector2f> uv_buf;
-	std::vector<FVector3f> normal_buf;
+	// Corto decodes straight into the receiving result's buffers
 	std::shared_ptr<CortoDecodeResult> result;
-	int vertex_count;
-	int triangle_count;
 };
\ No newline at end of file
@@ -30,6 +30,8 @@ public:
 
 	std::shared_ptr<IEvercoastStreamingDataUploader> GetMeshDataUploader() const;
 	void SetMeshData(std::shared_ptr<CortoLocalMeshFrame> localMeshFrame);
+	// Mesh frames handed to SetMeshData() that the render thread hasn't uploaded yet
+	int32 GetMeshUpdatesInFlight() const;
 	void SetTextureData(std::shared_ptr<CortoLocalTextureFrame> localTexture);
 
 	UFUNCTION(BlueprintCallable, Category="Evercoast Playback")
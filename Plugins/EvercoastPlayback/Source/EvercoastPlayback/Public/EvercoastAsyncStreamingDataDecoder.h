@@ -1,6 +1,9 @@
 #pragma once
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <vector>
 #include "EvercoastStreamingDataDecoder.h"
 #include "ec_decoder_compatibility.h"
@@ -9,6 +12,9 @@ class EvercoastVoxelDecoder;
 class FRunnable;
 class FRunnableThread;
 struct EvercoastLocalDataFrame;
+struct EvercoastDecodeTicket;
+struct CortoWebpUnifiedDecodeResult;
+template<typename T> class DecodeResultPool;
 class IEvercoastStreamingDataUploader;
 
 
@@ -18,9 +24,16 @@ public:
 
 	virtual bool HasNewEntry() const = 0;
 	virtual size_t GetNewEntryCount() const = 0;
-	virtual void AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata) = 0;
+	// Return false if the ticket wasn't taken, e.g. the data only completes a frame which already has one
+	virtual bool AddEntry(double timestamp, int64_t frameIndex, const uint8_t* data, size_t dataSize, uint32_t metadata, const EvercoastDecodeTicket& ticket) = 0;
+	// Frames queued or being decoded, not yet handed to the presorter
 	virtual int GetPotentialResultCount() const = 0;
 	virtual void FlushAndDisposeResults() = 0;
+	// Frames made of multiple pieces of data(e.g. mesh + image) have to be completed on the worker which holds them
+	virtual bool HasIncompleteFrame(int64_t frameIndex) const
+	{
+		return false;
+	}
 
 };
 
@@ -38,20 +51,13 @@ public:
 
 		// The usual add result to cache. The result should be lightweight(e.g. EvercoastVoxelDecodeResult)
 		void Add(std::shared_ptr<GenericDecodeResult> result);
-		// When results are heavy (e.g. CortoDecodeResult & WebpDecodeResult), it better be allocated inside ResultCache to be reused later
-		// Returns null when such object isn't being created
-		std::shared_ptr<GenericDecodeResult> Prealloc();
-		// When the preallocation returns null, it's the caller's job to supply a prefabricated result object
-		void FillLastPrealloc(std::shared_ptr<GenericDecodeResult> newCache);
-		// Manipulate preallocation need to freeze the cache as a whole
-		void Lock();
-		// Manipulate preallocation need to freeze the cache as a whole
-		void Unlock();
+		// Served from the timestamp index, doesn't wait on decoder threads adding results
 		std::shared_ptr<GenericDecodeResult> Query(double timestamp, double halfFrameInterval);
 		bool Trim(double medianTimestamp, double halfFrameInterval, int halfCacheWidth);
 		void Dispose();
 		void DisposeAndReinit();
-		void Resize(uint32_t bufferCount);
+		// frameInterval keys the direct-mapped index, 0 to only use the sorted index
+		void Resize(uint32_t bufferCount, double frameInterval);
 		int Size() const;
 		bool IsFull() const;
 		bool IsEmpty() const;
@@ -60,6 +66,15 @@ public:
 		bool IsBeyond(double timestamp, double halfFrameInterval) const;
 
 	private:
+		// Drop the references of ring slots [fromIdx, toIdx)
+		void Release(int fromIdx, int toIdx);
+
+		// Index mirrors the ring content in [start, end). Below expect m_mutex being held, they take m_indexLock.
+		void IndexAdd(const std::shared_ptr<GenericDecodeResult>& result);
+		void RebuildIndex();
+		void ClearIndex();
+		int64_t FrameKey(double timestamp) const;
+
 		std::shared_ptr<GenericDecodeResult>* m_resultArray; // ring of cached results
 
 		// when (end + 1) % count == start, the ring is full
@@ -68,17 +83,41 @@ public:
 		int m_bufferCount;
 
 		mutable std::recursive_mutex m_mutex;
+
+		struct IndexSlot
+		{
+			int64_t key = INT64_MIN;
+			double timestamp = 0;
+			std::shared_ptr<GenericDecodeResult> result;
+		};
+
+		// Timestamps quantised by the frame interval(i.e. frame number) pick a slot directly. Table is at least twice
+		// the ring size so consecutive frames never collide. Anything evicted by a collision, e.g. frames across a
+		// loop back, is still found in the sorted index by binary search.
+		std::vector<IndexSlot> m_directIndex;
+		std::vector<IndexSlot> m_sortedIndex; // ascending timestamp
+		double m_frameInterval;
+
+		// Writers already hold m_mutex, readers only ever take this one shared
+		mutable std::shared_mutex m_indexLock;
 	};
 
-	// Middle man between ResultCache and specific FEvercoastGenericDecodeThread, sort the delivered result in timestamp ascending order
-	// before feeding to ResultCache
+	// Middle man between ResultCache and the FEvercoastGenericDecodeThread workers. Every received frame is issued a
+	// ticket in receiving order, and results are fed to ResultCache strictly in ticket order no matter which worker
+	// finishes first. Ordering doesn't rely on timestamps so looping back and seeking don't confuse it, and flushing
+	// starts a new epoch so late results from before the flush are dropped.
 	class ResultPresorter
 	{
 	public:
 
-		ResultPresorter(ResultCache& resultCache, double frameInterval);
+		explicit ResultPresorter(ResultCache& resultCache);
 
-		void Add(std::shared_ptr<GenericDecodeResult> result);
+		EvercoastDecodeTicket Issue();
+		void Add(const EvercoastDecodeTicket& ticket, std::shared_ptr<GenericDecodeResult> result);
+		// Decoding failed or the ticket went unused, don't hold up the frames after it
+		void Skip(const EvercoastDecodeTicket& ticket);
+		// Results waiting for earlier tickets
+		int GetPendingCount() const;
 
 		void Dispose();
 		void DisposeAndReinit();
@@ -86,12 +125,13 @@ public:
 		void CleanupPresortedResults();
 
 	private:
-		void CheckContinuityAndFeed();
-		void ForceDeliver(std::shared_ptr<GenericDecodeResult> result);
+		void FeedInOrder();
 
-		std::vector<std::shared_ptr<GenericDecodeResult>> m_presortedResults;
-		double m_frameInterval;
-		double m_lastDeliveredTimestamp;
+		// sequence -> result, null for skipped
+		std::map<uint64_t, std::shared_ptr<GenericDecodeResult>> m_presortedResults;
+		uint32_t m_epoch;
+		uint64_t m_nextSequenceToIssue;
+		uint64_t m_nextSequenceToDeliver;
 		ResultCache& m_resultCache;
 
 		mutable std::recursive_mutex m_mutex;
@@ -100,6 +140,7 @@ public:
 
 
 	static constexpr int DEFAULT_BUFFER_COUNT = 30;
+	static constexpr int MAX_DECODE_THREAD_COUNT = 8;
 	EvercoastAsyncStreamingDataDecoder(DecoderType decoderType);
 	virtual ~EvercoastAsyncStreamingDataDecoder();
 	// ~Start of IEvercoastStreamingDataDecoder~
@@ -110,15 +151,18 @@ public:
 	virtual bool TrimCache(double medianTimestamp) override;
 	virtual void FlushAndDisposeResults() override;
 	virtual void SetRequiresExternalData(bool required) override;
+	virtual void SetRequiredVoxelLOD(uint32_t lod) override;
+	virtual void SetCompactVoxels(bool compact) override;
 	virtual void ResizeBuffer(uint32_t bufferCount, double halfFrameInterval) override;
 	virtual bool IsGoingToBeFull() const override;
 	// ~End of IEvercoastStreamingDataDecoder~
 
 	
 private:
-	void Init(double frameInterval, int maxThreadCount);
+	void Init(int maxThreadCount);
 	void Deinit();
 	FEvercoastGenericDecodeThread* FindLeastJobWorker();
+	FEvercoastGenericDecodeThread* FindWorkerWithIncompleteFrame(int64_t frameIndex);
 
 	std::shared_ptr<IGenericDecoder> m_baseDecoder;
 	std::shared_ptr<IGenericDecoder> m_auxDecoder;
@@ -129,6 +173,10 @@ private:
 
 	ResultCache m_resultCache;
 	ResultPresorter* m_resultPresorter;
+	std::shared_ptr<DecodeResultPool<CortoWebpUnifiedDecodeResult>> m_cortoResultPool;
+	bool m_requiresExternalData;
+	int32_t m_requiredVoxelLOD; // -1 to leave the decoder's default
+	bool m_compactVoxels;
 	uint32_t m_halfCacheWidth;
 	double m_halfFrameInterval;
 
@@ -1,55 +1,119 @@
 #pragma once
 
 #include <string>
-#include <deque>
-#include <mutex>
+#include <atomic>
+#include <memory>
 #include "CoreMinimal.h"
 
 
 class EVERCOASTPLAYBACK_API EvercoastPerfCounter
 {
 public:
-	// Counter starts with a name, and within a time span that it will automatically accumulate the 
-	// latest sample and dispose the outdated samples based on timestamps
+	// Counter starts with a name, and within a time span that it will automatically accumulate the
+	// latest sample and dispose the outdated samples based on timestamps.
+	// Samples land in log-linear histograms(about 3% relative error) split into time slices, with counts and
+	// sums kept per writer shard, so adding takes a few relaxed atomics and no lock. Getters merge the slices
+	// in the window.
 	EvercoastPerfCounter(const std::string& name, double timeSpan);
-	~EvercoastPerfCounter() = default;
+	~EvercoastPerfCounter();
 
 	// Begin of thread-safe functions
 	void AddSample();
 	void AddSampleAsInt64(int64_t measuredData);
 	void AddSampleAsDouble(double measuredData);
 
-	size_t GetSampleCount(); // trim happens so no const
+	size_t GetSampleCount();
 
-	double GetSampleAccumulatedDouble(); // trim happens so no const
+	double GetSampleAccumulatedDouble();
 	int64_t GetSampleAccumulatedInt64();
 
 	double GetSampleAverageInt64OnCount();
 	double GetSampleAverageInt64OnDuration();
 	double GetSampleAverageDoubleOnCount();
 	double GetSampleAverageDoubleOnDuration();
+
+	// percentile in [0, 1], e.g. 0.95. -1 when there's no sample
+	double GetSamplePercentile(double percentile);
+
+	struct Summary
+	{
+		size_t count = 0;
+		double accumulated = 0;
+		// Per second over the time covered
+		double rate = 0;
+		double p50 = 0;
+		double p95 = 0;
+		double p99 = 0;
+	};
+	// All of the above from a single merge
+	Summary GetSummary();
+
+	// Not safe against concurrent adding, samples added meanwhile may be lost
 	void SetTimespan(double newTimespan);
 	void Reset();
 	// End of thread-safe functions
 
 	const std::string& Name() const;
-	
-	struct DataType
+
+	static constexpr int SHARD_COUNT = 4;
+	static constexpr int SLICE_COUNT = 8;
+	// Power of two exponents covered, values outside are clamped into the end buckets
+	static constexpr int EXPONENT_MIN = -20;
+	static constexpr int EXPONENT_COUNT = 48;
+	static constexpr int SUB_BUCKET_BITS = 4;
+	static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	// Negative magnitudes, zero, positive magnitudes
+	static constexpr int MAGNITUDE_BUCKET_COUNT = EXPONENT_COUNT * SUB_BUCKET_COUNT;
+	static constexpr int BUCKET_COUNT = MAGNITUDE_BUCKET_COUNT * 2 + 1;
+	// Histogram buckets hold the low bits of the slice index their count belongs to, so a slice coming round
+	// again never needs clearing: a bucket from an older slice restarts from 1 on its first new sample. Counts
+	// saturate at 2^20 per bucket and slice.
+	static constexpr int BUCKET_COUNT_BITS = 20;
+	static constexpr uint32_t BUCKET_COUNT_MASK = (1u << BUCKET_COUNT_BITS) - 1;
+
+private:
+	struct Slice
 	{
-		union {
-			double measuredDouble;
-			int64_t measuredInt64;
-		} data;
-		double timestamp;
+		// Which slice of time this holds, -1 when unused
+		std::atomic<int64_t> index{ -1 };
+		std::atomic<uint64_t> count{ 0 };
+		std::atomic<int64_t> sumInt64{ 0 };
+		std::atomic<double> sumDouble{ 0 };
 	};
 
-private:
+	struct alignas(64) Shard
+	{
+		Slice slices[SLICE_COUNT];
+	};
+
+	// Shared by the shards, samples of different values rarely meet in a bucket
+	struct Histogram
+	{
+		std::atomic<uint32_t> buckets[BUCKET_COUNT];
+	};
+
+	struct MergedWindow
+	{
+		uint64_t count = 0;
+		int64_t sumInt64 = 0;
+		double sumDouble = 0;
+		double coveredTime = 0;
+		uint64_t buckets[BUCKET_COUNT];
+	};
+
+	void Record(int64_t valueInt64, double valueDouble);
+	Slice& AcquireSlice(int64_t index);
+	static void AddToBucket(std::atomic<uint32_t>& bucket, uint32_t tag);
+	void Merge(MergedWindow& merged, bool withBuckets);
 
-	void TrimToTimespan();
+	static int BucketOf(double value);
+	static double BucketValue(int bucket);
+	static double Percentile(const MergedWindow& merged, double percentile);
 
 	std::string _name;
-	mutable std::mutex _mutex;
-	std::deque<DataType> _measurements;
-	double _duration;
-	
-};
\ No newline at end of file
+	std::unique_ptr<Shard[]> _shards;
+	std::unique_ptr<Histogram[]> _histograms;
+	std::atomic<double> _duration;
+	std::atomic<double> _sliceDuration;
+	std::atomic<double> _startTime;
+};
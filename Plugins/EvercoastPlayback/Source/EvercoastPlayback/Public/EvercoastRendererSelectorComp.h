@@ -53,6 +53,8 @@ public:
 
 	void ChooseCorrespondingSubRenderer(DecoderType decoderType);
 	std::vector<std::shared_ptr<IEvercoastStreamingDataUploader>> GetDataUploaders() const;
+	// World bounds of the sub renderer in use, false if none is chosen yet
+	bool GetRenderedBounds(FBoxSphereBounds& outBounds) const;
 
 private:
 	bool IsUsingVoxelRenderer() const;
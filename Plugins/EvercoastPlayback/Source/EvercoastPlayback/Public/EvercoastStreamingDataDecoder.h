@@ -13,4 +13,9 @@ public:
 	virtual bool IsTimestampBeyondCache(double timestamp) = 0;
 	virtual bool TrimCache(double medianTimestamp) = 0;
 	virtual void SetRequiresExternalData(bool required) = 0;
+	// Voxel data only, LOD0 is the most detailed. Applies to frames decoded from now on, cached ones are kept.
+	virtual void SetRequiredVoxelLOD(uint32_t lod) = 0;
+	// Voxel data only, one half float element per voxel instead of separate coordinates and colours, see
+	// VoxelCompactPacking. Applies to frames decoded from now on.
+	virtual void SetCompactVoxels(bool compact) = 0;
 };
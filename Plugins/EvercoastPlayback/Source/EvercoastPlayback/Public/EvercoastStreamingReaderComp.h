@@ -12,6 +12,7 @@
 #include <future>
 #include <mutex>
 #include <numeric>
+#include <vector>
 #include "UObject/LazyObjectPtr.h"
 #include "UObject/SoftObjectPtr.h"
 #include "TimestampDriver.h"
@@ -73,6 +74,18 @@ public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, BlueprintSetter = SetRendererActor, BlueprintGetter = GetRendererActor, Category = "Rendering")
 	AEvercoastVolcapActor* RendererActor;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering", meta = (Tooltip = "Decode voxel data at the level of detail matching its size on screen, within the voxel budget shared by all readers with this option on. Only for .ecv data played in game."))
+	bool bScreenSizeVoxelLOD = false;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Rendering", meta = (Tooltip = "Screen pixels each decoded voxel is expected to cover. Higher values pick coarser levels of detail.", EditCondition = "bScreenSizeVoxelLOD", ClampMin = "0.1"))
+	float TargetPixelsPerVoxel = 1.0f;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Rendering", meta = (Tooltip = "Voxels per frame, in thousands, shared by all readers with screen size level of detail on. The smallest value among them applies.", EditCondition = "bScreenSizeVoxelLOD", ClampMin = "1"))
+	int32 VoxelLODBudgetInThousands = 16384;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Rendering", meta = (Tooltip = "Store decoded voxels as one 8 byte half float element instead of 12 bytes of coordinates and colour, so less is written and uploaded per frame. Colours lose some precision and coordinates beyond 2048 round to even. Only for .ecv data, takes effect when the asset is opened."))
+	bool bCompactVoxelData = false;
+
 	UPROPERTY(EditAnywhere, Category = "Data Source", meta = (Tooltip="Limit the source data's bit rate. Unit is megabit per second.", GetOptions = "GetDataBitRates"))
 	FString DataBitRateLimit = "Unlimited";
 
@@ -82,6 +95,27 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Data Source", meta = (Tooltip = "Normally disk cache will be used. Turn on this option to force using memory cache. On some device like iOS which memory is limited this option should be left off."))
 	bool bForceMemoryCache = false;
 
+	UPROPERTY(EditAnywhere, Category = "Data Source", meta = (Tooltip = "Switch between representations of the same frame rate based on the measured download throughput and buffered data. Only for HTTP streams, DataBitRateLimit still caps the choices."))
+	bool bAdaptiveBitRate = false;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Data Source", meta = (Tooltip = "How many HTTP range requests can be downloading at the same time. Adjacent ranges are merged into one request.", ClampMin = "1", ClampMax = "16"))
+	int32 MaxConcurrentHttpRequests = 4;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Data Source", meta = (Tooltip = "How many times a failed HTTP range request is retried before giving up.", ClampMin = "0"))
+	int32 HttpMaxRetries = 3;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Data Source", meta = (Tooltip = "Timeout of each HTTP range request in seconds, 0 for no timeout. Not applied in editor.", ClampMin = "0"))
+	float HttpRequestTimeoutInSeconds = 5.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Data Source", meta = (Tooltip = "Keep HTTP streamed content on disk across sessions, so repeated plays are served locally. Content is revalidated by its ETag."))
+	bool bUsePersistentCache = false;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Data Source", meta = (Tooltip = "Size limit of the persistent cache shared by all readers. Least recently used content is evicted first.", EditCondition = "bUsePersistentCache", ClampMin = "64"))
+	int32 PersistentCacheSizeInMB = 4096;
+
+	UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Data Source", meta = (Tooltip = "Decode the texture video of mesh data on the GPU's video decoder when the platform has one, otherwise it is decoded in software."))
+	bool bHardwareVideoDecode = false;
+
 	UFUNCTION(BlueprintCallable, Category = "Evercoast Playback")
 	void StreamingPlay();
 
@@ -245,6 +279,13 @@ private:
 	bool IsTimestampBeyondVideoCache(double timestamp) const;
 	// ~Functions only for corto mesh decoder
 
+	// ~Screen size voxel LOD
+	void UpdateVoxelLOD();
+	void StopVoxelLOD();
+	void SetVoxelLOD(uint32_t lod);
+	static void EvaluateVoxelLOD();
+	// ~Screen size voxel LOD
+
 	void _PrintDebugStatus() const; 
 	bool IsFrameCached(double testTimestamp) const;
 
@@ -342,4 +383,10 @@ private:
 	int32_t m_currentMatchingFrameNumber;
 	float m_currentMatchingTimestamp;
 	float m_lastDueTimestamp;
+
+	// Screen size voxel LOD, counts are from the latest uploaded frame
+	double m_voxelLODScreenRadius;
+	std::vector<uint32_t> m_voxelLODCounts;
+	uint32_t m_voxelLOD;
+	bool m_voxelLODRegistered;
 };
@@ -12,22 +12,53 @@ DECLARE_LOG_CATEGORY_EXTERN(EvercoastVoxelDecoderLog, Log, All);
 constexpr uint32_t DECODER_MAX_VOXEL_COUNT = 2048 * 2048;
 constexpr uint32_t DECODER_POSITION_ELEMENT_SIZE = 8;
 constexpr uint32_t DECODER_COLOUR_ELEMENT_SIZE = 4;
+constexpr uint32_t DECODER_MAX_LOD_COUNT = 16;
 
 class EVERCOASTPLAYBACK_API EvercoastVoxelDecodeOption : public GenericDecodeOption
 {
 public:
 	Definition definition;
-	EvercoastVoxelDecodeOption(Definition def) : definition(def)
+	// Pack each voxel into one half float element after decoding, see VoxelCompactPacking
+	bool compactVoxels;
+	EvercoastVoxelDecodeOption(Definition def, bool compact = false) : definition(def), compactVoxels(compact)
 	{}
 };
 
+// Releases the decoded voxel frame once the last holder lets go of it
+struct EVERCOASTPLAYBACK_API EvercoastVoxelFrameOwner
+{
+	explicit EvercoastVoxelFrameOwner(GTHandle handle, bool isCompact = false) : frame(handle), compact(isCompact)
+	{}
+
+	~EvercoastVoxelFrameOwner()
+	{
+		if (frame != InvalidHandle)
+		{
+			release_voxel_frame_instance(frame);
+		}
+	}
+
+	const GTHandle frame;
+	// Coordinates hold VoxelCompactPacking elements, the colour stream is stale
+	const bool compact;
+};
+
 class EVERCOASTPLAYBACK_API EvercoastVoxelDecodeResult : public GenericDecodeResult
 {
 public:
     GTHandle resultFrame;
-	EvercoastVoxelDecodeResult(bool success, double timestamp, int64_t index, GTHandle handle) :
+	// Shared with the local frames being rendered, so the voxels can be read in place after the cache slot is reused
+	std::shared_ptr<const EvercoastVoxelFrameOwner> resultFrameOwner;
+	// LOD the frame was decoded at, and the voxel count of every LOD available in the frame, LOD0 the most detailed
+	uint32_t lod;
+	uint32_t lodCount;
+	uint32_t lodVoxelCounts[DECODER_MAX_LOD_COUNT];
+
+	EvercoastVoxelDecodeResult(bool success, double timestamp, int64_t index, GTHandle handle, bool compact = false) :
 		GenericDecodeResult(success, timestamp, index),
-		resultFrame(handle)
+		resultFrame(handle),
+		resultFrameOwner(handle != InvalidHandle ? std::make_shared<const EvercoastVoxelFrameOwner>(handle, compact) : nullptr),
+		lod(0), lodCount(0)
 	{}
 
 	virtual DecodeResultType GetType() const override
@@ -39,11 +70,8 @@ public:
 	{
 		GenericDecodeResult::InvalidateResult();
 
-		if (resultFrame != InvalidHandle)
-		{
-			release_voxel_frame_instance(resultFrame);
-			resultFrame = InvalidHandle;
-		}
+		resultFrameOwner.reset();
+		resultFrame = InvalidHandle;
 	}
 };
 
@@ -59,6 +87,8 @@ public:
 	virtual std::shared_ptr<GenericDecodeResult> TakeResult() override;
 private:
 	EvercoastVoxelDecoder(GTHandle decoder_interface);
+	// Voxel counts of the opened frame per LOD, returns the number of LODs, 0 if the header can't be read
+	uint32_t ReadLODVoxelCounts(uint32_t* outCounts) const;
 
 	static bool s_initialised;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "CoreMinimal.h"
 #include "UnrealEngineCompatibility.h"
 #include "GenericDecoder.h"
@@ -21,6 +22,9 @@ struct ECSpzHeader
 
 #pragma pack(pop)
 
+class ZstdWindowReader;
+class AlignedBlockPool;
+
 class EvercoastGaussianSplatDecodeOption : public GenericDecodeOption
 {
 public:
@@ -76,6 +80,14 @@ public:
 	virtual std::shared_ptr<GenericDecodeResult> TakeResult() override;
 
 private:
+    EvercoastGaussianSplatDecoder();
+
     std::shared_ptr<GenericDecodeResult> m_result;
+
+    // Decompression context, window and scratch are reused frame after frame
+    std::unique_ptr<ZstdWindowReader> m_reader;
+    std::vector<uint8_t> m_alphaScratch;
+    // Upload blocks of passthrough results
+    std::shared_ptr<AlignedBlockPool> m_blockPool;
 };
 
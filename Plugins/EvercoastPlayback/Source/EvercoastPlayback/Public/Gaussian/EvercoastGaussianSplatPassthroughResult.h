@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include "CoreMinimal.h"
 #include "UnrealEngineCompatibility.h"
@@ -86,7 +87,8 @@ public:
         uint8_t* inColourAlpha, uint32_t inColourAlphaSize,
         uint8_t* inScale, uint32_t inScaleSize,
         uint8_t* inRotation, uint32_t inRotationSize,
-        uint8_t* inSHCoeff, uint32_t inSHCoeffSize
+        uint8_t* inSHCoeff, uint32_t inSHCoeffSize,
+        std::function<void(uint8_t*)> wholeMemoryBlockReleaser = nullptr
     );
 
     virtual ~EvercoastGaussianSplatPassthroughResult();
@@ -115,6 +117,8 @@ public:
     // pointer for memory management, only this pointer needs to be transferred and freed
     uint8_t* memBlock;
     uint32_t memBlockSize;
+    // Gives memBlock back to where it came from, e.g. a pool. Blocks without one are new[] allocated.
+    std::function<void(uint8_t*)> memBlockReleaser;
 
     // interleaved attributes data
     uint8_t* packedPositions;
@@ -25,11 +25,15 @@ DECLARE_LOG_CATEGORY_EXTERN(EvercoastReaderLog, Log, All);
 
 class IEvercoastStreamingDataDecoder;
 class FHttpModule;
-class SavedHttpRequest; // we need this silly method to keep IHttpRequest reference alive
+class HttpRangeScheduler;
+class AdaptiveBitRateController;
 class TheReaderDelegate;
 class TheValidationDelegate;
 class UEvercoastStreamingAudioImportCallback;
 class URuntimeAudio;
+class IReaderCache;
+class IAsyncReadFileHandle;
+class IAsyncReadRequest;
 enum class ERuntimeAudioFactoryResult;
 
 typedef int32_t ECReaderEvent;
@@ -89,6 +93,7 @@ public:
 	uint32_t GetMainChannelId() const;
 	uint32_t GetTextureChannelId() const;
 	GTHandle GetRawHandle() const;
+	uint64_t GetCacheOccupancyInBytes() const;
 	bool IsAudioDataAvailable() const;
 	UAudioComponent* GetReceivingAudioComponent() const;
 	TArray<uint32_t> GetBitRates() const
@@ -119,76 +124,32 @@ public:
 	{
 		m_preferExternalVideoData = preferVideo;
 	}
-#if WITH_EDITOR
-	// only for checking the validity of location. ReadDelegate will have to call 
-	bool ValidateLocation(const FString& urlOrFilePath, double timeoutSec); 
-#endif
-private:
 
-	class IReaderCache
+	// Takes effect on the next opened HTTP connection. timeoutInSeconds is ignored in editor.
+	void SetHttpRequestLimits(uint32_t maxConcurrentRequests, uint32_t maxRetries, float timeoutInSeconds)
 	{
-	public:
-		virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) = 0;
-		virtual bool Remove(uint32_t cache_id) = 0;
-		virtual const uint8_t* Get(uint32_t cache_id) = 0;
-		virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) = 0;
-		virtual void Reset() = 0;
-	};
+		m_maxConcurrentHttpRequests = maxConcurrentRequests;
+		m_maxHttpRetries = maxRetries;
+		m_httpTimeoutInSeconds = timeoutInSeconds;
+	}
 
-	// A cache mainly caches data to disk, while holding the most recent requested cache in memory.
-	class ReaderDiskCache : public IReaderCache
+	// Keep HTTP streamed content across sessions, shared by all readers
+	void SetUsingPersistentCache(bool usePersistentCache)
 	{
-	public:
-		ReaderDiskCache();
-		virtual ~ReaderDiskCache();
-		// Allocate and copy data on the fly. Return true for new cache entry, false for existing entry updated
-		virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) override;
-		virtual bool Remove(uint32_t cache_id) override;
-		virtual const uint8_t* Get(uint32_t cache_id) override;
-		virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) override;
-
-		virtual void Reset() override;
-	private:
-		ReaderDiskCache(const ReaderDiskCache&) = delete;
-		ReaderDiskCache& operator=(const ReaderDiskCache&) = delete;
-
-		FArchive* GetCacheFileWriter();
-		FArchive* GetCacheFileReader();
-
-		struct DiskCacheRecord
-		{
-			size_t offset = 0;
-			uint32_t size = 0;
-		};
-
-		std::map<uint32_t, DiskCacheRecord> m_entries;
-		FString m_cacheFileFullpath;
-		std::vector<uint8_t> m_currentCache; // just raw array of uint8_t but won't leak
-		uint32_t m_currentCacheId;
-		std::recursive_mutex m_lock;
-	};
+		m_usePersistentCache = usePersistentCache;
+	}
 
-	// Memory only cache, to reduce IO pressure
-	class ReaderMemoryCache : public IReaderCache
+	// Switch main channel representations of the same frame rate by measured throughput, HTTP only.
+	// The bit rate limit still caps the choices.
+	void SetAdaptiveBitRate(bool adaptiveBitRate)
 	{
-	public:
-		ReaderMemoryCache();
-		virtual ~ReaderMemoryCache();
-		// Allocate and copy data on the fly. Return true for new cache entry, false for existing entry updated
-		virtual bool CopyAdd(uint32_t cache_id, const uint8_t* data, uint32_t size) override;
-		virtual bool Remove(uint32_t cache_id) override;
-		virtual const uint8_t* Get(uint32_t cache_id) override;
-		virtual const uint8_t* GetRange(uint32_t cache_id, uint32_t offset, uint32_t size) override;
-
-		virtual void Reset() override;
-	private:
-		ReaderMemoryCache(const ReaderMemoryCache&) = delete;
-		ReaderMemoryCache& operator=(const ReaderMemoryCache&) = delete;
-
-		std::map<uint32_t, uint8_t*> m_entries;
-		std::recursive_mutex m_lock;
-	};
-
+		m_adaptiveBitRate = adaptiveBitRate;
+	}
+#if WITH_EDITOR
+	// only for checking the validity of location. ReadDelegate will have to call 
+	bool ValidateLocation(const FString& urlOrFilePath, double timeoutSec); 
+#endif
+private:
 
 	// For an UObject you have to separate constructor and init functions like this
 	UGhostTreeFormatReader(const FObjectInitializer&);
@@ -196,7 +157,10 @@ private:
 
 	void ProcessRequestResults();
 	void FinishPendingBlocks();
-	static TSharedRef<IHttpRequest, ESPMode::ThreadSafe> NewHttpRequest(const FString& url, uint64_t rangeStart, uint64_t rangeEnd, float timeout);
+	void ReleaseFinishedFileReadRequests();
+	void CloseFileStream();
+	// Drop the read results not yet handed to GhostTree, after its reads are all gone
+	void DiscardRequestResults();
 	void CreateCache();
 
 	// ~Start of ReaderDelegate imlementation~
@@ -213,7 +177,14 @@ private:
 	bool OnOpenConnection(uint32_t conn_handle, const char* name);
 	bool OnCloseConnection(uint32_t conn_handle);
 	bool OnReaderReadFromConnection(uint32_t conn_handle, ReadRequest request);
+	bool OnCancelConnectionRequest(uint32_t conn_handle, uint32_t requestId);
 	// ~End of ReaderDelegate imlementation~
+	void OnHttpRangeComplete(const ReadRequest& readRequest, const uint8_t* data, uint32_t size, const FString& etag, bool succeeded);
+	bool ReadFromPersistentCache(const ReadRequest& readRequest);
+	void SetupAdaptiveBitRate(const ChannelInfo& info, uint32_t selectedRepresentationId);
+	void EvaluateAdaptiveBitRate(double timestamp);
+	void ApplyPendingRepresentationSwitch();
+	void ResetAdaptiveBitRate();
 
 	void OnRuntimeAudioResult(URuntimeAudio* audio, ERuntimeAudioFactoryResult result);
 
@@ -241,10 +212,31 @@ private:
 	std::queue<uint32_t> m_failedRequestId;
 
 	OperatingMode m_currMode;
-	// Filesystem request
-	TSharedPtr<FArchive, ESPMode::NotThreadSafe> m_fileStream;
-	// Http request
-	std::vector<std::shared_ptr<SavedHttpRequest>> m_savedHttpRequestList;
+	// Filesystem request, read asynchronously straight into the cache's storage
+	IAsyncReadFileHandle* m_asyncFileHandle;
+	struct PendingFileRead
+	{
+		IAsyncReadRequest* asyncRequest = nullptr;
+		// Set by the completion callback, the result is queued for GhostTree by then
+		bool completed = false;
+	};
+	// Keyed by GhostTree's request id. Reads removed from here before completing are cancelled, their
+	// completions get dropped.
+	std::map<uint32_t, PendingFileRead> m_pendingFileReads;
+	// Http request, coalesced and throttled by the scheduler
+	std::shared_ptr<HttpRangeScheduler> m_httpScheduler;
+	uint32_t m_maxConcurrentHttpRequests;
+	uint32_t m_maxHttpRetries;
+	float m_httpTimeoutInSeconds;
+	bool m_usePersistentCache;
+
+	// Adaptive bit rate
+	bool m_adaptiveBitRate;
+	std::shared_ptr<AdaptiveBitRateController> m_abrController;
+	double m_segmentDuration;
+	double m_cachedUntil;
+	int64_t m_lastSegmentIndex;
+	int64_t m_pendingRepresentationId;
 
 	std::recursive_mutex m_readerLock;
 	bool m_isMesh;
@@ -16,4 +16,27 @@ public:
     FString AccessToken;
     UPROPERTY(Config, BlueprintReadOnly)
     float WarmUpTime = 0.0f;
+    // Longest the network thread sleeps between polls while no frame is expected, see RealtimeReceiveWait
+    UPROPERTY(Config, BlueprintReadOnly)
+    float MaxIdleWaitMs = 2.0f;
+    // Connection attempts back off from 10ms up to this
+    UPROPERTY(Config, BlueprintReadOnly)
+    float MaxConnectBackoffMs = 2000.0f;
+    // When set, every frame received is written to this capture file, relative to the Saved directory
+    UPROPERTY(Config, BlueprintReadOnly)
+    FString RecordCapturePath;
+    // Replays of replay://<capture file> addresses: time scale of the recorded arrival times, chance of a loss
+    // burst starting at each frame, longest burst, and the most each frame is delayed by
+    UPROPERTY(Config, BlueprintReadOnly)
+    float ReplayTimeScale = 1.0f;
+    UPROPERTY(Config, BlueprintReadOnly)
+    float ReplayLossRate = 0.0f;
+    UPROPERTY(Config, BlueprintReadOnly)
+    int32 ReplayMaxLossBurst = 1;
+    UPROPERTY(Config, BlueprintReadOnly)
+    float ReplayMaxJitterMs = 0.0f;
+    UPROPERTY(Config, BlueprintReadOnly)
+    bool ReplayLoop = false;
+    UPROPERTY(Config, BlueprintReadOnly)
+    int32 ReplaySeed = 0;
 };
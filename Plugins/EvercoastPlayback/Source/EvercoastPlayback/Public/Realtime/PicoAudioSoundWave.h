@@ -7,8 +7,7 @@
 #include "Containers/Queue.h"
 #include "Sound/SoundWave.h"
 #include <vector>
-#include <mutex>
-#include <queue>
+#include <atomic>
 #include <memory>
 
 #include "PicoAudioSoundWave.generated.h"
@@ -20,6 +19,8 @@
 #endif
 
 class EvercoastPerfCounter;
+class PCMBlockRing;
+class PCMDriftResampler;
 
 DECLARE_LOG_CATEGORY_EXTERN(EvercoastRealtimeAudioLog, Log, All);
 
@@ -93,50 +94,50 @@ public:
 	float GetSecondaryCachedAudioTime() const;
 
 private:
-	struct AudioSegment
-	{
-		int64_t frame_num;
-		double timestamp;
-		double duration;
-		TArray<uint8> pcm;
-
-		// Linear interpolate from v0 to this, based on provided value t which ranges from 0 to 1
-		AudioSegment lerp(const AudioSegment& v0, float t) const;
-	};
-
-
-	// Pumps audio queued from game thread
-	void PumpQueuedAudio();
-
-	bool InterpolateAudio(const AudioSegment& newSegment, int interpolatingFrame, AudioSegment& out);
-
-	
-
-	mutable std::mutex m_mutex{};
-	std::queue<AudioSegment> m_segments{};
-	AudioSegment m_lastReceivedSegment{ -1, -1, -1 };
+	// Network thread side, splits the packet into blocks and conceals the frames lost before it
+	void WriteBlocks(double timestamp, int64_t frameNum, const int16_t* samples, int32_t sampleCount, int64_t missingFrames);
+	// Audio render thread side
+	void UpdateDriftRatio(bool gated);
+
+	// Blocks go from the network thread to the audio render thread through here without locking either
+	std::unique_ptr<PCMBlockRing> m_ring;
+	// Only accessible in audio thread
+	std::unique_ptr<PCMDriftResampler> m_resampler;
+	double m_driftRatio{ 1.0 };
+	int32 m_resamplerChannels{ 0 };
+
+	// Only accessible in network thread. Copy of the last received block, concealment repeats it
+	std::vector<int16_t> m_lastBlock;
+	double m_lastBlockTimestamp{ -1 };
+	// Epoch the network thread last wrote in, it starts over once ResetAudio() moved it on
+	uint32_t m_writerEpoch{ 0 };
 	
+	// Bumped by ResetAudio(), the audio thread drops blocks of earlier epochs
+	std::atomic<uint32_t> m_epoch{ 0 };
 	// Flag to reset the audio buffer
 	FThreadSafeBool bReset;
-	// Only accessible in audio thread, no need to lock m_audioBuffer
-	TArray<uint8> m_audioBuffer;
 
+	// Only accessible in network thread
 	bool m_initialised{ false };
 	FThreadSafeBool m_isReady{ false };
 	FThreadSafeBool m_hasInitialSynced{ false };
 
 	uint64 m_prevFrameNum{ 0 };
-	double m_initialTimestamp{ 0 };
+	std::atomic<double> m_initialTimestamp{ 0 };
+	// Timestamp of video asked to sync to before the initial sync, the audio thread drops audio older than it
+	std::atomic<double> m_syncRequestTimestamp{ -1 };
 
-	mutable std::mutex m_stats_mutex{};
-	double m_lastAudioBufferTimestamp{ 0 };
-	double m_lastPCMGenerationFedTimestamp{ 0 };
-	double m_lastReceivedAudioTimestamp{ 0 };
+	std::atomic<double> m_lastPCMGenerationFedTimestamp{ 0 };
+	std::atomic<double> m_lastReceivedAudioTimestamp{ 0 };
+	std::atomic<int32> m_pendingResampleFrames{ 0 };
+	std::atomic<uint64> m_underrunCount{ 0 };
+	std::atomic<uint64> m_concealedBlockCount{ 0 };
+	std::atomic<uint64> m_overflowBlockCount{ 0 };
 
 	std::shared_ptr<EvercoastPerfCounter> m_missingFrameCounter;
 
-	double m_audioBufferPumpDelay{ 0 };
-	double m_currVideoSyncingExtrapolatedTimestamp{ 0 };
+	std::atomic<double> m_audioBufferPumpDelay{ 0 };
+	std::atomic<double> m_currVideoSyncingExtrapolatedTimestamp{ 0 };
 
 	float m_warmupTime{ 0.0f };
 };
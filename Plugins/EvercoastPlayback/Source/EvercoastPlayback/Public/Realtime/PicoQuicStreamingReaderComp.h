@@ -7,6 +7,7 @@
 #include "EvercoastPerfCounter.h"
 #include <memory>
 #include <queue>
+#include <deque>
 #include <functional>
 #include "Delegates/Delegate.h"
 #include "PicoQuicStreamingReaderComp.generated.h"
@@ -86,6 +87,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Profiling")
 	float GetVideoLaggingTime();
 
+	// percentile in [0, 1] of the video lagging over the last 2 seconds, -1 when nothing was measured
+	UFUNCTION(BlueprintCallable, Category = "Profiling")
+	float GetVideoLaggingTimePercentile(float percentile);
+
 	UFUNCTION(BlueprintCallable, Category = "Profiling")
 	float GetActualVideoBehindAudioTime();
 
@@ -172,6 +177,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Livestreaming")
 	bool		IgnoreAudio;
 
+	// Seconds each received frame is held so ones overtaken on the network can be put back in order. 0 decodes in arrival order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Livestreaming", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float		JitterBufferLatency;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Livestreaming")
 	UMaterialInterface* OverrideVoxelBasedMaterial;
 
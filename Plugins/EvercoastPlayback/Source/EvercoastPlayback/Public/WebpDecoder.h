@@ -16,8 +16,11 @@ public:
 	void Lock() const;
 	void Unlock() const;
 
-	// Applying result transfer the data ownership
-	bool ApplyResult(bool success, double timestamp, int64_t frameIndex, int width, int height, uint8_t bpp, uint8_t* data);
+	// Where to decode a width x height image to, Pitch bytes per row. The buffer is kept for following frames and
+	// only replaced when it's too small or a copy of this result still shares it
+	uint8_t* PrepareTexels(int width, int height, uint8_t bpp);
+	// Called after decoding into the buffer from PrepareTexels()
+	void ApplyResult(bool success, double timestamp, int64_t frameIndex);
 
 	virtual DecodeResultType GetType() const override
 	{
@@ -34,10 +37,18 @@ public:
 		return Height;
 	}
 
+	// Row pitch is kept a multiple of this, and rows start at this alignment
+	static constexpr int PITCH_ALIGNMENT = 64;
+
 	int Width;
 	int Height;
 	uint8_t BitPerPixel;
-	uint8_t* RawTexelBuffer;
+	int Pitch;
+	uint8_t* RawTexelBuffer; // points into TexelStorage
+
+	// Copies of a result share the texels rather than duplicating them
+	std::shared_ptr<uint8_t> TexelStorage;
+	size_t TexelCapacity;
 
 	mutable std::mutex RWLock;
 };
@@ -46,6 +57,9 @@ public:
 class EVERCOASTPLAYBACK_API WebpDecoder : public IGenericDecoder
 {
 public:
+	// Images at least this big get libwebp's extra worker thread
+	static constexpr int THREADED_DECODE_PIXEL_COUNT = 1024 * 1024;
+
 	static std::shared_ptr<WebpDecoder> Create();
 	virtual ~WebpDecoder();
 